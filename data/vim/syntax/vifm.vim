@@ -117,7 +117,7 @@ syntax case match
 syntax keyword vifmOption contained aproposprg autochpos cdpath cd chaselinks
 		\ classify columns co confirm cf cpoptions cpo deleteprg dotdirs dirsize
 		\ fastrun fillchars fcs findprg followlinks fusehome gdefault grepprg
-		\ history hi hlsearch hls iec ignorecase ic iooptions incsearch is
+		\ history hi hlsearch hls iec ignorecase ic iooptions ioworkers incsearch is
 		\ laststatus lines locateprg ls lsview mintimeoutlen number nu numberwidth
 		\ nuw relativenumber rnu rulerformat ruf runexec scrollbind scb scrolloff so
 		\ sort sortgroups sortorder sortnumbers shell sh shortmess shm slowfs
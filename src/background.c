@@ -875,6 +875,11 @@ background_task_bootstrap(void *arg)
 
 	set_current_job(task_args->job);
 
+	if(cfg.io_idle_prio)
+	{
+		lower_io_priority();
+	}
+
 	task_args->func(&task_args->job->bg_op, task_args->args);
 
 	/* Mark task as finished normally. */
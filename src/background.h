@@ -28,6 +28,7 @@
 
 #include <sys/types.h> /* pid_t */
 
+#include <stdint.h> /* uint64_t */
 #include <stdio.h>
 
 /* Special value of total amount of work in job_t structure to indicate
@@ -52,6 +53,7 @@ typedef struct bg_op_t
 
 	int progress; /* Progress in percents.  -1 if task doesn't provide one. */
 	char *descr;  /* Description of current activity, can be NULL. */
+	uint64_t rate; /* Bytes processed per second recently, zero if unknown. */
 }
 bg_op_t;
 
@@ -206,6 +206,17 @@ cfg_init(void)
 	cfg.decorations[FT_DIR][DECORATION_SUFFIX] = '/';
 
 	cfg.fast_file_cloning = 0;
+	cfg.verify_copies = VC_NONE;
+	cfg.io_workers = 4;
+	cfg.io_rate = 0U;
+	cfg.io_ops_rate = 0U;
+	cfg.io_job_rate = 0U;
+	cfg.io_job_ops_rate = 0U;
+	cfg.io_idle_prio = 0;
+
+	cfg.prefetch_entries = 0;
+	cfg.prefetch_jobs = 1;
+	cfg.preview_cache_size = 8*1024*1024;
 }
 
 void
@@ -21,6 +21,7 @@
 #define VIFM__CFG__CONFIG_H__
 
 #include <stddef.h> /* size_t wchar_t */
+#include <stdint.h> /* uint64_t */
 
 #include "../compat/fs_limits.h"
 #include "../ui/color_scheme.h"
@@ -57,6 +58,15 @@ typedef enum
 }
 ViewDirSize;
 
+/* Whether and how copies of files are checked to match their sources. */
+typedef enum
+{
+	VC_NONE,   /* Copies aren't verified. */
+	VC_FAST,   /* Checksums are computed with a fast non-cryptographic hash. */
+	VC_SHA256, /* Checksums are computed with SHA-256. */
+}
+VerifyCopies;
+
 /* Indexes for cfg.decorations. */
 enum
 {
@@ -182,6 +192,26 @@ typedef struct config_t
 
 	/* Controls use of fast file cloning for file systems that support it. */
 	int fast_file_cloning;
+
+	/* Controls verification of copied files. */
+	VerifyCopies verify_copies;
+
+	/* Maximum number of files to copy concurrently. */
+	int io_workers;
+
+	/* Limits on rate of background operations, zero means no limit. */
+	uint64_t io_rate;         /* Bytes per second for all operations. */
+	uint64_t io_ops_rate;     /* File operations per second for all of them. */
+	uint64_t io_job_rate;     /* Bytes per second for each operation. */
+	uint64_t io_job_ops_rate; /* File operations per second for each one. */
+
+	/* Whether background operations should use idle I/O priority. */
+	int io_idle_prio;
+
+	/* Prefetching of previews of files around the cursor. */
+	int prefetch_entries;        /* Number of files in each direction. */
+	int prefetch_jobs;           /* Number of viewers to run at a time. */
+	uint64_t preview_cache_size; /* Limit on memory used by previews. */
 }
 config_t;
 
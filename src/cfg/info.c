@@ -958,6 +958,10 @@ write_options(FILE *const fp)
 	fprintf(fp, "=lines=%d\n", cfg.lines);
 	fprintf(fp, "=locateprg=%s\n", escape_spaces(cfg.locate_prg));
 	fprintf(fp, "=mintimeoutlen=%d\n", cfg.min_timeout_len);
+#ifndef _WIN32
+	fprintf(fp, "=previewprefetch=%s\n",
+			escape_spaces(get_option_value("previewprefetch", OPT_GLOBAL)));
+#endif
 	fprintf(fp, "=rulerformat=%s\n", escape_spaces(cfg.ruler_format));
 	fprintf(fp, "=%srunexec\n", cfg.auto_execute ? "" : "no");
 	fprintf(fp, "=%sscrollbind\n", cfg.scroll_bind ? "" : "no");
@@ -1004,11 +1008,22 @@ write_options(FILE *const fp)
 		fprintf(fp, "%s", "nonrootparent,");
 	fprintf(fp, "\n");
 
+	fprintf(fp, "=iolimits=%s\n",
+			escape_spaces(get_option_value("iolimits", OPT_GLOBAL)));
+
 	fprintf(fp, "%s", "=iooptions=");
 	if(cfg.fast_file_cloning)
 		fprintf(fp, "%s", "fastfilecloning,");
+	if(cfg.verify_copies == VC_FAST)
+		fprintf(fp, "%s", "verify,");
+	if(cfg.verify_copies == VC_SHA256)
+		fprintf(fp, "%s", "verifysha256,");
+	if(cfg.io_idle_prio)
+		fprintf(fp, "%s", "idleprio,");
 	fprintf(fp, "\n");
 
+	fprintf(fp, "=ioworkers=%d\n", cfg.io_workers);
+
 	fprintf(fp, "=dirsize=%s", cfg.view_dir_size == VDS_SIZE ? "size" : "nitems");
 
 	fprintf(fp, "=classify=%s\n", escape_spaces(classify_to_str()));
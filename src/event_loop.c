@@ -36,6 +36,7 @@
 #include "modes/dialogs/msg_dialog.h"
 #include "modes/modes.h"
 #include "ui/fileview.h"
+#include "ui/quickview.h"
 #include "ui/statusbar.h"
 #include "ui/statusline.h"
 #include "ui/ui.h"
@@ -330,6 +331,7 @@ process_scheduled_updates(void)
 	{
 		need_redraw += (process_scheduled_updates_of_view(curr_view) != 0);
 		need_redraw += (process_scheduled_updates_of_view(other_view) != 0);
+		need_redraw += (qv_check_for_updates(is_input_buf_empty()) != 0);
 	}
 
 	need_redraw += (fetch_redraw_scheduled() != 0);
@@ -27,6 +27,9 @@
 #endif
 
 #include <curses.h>
+#ifndef _WIN32
+#include <pthread.h> /* PTHREAD_* pthread_*() */
+#endif
 
 #include <sys/stat.h> /* stat */
 #include <unistd.h> /* close() fork() pipe() */
@@ -65,6 +68,7 @@
 #include "utils/path.h"
 #include "utils/regexp.h"
 #include "utils/str.h"
+#include "utils/str_pool.h"
 #include "utils/string_array.h"
 #include "utils/test_helpers.h"
 #include "utils/trie.h"
@@ -79,6 +83,22 @@
 #include "status.h"
 #include "types.h"
 
+/* Minimal number of entries in a directory starting from which file information
+ * is queried by several threads. */
+#define PARALLEL_STAT_THRESHOLD 1024
+
+/* Number of entries claimed by a stat worker at a time. */
+#define STAT_BATCH_SIZE 256
+
+/* Maximum number of threads (including the current one) that query file
+ * information.  Most of the time they wait on the file system, so this isn't
+ * tied to number of processors. */
+#define MAX_STAT_WORKERS 8
+
+/* Reloaded list is patched instead of being sorted from scratch if number of new
+ * or changed entries doesn't exceed its size divided by this number. */
+#define PATCH_LIST_RATIO 2
+
 /* Custom argument for is_in_list() function. */
 typedef struct
 {
@@ -91,6 +111,29 @@ list_t;
  * if particular property holds and zero otherwise. */
 typedef int (*predicate_func)(const dir_entry_t *entry);
 
+/* State of loading directory list passed to add_file_entry_to_view(). */
+typedef struct
+{
+	FileView *view;  /* View whose list is being loaded. */
+	int progressive; /* Whether partially loaded list should be displayed. */
+	int next_draw;   /* Number of entries at which partial list is drawn. */
+	int nfilled;     /* Number of leading entries with file information. */
+}
+load_state_t;
+
+#ifndef _WIN32
+/* State shared among threads that fill in directory entries. */
+typedef struct
+{
+	dir_entry_t *entries; /* Entries to process. */
+	char *failed;         /* Per-entry flags of failed queries. */
+	int count;            /* Number of entries. */
+	int next;             /* Index of the first unclaimed entry. */
+	pthread_mutex_t lock; /* Protects the next field. */
+}
+stat_job_t;
+#endif
+
 static void init_view(FileView *view);
 static void init_flist(FileView *view);
 static void reset_view(FileView *view);
@@ -107,8 +150,11 @@ static void free_saved_selection(FileView *view);
 static int fill_dir_entry_by_path(dir_entry_t *entry, const char path[]);
 #ifndef _WIN32
 static int fill_dir_entry(dir_entry_t *entry, const char path[],
-		const struct dirent *d);
+		FileType type_hint);
 static int data_is_dir_entry(const struct dirent *d);
+static void * stat_worker(void *arg);
+static void process_stat_batches(stat_job_t *job);
+static int claim_stat_batch(stat_job_t *job, int *first, int *last);
 #else
 static int fill_dir_entry(dir_entry_t *entry, const char path[],
 		const WIN32_FIND_DATAW *ffd);
@@ -126,10 +172,20 @@ static int is_dead_or_filtered(FileView *view, const dir_entry_t *entry,
 static void update_entries_data(FileView *view);
 static int is_dir_big(const char path[]);
 static void free_view_entries(FileView *view);
-static int update_dir_list(FileView *view, int reload);
+static int update_dir_list(FileView *view, int reload, int progressive);
+static int fill_dir_entries(FileView *view, int from);
+static void draw_partial_list(FileView *view);
 static int add_file_entry_to_view(const char name[], const void *data,
 		void *param);
 static void sort_dir_list(int msg, FileView *view);
+static int patch_sorted_list(FileView *view, dir_entry_t *entries, int len);
+static int * index_names(const dir_entry_t entries[], int count,
+		size_t *mask);
+static int find_name(const int index[], size_t mask,
+		const dir_entry_t entries[], const char name[]);
+static size_t hash_name(const char name[]);
+static int sort_data_matches(const FileView *view, const dir_entry_t *a,
+		const dir_entry_t *b);
 static void merge_lists(FileView *view, dir_entry_t *entries, int len);
 static void add_to_trie(trie_t trie, FileView *view, dir_entry_t *entry);
 static int is_in_trie(trie_t trie, FileView *view, dir_entry_t *entry,
@@ -140,6 +196,7 @@ static int rescue_from_empty_filelist(FileView *view);
 static void init_dir_entry(FileView *view, dir_entry_t *entry,
 		const char name[]);
 static void free_dir_entries(FileView *view, dir_entry_t **entries, int *count);
+static void free_entry_name(dir_entry_t *entry);
 static dir_entry_t * alloc_dir_entry(dir_entry_t **list, int list_size);
 static int file_can_be_displayed(const char directory[], const char filename[]);
 TSTATIC void pick_cd_path(FileView *view, const char base_dir[],
@@ -1470,7 +1527,8 @@ flist_custom_add(FileView *view, const char path[])
 
 	init_dir_entry(view, dir_entry, get_last_path_component(canonic_path));
 
-	dir_entry->origin = strdup(canonic_path);
+	dir_entry->origin = str_pool_dup(canonic_path);
+	dir_entry->origin_pooled = 1;
 	remove_last_path_component(dir_entry->origin);
 
 	if(fill_dir_entry_by_path(dir_entry, canonic_path) != 0)
@@ -1489,14 +1547,16 @@ flist_custom_add(FileView *view, const char path[])
 static int
 fill_dir_entry_by_path(dir_entry_t *entry, const char path[])
 {
-	return fill_dir_entry(entry, path, NULL);
+	return fill_dir_entry(entry, path, FT_UNK);
 }
 
 /* Fills fields of the entry from stat information of the file specified by its
- * path.  d is optional source of file type.  Returns zero on success, otherwise
- * non-zero is returned. */
+ * path.  type_hint is used when file type can't be derived from its mode (pass
+ * FT_UNK if there is no hint).  Might be called from several threads at the
+ * same time for different entries.  Returns zero on success, otherwise non-zero
+ * is returned. */
 static int
-fill_dir_entry(dir_entry_t *entry, const char path[], const struct dirent *d)
+fill_dir_entry(dir_entry_t *entry, const char path[], FileType type_hint)
 {
 	struct stat s;
 
@@ -1510,7 +1570,7 @@ fill_dir_entry(dir_entry_t *entry, const char path[], const struct dirent *d)
 	entry->type = get_type_from_mode(s.st_mode);
 	if(entry->type == FT_UNK)
 	{
-		entry->type = (d == NULL) ? FT_UNK : type_from_dir_entry(d);
+		entry->type = type_hint;
 	}
 	if(entry->type == FT_UNK)
 	{
@@ -1551,6 +1611,46 @@ data_is_dir_entry(const struct dirent *d)
 	return is_dirent_targets_dir(d);
 }
 
+/* Entry point of a thread that fills in directory entries.  Returns NULL. */
+static void *
+stat_worker(void *arg)
+{
+	process_stat_batches(arg);
+	return NULL;
+}
+
+/* Fills in entries of the job batch by batch until there are no more unclaimed
+ * entries left. */
+static void
+process_stat_batches(stat_job_t *job)
+{
+	int first, last;
+	while(claim_stat_batch(job, &first, &last))
+	{
+		int i;
+		for(i = first; i < last; ++i)
+		{
+			dir_entry_t *const entry = &job->entries[i];
+			job->failed[i] = (fill_dir_entry(entry, entry->name, entry->type) != 0);
+		}
+	}
+}
+
+/* Reserves next batch of entries of the job for processing.  Returns non-zero
+ * and sets *first and *last (exclusive) on success, otherwise zero is
+ * returned. */
+static int
+claim_stat_batch(stat_job_t *job, int *first, int *last)
+{
+	pthread_mutex_lock(&job->lock);
+	*first = job->next;
+	*last = MIN(job->next + STAT_BATCH_SIZE, job->count);
+	job->next = *last;
+	pthread_mutex_unlock(&job->lock);
+
+	return *first < *last;
+}
+
 #else
 
 /* Fills directory entry with information about file specified by the path.
@@ -1903,6 +2003,8 @@ load_dir_list_internal(FileView *view, int reload, int draw_only)
 static int
 populate_dir_list_internal(FileView *view, int reload)
 {
+	int progressive;
+
 	view->filtered = 0;
 
 	if(flist_custom_active(view))
@@ -1922,12 +2024,14 @@ populate_dir_list_internal(FileView *view, int reload)
 		return 0;
 	}
 
-	if(!reload && is_dir_big(view->curr_dir))
+	/* Big directories are drawn while they are being loaded to show something
+	 * as soon as possible.  Loading is still synchronous: keys aren't processed
+	 * until it's over and partial lists are sorted on this thread. */
+	progressive = !reload && !vle_mode_is(CMDLINE_MODE) &&
+		is_dir_big(view->curr_dir);
+	if(progressive)
 	{
-		if(!vle_mode_is(CMDLINE_MODE))
-		{
-			ui_sb_quick_msgf("%s", "Reading directory...");
-		}
+		ui_sb_quick_msgf("%s", "Reading directory...");
 	}
 
 	if(curr_stats.load_stage < 2)
@@ -1942,7 +2046,7 @@ populate_dir_list_internal(FileView *view, int reload)
 		return 1;
 	}
 
-	if(update_dir_list(view, reload) != 0)
+	if(update_dir_list(view, reload, progressive) != 0)
 	{
 		/* We don't have read access, only execute, or there were other problems. */
 		free_view_entries(view);
@@ -2135,13 +2239,20 @@ free_view_entries(FileView *view)
 	free_dir_entries(view, &view->dir_entry, &view->list_rows);
 }
 
-/* Updates file list with files from current directory.  Returns zero on
- * success, otherwise non-zero is returned. */
+/* Updates file list with files from current directory.  The progressive
+ * parameter enables drawing partially loaded list.  Returns zero on success,
+ * otherwise non-zero is returned. */
 static int
-update_dir_list(FileView *view, int reload)
+update_dir_list(FileView *view, int reload, int progressive)
 {
 	dir_entry_t *prev_dir_entries = NULL;
 	int prev_list_rows = 0;
+	load_state_t state = {
+		.view = view,
+		.progressive = progressive && ui_view_is_visible(view),
+		.next_draw = MAX((int)view->window_cells, 1),
+		.nfilled = 0,
+	};
 
 	if(reload)
 	{
@@ -2167,28 +2278,42 @@ update_dir_list(FileView *view, int reload)
 	}
 #endif
 
-	if(enum_dir_content(view->curr_dir, &add_file_entry_to_view, view) != 0)
+	if(enum_dir_content(view->curr_dir, &add_file_entry_to_view, &state) != 0)
 	{
 		LOG_SERROR_MSG(errno, "Can't opendir() \"%s\"", view->curr_dir);
 		free_dir_entries(view, &prev_dir_entries, &prev_list_rows);
 		return 1;
 	}
 
+	if(fill_dir_entries(view, state.nfilled) != 0)
+	{
+		show_error_msg("Memory Error", "Unable to allocate enough memory");
+		free_dir_entries(view, &prev_dir_entries, &prev_list_rows);
+		return 1;
+	}
+
 	if(cfg_parent_dir_is_visible(is_root_dir(view->curr_dir)) ||
 			view->list_rows == 0)
 	{
 		add_parent_dir(view);
 	}
 
-	sort_dir_list(!reload, view);
-
-	if(reload)
+	if(reload && patch_sorted_list(view, prev_dir_entries, prev_list_rows) == 0)
 	{
-		/* Merging must be performed after sorting so that list position remains
-		 * fixed (sorting doesn't preserve it). */
-		merge_lists(view, prev_dir_entries, prev_list_rows);
 		free_dir_entries(view, &prev_dir_entries, &prev_list_rows);
 	}
+	else
+	{
+		sort_dir_list(!reload, view);
+
+		if(reload)
+		{
+			/* Merging must be performed after sorting so that list position
+			 * remains fixed (sorting doesn't preserve it). */
+			merge_lists(view, prev_dir_entries, prev_list_rows);
+			free_dir_entries(view, &prev_dir_entries, &prev_list_rows);
+		}
+	}
 
 	view->dir_entry = dynarray_shrink(view->dir_entry);
 
@@ -2200,7 +2325,8 @@ update_dir_list(FileView *view, int reload)
 static int
 add_file_entry_to_view(const char name[], const void *data, void *param)
 {
-	FileView *const view = param;
+	load_state_t *const state = param;
+	FileView *const view = state->view;
 	dir_entry_t *entry;
 
 	/* Always ignore the "." and ".." directories. */
@@ -2230,6 +2356,12 @@ add_file_entry_to_view(const char name[], const void *data, void *param)
 
 	init_dir_entry(view, entry, name);
 
+#ifndef _WIN32
+	/* Querying file information is postponed until fill_dir_entries() call,
+	 * just remember what directory entry tells about type of the file. */
+	entry->type = (data == NULL) ? FT_UNK : type_from_dir_entry(data);
+	++view->list_rows;
+#else
 	if(fill_dir_entry(entry, entry->name, data) == 0)
 	{
 		++view->list_rows;
@@ -2238,7 +2370,139 @@ add_file_entry_to_view(const char name[], const void *data, void *param)
 	{
 		free_dir_entry(view, entry);
 	}
+#endif
+
+	if(state->progressive && view->list_rows >= state->next_draw)
+	{
+		if(fill_dir_entries(view, state->nfilled) != 0)
+		{
+			show_error_msg("Memory Error", "Unable to allocate enough memory");
+			return 1;
+		}
+		state->nfilled = view->list_rows;
+
+		draw_partial_list(view);
+
+		/* Doubling the threshold keeps number of redraws logarithmic. */
+		state->next_draw = view->list_rows*2;
+	}
+
+	return 0;
+}
+
+/* Draws sorted version of partially loaded file list of the view and reports
+ * number of items read so far.  The list and position in it are left
+ * unchanged. */
+static void
+draw_partial_list(FileView *view)
+{
+	dir_entry_t *const entries = view->dir_entry;
+	const int list_pos = view->list_pos;
+	const int top_line = view->top_line;
+	const int curr_line = view->curr_line;
+
+	/* Sorting is performed on a shallow copy, because sorting the list itself
+	 * affects order of entries that compare equal after the final sorting. */
+	dir_entry_t *const copy = reallocarray(NULL, view->list_rows, sizeof(*copy));
+	if(copy == NULL)
+	{
+		return;
+	}
+	memcpy(copy, entries, sizeof(*copy)*view->list_rows);
+
+	view->dir_entry = copy;
+	view->list_pos = 0;
+	view->top_line = 0;
+	view->curr_line = 0;
+
+	sort_view(view);
+	draw_dir_list_only(view);
+
+	view->dir_entry = entries;
+	view->list_pos = list_pos;
+	view->top_line = top_line;
+	view->curr_line = curr_line;
+
+	free(copy);
+
+	ui_sb_quick_msgf("Reading directory... %d items", view->list_rows);
+}
+
+/* Queries information about files of just enumerated directory entries
+ * starting at the specified index distributing the work among several threads
+ * for large directories.  Entries for which querying failed are removed from
+ * the list.  Returns zero on success, otherwise non-zero is returned. */
+static int
+fill_dir_entries(FileView *view, int from)
+{
+#ifndef _WIN32
+	stat_job_t job;
+	pthread_t workers[MAX_STAT_WORKERS - 1];
+	int nworkers = 0;
+	int i, j;
+
+	if(view->list_rows <= from)
+	{
+		return 0;
+	}
+
+	job.entries = &view->dir_entry[from];
+	job.count = view->list_rows - from;
+	job.next = 0;
+	job.failed = calloc(job.count, sizeof(*job.failed));
+	if(job.failed == NULL)
+	{
+		return 1;
+	}
+	pthread_mutex_init(&job.lock, NULL);
+
+	if(job.count >= PARALLEL_STAT_THRESHOLD)
+	{
+		const int nbatches = DIV_ROUND_UP(job.count, STAT_BATCH_SIZE);
+		const int max_workers = MIN(nbatches, MAX_STAT_WORKERS) - 1;
+		while(nworkers < max_workers)
+		{
+			if(pthread_create(&workers[nworkers], NULL, &stat_worker, &job) != 0)
+			{
+				/* Just do the rest of the work with what we have. */
+				break;
+			}
+			++nworkers;
+		}
+	}
+
+	/* Current thread does its share of the work as well. */
+	process_stat_batches(&job);
+
+	for(i = 0; i < nworkers; ++i)
+	{
+		(void)pthread_join(workers[i], NULL);
+	}
+	pthread_mutex_destroy(&job.lock);
+
+	/* Drop entries that couldn't be filled in preserving order of others. */
+	j = 0;
+	for(i = 0; i < job.count; ++i)
+	{
+		if(job.failed[i])
+		{
+			free_dir_entry(view, &job.entries[i]);
+			continue;
+		}
+
+		if(i != j)
+		{
+			job.entries[j] = job.entries[i];
+		}
+		++j;
+	}
+	view->list_rows = from + j;
 
+	free(job.failed);
+#else
+	(void)view;
+	(void)from;
+#endif
 	return 0;
 }
 
@@ -2279,6 +2543,220 @@ sort_dir_list(int msg, FileView *view)
 	}
 }
 
+/* Sorts reloaded list of the view by reusing order of the previous (sorted)
+ * list for entries that didn't change and inserting the rest into it, which is
+ * much cheaper than sorting everything when only few files changed.  State of
+ * entries is merged as well.  Returns zero on success, otherwise non-zero is
+ * returned and nothing is changed. */
+static int
+patch_sorted_list(FileView *view, dir_entry_t *entries, int len)
+{
+	int i;
+	int nsorted = 0, nadded = 0;
+	int closes_dist;
+	const int prev_pos = view->list_pos;
+	size_t mask;
+	int *index;
+	int *prev_idx = NULL, *new_idx = NULL;
+	dir_entry_t **sorted = NULL, **added = NULL;
+
+	if(len == 0 || flist_custom_active(view))
+	{
+		return 1;
+	}
+
+	index = index_names(entries, len, &mask);
+	prev_idx = reallocarray(NULL, view->list_rows, sizeof(*prev_idx));
+	new_idx = reallocarray(NULL, len, sizeof(*new_idx));
+	sorted = reallocarray(NULL, view->list_rows, sizeof(*sorted));
+	added = reallocarray(NULL, view->list_rows, sizeof(*added));
+	if(index == NULL || prev_idx == NULL || new_idx == NULL || sorted == NULL ||
+			added == NULL)
+	{
+		goto fail;
+	}
+
+	for(i = 0; i < len; ++i)
+	{
+		new_idx[i] = -1;
+	}
+
+	/* Match entries by name and split them into unchanged ones that remain
+	 * sorted and those that need to be inserted.  list_num field remembers
+	 * where entries were before reordering. */
+	for(i = 0; i < view->list_rows; ++i)
+	{
+		dir_entry_t *const entry = &view->dir_entry[i];
+		const int j = find_name(index, mask, entries, entry->name);
+
+		entry->list_num = i;
+		prev_idx[i] = j;
+
+		if(j >= 0 && sort_data_matches(view, entry, &entries[j]))
+		{
+			new_idx[j] = i;
+		}
+		else
+		{
+			added[nadded++] = entry;
+		}
+	}
+
+	if(nadded > view->list_rows/PATCH_LIST_RATIO)
+	{
+		goto fail;
+	}
+
+	/* Unchanged entries go in the order of the previous list. */
+	for(i = 0; i < len; ++i)
+	{
+		if(new_idx[i] >= 0)
+		{
+			sorted[nsorted++] = &view->dir_entry[new_idx[i]];
+		}
+	}
+
+	if(sort_merge_into_view(view, sorted, nsorted, added, nadded) != 0)
+	{
+		goto fail;
+	}
+
+	/* Transfer information from previous entries to the new ones. */
+	closes_dist = INT_MIN;
+	for(i = 0; i < view->list_rows; ++i)
+	{
+		dir_entry_t *const entry = &view->dir_entry[i];
+		const int j = prev_idx[entry->list_num];
+		if(j < 0)
+		{
+			continue;
+		}
+
+		merge_entries(entry, &entries[j]);
+		view->selected_files += (entry->selected != 0);
+		closes_dist = correct_pos(view, i, j - prev_pos, closes_dist);
+	}
+
+	free(added);
+	free(sorted);
+	free(new_idx);
+	free(prev_idx);
+	free(index);
+	return 0;
+
+fail:
+	free(added);
+	free(sorted);
+	free(new_idx);
+	free(prev_idx);
+	free(index);
+	return 1;
+}
+
+/* Builds hash table of entry names using open addressing.  *mask is set to
+ * size of the table minus one.  Returns the table, which maps hashes to entry
+ * indexes plus one (zero marks empty slots), or NULL on error. */
+static int *
+index_names(const dir_entry_t entries[], int count, size_t *mask)
+{
+	int i;
+	int *index;
+	size_t size = 16U;
+
+	while(size < (size_t)count*2U)
+	{
+		size *= 2U;
+	}
+
+	index = calloc(size, sizeof(*index));
+	if(index == NULL)
+	{
+		return NULL;
+	}
+
+	*mask = size - 1U;
+	for(i = 0; i < count; ++i)
+	{
+		size_t slot = hash_name(entries[i].name) & *mask;
+		while(index[slot] != 0)
+		{
+			slot = (slot + 1U) & *mask;
+		}
+		index[slot] = i + 1;
+	}
+	return index;
+}
+
+/* Looks up entry by its name in the table built by index_names().  Returns
+ * index of the entry or -1 if there is no such entry. */
+static int
+find_name(const int index[], size_t mask, const dir_entry_t entries[],
+		const char name[])
+{
+	size_t slot = hash_name(name) & mask;
+	while(index[slot] != 0)
+	{
+		const int i = index[slot] - 1;
+		if(strcmp(entries[i].name, name) == 0)
+		{
+			return i;
+		}
+		slot = (slot + 1U) & mask;
+	}
+	return -1;
+}
+
+/* Computes FNV-1a hash of the name.  Returns the hash. */
+static size_t
+hash_name(const char name[])
+{
+	size_t hash = 2166136261U;
+	while(*name != '\0')
+	{
+		hash = (hash ^ (unsigned char)*name++)*16777619U;
+	}
+	return hash;
+}
+
+/* Checks whether two entries of the same file have equal values of everything
+ * that affects sorting.  Returns non-zero if so, otherwise zero is returned. */
+static int
+sort_data_matches(const FileView *view, const dir_entry_t *a,
+		const dir_entry_t *b)
+{
+	if(a->type != b->type || a->size != b->size || a->mtime != b->mtime ||
+			a->atime != b->atime || a->ctime != b->ctime)
+	{
+		return 0;
+	}
+
+#ifndef _WIN32
+	if(a->mode != b->mode || a->uid != b->uid || a->gid != b->gid ||
+			a->nlinks != b->nlinks)
+	{
+		return 0;
+	}
+#endif
+
+	/* Whether symbolic link points to a directory can change without change of
+	 * the link. */
+	if(a->type == FT_LINK)
+	{
+		return 0;
+	}
+
+	/* Size and number of items of directories are taken from cache and can
+	 * change behind our back. */
+	if(a->type == FT_DIR &&
+			(ui_view_sort_list_contains(view->sort, SK_BY_SIZE) ||
+			 ui_view_sort_list_contains(view->sort, SK_BY_NITEMS)))
+	{
+		return 0;
+	}
+
+	return 1;
+}
+
 /* Merges elements from previous list into the new one. */
 static void
 merge_lists(FileView *view, dir_entry_t *entries, int len)
@@ -2293,7 +2771,7 @@ merge_lists(FileView *view, dir_entry_t *entries, int len)
 		add_to_trie(prev_names, view, &entries[i]);
 
 		/* We won't use the name later, so free some memory. */
-		update_string(&entries[i].name, NULL);
+		free_entry_name(&entries[i]);
 	}
 
 	closes_dist = INT_MIN;
@@ -2476,8 +2954,10 @@ add_parent_dir(FileView *view)
 static void
 init_dir_entry(FileView *view, dir_entry_t *entry, const char name[])
 {
-	entry->name = strdup(name);
+	entry->name = str_pool_dup(name);
+	entry->name_pooled = 1;
 	entry->origin = &view->curr_dir[0];
+	entry->origin_pooled = 0;
 
 	entry->size = 0ULL;
 #ifndef _WIN32
@@ -2523,8 +3003,10 @@ replace_dir_entries(FileView *view, dir_entry_t **entries, int *count,
 	{
 		dir_entry_t *const entry = &new[i];
 
-		entry->name = strdup(entry->name);
-		entry->origin = strdup(entry->origin);
+		entry->name = str_pool_dup(entry->name);
+		entry->name_pooled = 1;
+		entry->origin = str_pool_dup(entry->origin);
+		entry->origin_pooled = 1;
 
 		if(entry->name == NULL || entry->origin == NULL)
 		{
@@ -2558,16 +3040,37 @@ free_dir_entries(FileView *view, dir_entry_t **entries, int *count)
 void
 free_dir_entry(const FileView *view, dir_entry_t *entry)
 {
-	free(entry->name);
-	entry->name = NULL;
+	free_entry_name(entry);
 
 	if(entry->origin != &view->curr_dir[0])
 	{
-		free(entry->origin);
+		if(entry->origin_pooled)
+		{
+			str_pool_free(entry->origin);
+		}
+		else
+		{
+			free(entry->origin);
+		}
 		entry->origin = NULL;
 	}
 }
 
+/* Frees name of the entry taking into account where it was allocated. */
+static void
+free_entry_name(dir_entry_t *entry)
+{
+	if(entry->name_pooled)
+	{
+		str_pool_free(entry->name);
+	}
+	else
+	{
+		free(entry->name);
+	}
+	entry->name = NULL;
+}
+
 int
 add_dir_entry(dir_entry_t **list, size_t *list_size, const dir_entry_t *entry)
 {
@@ -3219,7 +3722,14 @@ fentry_rename(dir_entry_t *entry, const char to[])
 	/* Rename file in internal structures for correct positioning of cursor
 	 * after reloading, as cursor will be positioned on the file with the same
 	 * name. */
-	(void)replace_string(&entry->name, to);
+	char *const new_name = str_pool_dup(to);
+
+	if(new_name != NULL)
+	{
+		free_entry_name(entry);
+		entry->name = new_name;
+		entry->name_pooled = 1;
+	}
 	/* Name change can affect name specific highlight, so reset the cache. */
 	entry->hi_num = -1;
 }
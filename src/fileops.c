@@ -23,6 +23,7 @@
 
 #include <fcntl.h>
 #include <sys/stat.h> /* stat */
+#include <sys/time.h> /* gettimeofday() timeval */
 #include <sys/types.h> /* waitpid() */
 #ifdef _WIN32
 #include <windows.h>
@@ -43,8 +44,10 @@
 #include "cfg/config.h"
 #include "compat/fs_limits.h"
 #include "compat/os.h"
+#include "compat/reallocarray.h"
 #include "int/vim.h"
 #include "io/ioeta.h"
+#include "io/iojournal.h"
 #include "io/ionotif.h"
 #include "modes/dialogs/msg_dialog.h"
 #include "modes/cmdline.h"
@@ -53,6 +56,7 @@
 #include "ui/fileview.h"
 #include "ui/statusbar.h"
 #include "ui/ui.h"
+#include "utils/dirsize.h"
 #ifdef _WIN32
 #include "utils/env.h"
 #endif
@@ -83,6 +87,10 @@
 /* Key used to switch to progress dialog. */
 #define IO_DETAILS_KEY 'i'
 
+/* Minimal interval in milliseconds over which rate of background operation is
+ * computed. */
+#define RATE_INTERVAL_MS 1000
+
 /* What to do with rename candidate name (old name and new name). */
 typedef enum
 {
@@ -118,6 +126,9 @@ typedef struct
 	int dialog;
 
 	int width; /* Maximum reached width of the dialog. */
+
+	uint64_t rate_bytes; /* Number of processed bytes at rate_time. */
+	uint64_t rate_time;  /* Start of interval of rate computation in ms. */
 }
 progress_data_t;
 
@@ -129,6 +140,8 @@ typedef struct
 	int force;
 	char **sel_list;
 	size_t sel_list_len;
+	/* Full destination paths of elements of sel_list for copying/moving. */
+	char **dsts;
 	char path[PATH_MAX];
 	int from_file;
 	int use_trash; /* Whether either source or destination is trash directory. */
@@ -148,6 +161,8 @@ static int calc_io_progress(const io_progress_t *const state, int *skip);
 static void io_progress_fg(const io_progress_t *const state, int progress);
 static void io_progress_fg_sb(const io_progress_t *const state, int progress);
 static void io_progress_bg(const io_progress_t *const state, int progress);
+static void update_rate(progress_data_t *pdata, const ioeta_estim_t *estim);
+static uint64_t get_time_ms(void);
 static char * format_file_progress(const ioeta_estim_t *estim, int precision);
 static void format_pretty_path(const char base_dir[], const char path[],
 		char pretty[], size_t pretty_size);
@@ -175,6 +190,8 @@ static void put_confirm_cb(const char dest_name[]);
 static void prompt_what_to_do(const char src_name[]);
 static void handle_prompt_response(const char fname[], char response);
 static void put_files_in_bg(bg_op_t *bg_op, void *arg);
+static int put_file_in_bg(ops_t *ops, OPS op, size_t index, const char src[],
+		const char dst[]);
 TSTATIC const char * gen_clone_name(const char normal_name[]);
 static char ** grab_marked_files(FileView *view, size_t *nmarked);
 static int clone_file(const dir_entry_t *entry, const char path[],
@@ -212,8 +229,19 @@ static ops_t * get_bg_ops(OPS main_op, const char descr[], const char dir[],
 		bg_op_t *bg_op);
 static progress_data_t * alloc_progress_data(int bg, void *info);
 static void free_ops(ops_t *ops);
-static void cpmv_file_in_bg(ops_t *ops, const char src[], const char dst[],
-		int move, int force, int from_trash, const char dst_dir[]);
+static int make_bg_dsts(bg_args_t *args);
+static char * get_bg_dst(const bg_args_t *args, size_t index);
+static int cpmv_file_in_bg(ops_t *ops, size_t index, const char src[],
+		const char dst[], int move, int from_trash);
+static void start_journal(ops_t *ops, int move, int force, const char dir[],
+		char *srcs[], char *dsts[], size_t count);
+static void mark_started(ops_t *ops, size_t index);
+static void mark_done(ops_t *ops, size_t index);
+static void finish_journal(ops_t *ops);
+static char * get_journal_dir(void);
+static int start_resumption(iojournal_t *journal);
+static void resume_files_in_bg(bg_op_t *bg_op, void *arg);
+TSTATIC int resume_item(ops_t *ops, iojournal_t *journal, size_t index);
 static int mv_file(const char src[], const char src_dir[], const char dst[],
 		const char dst_dir[], OPS op, int cancellable, ops_t *ops);
 static int mv_file_f(const char src[], const char dst[], OPS op, int bg,
@@ -235,6 +263,10 @@ static void update_dir_entry_size(const FileView *view, int index, int force);
 static void start_dir_size_calc(const char path[], int force);
 static void dir_size_bg(bg_op_t *bg_op, void *arg);
 static void dir_size(char path[], int force);
+static int get_cached_dir_size(const char path[], uint64_t *size, void *arg);
+static void cache_dir_size(const char path[], const dirsize_stats_t *stats,
+		void *arg);
+static int dir_size_progress(const dirsize_stats_t *stats, void *arg);
 static void redraw_after_path_change(FileView *view, const char path[]);
 
 /* Temporary storage for extension of file being renamed in name-only mode. */
@@ -514,9 +546,40 @@ io_progress_bg(const io_progress_t *const state, int progress)
 	bg_op_t *const bg_op = pdata->bg_op;
 
 	bg_op->progress = progress/IO_PRECISION;
+	update_rate(pdata, estim);
 	bg_op_changed(bg_op);
 }
 
+/* Recomputes rate of background operation once in a while. */
+static void
+update_rate(progress_data_t *pdata, const ioeta_estim_t *estim)
+{
+	const uint64_t now = get_time_ms();
+	const uint64_t elapsed = now - pdata->rate_time;
+
+	if(elapsed < RATE_INTERVAL_MS)
+	{
+		return;
+	}
+
+	/* Amount of processed data can go down on moving to the next stage. */
+	pdata->bg_op->rate = (estim->current_byte < pdata->rate_bytes)
+	                   ? 0U
+	                   : (estim->current_byte - pdata->rate_bytes)*1000U/elapsed;
+
+	pdata->rate_bytes = estim->current_byte;
+	pdata->rate_time = now;
+}
+
+/* Retrieves current time.  Returns the time in milliseconds. */
+static uint64_t
+get_time_ms(void)
+{
+	struct timeval tv;
+	(void)gettimeofday(&tv, NULL);
+	return (uint64_t)tv.tv_sec*1000U + tv.tv_usec/1000;
+}
+
 /* Formats file progress part of the progress message.  Returns pointer to newly
  * allocated memory. */
 static char *
@@ -2261,38 +2324,54 @@ put_files_in_bg(bg_op_t *bg_op, void *arg)
 		}
 	}
 
+	start_journal(ops, args->move, 0, args->path, args->sel_list, args->list,
+			args->sel_list_len);
+
 	for(i = 0U; i < args->sel_list_len; ++i, ++bg_op->done)
 	{
-		struct stat src_st;
 		const char *const src = args->sel_list[i];
-		const char *const dst = args->list[i];
-
-		if(paths_are_equal(src, dst))
+		bg_op_set_descr(bg_op, src);
+		if(put_file_in_bg(ops, op, i, src, args->list[i]) == 0)
 		{
-			/* Just ignore this file. */
-			continue;
+			mark_done(ops, i);
 		}
+	}
 
-		if(os_lstat(src, &src_st) != 0)
-		{
-			/* File isn't there, assume that it's fine and don't error in this
-			 * case. */
-			continue;
-		}
+	finish_journal(ops);
+	free_ops(ops);
+	free_bg_args(args);
+}
 
-		if(path_exists(dst, NODEREF))
-		{
-			/* This file wasn't here before (when checking in put_files_bg()), won't
-			 * overwrite. */
-			continue;
-		}
+/* Puts single file in background.  Returns zero if the file was put or
+ * skipped, otherwise non-zero is returned. */
+static int
+put_file_in_bg(ops_t *ops, OPS op, size_t index, const char src[],
+		const char dst[])
+{
+	struct stat src_st;
 
-		bg_op_set_descr(bg_op, src);
-		(void)perform_operation(op, ops, (void *)1, src, dst);
+	if(paths_are_equal(src, dst))
+	{
+		/* Just ignore this file. */
+		return 0;
 	}
 
-	free_ops(ops);
-	free_bg_args(args);
+	if(os_lstat(src, &src_st) != 0)
+	{
+		/* File isn't there, assume that it's fine and don't error in this
+		 * case. */
+		return 0;
+	}
+
+	if(path_exists(dst, NODEREF))
+	{
+		/* This file wasn't here before (when checking in put_files_bg()), won't
+		 * overwrite. */
+		return 0;
+	}
+
+	mark_started(ops, index);
+	return perform_operation(op, ops, (void *)1, src, dst);
 }
 
 TSTATIC const char *
@@ -3365,6 +3444,7 @@ get_ops(OPS main_op, const char descr[], const char base_dir[],
 	if(cfg.use_system_calls)
 	{
 		ops->estim = ioeta_alloc(alloc_progress_data(0, ops));
+		ops_stream_eta(ops);
 	}
 	return ops;
 }
@@ -3407,6 +3487,14 @@ cpmv_files_bg(FileView *view, char **list, int nlines, int move, int force)
 
 	general_prepare_for_bg_task(view, args);
 
+	/* Processing only some of the files isn't an option, so fail early. */
+	if(make_bg_dsts(args) != 0)
+	{
+		free_bg_args(args);
+		show_error_msg("Memory Error", "Unable to allocate enough memory");
+		return 0;
+	}
+
 	if(bg_execute(task_desc, "...", args->sel_list_len, 1, &cpmv_files_in_bg,
 				args) != 0)
 	{
@@ -3665,16 +3753,22 @@ cpmv_files_in_bg(bg_op_t *bg_op, void *arg)
 		}
 	}
 
+	start_journal(ops, args->move, !args->use_trash, args->path, args->sel_list,
+			args->dsts, args->sel_list_len);
+
 	for(i = 0U; i < args->sel_list_len; ++i)
 	{
 		const char *const src = args->sel_list[i];
-		const char *const dst = custom_fnames ? args->list[i] : NULL;
 		bg_op_set_descr(bg_op, src);
-		cpmv_file_in_bg(ops, src, dst, args->move, args->force, args->use_trash,
-				args->path);
+		if(cpmv_file_in_bg(ops, i, src, args->dsts[i], args->move,
+					args->use_trash) == 0)
+		{
+			mark_done(ops, i);
+		}
 		++bg_op->done;
 	}
 
+	finish_journal(ops);
 	free_ops(ops);
 	free_bg_args(args);
 }
@@ -3696,6 +3790,7 @@ get_bg_ops(OPS main_op, const char descr[], const char dir[], bg_op_t *bg_op)
 	ops = ops_alloc(main_op, 1, descr, dir, dir);
 	pdata = alloc_progress_data(1, bg_op);
 	ops->estim = ioeta_alloc(pdata);
+	ops_stream_eta(ops);
 
 	return ops;
 }
@@ -3715,6 +3810,9 @@ alloc_progress_data(int bg, void *info)
 	pdata->dialog = 0;
 	pdata->width = 0;
 
+	pdata->rate_bytes = 0U;
+	pdata->rate_time = get_time_ms();
+
 	return pdata;
 }
 
@@ -3745,16 +3843,44 @@ free_ops(ops_t *ops)
 	ops_free(ops);
 }
 
-/* Actual implementation of background file copying/moving. */
-static void
-cpmv_file_in_bg(ops_t *ops, const char src[], const char dst[], int move,
-		int force, int from_trash, const char dst_dir[])
+/* Fills dsts field of the args with full destination paths, which are needed
+ * to be able to resume the operation.  Returns zero on success, otherwise
+ * non-zero is returned and the field is left unset. */
+static int
+make_bg_dsts(bg_args_t *args)
+{
+	size_t i;
+	char **const dsts = calloc(args->sel_list_len, sizeof(*dsts));
+	if(dsts == NULL && args->sel_list_len != 0U)
+	{
+		return 1;
+	}
+
+	for(i = 0U; i < args->sel_list_len; ++i)
+	{
+		dsts[i] = get_bg_dst(args, i);
+		if(dsts[i] == NULL)
+		{
+			free_string_array(dsts, i);
+			return 1;
+		}
+	}
+
+	args->dsts = dsts;
+	return 0;
+}
+
+/* Forms full destination path for an item of background copying/moving.
+ * Returns newly allocated string or NULL on error. */
+static char *
+get_bg_dst(const bg_args_t *args, size_t index)
 {
-	char dst_full[PATH_MAX];
+	const char *const src = args->sel_list[index];
+	const char *dst = (args->nlines > 0) ? args->list[index] : NULL;
 
 	if(dst == NULL)
 	{
-		if(from_trash)
+		if(args->use_trash)
 		{
 			dst = get_real_name_from_trash_name(src);
 		}
@@ -3764,20 +3890,297 @@ cpmv_file_in_bg(ops_t *ops, const char src[], const char dst[], int move,
 		}
 	}
 
-	snprintf(dst_full, sizeof(dst_full), "%s/%s", dst_dir, dst);
-	if(path_exists(dst_full, DEREF) && !from_trash)
+	return format_str("%s/%s", args->path, dst);
+}
+
+/* Actual implementation of background file copying/moving.  Returns zero on
+ * success, otherwise non-zero is returned. */
+static int
+cpmv_file_in_bg(ops_t *ops, size_t index, const char src[], const char dst[],
+		int move, int from_trash)
+{
+	if(!from_trash)
 	{
-		(void)perform_operation(OP_REMOVESL, NULL, (void *)1, dst_full, NULL);
+		if(path_exists(dst, DEREF))
+		{
+			(void)perform_operation(OP_REMOVESL, NULL, (void *)1, dst, NULL);
+		}
+		if(ops != NULL)
+		{
+			iojournal_item_cleared(ops->journal, index);
+		}
 	}
 
+	mark_started(ops, index);
 	if(move)
 	{
-		(void)mv_file_f(src, dst_full, OP_MOVE, 1, 0, ops);
+		return mv_file_f(src, dst, OP_MOVE, 1, 0, ops);
 	}
-	else
+	return cp_file_f(src, dst, CMLO_COPY, 1, 0, ops);
+}
+
+/* Starts journal of background operation, so that it can be resumed if vifm
+ * exits before the operation is finished.  ops can be NULL. */
+static void
+start_journal(ops_t *ops, int move, int force, const char dir[], char *srcs[],
+		char *dsts[], size_t count)
+{
+	char *journal_dir;
+
+	if(ops == NULL)
+	{
+		return;
+	}
+
+	journal_dir = get_journal_dir();
+	ops->journal = iojournal_create(journal_dir, move ? IOJ_MOVE : IOJ_COPY,
+			force, dir, srcs, dsts, count);
+	free(journal_dir);
+}
+
+/* Records that destination of item of journaled operation is about to be
+ * written.  ops can be NULL. */
+static void
+mark_started(ops_t *ops, size_t index)
+{
+	if(ops != NULL)
+	{
+		iojournal_item_started(ops->journal, index);
+	}
+}
+
+/* Records that item of journaled operation doesn't need to be processed
+ * anymore.  ops can be NULL. */
+static void
+mark_done(ops_t *ops, size_t index)
+{
+	if(ops != NULL)
+	{
+		iojournal_item_done(ops->journal, index);
+	}
+}
+
+/* Removes journal of finished operation.  ops can be NULL. */
+static void
+finish_journal(ops_t *ops)
+{
+	if(ops != NULL)
+	{
+		iojournal_close(ops->journal, 1);
+		ops->journal = NULL;
+	}
+}
+
+/* Retrieves path to directory with journals of background operations.  Returns
+ * newly allocated string. */
+static char *
+get_journal_dir(void)
+{
+	return format_str("%s/journal", cfg.config_dir);
+}
+
+void
+resume_bg_ops(void)
+{
+	char **paths;
+	int npaths;
+	int i;
+	iojournal_t **journals = NULL;
+	int njournals = 0;
+	char *journal_dir;
+
+	if(!cfg.use_system_calls)
+	{
+		return;
+	}
+
+	journal_dir = get_journal_dir();
+	paths = iojournal_list(journal_dir, &npaths);
+	free(journal_dir);
+
+	for(i = 0; i < npaths; ++i)
+	{
+		/* Journals that can't be loaded are either broken or used by another
+		 * instance, leave them alone. */
+		iojournal_t *const journal = iojournal_load(paths[i]);
+		if(journal == NULL)
+		{
+			continue;
+		}
+
+		if(journal->nitems == 0U)
+		{
+			iojournal_close(journal, 1);
+			continue;
+		}
+
+		{
+			void *const p = reallocarray(journals, njournals + 1, sizeof(*journals));
+			if(p == NULL)
+			{
+				iojournal_close(journal, 0);
+				continue;
+			}
+			journals = p;
+			journals[njournals++] = journal;
+		}
+	}
+	free_string_array(paths, npaths);
+
+	if(njournals != 0)
+	{
+		char msg[128];
+		int resume;
+
+		snprintf(msg, sizeof(msg), "%d background operation%s %s interrupted by "
+				"exit of vifm.  Resume %s?", njournals, (njournals == 1) ? "" : "s",
+				(njournals == 1) ? "was" : "were", (njournals == 1) ? "it" : "them");
+		resume = prompt_msg("Interrupted operations", msg);
+
+		for(i = 0; i < njournals; ++i)
+		{
+			if(!resume)
+			{
+				iojournal_close(journals[i], 1);
+			}
+			else if(start_resumption(journals[i]) != 0)
+			{
+				iojournal_close(journals[i], 0);
+			}
+		}
+	}
+
+	free(journals);
+}
+
+/* Starts background task that finishes interrupted operation.  Returns zero on
+ * success, otherwise non-zero is returned. */
+static int
+start_resumption(iojournal_t *journal)
+{
+	char task_desc[COMMAND_GROUP_INFO_LEN];
+	int pending = 0;
+	size_t i;
+
+	for(i = 0U; i < journal->nitems; ++i)
+	{
+		pending += !journal->items[i].done;
+	}
+
+	snprintf(task_desc, sizeof(task_desc), "Resume %s to %s",
+			(journal->op == IOJ_MOVE) ? "moving" : "copying",
+			replace_home_part(journal->target_dir));
+
+	if(bg_execute(task_desc, "...", pending, 1, &resume_files_in_bg,
+				journal) != 0)
+	{
+		show_error_msg("Can't process files",
+				"Failed to initiate background operation");
+		return 1;
+	}
+	return 0;
+}
+
+/* Entry point of a background task that finishes interrupted operation. */
+static void
+resume_files_in_bg(bg_op_t *bg_op, void *arg)
+{
+	iojournal_t *const journal = arg;
+	const int move = (journal->op == IOJ_MOVE);
+	size_t i;
+	ops_t *ops;
+
+	ops = get_bg_ops(move ? OP_MOVE : OP_COPY, move ? "moving" : "copying",
+			journal->target_dir, bg_op);
+
+	if(ops != NULL)
+	{
+		bg_op_set_descr(bg_op, "estimating...");
+		for(i = 0U; i < journal->nitems; ++i)
+		{
+			if(!journal->items[i].done)
+			{
+				ops_enqueue(ops, journal->items[i].src, journal->items[i].dst);
+			}
+		}
+		ops->journal = journal;
+	}
+
+	for(i = 0U; i < journal->nitems; ++i)
+	{
+		if(journal->items[i].done)
+		{
+			continue;
+		}
+
+		bg_op_set_descr(bg_op, journal->items[i].src);
+		if(resume_item(ops, journal, i) == 0)
+		{
+			iojournal_item_done(journal, i);
+		}
+		++bg_op->done;
+	}
+
+	free_ops(ops);
+	iojournal_close(journal, 1);
+}
+
+/* Finishes processing of an item of interrupted operation reusing whatever was
+ * already done.  Destination is continued only if the item was started, so
+ * files that existed before aren't mistaken for partial copies.  Returns zero
+ * on success, otherwise non-zero is returned. */
+TSTATIC int
+resume_item(ops_t *ops, iojournal_t *journal, size_t index)
+{
+	const iojournal_item_t *const item = &journal->items[index];
+	struct stat st;
+
+	if(os_lstat(item->src, &st) != 0)
+	{
+		/* Source is gone, which most likely means that it was moved completely or
+		 * removed by someone, nothing to do in both cases. */
+		return 0;
+	}
+
+	if(!item->started)
+	{
+		/* Nothing was written to the destination, so whatever is there isn't a
+		 * partial copy and is treated the way interrupted operation would. */
+		if(journal->force)
+		{
+			if(path_exists(item->dst, NODEREF))
+			{
+				(void)perform_operation(OP_REMOVESL, NULL, (void *)1, item->dst, NULL);
+			}
+			iojournal_item_cleared(journal, index);
+		}
+		else if(path_exists(item->dst, NODEREF))
+		{
+			return 0;
+		}
+
+		iojournal_item_started(journal, index);
+		return perform_operation((journal->op == IOJ_MOVE) ? OP_MOVE : OP_COPY,
+				ops, (void *)1, item->src, item->dst);
+	}
+
+	if(journal->op == IOJ_MOVE && !path_exists(item->dst, NODEREF))
 	{
-		(void)cp_file_f(src, dst_full, CMLO_COPY, 1, 0, ops);
+		return perform_operation(OP_MOVE, ops, (void *)1, item->src, item->dst);
+	}
+
+	/* Copying of the rest of files skips complete files and appends to partially
+	 * copied ones. */
+	if(perform_operation(OP_COPYA, ops, (void *)1, item->src, item->dst) != 0)
+	{
+		return 1;
 	}
+
+	if(journal->op == IOJ_MOVE)
+	{
+		return perform_operation(OP_REMOVESL, ops, (void *)1, item->src, NULL);
+	}
+	return 0;
 }
 
 /* Adapter for mv_file_f() that accepts paths broken into directory/file
@@ -3897,6 +4300,7 @@ static void
 free_bg_args(bg_args_t *args)
 {
 	free_string_array(args->list, args->nlines);
+	free_string_array(args->dsts, args->sel_list_len);
 	free_string_array(args->sel_list, args->sel_list_len);
 	free(args);
 }
@@ -4307,59 +4711,55 @@ dir_size(char path[], int force)
 	redraw_after_path_change(&rwin, path);
 }
 
-/* Calculates size of a directory possibly using cache of known sizes.  Returns
- * size of a directory or zero on error. */
 uint64_t
 calculate_dir_size(const char path[], int force_update)
 {
-	DIR* dir;
-	struct dirent* dentry;
-	const char* slash = "";
-	uint64_t size;
+	dirsize_stats_t stats;
+	char parent[PATH_MAX];
+	const dirsize_params_t params = {
+		.count_links = 1,
+		.get_cached = force_update ? NULL : &get_cached_dir_size,
+		.dir_done = &cache_dir_size,
+		.progress = &dir_size_progress,
+		.arg = parent,
+	};
 
-	dir = os_opendir(path);
-	if(dir == NULL)
-	{
-		return 0;
-	}
+	copy_str(parent, sizeof(parent), path);
+	remove_last_path_component(parent);
 
-	if(!ends_with_slash(path))
+	if(dirsize_calc(path, &params, &stats) != 0)
 	{
-		slash = "/";
+		return 0;
 	}
+	return stats.bytes;
+}
 
-	size = 0;
-	while((dentry = os_readdir(dir)) != NULL)
-	{
-		char full_path[PATH_MAX];
-
-		if(is_builtin_dir(dentry->d_name))
-		{
-			continue;
-		}
-
-		snprintf(full_path, sizeof(full_path), "%s%s%s", path, slash,
-				dentry->d_name);
-		if(is_dir_entry(full_path, dentry))
-		{
-			uint64_t dir_size;
-			dcache_get_at(full_path, &dir_size, NULL);
-			if(dir_size == DCACHE_UNKNOWN || force_update)
-			{
-				dir_size = calculate_dir_size(full_path, force_update);
-			}
-			size += dir_size;
-		}
-		else
-		{
-			size += get_file_size(full_path);
-		}
-	}
+/* Implementation of dirsize_params_t::get_cached callback that queries dcache
+ * for size of a directory.  Returns non-zero if the size is known. */
+static int
+get_cached_dir_size(const char path[], uint64_t *size, void *arg)
+{
+	dcache_get_at(path, size, NULL);
+	return *size != DCACHE_UNKNOWN;
+}
 
-	os_closedir(dir);
+/* Implementation of dirsize_params_t::dir_done callback that stores size of a
+ * directory in dcache as soon as it's known. */
+static void
+cache_dir_size(const char path[], const dirsize_stats_t *stats, void *arg)
+{
+	(void)dcache_set_at(path, stats->bytes, DCACHE_UNKNOWN);
+}
 
-	(void)dcache_set_at(path, size, DCACHE_UNKNOWN);
-	return size;
+/* Implementation of dirsize_params_t::progress callback that makes views
+ * display sizes calculated so far.  Returns zero. */
+static int
+dir_size_progress(const dirsize_stats_t *stats, void *arg)
+{
+	const char *const parent = arg;
+	redraw_after_path_change(&lwin, parent);
+	redraw_after_path_change(&rwin, parent);
+	return 0;
 }
 
 /* Schedules view redraw in case path change might have affected it. */
@@ -27,6 +27,7 @@
 #include <stdint.h> /* uint64_t */
 
 #include "ui/ui.h"
+#include "ops.h"
 #include "utils/test_helpers.h"
 
 /* Type of reaction on an error. */
@@ -132,6 +133,11 @@ int cpmv_files(FileView *view, char **list, int nlines, CopyMoveLikeOp op,
  * value for save_msg flag. */
 int cpmv_files_bg(FileView *view, char **list, int nlines, int move, int force);
 
+/* Offers to resume background copying/moving/putting of files that was
+ * interrupted by exit of vifm (journals are kept in configuration
+ * directory). */
+void resume_bg_ops(void);
+
 /* Can modify strings in the names array. */
 void make_dirs(FileView *view, char **names, int count, int create_parent);
 
@@ -160,6 +166,7 @@ TSTATIC_DEFS(
 	const char * gen_clone_name(const char normal_name[]);
 	int is_name_list_ok(int count, int nlines, char *list[], char *files[]);
 	const char * incdec_name(const char fname[], int k);
+	int resume_item(ops_t *ops, iojournal_t *journal, size_t index);
 )
 
 #endif /* VIFM__FILEOPS_H__ */
@@ -23,6 +23,8 @@
 
 #include "ioe.h"
 #include "ioeta.h"
+#include "iojournal.h"
+#include "iothrottle.h"
 
 /* ioc - I/O common - Input/Output common */
 
@@ -45,6 +47,15 @@ typedef enum
 }
 IoCrs;
 
+/* Verification of copies of files. */
+typedef enum
+{
+	IO_VERIFY_NONE,   /* Don't verify copies. */
+	IO_VERIFY_FAST,   /* Compare fast non-cryptographic hashes (XXH64). */
+	IO_VERIFY_SHA256, /* Compare SHA-256 hashes. */
+}
+IoVerify;
+
 /* Forward declaration for io_confirm. */
 typedef struct io_args_t io_args_t;
 
@@ -111,9 +122,28 @@ struct io_args_t
 	 * overwrite. */
 	io_confirm confirm;
 
+	/* Maximum number of files of a subtree to copy or directories to remove
+	 * concurrently.  Values less than two mean sequential processing. */
+	int nworkers;
+
+	/* Whether copies of files should be checked to be bit-exact.  Data is hashed
+	 * while it's copied and then compared with hash of data read back from the
+	 * destination, mismatches are reported as errors.  Ignored on Windows. */
+	IoVerify verify;
+
 	/* Set to NULL to do not use estimates. */
 	ioeta_estim_t *estim;
 
+	/* Journal of the operation, to which offsets of data known to be on disk are
+	 * recorded.  On appending to files of a resumed operation complete files are
+	 * skipped and partial ones are continued from verified offsets.  Set to NULL
+	 * to do not journal. */
+	iojournal_t *journal;
+
+	/* Rate limiter charged for data and file operations, which can block for
+	 * them to fit into the limits.  Set to NULL to do not limit the rate. */
+	iothrottle_t *throttle;
+
 	/* Output of the operation after it finishes. */
 	io_result_t result;
 };
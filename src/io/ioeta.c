@@ -18,17 +18,29 @@
 
 #include "ioeta.h"
 
-#include <assert.h> /* assert() */
 #include <stddef.h> /* NULL size_t */
 #include <stdint.h> /* uint64_t */
 #include <stdlib.h> /* calloc() free() */
 
 #include "../ui/cancellation.h"
+#include "../utils/dirsize.h"
+#include "../utils/fs.h"
 #include "private/ioeta.h"
-#include "private/traverser.h"
+#include "private/ionotif.h"
+#include "private/walker.h"
 
-static VisitResult eta_visitor(const char full_path[], VisitAction action,
-		void *param);
+/* Argument of dirsize callbacks. */
+typedef struct
+{
+	ioeta_estim_t *estim; /* Estimation to update. */
+	size_t base_items;    /* Value of estim->total_items before calculation. */
+	uint64_t base_bytes;  /* Value of estim->total_bytes before calculation. */
+}
+eta_state_t;
+
+static void calculate_subtree(ioeta_estim_t *estim, const char path[]);
+static int eta_progress(const dirsize_stats_t *stats, void *arg);
+static void update_estim(eta_state_t *state, const dirsize_stats_t *stats);
 
 ioeta_estim_t *
 ioeta_alloc(void *param)
@@ -43,6 +55,7 @@ ioeta_free(ioeta_estim_t *estim)
 {
 	if(estim != NULL)
 	{
+		walker_free(estim->walker);
 		free(estim->item);
 		free(estim->target);
 		free(estim);
@@ -52,42 +65,85 @@ ioeta_free(ioeta_estim_t *estim)
 void
 ioeta_calculate(ioeta_estim_t *estim, const char path[], int shallow)
 {
+	if(shallow)
+	{
+		estim->shallow = 1;
+	}
+
+	if(estim->walker != NULL && walker_add(estim->walker, path, shallow) == 0)
+	{
+		return;
+	}
+
 	if(shallow)
 	{
 		ioeta_add_item(estim, path);
 	}
+	else if(is_symlink(path) || !is_dir(path))
+	{
+		/* Treat symbolic links to directories as files as well. */
+		ioeta_add_file(estim, path);
+	}
 	else
 	{
-		(void)traverse(path, &eta_visitor, estim);
+		calculate_subtree(estim, path);
 	}
 }
 
-/* Implementation of traverse() visitor for subtree copying.  Returns 0 on
- * success, otherwise non-zero is returned. */
-static VisitResult
-eta_visitor(const char full_path[], VisitAction action, void *param)
+void
+ioeta_stream(ioeta_estim_t *estim, int keep_listings)
 {
-	ioeta_estim_t *const estim = param;
-
-	if(ui_cancellation_requested())
+	if(estim->walker == NULL)
 	{
-		return VR_CANCELLED;
+		estim->walker = walker_create(keep_listings, estim->total_items,
+				estim->total_bytes);
 	}
+}
 
-	switch(action)
-	{
-		case VA_DIR_ENTER:
-			ioeta_add_dir(estim, full_path);
-			return VR_SKIP_DIR_LEAVE;
-		case VA_FILE:
-			ioeta_add_file(estim, full_path);
-			return VR_OK;
-		case VA_DIR_LEAVE:
-			assert(0 && "Can't get here because of VR_SKIP_DIR_LEAVE.");
-			return VR_OK;
-	}
+/* Calculates estimates for a directory traversing it in parallel. */
+static void
+calculate_subtree(ioeta_estim_t *estim, const char path[])
+{
+	dirsize_stats_t stats;
+	eta_state_t state = {
+		.estim = estim,
+		.base_items = estim->total_items,
+		.base_bytes = estim->total_bytes,
+	};
+	const dirsize_params_t params = {
+		.count_links = 0,
+		.data_only = 1,
+		.progress = &eta_progress,
+		.arg = &state,
+	};
+
+	ioeta_add_dir(estim, path);
+
+	(void)dirsize_calc(path, &params, &stats);
+
+	update_estim(&state, &stats);
+	ionotif_notify(IO_PS_ESTIMATING, estim);
+}
+
+/* Implementation of dirsize_params_t::progress callback that reports estimates
+ * calculated so far.  Returns non-zero to cancel calculation. */
+static int
+eta_progress(const dirsize_stats_t *stats, void *arg)
+{
+	eta_state_t *const state = arg;
+
+	update_estim(state, stats);
+	ionotif_notify(IO_PS_ESTIMATING, state->estim);
 
-	return VR_OK;
+	return ui_cancellation_requested();
+}
+
+/* Sets totals of the estimation from statistics of the subtree. */
+static void
+update_estim(eta_state_t *state, const dirsize_stats_t *stats)
+{
+	state->estim->total_items = state->base_items + stats->nfiles;
+	state->estim->total_bytes = state->base_bytes + stats->bytes;
 }
 
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
@@ -61,6 +61,14 @@ typedef struct
 
 	/* Custom parameter for notification callbacks. */
 	void *param;
+
+	/* Calculates estimates in background, NULL when they are calculated in
+	 * place. */
+	struct walker_t *walker;
+
+	/* Whether estimation didn't recur into directories.  Operations that list
+	 * directories anyway add what they find to totals in this case. */
+	int shallow;
 }
 ioeta_estim_t;
 
@@ -75,6 +83,13 @@ void ioeta_free(ioeta_estim_t *estim);
  * directories. */
 void ioeta_calculate(ioeta_estim_t *estim, const char path[], int shallow);
 
+/* Makes subsequent ioeta_calculate() calls return immediately and calculate
+ * estimates in background, totals are refined as operation progresses.  When
+ * keep_listings is non-zero, operations reuse subtree listings made by
+ * estimation instead of traversing the same subtrees again.  Does nothing if
+ * background thread can't be started. */
+void ioeta_stream(ioeta_estim_t *estim, int keep_listings);
+
 #endif /* VIFM__IO__IOETA_H__ */
 
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
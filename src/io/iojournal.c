@@ -0,0 +1,767 @@
+/* vifm
+ * Copyright (C) 2026 agent.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "iojournal.h"
+
+#include <pthread.h> /* PTHREAD_* pthread_* */
+#ifndef _WIN32
+#include <sys/file.h> /* LOCK_* flock() */
+#endif
+#include <sys/stat.h> /* stat */
+#include <sys/types.h> /* off_t */
+#include <fcntl.h> /* O_* open() */
+#include <unistd.h> /* close() fsync() ftruncate() getpid() read() truncate()
+                       unlink() write() */
+
+#include <errno.h> /* EEXIST EINTR errno */
+#include <stddef.h> /* NULL size_t */
+#include <stdint.h> /* uint64_t */
+#include <stdio.h> /* snprintf() */
+#include <stdlib.h> /* calloc() free() malloc() realloc() strtoull() */
+#include <string.h> /* memchr() memcpy() strcmp() strdup() strlen() */
+#include <time.h> /* time() */
+
+#include "../compat/os.h"
+#include "../compat/reallocarray.h"
+#include "../utils/fs.h"
+#include "../utils/macros.h"
+#include "../utils/str.h"
+#include "../utils/trie.h"
+
+/* Version of format of journal files. */
+#define FORMAT_VERSION "1"
+
+/* Maximum number of fields in a record. */
+#define MAX_FIELDS 4
+
+/* Record types.  Each record is a type character followed by fields, each of
+ * which ends with a null character, and a newline. */
+#define REC_HEADER  'V' /* Version, operation, force flag, target directory. */
+#define REC_ITEM    'I' /* Source and destination paths of an item. */
+#define REC_CLEARED 'C' /* Index of item, whose destination was removed. */
+#define REC_STARTED 'S' /* Index of item, whose destination is being written. */
+#define REC_DONE    'D' /* Index of processed item. */
+#define REC_OFFSET  'O' /* Path of destination file and its verified size. */
+
+/* Private part of the journal. */
+struct iojournal_file_t
+{
+	char *path;           /* Path to the file. */
+	int fd;               /* Descriptor of the file opened for appending. */
+	pthread_mutex_t lock; /* Serializes writes to the file. */
+	trie_t offsets;       /* Verified offsets of files of resumed operation. */
+};
+
+/* Dynamically growing buffer for records. */
+typedef struct
+{
+	char *data; /* Contents of the buffer. */
+	size_t len; /* Length of the contents. */
+	int failed; /* Whether allocation failed. */
+}
+buf_t;
+
+static iojournal_t * alloc_journal(const char path[], int fd);
+static int open_new_file(const char dir[], char **path);
+static int lock_file(int fd);
+static void put_record(buf_t *buf, char type, const char *fields[], int count);
+static int write_record(iojournal_t *journal, char type, const char *fields[],
+		int count, int sync);
+static int write_all(int fd, const char data[], size_t len, int sync);
+static void sync_dir(const char dir[]);
+static char * read_file(int fd, size_t *len);
+static int parse_record(const char data[], size_t len, size_t *pos, char *type,
+		const char *fields[]);
+static int apply_record(iojournal_t *journal, char type, const char *fields[],
+		int count);
+static int add_item(iojournal_t *journal, const char src[], const char dst[]);
+static iojournal_item_t * get_item(iojournal_t *journal, const char index[]);
+static uint64_t get_verified_offset(iojournal_t *journal, const char dst[]);
+
+iojournal_t *
+iojournal_create(const char dir[], IoJournalOp op, int force,
+		const char target_dir[], char *srcs[], char *dsts[], size_t count)
+{
+	size_t i;
+	char *path;
+	iojournal_t *journal;
+	buf_t buf = { .data = NULL };
+	const char *header[] = {
+		FORMAT_VERSION, (op == IOJ_MOVE) ? "move" : "copy", force ? "1" : "0",
+		target_dir
+	};
+
+	const int fd = open_new_file(dir, &path);
+	if(fd < 0)
+	{
+		return NULL;
+	}
+
+	journal = alloc_journal(path, fd);
+	free(path);
+	if(journal == NULL)
+	{
+		return NULL;
+	}
+
+	journal->op = op;
+	journal->force = force;
+	journal->target_dir = strdup(target_dir);
+
+	put_record(&buf, REC_HEADER, header, ARRAY_LEN(header));
+	for(i = 0U; i < count; ++i)
+	{
+		const char *item[] = { srcs[i], dsts[i] };
+		put_record(&buf, REC_ITEM, item, ARRAY_LEN(item));
+		if(add_item(journal, srcs[i], dsts[i]) != 0)
+		{
+			buf.failed = 1;
+			break;
+		}
+	}
+
+	/* The journal isn't usable if it's incomplete. */
+	if(journal->target_dir == NULL || buf.failed ||
+			write_all(fd, buf.data, buf.len, 1) != 0)
+	{
+		free(buf.data);
+		iojournal_close(journal, 1);
+		return NULL;
+	}
+	free(buf.data);
+
+	sync_dir(dir);
+	return journal;
+}
+
+char **
+iojournal_list(const char dir[], int *count)
+{
+	int i;
+	char **list;
+
+	*count = 0;
+	list = list_regular_files(dir, NULL, count);
+
+	for(i = 0; i < *count; ++i)
+	{
+		char *const full_path = format_str("%s/%s", dir, list[i]);
+		if(full_path != NULL)
+		{
+			free(list[i]);
+			list[i] = full_path;
+		}
+	}
+
+	return list;
+}
+
+iojournal_t *
+iojournal_load(const char path[])
+{
+	iojournal_t *journal;
+	char *data;
+	size_t len;
+	size_t pos = 0U;
+	size_t valid_len = 0U;
+	int have_header = 0;
+
+	const int fd = open(path, O_RDWR | O_APPEND);
+	if(fd < 0)
+	{
+		return NULL;
+	}
+
+	if(lock_file(fd) != 0 || (data = read_file(fd, &len)) == NULL)
+	{
+		(void)close(fd);
+		return NULL;
+	}
+
+	journal = alloc_journal(path, fd);
+	if(journal == NULL)
+	{
+		free(data);
+		return NULL;
+	}
+
+	journal->resumed = 1;
+	journal->file->offsets = trie_create();
+
+	while(pos < len)
+	{
+		char type;
+		const char *fields[MAX_FIELDS];
+		const int count = parse_record(data, len, &pos, &type, fields);
+
+		/* Records are processed until the first incomplete or unexpected one. */
+		if(count < 0 || (type == REC_HEADER) == have_header ||
+				apply_record(journal, type, fields, count) != 0)
+		{
+			break;
+		}
+
+		have_header = 1;
+		valid_len = pos;
+	}
+
+	free(data);
+
+	if(!have_header || journal->file->offsets == NULL_TRIE)
+	{
+		iojournal_close(journal, 0);
+		return NULL;
+	}
+
+	/* Drop the tail that was cut short, so that new records can be parsed. */
+	if(valid_len != len && ftruncate(fd, valid_len) != 0)
+	{
+		iojournal_close(journal, 0);
+		return NULL;
+	}
+
+	return journal;
+}
+
+void
+iojournal_item_cleared(iojournal_t *journal, size_t index)
+{
+	char index_str[32];
+	const char *fields[] = { index_str };
+
+	if(journal == NULL)
+	{
+		return;
+	}
+
+	snprintf(index_str, sizeof(index_str), "%" PRINTF_ULL,
+			(unsigned long long)index);
+	journal->items[index].cleared = 1;
+	/* Losing this record after new data is written to the destination would
+	 * make it look like a part of the copy. */
+	(void)write_record(journal, REC_CLEARED, fields, ARRAY_LEN(fields), 1);
+}
+
+void
+iojournal_item_started(iojournal_t *journal, size_t index)
+{
+	char index_str[32];
+	const char *fields[] = { index_str };
+
+	if(journal == NULL)
+	{
+		return;
+	}
+
+	snprintf(index_str, sizeof(index_str), "%" PRINTF_ULL,
+			(unsigned long long)index);
+	journal->items[index].started = 1;
+	/* Without this record resumption can't tell partial copy from a file that
+	 * existed before and must not be touched, so it must be on disk first. */
+	(void)write_record(journal, REC_STARTED, fields, ARRAY_LEN(fields), 1);
+}
+
+void
+iojournal_item_done(iojournal_t *journal, size_t index)
+{
+	char index_str[32];
+	const char *fields[] = { index_str };
+
+	if(journal == NULL)
+	{
+		return;
+	}
+
+	snprintf(index_str, sizeof(index_str), "%" PRINTF_ULL,
+			(unsigned long long)index);
+	journal->items[index].done = 1;
+	/* Losing this record just makes resumption check the item once more. */
+	(void)write_record(journal, REC_DONE, fields, ARRAY_LEN(fields), 0);
+}
+
+void
+iojournal_checkpoint(iojournal_t *journal, const char dst[], uint64_t offset)
+{
+	char offset_str[32];
+	const char *fields[] = { dst, offset_str };
+
+	if(journal == NULL)
+	{
+		return;
+	}
+
+	snprintf(offset_str, sizeof(offset_str), "%llu",
+			(unsigned long long)offset);
+	/* Data is already on disk, losing this record only makes resumption start
+	 * from an earlier offset. */
+	(void)write_record(journal, REC_OFFSET, fields, ARRAY_LEN(fields), 0);
+}
+
+int
+iojournal_resume_file(iojournal_t *journal, const char src[],
+		const char dst[])
+{
+	struct stat src_st;
+	struct stat dst_st;
+	uint64_t offset;
+
+	if(journal == NULL || !journal->resumed || os_lstat(src, &src_st) != 0 ||
+			os_lstat(dst, &dst_st) != 0)
+	{
+		return 0;
+	}
+
+	/* Links and special files are created in one step. */
+	if(!S_ISREG(src_st.st_mode))
+	{
+		return (src_st.st_mode & S_IFMT) == (dst_st.st_mode & S_IFMT);
+	}
+
+	if(!S_ISREG(dst_st.st_mode))
+	{
+		return 0;
+	}
+
+	/* Copying sets modification time after all data is written. */
+	if(dst_st.st_size == src_st.st_size && dst_st.st_mtime == src_st.st_mtime)
+	{
+		return 1;
+	}
+
+	/* Copying will report the error if there is a problem with the file. */
+	offset = MIN(get_verified_offset(journal, dst), (uint64_t)dst_st.st_size);
+	if(offset != (uint64_t)dst_st.st_size)
+	{
+		(void)truncate(dst, offset);
+	}
+	return 0;
+}
+
+void
+iojournal_close(iojournal_t *journal, int discard)
+{
+	size_t i;
+
+	if(journal == NULL)
+	{
+		return;
+	}
+
+	if(discard)
+	{
+		(void)unlink(journal->file->path);
+	}
+	/* This also releases the lock. */
+	(void)close(journal->file->fd);
+
+	for(i = 0U; i < journal->nitems; ++i)
+	{
+		free(journal->items[i].src);
+		free(journal->items[i].dst);
+	}
+	free(journal->items);
+	free(journal->target_dir);
+
+	trie_free_with_data(journal->file->offsets);
+	pthread_mutex_destroy(&journal->file->lock);
+	free(journal->file->path);
+	free(journal->file);
+	free(journal);
+}
+
+/* Allocates journal that is backed by the file.  Takes ownership of the fd,
+ * but not of the path.  Returns the journal or NULL on error. */
+static iojournal_t *
+alloc_journal(const char path[], int fd)
+{
+	iojournal_t *const journal = calloc(1U, sizeof(*journal));
+	iojournal_file_t *const file = calloc(1U, sizeof(*file));
+	char *const path_copy = strdup(path);
+
+	if(journal == NULL || file == NULL || path_copy == NULL ||
+			pthread_mutex_init(&file->lock, NULL) != 0)
+	{
+		free(path_copy);
+		free(file);
+		free(journal);
+		(void)close(fd);
+		return NULL;
+	}
+
+	file->path = path_copy;
+	file->fd = fd;
+	file->offsets = NULL_TRIE;
+	journal->file = file;
+	return journal;
+}
+
+/* Creates new locked journal file in the dir.  Sets *path to its path on
+ * success.  Returns file descriptor or -1 on error. */
+static int
+open_new_file(const char dir[], char **path)
+{
+	static int counter;
+
+	(void)make_path(dir, 0700);
+
+	while(1)
+	{
+		int fd;
+
+		*path = format_str("%s/%ld-%ld-%d", dir, (long)getpid(), (long)time(NULL),
+				++counter);
+		if(*path == NULL)
+		{
+			return -1;
+		}
+
+		fd = open(*path, O_WRONLY | O_APPEND | O_CREAT | O_EXCL, 0600);
+		if(fd >= 0)
+		{
+			if(lock_file(fd) == 0)
+			{
+				return fd;
+			}
+			(void)close(fd);
+			(void)unlink(*path);
+		}
+		else if(errno == EEXIST)
+		{
+			free(*path);
+			continue;
+		}
+
+		free(*path);
+		*path = NULL;
+		return -1;
+	}
+}
+
+/* Takes exclusive lock on the file, which protects it from being resumed by
+ * another instance while it's in use.  Returns zero on success, otherwise
+ * non-zero is returned. */
+static int
+lock_file(int fd)
+{
+#ifndef _WIN32
+	return flock(fd, LOCK_EX | LOCK_NB);
+#else
+	return 0;
+#endif
+}
+
+/* Appends record to the buffer. */
+static void
+put_record(buf_t *buf, char type, const char *fields[], int count)
+{
+	int i;
+	size_t len = 2U;
+	char *p;
+
+	if(buf->failed)
+	{
+		return;
+	}
+
+	for(i = 0; i < count; ++i)
+	{
+		len += strlen(fields[i]) + 1U;
+	}
+
+	p = realloc(buf->data, buf->len + len);
+	if(p == NULL)
+	{
+		buf->failed = 1;
+		return;
+	}
+	buf->data = p;
+
+	buf->data[buf->len++] = type;
+	for(i = 0; i < count; ++i)
+	{
+		const size_t field_len = strlen(fields[i]) + 1U;
+		memcpy(buf->data + buf->len, fields[i], field_len);
+		buf->len += field_len;
+	}
+	buf->data[buf->len++] = '\n';
+}
+
+/* Appends a record to the journal optionally waiting until it's on disk.
+ * Returns zero on success, otherwise non-zero is returned. */
+static int
+write_record(iojournal_t *journal, char type, const char *fields[], int count,
+		int sync)
+{
+	int result;
+	buf_t buf = { .data = NULL };
+
+	put_record(&buf, type, fields, count);
+	if(buf.failed)
+	{
+		free(buf.data);
+		return 1;
+	}
+
+	pthread_mutex_lock(&journal->file->lock);
+	result = write_all(journal->file->fd, buf.data, buf.len, sync);
+	pthread_mutex_unlock(&journal->file->lock);
+
+	free(buf.data);
+	return result;
+}
+
+/* Writes whole buffer to the file and optionally flushes it to disk.  Returns
+ * zero on success, otherwise non-zero is returned. */
+static int
+write_all(int fd, const char data[], size_t len, int sync)
+{
+	while(len != 0U)
+	{
+		const ssize_t written = write(fd, data, len);
+		if(written < 0)
+		{
+			if(errno == EINTR)
+			{
+				continue;
+			}
+			return 1;
+		}
+		data += written;
+		len -= written;
+	}
+
+#ifndef _WIN32
+	return sync ? fsync(fd) : 0;
+#else
+	return 0;
+#endif
+}
+
+/* Flushes entries of the directory to disk, so that newly created file isn't
+ * lost on a crash. */
+static void
+sync_dir(const char dir[])
+{
+#ifndef _WIN32
+	const int fd = open(dir, O_RDONLY);
+	if(fd >= 0)
+	{
+		(void)fsync(fd);
+		(void)close(fd);
+	}
+#endif
+}
+
+/* Reads whole file.  Sets *len to its length.  Returns newly allocated buffer
+ * or NULL on error. */
+static char *
+read_file(int fd, size_t *len)
+{
+	struct stat st;
+	char *data;
+	size_t total = 0U;
+
+	if(fstat(fd, &st) != 0)
+	{
+		return NULL;
+	}
+
+	data = malloc(st.st_size + 1U);
+	if(data == NULL)
+	{
+		return NULL;
+	}
+
+	while(total < (size_t)st.st_size)
+	{
+		const ssize_t n = read(fd, data + total, st.st_size - total);
+		if(n < 0 && errno == EINTR)
+		{
+			continue;
+		}
+		if(n <= 0)
+		{
+			break;
+		}
+		total += n;
+	}
+
+	*len = total;
+	return data;
+}
+
+/* Parses record at the *pos of the data advancing the position past it.  Sets
+ * *type and fields.  Returns number of fields or -1 for an incomplete or
+ * malformed record. */
+static int
+parse_record(const char data[], size_t len, size_t *pos, char *type,
+		const char *fields[])
+{
+	size_t p = *pos;
+	int count = 0;
+
+	*type = data[p++];
+
+	while(p < len && data[p] != '\n')
+	{
+		const char *const end = memchr(data + p, '\0', len - p);
+		if(end == NULL || count == MAX_FIELDS)
+		{
+			return -1;
+		}
+
+		fields[count++] = data + p;
+		p = end - data + 1;
+	}
+
+	if(p == len)
+	{
+		return -1;
+	}
+
+	*pos = p + 1U;
+	return count;
+}
+
+/* Updates journal according to the record.  Returns zero on success, otherwise
+ * non-zero is returned. */
+static int
+apply_record(iojournal_t *journal, char type, const char *fields[], int count)
+{
+	iojournal_item_t *item;
+	uint64_t *offset;
+
+	switch(type)
+	{
+		case REC_HEADER:
+			if(count != 4 || strcmp(fields[0], FORMAT_VERSION) != 0)
+			{
+				return 1;
+			}
+			journal->op = (strcmp(fields[1], "move") == 0) ? IOJ_MOVE : IOJ_COPY;
+			journal->force = (strcmp(fields[2], "1") == 0);
+			journal->target_dir = strdup(fields[3]);
+			return (journal->target_dir == NULL);
+
+		case REC_ITEM:
+			return (count != 2 || add_item(journal, fields[0], fields[1]) != 0);
+
+		case REC_CLEARED:
+		case REC_STARTED:
+		case REC_DONE:
+			item = (count == 1) ? get_item(journal, fields[0]) : NULL;
+			if(item == NULL)
+			{
+				return 1;
+			}
+			if(type == REC_CLEARED)
+			{
+				item->cleared = 1;
+			}
+			else if(type == REC_STARTED)
+			{
+				item->started = 1;
+			}
+			else
+			{
+				item->done = 1;
+			}
+			return 0;
+
+		case REC_OFFSET:
+			if(count != 2)
+			{
+				return 1;
+			}
+			if(trie_get(journal->file->offsets, fields[0], (void **)&offset) != 0)
+			{
+				offset = malloc(sizeof(*offset));
+				if(offset == NULL ||
+						trie_set(journal->file->offsets, fields[0], offset) < 0)
+				{
+					free(offset);
+					return 1;
+				}
+			}
+			*offset = strtoull(fields[1], NULL, 10);
+			return 0;
+	}
+
+	return 1;
+}
+
+/* Appends item to the list of items of the journal.  Returns zero on success,
+ * otherwise non-zero is returned. */
+static int
+add_item(iojournal_t *journal, const char src[], const char dst[])
+{
+	iojournal_item_t *item;
+	void *const p = reallocarray(journal->items, journal->nitems + 1U,
+			sizeof(*journal->items));
+	if(p == NULL)
+	{
+		return 1;
+	}
+	journal->items = p;
+
+	item = &journal->items[journal->nitems];
+	item->src = strdup(src);
+	item->dst = strdup(dst);
+	item->cleared = 0;
+	item->started = 0;
+	item->done = 0;
+	if(item->src == NULL || item->dst == NULL)
+	{
+		free(item->src);
+		free(item->dst);
+		return 1;
+	}
+
+	++journal->nitems;
+	return 0;
+}
+
+/* Looks up item by its index in string form.  Returns the item or NULL. */
+static iojournal_item_t *
+get_item(iojournal_t *journal, const char index[])
+{
+	char *end;
+	const unsigned long long i = strtoull(index, &end, 10);
+	if(end == index || index[0] == '-' || *end != '\0' ||
+			i >= journal->nitems)
+	{
+		return NULL;
+	}
+	return &journal->items[i];
+}
+
+/* Retrieves offset up to which the dst file is known to be written to disk.
+ * Returns the offset. */
+static uint64_t
+get_verified_offset(iojournal_t *journal, const char dst[])
+{
+	void *data;
+	if(trie_get(journal->file->offsets, dst, &data) != 0)
+	{
+		return 0U;
+	}
+	return *(uint64_t *)data;
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
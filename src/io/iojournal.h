@@ -0,0 +1,117 @@
+/* vifm
+ * Copyright (C) 2026 agent.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef VIFM__IO__IOJOURNAL_H__
+#define VIFM__IO__IOJOURNAL_H__
+
+#include <stddef.h> /* size_t */
+#include <stdint.h> /* uint64_t */
+
+/* iojournal - Input/Output journal - durable log of progress of an operation */
+
+/* Journal is an append-only file of records that describe items of an
+ * operation, which of them were finished and offsets up to which data of
+ * destination files is known to be on disk.  Only records, loss of which can
+ * lead to wrong results, are synced; a record cut short by a crash is dropped
+ * on loading.
+ * Completeness of files inside of directories is derived from destination
+ * files themselves (copying sets their timestamps last) to keep the log small
+ * for large trees. */
+
+/* Kind of journaled operation. */
+typedef enum
+{
+	IOJ_COPY, /* Copying of items. */
+	IOJ_MOVE, /* Moving of items. */
+}
+IoJournalOp;
+
+/* Single item of an operation. */
+typedef struct
+{
+	char *src;   /* Source path. */
+	char *dst;   /* Full destination path. */
+	int cleared; /* Whether destination was removed to be overwritten. */
+	int started; /* Whether destination might contain a partial copy. */
+	int done;    /* Whether item was processed. */
+}
+iojournal_item_t;
+
+/* Opaque declaration of private part of the journal. */
+typedef struct iojournal_file_t iojournal_file_t;
+
+/* Journal of an operation. */
+typedef struct
+{
+	IoJournalOp op;          /* Operation on the items. */
+	int force;               /* Whether destinations are overwritten. */
+	char *target_dir;        /* Directory in which operation takes place. */
+	iojournal_item_t *items; /* List of items. */
+	size_t nitems;           /* Number of items. */
+	int resumed;             /* Whether this is a continuation of an operation. */
+
+	iojournal_file_t *file;  /* Backing file and its state. */
+}
+iojournal_t;
+
+/* Creates journal for a new operation in the dir, which is created if needed.
+ * The journal is locked until it's closed.  Returns the journal or NULL on
+ * error. */
+iojournal_t * iojournal_create(const char dir[], IoJournalOp op, int force,
+		const char target_dir[], char *srcs[], char *dsts[], size_t count);
+
+/* Lists journals in the dir.  *count is set to number of elements.  Returns
+ * array of full paths, which might be NULL. */
+char ** iojournal_list(const char dir[], int *count);
+
+/* Loads journal of an interrupted operation and locks it.  Returns the journal
+ * or NULL if it's invalid or in use. */
+iojournal_t * iojournal_load(const char path[]);
+
+/* Records that destination of the item was removed.  The journal can be
+ * NULL. */
+void iojournal_item_cleared(iojournal_t *journal, size_t index);
+
+/* Records that destination of the item is about to be written.  Must be called
+ * before anything is created there.  The journal can be NULL. */
+void iojournal_item_started(iojournal_t *journal, size_t index);
+
+/* Records that the item was processed.  The journal can be NULL. */
+void iojournal_item_done(iojournal_t *journal, size_t index);
+
+/* Records that first offset bytes of the dst file are on disk.  Can be called
+ * from several threads.  The journal can be NULL. */
+void iojournal_checkpoint(iojournal_t *journal, const char dst[],
+		uint64_t offset);
+
+/* Prepares destination file of a resumed operation for copying the rest of the
+ * source into it.  Must be used only inside of destinations of started items,
+ * because files there are assumed to be written by the operation.  The journal
+ * can be NULL.  Returns non-zero if dst is already a complete copy of src,
+ * otherwise it's truncated to the last verified offset and zero is returned. */
+int iojournal_resume_file(iojournal_t *journal, const char src[],
+		const char dst[]);
+
+/* Frees the journal.  Discarding removes its file, otherwise the file stays for
+ * later resumption.  The journal can be NULL. */
+void iojournal_close(iojournal_t *journal, int discard);
+
+#endif /* VIFM__IO__IOJOURNAL_H__ */
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -24,24 +24,35 @@
 
 #include "iop.h"
 
+#ifdef __linux__
+#include <sys/ioctl.h> /* _IOW ioctl() */
+#include <sys/sendfile.h> /* sendfile() */
+#include <sys/syscall.h> /* __NR_copy_file_range */
+#endif
 #ifndef _WIN32
-#include <sys/ioctl.h> /* ioctl() */
+#include <fcntl.h> /* F_GETFL F_SETFL O_DIRECT O_RDONLY POSIX_FADV_* fcntl()
+                      open() posix_fadvise() */
 #endif
 #include <sys/stat.h> /* stat */
 #include <sys/types.h> /* mode_t */
-#include <unistd.h> /* rmdir() symlink() unlink() */
+#include <unistd.h> /* SEEK_CUR SEEK_DATA SEEK_HOLE close() fdatasync() fsync()
+                      ftruncate() lseek() pread() pwrite() read() rmdir()
+                      symlink() syscall() unlink() write() */
 
 #include <assert.h> /* assert() */
-#include <errno.h> /* EEXIST ENOENT EISDIR errno */
+#include <errno.h> /* EBADF EEXIST EINTR EINVAL EIO EISDIR ENOENT ENOMEM ENOSYS
+                     ENXIO EOPNOTSUPP ETXTBSY EXDEV errno */
 #include <stddef.h> /* NULL size_t */
+#include <stdint.h> /* uint64_t */
 #include <stdio.h> /* FILE fpos_t fclose() fgetpos() fread() fseek() fsetpos()
                       fwrite() snprintf() */
-#include <stdlib.h> /* free() */
-#include <string.h> /* strchr() strerror() */
+#include <stdlib.h> /* free() posix_memalign() */
+#include <string.h> /* memcmp() strchr() strerror() */
 
 #include "../compat/fs_limits.h"
 #include "../compat/os.h"
 #include "../ui/cancellation.h"
+#include "../utils/checksum.h"
 #include "../utils/fs.h"
 #include "../utils/log.h"
 #include "../utils/macros.h"
@@ -50,14 +61,73 @@
 #include "../utils/utf8.h"
 #include "../utils/utils.h"
 #include "../background.h"
+#include "private/hasher.h"
 #include "private/ioe.h"
 #include "private/ioeta.h"
 #include "ioc.h"
+#include "iothrottle.h"
 
 /* Amount of data to transfer at once. */
 #define BLOCK_SIZE 32*1024
 
-static int clone_file(int dest_fd, int src_fd);
+/* Amount of data to transfer at once by buffered copying on Linux. */
+#define LARGE_BLOCK_SIZE (1024U*1024U)
+
+/* Alignment of buffer for buffered copying, matches page size on most
+ * systems. */
+#define BUFFER_ALIGNMENT 4096
+
+/* Amount of data to copy at once in kernel, determines how often progress is
+ * updated. */
+#define KERNEL_CHUNK_SIZE (8U*1024U*1024U)
+
+/* Default amount of data written to a file between checkpoints of journal.
+ * Each checkpoint waits for the data to reach the disk. */
+#define CHECKPOINT_SIZE (64U*1024U*1024U)
+
+#ifdef __linux__
+
+/* Result of an attempt to copy file content using particular method. */
+typedef enum
+{
+	CR_OK,          /* Content was copied. */
+	CR_FAILED,      /* Copying failed or was cancelled, error is reported. */
+	CR_UNSUPPORTED, /* Method isn't available, nothing was copied. */
+}
+CopyResult;
+
+/* Function that copies up to len bytes from in to out without passing data
+ * through user space.  Returns number of copied bytes, zero on end of input or
+ * -1 on error. */
+typedef ssize_t (*copy_chunk_func)(int in, int out, size_t len);
+
+#endif
+
+static int copy_contents(io_args_t *args, FILE *in, FILE *out, int append);
+#ifdef __linux__
+static int method_allowed(CopyMethod method);
+static CopyResult clone_file(io_args_t *args, int dst, int src);
+static CopyResult copy_sparse(io_args_t *args, int in, int out);
+static CopyResult copy_range(io_args_t *args, int in, int out, off_t offset,
+		off_t len, int *in_kernel);
+static CopyResult copy_in_kernel(io_args_t *args, int in, int out,
+		copy_chunk_func copy_chunk);
+static ssize_t copy_file_range_chunk(int in, int out, size_t len);
+static ssize_t sendfile_chunk(int in, int out, size_t len);
+static CopyResult copy_buffered_fd(io_args_t *args, int in, int out);
+static int pwrite_all(int fd, const char buf[], size_t len, off_t offset);
+static void checkpoint(io_args_t *args, int out, uint64_t *unsynced,
+		size_t written, off_t size);
+#endif
+#ifndef _WIN32
+static int copy_verified(io_args_t *args, int in, int out);
+static int verify_copy(io_args_t *args, int out, off_t offset,
+		const unsigned char digest[], size_t digest_len);
+static int write_all(int fd, const char buf[], size_t len);
+#endif
+TSTATIC void iop_force_copy_method(CopyMethod method);
+TSTATIC void iop_set_checkpoint_size(uint64_t size);
+TSTATIC void iop_set_verify_hook(void (*hook)(const char dst[]));
 #ifdef _WIN32
 static DWORD CALLBACK win_progress_cb(LARGE_INTEGER total,
 		LARGE_INTEGER transferred, LARGE_INTEGER stream_size,
@@ -67,6 +137,16 @@ static DWORD CALLBACK win_progress_cb(LARGE_INTEGER total,
 static IoErrCbResult sig_err(io_args_t *const args, int *result,
 		const char path[], int error_code, const char msg[]);
 
+/* Method of copying file content to use exclusively, CM_AUTO means all. */
+static CopyMethod forced_method = CM_AUTO;
+
+/* Amount of data written to a file between checkpoints of journal. */
+static uint64_t checkpoint_size = CHECKPOINT_SIZE;
+
+/* Function called before reading back copied file for verification or
+ * NULL. */
+static void (*verify_hook)(const char dst[]);
+
 int
 iop_mkfile(io_args_t *const args)
 {
@@ -80,6 +160,7 @@ iop_mkfile(io_args_t *const args)
 		return -1;
 	}
 
+	(void)iothrottle_charge(args->throttle, 0U, 1U, args->cancellable);
 	f = os_fopen(path, "wb");
 	if(f == NULL)
 	{
@@ -109,6 +190,8 @@ iop_mkdir(io_args_t *const args)
 	enum { PATH_PREFIX_LEN = 2 };
 #endif
 
+	(void)iothrottle_charge(args->throttle, 0U, 1U, args->cancellable);
+
 	if(create_parent)
 	{
 		char *const partial_path = strdup(path);
@@ -163,6 +246,7 @@ iop_rmfile(io_args_t *const args)
 	int result;
 
 	ioeta_update(args->estim, path, path, 0, 0);
+	(void)iothrottle_charge(args->throttle, 0U, 1U, args->cancellable);
 
 	size = get_file_size(path);
 
@@ -225,6 +309,7 @@ iop_rmdir(io_args_t *const args)
 	int result;
 
 	ioeta_update(args->estim, path, path, 0, 0);
+	(void)iothrottle_charge(args->throttle, 0U, 1U, args->cancellable);
 
 #ifndef _WIN32
 	do
@@ -281,16 +366,22 @@ iop_cp(io_args_t *const args)
 	const int cancellable = args->cancellable;
 	struct stat st;
 
-	char block[BLOCK_SIZE];
 	FILE *in, *out;
-	/* Suppress possible false-positive compiler warning. */
-	size_t nread = (size_t)-1;
 	int error;
-	int cloned;
 	struct stat src_st;
 	const char *open_mode = "wb";
 
 	ioeta_update(args->estim, src, dst, 0, 0);
+	(void)iothrottle_charge(args->throttle, 0U, 1U, args->cancellable);
+
+	if(crs == IO_CRS_APPEND_TO_FILES &&
+			iojournal_resume_file(args->journal, src, dst))
+	{
+		/* Count data the same way estimation does. */
+		ioeta_update(args->estim, NULL, NULL, 1,
+				is_symlink(src) ? 0U : get_file_data_size(src));
+		return 0;
+	}
 
 #ifdef _WIN32
 	if(is_symlink(src) || crs != IO_CRS_APPEND_TO_FILES)
@@ -500,7 +591,6 @@ iop_cp(io_args_t *const args)
 	}
 
 	error = 0;
-	cloned = 0;
 
 	if(crs == IO_CRS_APPEND_TO_FILES)
 	{
@@ -515,19 +605,100 @@ iop_cp(io_args_t *const args)
 			ioeta_update(args->estim, NULL, NULL, 0, get_file_size(dst));
 		}
 	}
-	else if(args->arg4.fast_file_cloning)
+
+	if(!error)
+	{
+		error = copy_contents(args, in, out, crs == IO_CRS_APPEND_TO_FILES);
+	}
+
+	if(fclose(in) != 0)
+	{
+		(void)ioe_errlst_append(&args->result.errors, src, errno, strerror(errno));
+	}
+	if(fclose(out) != 0)
 	{
-		if(clone_file(fileno(out), fileno(in)) == 0)
+		(void)ioe_errlst_append(&args->result.errors, dst, errno, strerror(errno));
+	}
+
+	if(error == 0 && os_lstat(src, &src_st) == 0)
+	{
+		error = os_chmod(dst, src_st.st_mode & 07777);
+		if(error != 0)
 		{
-			cloned = 1;
+			(void)ioe_errlst_append(&args->result.errors, dst, errno,
+					strerror(errno));
 		}
 	}
 
-	/* TODO: use sendfile() if platform supports it. */
+	if(error == 0)
+	{
+		clone_timestamps(dst, src, &st);
+	}
+
+	ioeta_update(args->estim, NULL, NULL, 1, 0);
+
+	return error;
+}
+
+/* Copies content of in to out starting at current positions of the streams
+ * using the fastest method that works.  Appending means that out isn't empty.
+ * Returns zero on success, otherwise non-zero is returned. */
+static int
+copy_contents(io_args_t *args, FILE *in, FILE *out, int append)
+{
+#ifdef __linux__
+	/* Streams weren't read from or written to, so their descriptors are at the
+	 * same positions and can be used directly. */
+	const int in_fd = fileno(in);
+	const int out_fd = fileno(out);
+	CopyResult result = CR_UNSUPPORTED;
+
+	if(args->verify != IO_VERIFY_NONE)
+	{
+		/* Data has to pass through user space to be hashed. */
+		return copy_verified(args, in_fd, out_fd);
+	}
+
+	if(!append && args->arg4.fast_file_cloning && method_allowed(CM_CLONE))
+	{
+		result = clone_file(args, out_fd, in_fd);
+	}
+	if(result == CR_UNSUPPORTED && !append && method_allowed(CM_SPARSE))
+	{
+		result = copy_sparse(args, in_fd, out_fd);
+	}
+	if(result == CR_UNSUPPORTED && method_allowed(CM_COPY_FILE_RANGE))
+	{
+		result = copy_in_kernel(args, in_fd, out_fd, &copy_file_range_chunk);
+	}
+	if(result == CR_UNSUPPORTED && method_allowed(CM_SENDFILE))
+	{
+		result = copy_in_kernel(args, in_fd, out_fd, &sendfile_chunk);
+	}
+	if(result == CR_UNSUPPORTED)
+	{
+		result = copy_buffered_fd(args, in_fd, out_fd);
+	}
+	return result != CR_OK;
+#else
+	char block[BLOCK_SIZE];
+	/* Suppress possible false-positive compiler warning. */
+	size_t nread = (size_t)-1;
+	int error = 0;
+
+	(void)append;
 
-	while(!cloned && (nread = fread(&block, 1, sizeof(block), in)) != 0U)
+#ifndef _WIN32
+	if(args->verify != IO_VERIFY_NONE)
 	{
-		if(cancellable && ui_cancellation_requested())
+		return copy_verified(args, fileno(in), fileno(out));
+	}
+#endif
+
+	while((nread = fread(&block, 1, iothrottle_chunk(args->throttle,
+						sizeof(block)), in)) != 0U)
+	{
+		if(args->cancellable && ui_cancellation_requested())
 		{
 			error = 1;
 			break;
@@ -535,64 +706,662 @@ iop_cp(io_args_t *const args)
 
 		if(fwrite(&block, 1, nread, out) != nread)
 		{
-			(void)ioe_errlst_append(&args->result.errors, dst, errno,
+			(void)ioe_errlst_append(&args->result.errors, args->arg2.dst, errno,
 					strerror(errno));
 			error = 1;
 			break;
 		}
 
 		ioeta_update(args->estim, NULL, NULL, 0, nread);
+		if(iothrottle_charge(args->throttle, nread, 0U, args->cancellable))
+		{
+			error = 1;
+			break;
+		}
 	}
-	if(!cloned && nread == 0U && !feof(in) && ferror(in))
+	if(nread == 0U && !feof(in) && ferror(in))
 	{
-		(void)ioe_errlst_append(&args->result.errors, src, errno, strerror(errno));
+		(void)ioe_errlst_append(&args->result.errors, args->arg1.src, errno,
+				strerror(errno));
 	}
 
-	if(fclose(in) != 0)
+	return error;
+#endif
+}
+
+#ifdef __linux__
+
+/* Checks whether copying method can be used.  Returns non-zero if so. */
+static int
+method_allowed(CopyMethod method)
+{
+	return forced_method == CM_AUTO || forced_method == method;
+}
+
+/* Makes destination file share data with the source file on file systems that
+ * support reflinks.  Returns result of the operation. */
+static CopyResult
+clone_file(io_args_t *args, int dst, int src)
+{
+	/* FICLONE is a generalization of BTRFS_IOC_CLONE, which has the same code. */
+#undef FICLONE
+#define FICLONE _IOW(0x94, 9, int)
+	struct stat st;
+
+	if(ioctl(dst, FICLONE, src) != 0)
 	{
-		(void)ioe_errlst_append(&args->result.errors, src, errno, strerror(errno));
+		return CR_UNSUPPORTED;
 	}
-	if(fclose(out) != 0)
+
+	if(fstat(src, &st) == 0)
 	{
-		(void)ioe_errlst_append(&args->result.errors, dst, errno, strerror(errno));
+		ioeta_update(args->estim, NULL, NULL, 0, st.st_size);
 	}
+	return CR_OK;
+}
 
-	if(error == 0 && os_lstat(src, &src_st) == 0)
+/* Copies only data regions of a sparse file recreating holes in the
+ * destination.  Returns result of the operation, which is CR_UNSUPPORTED for
+ * files without holes or if holes can't be detected. */
+static CopyResult
+copy_sparse(io_args_t *args, int in, int out)
+{
+	struct stat st;
+	off_t offset = 0;
+	int in_kernel = method_allowed(CM_COPY_FILE_RANGE);
+
+	if(fstat(in, &st) != 0 || !S_ISREG(st.st_mode) ||
+			estimate_data_size(st.st_size, (uint64_t)st.st_blocks*512U) ==
+			(uint64_t)st.st_size)
 	{
-		error = os_chmod(dst, src_st.st_mode & 07777);
-		if(error != 0)
+		return CR_UNSUPPORTED;
+	}
+
+	while(offset < st.st_size)
+	{
+		CopyResult result;
+		off_t hole;
+		const off_t data = lseek(in, offset, SEEK_DATA);
+		if(data < 0)
 		{
-			(void)ioe_errlst_append(&args->result.errors, dst, errno,
+			if(errno == ENXIO)
+			{
+				/* The rest of the file is a hole. */
+				break;
+			}
+			if(offset == 0)
+			{
+				return CR_UNSUPPORTED;
+			}
+			(void)ioe_errlst_append(&args->result.errors, args->arg1.src, errno,
 					strerror(errno));
+			return CR_FAILED;
+		}
+
+		hole = lseek(in, data, SEEK_HOLE);
+		if(hole < 0)
+		{
+			hole = st.st_size;
 		}
+
+		result = copy_range(args, in, out, data, hole - data, &in_kernel);
+		if(result != CR_OK)
+		{
+			return CR_FAILED;
+		}
+
+		offset = hole;
 	}
 
-	if(error == 0)
+	/* Trailing hole is recreated by extending the file. */
+	if(ftruncate(out, st.st_size) != 0)
 	{
-		clone_timestamps(dst, src, &st);
+		(void)ioe_errlst_append(&args->result.errors, args->arg2.dst, errno,
+				strerror(errno));
+		return CR_FAILED;
 	}
 
-	ioeta_update(args->estim, NULL, NULL, 1, 0);
+	return CR_OK;
+}
 
-	return error;
+/* Copies len bytes at the offset from in to the same offset in out.
+ * *in_kernel specifies whether copy_file_range() should be tried and is reset
+ * if it's not supported.  Returns result of the operation, which is never
+ * CR_UNSUPPORTED. */
+static CopyResult
+copy_range(io_args_t *args, int in, int out, off_t offset, off_t len,
+		int *in_kernel)
+{
+	char *buf = NULL;
+	CopyResult result = CR_OK;
+	uint64_t unsynced = 0U;
+
+	while(len > 0)
+	{
+		ssize_t n = -1;
+		/* Copying big chunks at a low rate would alternate long bursts with long
+		 * waits. */
+		const size_t chunk = iothrottle_chunk(args->throttle,
+				MIN(len, KERNEL_CHUNK_SIZE));
+
+		if(args->cancellable && ui_cancellation_requested())
+		{
+			result = CR_FAILED;
+			break;
+		}
+
+#ifdef __NR_copy_file_range
+		if(*in_kernel)
+		{
+			loff_t in_off = offset, out_off = offset;
+			n = syscall(__NR_copy_file_range, in, &in_off, out, &out_off, chunk, 0U);
+			if(n <= 0)
+			{
+				/* Fall back to reading and writing on errors and premature end of
+				 * input, the latter is reported below. */
+				*in_kernel = 0;
+			}
+		}
+#endif
+
+		if(n <= 0)
+		{
+			if(buf == NULL && posix_memalign((void **)&buf, BUFFER_ALIGNMENT,
+						LARGE_BLOCK_SIZE) != 0)
+			{
+				(void)ioe_errlst_append(&args->result.errors, args->arg2.dst, ENOMEM,
+						strerror(ENOMEM));
+				result = CR_FAILED;
+				break;
+			}
+
+			n = pread(in, buf, MIN(chunk, LARGE_BLOCK_SIZE), offset);
+			if(n <= 0)
+			{
+				if(n < 0 && errno == EINTR)
+				{
+					continue;
+				}
+				(void)ioe_errlst_append(&args->result.errors, args->arg1.src,
+						(n == 0) ? EIO : errno, strerror((n == 0) ? EIO : errno));
+				result = CR_FAILED;
+				break;
+			}
+
+			if(pwrite_all(out, buf, n, offset) != 0)
+			{
+				(void)ioe_errlst_append(&args->result.errors, args->arg2.dst, errno,
+						strerror(errno));
+				result = CR_FAILED;
+				break;
+			}
+		}
+
+		offset += n;
+		len -= n;
+		ioeta_update(args->estim, NULL, NULL, 0, n);
+		checkpoint(args, out, &unsynced, n, offset);
+		if(iothrottle_charge(args->throttle, n, 0U, args->cancellable))
+		{
+			result = CR_FAILED;
+			break;
+		}
+	}
+
+	free(buf);
+	return result;
+}
+
+/* Copies file by chunks without moving data to and from user space.  Returns
+ * result of the operation, which is CR_UNSUPPORTED only if nothing was
+ * copied. */
+static CopyResult
+copy_in_kernel(io_args_t *args, int in, int out, copy_chunk_func copy_chunk)
+{
+	uint64_t copied = 0U;
+	uint64_t unsynced = 0U;
+
+	while(1)
+	{
+		ssize_t n;
+
+		if(args->cancellable && ui_cancellation_requested())
+		{
+			return CR_FAILED;
+		}
+
+		/* Copying big chunks at a low rate would alternate long bursts with long
+		 * waits. */
+		n = copy_chunk(in, out, iothrottle_chunk(args->throttle,
+					KERNEL_CHUNK_SIZE));
+		if(n < 0)
+		{
+			if(copied == 0U && (errno == ENOSYS || errno == EXDEV ||
+						errno == EINVAL || errno == EBADF || errno == EOPNOTSUPP ||
+						errno == ETXTBSY))
+			{
+				return CR_UNSUPPORTED;
+			}
+
+			(void)ioe_errlst_append(&args->result.errors, args->arg2.dst, errno,
+					strerror(errno));
+			return CR_FAILED;
+		}
+
+		if(n == 0)
+		{
+			/* Some pseudo-files report end of file to in-kernel copying, let
+			 * regular reading handle them as well as empty files. */
+			return (copied == 0U) ? CR_UNSUPPORTED : CR_OK;
+		}
+
+		copied += n;
+		ioeta_update(args->estim, NULL, NULL, 0, n);
+		checkpoint(args, out, &unsynced, n, -1);
+		if(iothrottle_charge(args->throttle, n, 0U, args->cancellable))
+		{
+			return CR_FAILED;
+		}
+	}
+}
+
+/* Copies chunk of data using copy_file_range().  Returns number of copied
+ * bytes, zero on end of input or -1 on error. */
+static ssize_t
+copy_file_range_chunk(int in, int out, size_t len)
+{
+#ifdef __NR_copy_file_range
+	return syscall(__NR_copy_file_range, in, NULL, out, NULL, len, 0U);
+#else
+	errno = ENOSYS;
+	return -1;
+#endif
 }
 
-/* Try to clone file fast on btrfs.  Returns 0 on success, otherwise non-zero is
+/* Copies chunk of data using sendfile().  Returns number of copied bytes, zero
+ * on end of input or -1 on error. */
+static ssize_t
+sendfile_chunk(int in, int out, size_t len)
+{
+	return sendfile(out, in, NULL, len);
+}
+
+/* Copies file by reading it into a buffer and writing it out.  Returns result
+ * of the operation. */
+static CopyResult
+copy_buffered_fd(io_args_t *args, int in, int out)
+{
+	void *buf;
+	CopyResult result = CR_OK;
+	uint64_t unsynced = 0U;
+
+	if(posix_memalign(&buf, BUFFER_ALIGNMENT, LARGE_BLOCK_SIZE) != 0)
+	{
+		(void)ioe_errlst_append(&args->result.errors, args->arg2.dst, ENOMEM,
+				strerror(ENOMEM));
+		return CR_FAILED;
+	}
+
+	(void)posix_fadvise(in, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+	while(1)
+	{
+		ssize_t nread;
+
+		if(args->cancellable && ui_cancellation_requested())
+		{
+			result = CR_FAILED;
+			break;
+		}
+
+		nread = read(in, buf, iothrottle_chunk(args->throttle, LARGE_BLOCK_SIZE));
+		if(nread < 0 && errno == EINTR)
+		{
+			continue;
+		}
+		if(nread < 0)
+		{
+			(void)ioe_errlst_append(&args->result.errors, args->arg1.src, errno,
+					strerror(errno));
+			result = CR_FAILED;
+			break;
+		}
+		if(nread == 0)
+		{
+			break;
+		}
+
+		if(write_all(out, buf, nread) != 0)
+		{
+			(void)ioe_errlst_append(&args->result.errors, args->arg2.dst, errno,
+					strerror(errno));
+			result = CR_FAILED;
+			break;
+		}
+
+		ioeta_update(args->estim, NULL, NULL, 0, nread);
+		checkpoint(args, out, &unsynced, nread, -1);
+		if(iothrottle_charge(args->throttle, nread, 0U, args->cancellable))
+		{
+			result = CR_FAILED;
+			break;
+		}
+	}
+
+	free(buf);
+	return result;
+}
+
+/* Writes whole buffer to a file descriptor at the offset.  Returns zero on
+ * success, otherwise non-zero is returned and errno is set. */
+static int
+pwrite_all(int fd, const char buf[], size_t len, off_t offset)
+{
+	while(len != 0U)
+	{
+		const ssize_t written = pwrite(fd, buf, len, offset);
+		if(written < 0)
+		{
+			if(errno == EINTR)
+			{
+				continue;
+			}
+			return 1;
+		}
+		buf += written;
+		len -= written;
+		offset += written;
+	}
+	return 0;
+}
+
+/* Records size of the output file in the journal after enough data was
+ * written to it and the data reached the disk.  Negative size means current
+ * position in the file. */
+static void
+checkpoint(io_args_t *args, int out, uint64_t *unsynced, size_t written,
+		off_t size)
+{
+	if(args->journal == NULL)
+	{
+		return;
+	}
+
+	*unsynced += written;
+	if(*unsynced < checkpoint_size)
+	{
+		return;
+	}
+	*unsynced = 0U;
+
+	if(size < 0)
+	{
+		size = lseek(out, 0, SEEK_CUR);
+	}
+
+	if(size >= 0 && fdatasync(out) == 0)
+	{
+		iojournal_checkpoint(args->journal, args->arg2.dst, size);
+	}
+}
+
+#endif
+
+#ifndef _WIN32
+
+/* Copies content of in to out starting at current positions of descriptors
+ * while hashing the data in parallel and then checks that data read back from
+ * out has the same checksum.  Returns zero on success, otherwise non-zero is
  * returned. */
 static int
-clone_file(int dst, int src)
+copy_verified(io_args_t *args, int in, int out)
 {
+	unsigned char digest[CHECKSUM_MAX_LEN];
+	size_t digest_len;
+	int error = 0;
 #ifdef __linux__
-#undef BTRFS_IOCTL_MAGIC
-#define BTRFS_IOCTL_MAGIC 0x94
-#undef BTRFS_IOC_CLONE
-#define BTRFS_IOC_CLONE _IOW(BTRFS_IOCTL_MAGIC, 9, int)
-	return ioctl(dst, BTRFS_IOC_CLONE, src);
-#else
-	(void)dst;
-	(void)src;
-	return -1;
+	uint64_t unsynced = 0U;
+#endif
+
+	const off_t offset = lseek(in, 0, SEEK_CUR);
+	hasher_t *const hasher = hasher_create(
+			(args->verify == IO_VERIFY_SHA256) ? CK_SHA256 : CK_XXH64,
+			LARGE_BLOCK_SIZE);
+	if(offset < 0 || hasher == NULL)
+	{
+		const int error_code = (offset < 0) ? errno : ENOMEM;
+		(void)ioe_errlst_append(&args->result.errors, args->arg1.src, error_code,
+				strerror(error_code));
+		if(hasher != NULL)
+		{
+			(void)hasher_finish(hasher, digest);
+		}
+		return 1;
+	}
+
+#ifdef POSIX_FADV_SEQUENTIAL
+	(void)posix_fadvise(in, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
+	while(1)
+	{
+		char *const buf = hasher_get_buf(hasher);
+		ssize_t nread;
+
+		do
+		{
+			nread = read(in, buf, iothrottle_chunk(args->throttle,
+						LARGE_BLOCK_SIZE));
+		}
+		while(nread < 0 && errno == EINTR);
+
+		if(nread <= 0)
+		{
+			if(nread < 0)
+			{
+				(void)ioe_errlst_append(&args->result.errors, args->arg1.src, errno,
+						strerror(errno));
+				error = 1;
+			}
+			hasher_put_buf(hasher, buf, 0U, 0U);
+			break;
+		}
+
+		if(write_all(out, buf, nread) != 0)
+		{
+			(void)ioe_errlst_append(&args->result.errors, args->arg2.dst, errno,
+					strerror(errno));
+			hasher_put_buf(hasher, buf, 0U, 0U);
+			error = 1;
+			break;
+		}
+
+		/* Hashing of this block overlaps with reading of the next one. */
+		hasher_put_buf(hasher, buf, 0U, nread);
+
+		ioeta_update(args->estim, NULL, NULL, 0, nread);
+#ifdef __linux__
+		checkpoint(args, out, &unsynced, nread, -1);
+#endif
+
+		if(iothrottle_charge(args->throttle, nread, 0U, args->cancellable) ||
+				(args->cancellable && ui_cancellation_requested()))
+		{
+			error = 1;
+			break;
+		}
+	}
+
+	digest_len = hasher_finish(hasher, digest);
+
+	return error || verify_copy(args, out, offset, digest, digest_len);
+}
+
+/* Reads back part of destination file starting at the offset bypassing caches
+ * where possible and compares its checksum with the digest.  Returns zero on
+ * match, otherwise non-zero is returned. */
+static int
+verify_copy(io_args_t *args, int out, off_t offset,
+		const unsigned char digest[], size_t digest_len)
+{
+	const char *const dst = args->arg2.dst;
+	unsigned char dst_digest[CHECKSUM_MAX_LEN];
+	hasher_t *hasher;
+	off_t pos;
+	size_t skip;
+	int fd;
+	int direct = 0;
+	int error = 0;
+
+	/* Data must reach the disk to be read from it. */
+	if(fsync(out) != 0)
+	{
+		(void)ioe_errlst_append(&args->result.errors, dst, errno, strerror(errno));
+		return 1;
+	}
+
+	if(verify_hook != NULL)
+	{
+		verify_hook(dst);
+	}
+
+#ifdef O_DIRECT
+	fd = open(dst, O_RDONLY | O_DIRECT);
+	direct = (fd >= 0);
+	if(fd < 0)
+#endif
+	{
+		fd = open(dst, O_RDONLY);
+	}
+	if(fd < 0)
+	{
+		(void)ioe_errlst_append(&args->result.errors, dst, errno, strerror(errno));
+		return 1;
+	}
+
+#ifdef POSIX_FADV_DONTNEED
+	/* Pages of synced file are clean and can be dropped, so that data is read
+	 * from the disk. */
+	if(!direct)
+	{
+		(void)posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+	}
+#endif
+
+	hasher = hasher_create(
+			(args->verify == IO_VERIFY_SHA256) ? CK_SHA256 : CK_XXH64,
+			LARGE_BLOCK_SIZE);
+	if(hasher == NULL)
+	{
+		(void)ioe_errlst_append(&args->result.errors, dst, ENOMEM,
+				strerror(ENOMEM));
+		(void)close(fd);
+		return 1;
+	}
+
+	/* Direct reads must start at aligned offsets. */
+	skip = offset%BUFFER_ALIGNMENT;
+	pos = offset - skip;
+
+	while(1)
+	{
+		char *const buf = hasher_get_buf(hasher);
+		const ssize_t nread = pread(fd, buf, LARGE_BLOCK_SIZE, pos);
+
+		if(nread < 0 && (errno == EINTR || (errno == EINVAL && direct)))
+		{
+			const int error_code = errno;
+			hasher_put_buf(hasher, buf, 0U, 0U);
+			/* File system might not support direct reads after all. */
+			if(error_code == EINVAL)
+			{
+#ifdef O_DIRECT
+				(void)fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_DIRECT);
+#endif
+				direct = 0;
+			}
+			continue;
+		}
+
+		if(nread <= 0 || (size_t)nread <= skip)
+		{
+			if(nread < 0)
+			{
+				(void)ioe_errlst_append(&args->result.errors, dst, errno,
+						strerror(errno));
+				error = 1;
+			}
+			hasher_put_buf(hasher, buf, 0U, 0U);
+			break;
+		}
+
+		hasher_put_buf(hasher, buf, skip, nread - skip);
+		pos += nread;
+		skip = 0U;
+
+		if(args->cancellable && ui_cancellation_requested())
+		{
+			error = 1;
+			break;
+		}
+	}
+
+	(void)close(fd);
+
+	if(hasher_finish(hasher, dst_digest) != digest_len ||
+			memcmp(dst_digest, digest, digest_len) != 0)
+	{
+		if(!error)
+		{
+			(void)ioe_errlst_append(&args->result.errors, dst, EIO,
+					"Copy doesn't match the source (checksum mismatch)");
+		}
+		return 1;
+	}
+
+	return error;
+}
+
+/* Writes whole buffer to a file descriptor.  Returns zero on success, otherwise
+ * non-zero is returned and errno is set. */
+static int
+write_all(int fd, const char buf[], size_t len)
+{
+	while(len != 0U)
+	{
+		const ssize_t written = write(fd, buf, len);
+		if(written < 0)
+		{
+			if(errno == EINTR)
+			{
+				continue;
+			}
+			return 1;
+		}
+		buf += written;
+		len -= written;
+	}
+	return 0;
+}
+
 #endif
+
+TSTATIC void
+iop_force_copy_method(CopyMethod method)
+{
+	forced_method = method;
+}
+
+TSTATIC void
+iop_set_checkpoint_size(uint64_t size)
+{
+	checkpoint_size = size;
+}
+
+TSTATIC void
+iop_set_verify_hook(void (*hook)(const char dst[]))
+{
+	verify_hook = hook;
 }
 
 #ifdef _WIN32
@@ -616,6 +1385,11 @@ static DWORD CALLBACK win_progress_cb(LARGE_INTEGER total,
 	}
 
 	ioeta_update(estim, src, dst, 0, transferred.QuadPart - last_size);
+	if(iothrottle_charge(args->throttle, transferred.QuadPart - last_size, 0U,
+				args->cancellable))
+	{
+		return PROGRESS_CANCEL;
+	}
 
 	last_size = transferred.QuadPart;
 
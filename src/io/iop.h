@@ -19,10 +19,26 @@
 #ifndef VIFM__IO__IOP_H__
 #define VIFM__IO__IOP_H__
 
+#include <stdint.h> /* uint64_t */
+
+#include "../utils/test_helpers.h"
 #include "ioc.h"
 
 /* iop - I/O primitive - Input/Output primitive */
 
+/* Methods of copying content of files by iop_cp() in the order in which they
+ * are tried.  Those that aren't supported are skipped. */
+typedef enum
+{
+	CM_AUTO,            /* Try all methods. */
+	CM_CLONE,           /* Reflink (if fast file cloning is requested). */
+	CM_SPARSE,          /* Copying only data regions of sparse files. */
+	CM_COPY_FILE_RANGE, /* In-kernel copying via copy_file_range(). */
+	CM_SENDFILE,        /* In-kernel copying via sendfile(). */
+	CM_BUFFERED,        /* Reading into a buffer and writing it out. */
+}
+CopyMethod;
+
 /* All functions return zero on success and non-zero on error. */
 
 /* Creates file.  Expects path in arg1.  Fails if one already exists. */
@@ -58,6 +74,17 @@ int iop_chmod(io_args_t *const args);
  * link. */
 int iop_ln(io_args_t *const args);
 
+TSTATIC_DEFS(
+	/* Restricts iop_cp() to the method (plus buffered copying as a fallback),
+	 * CM_AUTO restores default behaviour. */
+	void iop_force_copy_method(CopyMethod method);
+	/* Sets amount of data copied between checkpoints of journal. */
+	void iop_set_checkpoint_size(uint64_t size);
+	/* Sets function called before reading back copied file for verification.
+	 * NULL resets it. */
+	void iop_set_verify_hook(void (*hook)(const char dst[]));
+)
+
 #endif /* VIFM__IO__IOP_H__ */
 
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
@@ -25,10 +25,11 @@
 #include <stddef.h> /* NULL */
 #include <stdio.h> /* removee() snprintf() */
 #include <stdlib.h> /* free() */
-#include <string.h> /* strerror() strlen() */
+#include <string.h> /* strdup() strerror() strlen() */
 
 #include "../compat/fs_limits.h"
 #include "../compat/os.h"
+#include "../compat/reallocarray.h"
 #include "../ui/cancellation.h"
 #include "../utils/fs.h"
 #include "../utils/log.h"
@@ -36,16 +37,41 @@
 #include "../utils/str.h"
 #include "../utils/utils.h"
 #include "../background.h"
+#include "private/cpsched.h"
 #include "private/ioe.h"
 #include "private/ioeta.h"
+#ifndef _WIN32
+#include "private/rmtree.h"
+#endif
 #include "private/traverser.h"
+#include "private/walker.h"
 #include "ioc.h"
 #include "iop.h"
+#include "iothrottle.h"
+
+/* State of concurrent subtree copying. */
+typedef struct
+{
+	io_args_t *args;  /* Arguments of the operation. */
+	cpsched_t *sched; /* Scheduler of file copies. */
+	char **dirs;      /* Directories to finalize in order of leaving them. */
+	size_t ndirs;     /* Number of elements in dirs array. */
+}
+parallel_cp_t;
 
+#ifndef _WIN32
+static int can_rm_in_parallel(const io_args_t *args);
+#endif
 static VisitResult rm_visitor(const char full_path[], VisitAction action,
 		void *param);
 static VisitResult cp_visitor(const char full_path[], VisitAction action,
 		void *param);
+static int can_cp_in_parallel(const io_args_t *args);
+static int cp_in_parallel(io_args_t *args);
+static VisitResult parallel_cp_visitor(const char full_path[],
+		VisitAction action, void *param);
+static int traverse_listed(const io_args_t *args, const char path[],
+		subtree_visitor visitor, void *param);
 static int is_file(const char path[]);
 static VisitResult mv_visitor(const char full_path[], VisitAction action,
 		void *param);
@@ -56,9 +82,37 @@ int
 ior_rm(io_args_t *const args)
 {
 	const char *const path = args->arg1.path;
+
+#ifndef _WIN32
+	if(can_rm_in_parallel(args))
+	{
+		return rmtree_run(args, args->nworkers);
+	}
+#endif
+
 	return traverse(path, &rm_visitor, args);
 }
 
+#ifndef _WIN32
+
+/* Checks whether subtree can be removed by several threads.  Returns non-zero
+ * if so, otherwise zero is returned. */
+static int
+can_rm_in_parallel(const io_args_t *args)
+{
+	const char *const path = args->arg1.path;
+
+	/* Error callback needs to interact with the user. */
+	if(args->result.errors_cb != NULL)
+	{
+		return 0;
+	}
+
+	return args->nworkers > 1 && !is_symlink(path) && is_dir(path);
+}
+
+#endif
+
 /* Implementation of traverse() visitor for subtree removal.  Returns 0 on
  * success, otherwise non-zero is returned. */
 static VisitResult
@@ -85,6 +139,7 @@ rm_visitor(const char full_path[], VisitAction action, void *param)
 
 					.cancellable = rm_args->cancellable,
 					.estim = rm_args->estim,
+					.throttle = rm_args->throttle,
 
 					.result = rm_args->result,
 				};
@@ -100,6 +155,7 @@ rm_visitor(const char full_path[], VisitAction action, void *param)
 
 					.cancellable = rm_args->cancellable,
 					.estim = rm_args->estim,
+					.throttle = rm_args->throttle,
 
 					.result = rm_args->result,
 				};
@@ -133,6 +189,8 @@ ior_cp(io_args_t *const args)
 
 			.cancellable = args->cancellable,
 			.estim = args->estim,
+			.throttle = args->throttle,
+			.nworkers = args->nworkers,
 
 			.result = args->result,
 		};
@@ -150,7 +208,12 @@ ior_cp(io_args_t *const args)
 		}
 	}
 
-	return traverse(src, &cp_visitor, args);
+	if(can_cp_in_parallel(args))
+	{
+		return cp_in_parallel(args);
+	}
+
+	return traverse_listed(args, src, &cp_visitor, args);
 }
 
 /* Implementation of traverse() visitor for subtree copying.  Returns 0 on
@@ -161,6 +224,111 @@ cp_visitor(const char full_path[], VisitAction action, void *param)
 	return cp_mv_visitor(full_path, action, param, 1);
 }
 
+/* Checks whether subtree can be copied by several threads.  Returns non-zero if
+ * so, otherwise zero is returned. */
+static int
+can_cp_in_parallel(const io_args_t *args)
+{
+	const char *const src = args->arg1.src;
+
+	/* Overwrite confirmation needs to interact with the user. */
+	if(args->confirm != NULL && args->arg3.crs == IO_CRS_REPLACE_FILES)
+	{
+		return 0;
+	}
+
+	return args->nworkers > 1 && !is_symlink(src) && is_dir(src);
+}
+
+/* Copies subtree creating directories as they are traversed, copying files
+ * concurrently and finalizing directories after all files are in place.
+ * Returns zero on success, otherwise non-zero is returned. */
+static int
+cp_in_parallel(io_args_t *args)
+{
+	size_t i;
+	int result;
+	parallel_cp_t state = {
+		.args = args,
+		.sched = cpsched_start(args, args->nworkers),
+	};
+
+	if(state.sched == NULL)
+	{
+		return traverse_listed(args, args->arg1.src, &cp_visitor, args);
+	}
+
+	result = traverse_listed(args, args->arg1.src, &parallel_cp_visitor, &state);
+	if(cpsched_finish(state.sched) != 0)
+	{
+		result = 1;
+	}
+
+	/* Directories were left in post-order, so their metadata is restored before
+	 * that of their parents, just like in sequential case. */
+	for(i = 0U; i < state.ndirs; ++i)
+	{
+		if(cp_visitor(state.dirs[i], VA_DIR_LEAVE, args) != VR_OK)
+		{
+			result = 1;
+		}
+		free(state.dirs[i]);
+	}
+	free(state.dirs);
+
+	return result;
+}
+
+/* Implementation of traverse() visitor for concurrent subtree copying.  Returns
+ * 0 on success, otherwise non-zero is returned. */
+static VisitResult
+parallel_cp_visitor(const char full_path[], VisitAction action, void *param)
+{
+	parallel_cp_t *const state = param;
+	io_args_t *const cp_args = state->args;
+
+	switch(action)
+	{
+		case VA_DIR_ENTER:
+			return cp_visitor(full_path, action, cp_args);
+		case VA_FILE:
+			{
+				int error;
+				const char *const rel_part = full_path + strlen(cp_args->arg1.src);
+				char *const dst_full_path = format_str("%s/%s", cp_args->arg2.dst,
+						rel_part);
+
+				if(cp_args->cancellable && ui_cancellation_requested())
+				{
+					free(dst_full_path);
+					return VR_CANCELLED;
+				}
+
+				error = cpsched_copy(state->sched, full_path, dst_full_path);
+				free(dst_full_path);
+				return (error == 0) ? VR_OK : VR_ERROR;
+			}
+		case VA_DIR_LEAVE:
+			{
+				char *const path = strdup(full_path);
+				void *const p = reallocarray(state->dirs, state->ndirs + 1U,
+						sizeof(*state->dirs));
+				if(path == NULL || p == NULL)
+				{
+					free(path);
+					(void)ioe_errlst_append(&cp_args->result.errors, full_path,
+							IO_ERR_UNKNOWN, "Not enough memory");
+					return VR_ERROR;
+				}
+				state->dirs = p;
+				state->dirs[state->ndirs++] = path;
+				return VR_OK;
+			}
+	}
+
+	return VR_ERROR;
+}
+
 int
 ior_mv(io_args_t *const args)
 {
@@ -200,6 +368,7 @@ ior_mv(io_args_t *const args)
 		}
 	}
 
+	(void)iothrottle_charge(args->throttle, 0U, 1U, args->cancellable);
 	if(os_rename(src, dst) == 0)
 	{
 		ioeta_update(args->estim, src, dst, 1, 0);
@@ -218,6 +387,8 @@ ior_mv(io_args_t *const args)
 
 						.cancellable = args->cancellable,
 						.estim = args->estim,
+						.throttle = args->throttle,
+						.nworkers = args->nworkers,
 
 						.result = args->result,
 					};
@@ -246,6 +417,8 @@ ior_mv(io_args_t *const args)
 
 					.cancellable = args->cancellable,
 					.estim = args->estim,
+					.throttle = args->throttle,
+					.nworkers = args->nworkers,
 
 					.result = args->result,
 				};
@@ -286,6 +459,7 @@ ior_mv(io_args_t *const args)
 
 						.cancellable = args->cancellable,
 						.estim = args->estim,
+						.throttle = args->throttle,
 
 						.result = args->result,
 					};
@@ -314,6 +488,23 @@ ior_mv(io_args_t *const args)
 	}
 }
 
+/* Same as traverse(), but takes entries from listing made during estimation if
+ * it's available.  Returns zero on success, otherwise non-zero is returned. */
+static int
+traverse_listed(const io_args_t *args, const char path[],
+		subtree_visitor visitor, void *param)
+{
+	int result;
+
+	if(args->estim != NULL && args->estim->walker != NULL &&
+			walker_replay(args->estim->walker, path, visitor, param, &result) == 0)
+	{
+		return result;
+	}
+
+	return traverse(path, visitor, param);
+}
+
 /* Checks that path points to a file or symbolic link.  Returns non-zero if so,
  * otherwise zero is returned. */
 static int
@@ -356,7 +547,9 @@ cp_mv_visitor(const char full_path[], VisitAction action, void *param, int cp)
 	switch(action)
 	{
 		case VA_DIR_ENTER:
-			if(cp_args->arg3.crs != IO_CRS_REPLACE_FILES || !is_dir(dst_full_path))
+			if((cp_args->arg3.crs != IO_CRS_REPLACE_FILES &&
+						cp_args->arg3.crs != IO_CRS_APPEND_TO_FILES) ||
+					!is_dir(dst_full_path))
 			{
 				io_args_t args = {
 					.arg1.path = dst_full_path,
@@ -366,6 +559,7 @@ cp_mv_visitor(const char full_path[], VisitAction action, void *param, int cp)
 
 					.cancellable = cp_args->cancellable,
 					.estim = cp_args->estim,
+					.throttle = cp_args->throttle,
 
 					.result = cp_args->result,
 				};
@@ -385,7 +579,10 @@ cp_mv_visitor(const char full_path[], VisitAction action, void *param, int cp)
 
 					.cancellable = cp_args->cancellable,
 					.confirm = cp_args->confirm,
+					.verify = cp_args->verify,
 					.estim = cp_args->estim,
+					.journal = cp_args->journal,
+					.throttle = cp_args->throttle,
 
 					.result = cp_args->result,
 				};
@@ -405,6 +602,7 @@ cp_mv_visitor(const char full_path[], VisitAction action, void *param, int cp)
 
 						.cancellable = cp_args->cancellable,
 						.estim = cp_args->estim,
+						.throttle = cp_args->throttle,
 
 						.result = cp_args->result,
 					};
@@ -0,0 +1,253 @@
+/* vifm
+ * Copyright (C) 2026 agent.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "iothrottle.h"
+
+#include <pthread.h> /* PTHREAD_MUTEX_INITIALIZER pthread_mutex_* */
+#include <sys/time.h> /* gettimeofday() timeval */
+#include <unistd.h> /* usleep() */
+
+#include <stddef.h> /* NULL */
+#include <stdint.h> /* uint64_t */
+#include <stdlib.h> /* calloc() free() */
+
+#include "../ui/cancellation.h"
+
+/* Amount of time (in microseconds) worth of tokens that can be accumulated
+ * while a throttle isn't used, which is the size of bursts. */
+#define BURST_US 250000
+
+/* Longest single sleep in microseconds, which also limits delay of reaction
+ * to cancellation. */
+#define MAX_SLEEP_US 50000
+
+/* Token bucket. */
+typedef struct
+{
+	uint64_t rate; /* Number of tokens per second, zero means no limit. */
+	double tokens; /* Number of available tokens, negative value is a debt. */
+}
+bucket_t;
+
+/* Rate limiter. */
+struct iothrottle_t
+{
+	pthread_mutex_t lock;  /* Protects the rest of the fields. */
+	bucket_t bytes;        /* Limit on number of bytes. */
+	bucket_t ops;          /* Limit on number of operations. */
+	uint64_t last;         /* Time of the last refill in microseconds. */
+	iothrottle_t *parent;  /* Throttle to charge along with this one or NULL. */
+};
+
+static uint64_t take(iothrottle_t *throttle, uint64_t bytes, unsigned int ops,
+		uint64_t now);
+static void refill(bucket_t *bucket, uint64_t elapsed);
+static uint64_t take_tokens(bucket_t *bucket, uint64_t amount);
+static void set_rate(bucket_t *bucket, uint64_t rate);
+static uint64_t get_time_us(void);
+
+/* Throttle shared by all operations. */
+static iothrottle_t global_throttle = {
+	.lock = PTHREAD_MUTEX_INITIALIZER,
+};
+
+iothrottle_t *
+iothrottle_create(uint64_t bytes_rate, uint64_t ops_rate, iothrottle_t *parent)
+{
+	iothrottle_t *const throttle = calloc(1, sizeof(*throttle));
+	if(throttle == NULL)
+	{
+		return NULL;
+	}
+
+	if(pthread_mutex_init(&throttle->lock, NULL) != 0)
+	{
+		free(throttle);
+		return NULL;
+	}
+
+	throttle->bytes.rate = bytes_rate;
+	throttle->ops.rate = ops_rate;
+	throttle->last = get_time_us();
+	throttle->parent = parent;
+	return throttle;
+}
+
+void
+iothrottle_free(iothrottle_t *throttle)
+{
+	if(throttle != NULL)
+	{
+		pthread_mutex_destroy(&throttle->lock);
+		free(throttle);
+	}
+}
+
+void
+iothrottle_set_limits(iothrottle_t *throttle, uint64_t bytes_rate,
+		uint64_t ops_rate)
+{
+	pthread_mutex_lock(&throttle->lock);
+	set_rate(&throttle->bytes, bytes_rate);
+	set_rate(&throttle->ops, ops_rate);
+	pthread_mutex_unlock(&throttle->lock);
+}
+
+iothrottle_t *
+iothrottle_global(void)
+{
+	return &global_throttle;
+}
+
+int
+iothrottle_charge(iothrottle_t *throttle, uint64_t bytes, unsigned int ops,
+		int cancellable)
+{
+	const uint64_t now = get_time_us();
+	uint64_t wait = 0U;
+
+	for(; throttle != NULL; throttle = throttle->parent)
+	{
+		const uint64_t throttle_wait = take(throttle, bytes, ops, now);
+		if(throttle_wait > wait)
+		{
+			wait = throttle_wait;
+		}
+	}
+
+	while(wait != 0U)
+	{
+		const uint64_t slice = (wait > MAX_SLEEP_US) ? MAX_SLEEP_US : wait;
+
+		if(cancellable && ui_cancellation_requested())
+		{
+			return 1;
+		}
+
+		usleep(slice);
+		wait -= slice;
+	}
+
+	return 0;
+}
+
+uint64_t
+iothrottle_chunk(iothrottle_t *throttle, uint64_t size)
+{
+	for(; throttle != NULL; throttle = throttle->parent)
+	{
+		uint64_t rate;
+
+		pthread_mutex_lock(&throttle->lock);
+		rate = throttle->bytes.rate;
+		pthread_mutex_unlock(&throttle->lock);
+
+		if(rate != 0U)
+		{
+			const uint64_t burst = rate*BURST_US/1000000U;
+			if(burst < size)
+			{
+				size = (burst == 0U) ? 1U : burst;
+			}
+		}
+	}
+	return size;
+}
+
+/* Takes tokens from buckets of a single throttle.  Returns number of
+ * microseconds to wait until the throttle is out of debt. */
+static uint64_t
+take(iothrottle_t *throttle, uint64_t bytes, unsigned int ops, uint64_t now)
+{
+	uint64_t bytes_wait, ops_wait;
+
+	pthread_mutex_lock(&throttle->lock);
+
+	if(now > throttle->last)
+	{
+		refill(&throttle->bytes, now - throttle->last);
+		refill(&throttle->ops, now - throttle->last);
+		throttle->last = now;
+	}
+
+	bytes_wait = take_tokens(&throttle->bytes, bytes);
+	ops_wait = take_tokens(&throttle->ops, ops);
+
+	pthread_mutex_unlock(&throttle->lock);
+
+	return (bytes_wait > ops_wait) ? bytes_wait : ops_wait;
+}
+
+/* Adds tokens accumulated over specified number of microseconds. */
+static void
+refill(bucket_t *bucket, uint64_t elapsed)
+{
+	const double cap = (double)bucket->rate*BURST_US/1e6;
+
+	if(bucket->rate == 0U)
+	{
+		return;
+	}
+
+	bucket->tokens += (double)bucket->rate*elapsed/1e6;
+	if(bucket->tokens > cap)
+	{
+		bucket->tokens = cap;
+	}
+}
+
+/* Takes tokens from the bucket going into debt if there isn't enough of them.
+ * Returns number of microseconds to wait until the debt is repaid. */
+static uint64_t
+take_tokens(bucket_t *bucket, uint64_t amount)
+{
+	if(bucket->rate == 0U)
+	{
+		return 0U;
+	}
+
+	bucket->tokens -= (double)amount;
+	if(bucket->tokens >= 0.0)
+	{
+		return 0U;
+	}
+	return (uint64_t)(-bucket->tokens*1e6/bucket->rate);
+}
+
+/* Changes rate of a bucket forgiving debt accumulated at previous rate. */
+static void
+set_rate(bucket_t *bucket, uint64_t rate)
+{
+	bucket->rate = rate;
+	if(bucket->tokens < 0.0)
+	{
+		bucket->tokens = 0.0;
+	}
+}
+
+/* Retrieves current time.  Returns the time in microseconds. */
+static uint64_t
+get_time_us(void)
+{
+	struct timeval tv;
+	(void)gettimeofday(&tv, NULL);
+	return (uint64_t)tv.tv_sec*1000000U + tv.tv_usec;
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
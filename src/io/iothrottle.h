@@ -0,0 +1,67 @@
+/* vifm
+ * Copyright (C) 2026 agent.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef VIFM__IO__IOTHROTTLE_H__
+#define VIFM__IO__IOTHROTTLE_H__
+
+#include <stdint.h> /* uint64_t */
+
+/* iothrottle - Input/Output throttle - limits rate of operations */
+
+/* Throttle is a pair of token buckets (for bytes and for operations) refilled
+ * at constant rate.  Charging a throttle takes tokens from it and from all of
+ * its parents and sleeps until the most restrictive of them is out of debt,
+ * which makes throttles of several operations that share a parent divide its
+ * rate among themselves.  Zero rate means no limit. */
+
+/* Opaque declaration of throttle type. */
+typedef struct iothrottle_t iothrottle_t;
+
+/* Creates throttle with specified limits (per second) and optional parent.
+ * Returns NULL on error. */
+iothrottle_t * iothrottle_create(uint64_t bytes_rate, uint64_t ops_rate,
+		iothrottle_t *parent);
+
+/* Frees throttle.  The parameter can be NULL. */
+void iothrottle_free(iothrottle_t *throttle);
+
+/* Changes limits of the throttle (per second), which affects operations that
+ * are already running. */
+void iothrottle_set_limits(iothrottle_t *throttle, uint64_t bytes_rate,
+		uint64_t ops_rate);
+
+/* Retrieves throttle shared by all operations.  Returns the throttle. */
+iothrottle_t * iothrottle_global(void);
+
+/* Accounts for processing specified number of bytes and operations, possibly
+ * blocking to stay within the limits.  If cancellable is non-zero, waiting is
+ * interrupted by a request for cancellation.  The throttle can be NULL.
+ * Returns non-zero if waiting was interrupted, otherwise zero is returned. */
+int iothrottle_charge(iothrottle_t *throttle, uint64_t bytes, unsigned int ops,
+		int cancellable);
+
+/* Limits amount of data processed at once to the size of a burst of the most
+ * restrictive of the throttle and its parents, so that processing proceeds in
+ * short steps instead of long runs followed by long waits.  The throttle can
+ * be NULL.  Returns the size, which is between one and the size argument. */
+uint64_t iothrottle_chunk(iothrottle_t *throttle, uint64_t size);
+
+#endif /* VIFM__IO__IOTHROTTLE_H__ */
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
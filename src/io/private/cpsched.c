@@ -0,0 +1,362 @@
+/* vifm
+ * Copyright (C) 2026 agent.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+/* Files are copied by a pool of workers that take jobs from a shared queue in
+ * the order they were scheduled.  Workers don't touch arguments of the whole
+ * operation, each job collects its own errors and the scheduling thread merges
+ * them and reports progress as jobs complete.  This keeps all callbacks on the
+ * thread of the caller.
+ *
+ * Creating directories before their files are scheduled and finalizing
+ * directories after all files are copied is left to the caller. */
+
+#include "cpsched.h"
+
+#include <pthread.h> /* PTHREAD_* pthread_* */
+
+#include <stddef.h> /* NULL size_t */
+#include <stdint.h> /* uint64_t */
+#include <stdlib.h> /* calloc() free() */
+#include <string.h> /* strdup() */
+
+#include "../../ui/cancellation.h"
+#include "../../utils/fs.h"
+#include "../../utils/macros.h"
+#include "../ioc.h"
+#include "../ioe.h"
+#include "../iop.h"
+#include "ioe.h"
+#include "ioeta.h"
+
+/* Maximum number of threads to use. */
+#define MAX_WORKERS 16
+
+/* Maximum number of jobs per worker that can wait in the queue.  Limits memory
+ * consumption and makes scheduling thread report progress regularly. */
+#define QUEUE_DEPTH 16
+
+/* Copying of a single file. */
+typedef struct job_t
+{
+	struct job_t *next;  /* Next job in the queue or in the list of done ones. */
+	char *src;           /* Source path. */
+	char *dst;           /* Destination path. */
+	int skipped;         /* Whether copying wasn't even attempted. */
+	int failed;          /* Whether copying has failed. */
+	uint64_t bytes;      /* Amount of copied data. */
+	ioe_errlst_t errors; /* Errors that occurred during copying. */
+}
+job_t;
+
+struct cpsched_t
+{
+	io_args_t *args; /* Parameters and results of the whole operation. */
+
+	pthread_t threads[MAX_WORKERS]; /* Worker threads. */
+	int nthreads;                   /* Number of started workers. */
+
+	pthread_mutex_t lock;      /* Protects fields below. */
+	pthread_cond_t work_cond;  /* Signaled on new jobs and on stopping. */
+	pthread_cond_t done_cond;  /* Signaled when a job is completed. */
+	job_t *queue_head;         /* First job waiting for a worker. */
+	job_t *queue_tail;         /* Last job waiting for a worker. */
+	job_t *done;               /* Jobs to be reported. */
+	size_t npending;           /* Number of queued and running jobs. */
+	int stopping;              /* Whether no more jobs are going to be added. */
+	int failed;                /* Whether any of the jobs failed. */
+};
+
+static void * worker_thread(void *arg);
+static void run_job(const io_args_t *args, job_t *job);
+static int cancelled(const io_args_t *args);
+static job_t * take_done(cpsched_t *sched);
+static void report_done(cpsched_t *sched, job_t *done);
+static void free_job(job_t *job);
+
+cpsched_t *
+cpsched_start(io_args_t *args, int nworkers)
+{
+	int i;
+	cpsched_t *const sched = calloc(1, sizeof(*sched));
+	if(sched == NULL)
+	{
+		return NULL;
+	}
+
+	sched->args = args;
+	pthread_mutex_init(&sched->lock, NULL);
+	pthread_cond_init(&sched->work_cond, NULL);
+	pthread_cond_init(&sched->done_cond, NULL);
+
+	nworkers = MIN(nworkers, MAX_WORKERS);
+	for(i = 0; i < nworkers; ++i)
+	{
+		if(pthread_create(&sched->threads[sched->nthreads], NULL, &worker_thread,
+					sched) == 0)
+		{
+			++sched->nthreads;
+		}
+	}
+
+	if(sched->nthreads == 0)
+	{
+		(void)cpsched_finish(sched);
+		return NULL;
+	}
+
+	return sched;
+}
+
+int
+cpsched_copy(cpsched_t *sched, const char src[], const char dst[])
+{
+	job_t *done;
+	int failed;
+	job_t *const job = calloc(1, sizeof(*job));
+
+	if(job == NULL || (job->src = strdup(src)) == NULL ||
+			(job->dst = strdup(dst)) == NULL)
+	{
+		free_job(job);
+		(void)ioe_errlst_append(&sched->args->result.errors, src, IO_ERR_UNKNOWN,
+				"Not enough memory");
+		return 1;
+	}
+	ioe_errlst_init(&job->errors);
+	job->errors.active = sched->args->result.errors.active;
+
+	pthread_mutex_lock(&sched->lock);
+	while(sched->npending >= (size_t)sched->nthreads*QUEUE_DEPTH &&
+			!sched->failed)
+	{
+		pthread_cond_wait(&sched->done_cond, &sched->lock);
+	}
+
+	failed = sched->failed;
+	if(!failed)
+	{
+		if(sched->queue_tail == NULL)
+		{
+			sched->queue_head = job;
+		}
+		else
+		{
+			sched->queue_tail->next = job;
+		}
+		sched->queue_tail = job;
+		++sched->npending;
+		pthread_cond_signal(&sched->work_cond);
+	}
+
+	done = take_done(sched);
+	pthread_mutex_unlock(&sched->lock);
+
+	if(failed)
+	{
+		free_job(job);
+	}
+
+	report_done(sched, done);
+	return failed || cancelled(sched->args);
+}
+
+int
+cpsched_finish(cpsched_t *sched)
+{
+	int i;
+	int failed;
+
+	pthread_mutex_lock(&sched->lock);
+	sched->stopping = 1;
+	pthread_cond_broadcast(&sched->work_cond);
+	while(sched->npending != 0U)
+	{
+		job_t *done;
+
+		pthread_cond_wait(&sched->done_cond, &sched->lock);
+
+		done = take_done(sched);
+		pthread_mutex_unlock(&sched->lock);
+		report_done(sched, done);
+		pthread_mutex_lock(&sched->lock);
+	}
+	pthread_mutex_unlock(&sched->lock);
+
+	for(i = 0; i < sched->nthreads; ++i)
+	{
+		(void)pthread_join(sched->threads[i], NULL);
+	}
+
+	report_done(sched, take_done(sched));
+	failed = sched->failed;
+
+	pthread_cond_destroy(&sched->done_cond);
+	pthread_cond_destroy(&sched->work_cond);
+	pthread_mutex_destroy(&sched->lock);
+	free(sched);
+
+	return failed;
+}
+
+/* Entry point of worker threads.  Processes queued jobs until scheduler is
+ * stopped.  Returns NULL. */
+static void *
+worker_thread(void *arg)
+{
+	cpsched_t *const sched = arg;
+
+	pthread_mutex_lock(&sched->lock);
+	while(1)
+	{
+		job_t *job;
+
+		while(sched->queue_head == NULL && !sched->stopping)
+		{
+			pthread_cond_wait(&sched->work_cond, &sched->lock);
+		}
+
+		job = sched->queue_head;
+		if(job == NULL)
+		{
+			break;
+		}
+
+		sched->queue_head = job->next;
+		if(sched->queue_head == NULL)
+		{
+			sched->queue_tail = NULL;
+		}
+		job->next = NULL;
+
+		/* There is no point in copying more files after a failure. */
+		job->skipped = sched->failed;
+		pthread_mutex_unlock(&sched->lock);
+
+		if(!job->skipped)
+		{
+			run_job(sched->args, job);
+		}
+
+		pthread_mutex_lock(&sched->lock);
+		sched->failed |= job->failed;
+		job->next = sched->done;
+		sched->done = job;
+		--sched->npending;
+		pthread_cond_broadcast(&sched->done_cond);
+	}
+	pthread_mutex_unlock(&sched->lock);
+
+	return NULL;
+}
+
+/* Copies a single file.  Fields of the args are only read. */
+static void
+run_job(const io_args_t *args, job_t *job)
+{
+	io_args_t job_args = {
+		.arg1.src = job->src,
+		.arg2.dst = job->dst,
+		.arg3.crs = args->arg3.crs,
+		.arg4.fast_file_cloning = args->arg4.fast_file_cloning,
+
+		.cancellable = args->cancellable,
+		.verify = args->verify,
+		.journal = args->journal,
+		.throttle = args->throttle,
+
+		.result.errors = job->errors,
+	};
+
+	if(cancelled(args))
+	{
+		job->skipped = 1;
+		job->failed = 1;
+		return;
+	}
+
+	job->failed = (iop_cp(&job_args) != 0);
+	job->errors = job_args.result.errors;
+
+	/* Count data the same way estimation does. */
+	if(!job->failed && !is_symlink(job->src))
+	{
+		job->bytes = get_file_data_size(job->src);
+	}
+}
+
+/* Checks whether operation was cancelled.  Returns non-zero if so. */
+static int
+cancelled(const io_args_t *args)
+{
+	return args->cancellable && ui_cancellation_requested();
+}
+
+/* Detaches list of completed jobs.  Must be called with the lock held.  Returns
+ * the list. */
+static job_t *
+take_done(cpsched_t *sched)
+{
+	job_t *const done = sched->done;
+	sched->done = NULL;
+	return done;
+}
+
+/* Merges results of completed jobs into the results of the whole operation and
+ * frees the jobs. */
+static void
+report_done(cpsched_t *sched, job_t *done)
+{
+	io_args_t *const args = sched->args;
+
+	while(done != NULL)
+	{
+		job_t *const next = done->next;
+		size_t i;
+
+		for(i = 0U; i < done->errors.error_count; ++i)
+		{
+			const ioe_err_t *const err = &done->errors.errors[i];
+			(void)ioe_errlst_append(&args->result.errors, err->path, err->error_code,
+					err->msg);
+		}
+
+		if(!done->failed && !done->skipped)
+		{
+			ioeta_update(args->estim, done->src, done->dst, 1, done->bytes);
+		}
+
+		free_job(done);
+		done = next;
+	}
+}
+
+/* Frees a job.  The job can be NULL. */
+static void
+free_job(job_t *job)
+{
+	if(job != NULL)
+	{
+		ioe_errlst_free(&job->errors);
+		free(job->src);
+		free(job->dst);
+		free(job);
+	}
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,49 @@
+/* vifm
+ * Copyright (C) 2026 agent.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef VIFM__IO__PRIVATE__CPSCHED_H__
+#define VIFM__IO__PRIVATE__CPSCHED_H__
+
+#include "../ioc.h"
+
+/* cpsched - copy scheduler - copies independent files concurrently */
+
+/* Opaque declaration of scheduler type. */
+typedef struct cpsched_t cpsched_t;
+
+/* Starts up to nworkers threads that copy files according to settings of the
+ * args (conflict resolution, file cloning and cancellation).  Errors are
+ * appended to error list of the args and progress is reported via its estimate
+ * only from the thread that calls functions of this unit, so overwrite
+ * confirmation isn't supported.  Returns NULL on failure to start threads. */
+cpsched_t * cpsched_start(io_args_t *args, int nworkers);
+
+/* Schedules copying of a file.  Might wait until some of previously scheduled
+ * files are copied.  Returns non-zero if copying should be stopped because of
+ * an error or cancellation, otherwise zero is returned. */
+int cpsched_copy(cpsched_t *sched, const char src[], const char dst[]);
+
+/* Waits for all scheduled files to be copied, stops workers and frees the
+ * scheduler.  Returns non-zero if any of the files wasn't copied, otherwise
+ * zero is returned. */
+int cpsched_finish(cpsched_t *sched);
+
+#endif /* VIFM__IO__PRIVATE__CPSCHED_H__ */
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
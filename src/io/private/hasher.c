@@ -0,0 +1,216 @@
+/* vifm
+ * Copyright (C) 2026 agent.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+/* Buffers are passed between producer and the hashing thread, so data isn't
+ * copied.  Small number of buffers is enough to keep both sides busy while
+ * limiting amount of memory in use. */
+
+#include "hasher.h"
+
+#include <pthread.h> /* PTHREAD_* pthread_* */
+
+#include <stddef.h> /* NULL size_t */
+#include <stdlib.h> /* calloc() free() posix_memalign() */
+
+#include "../../utils/checksum.h"
+
+/* Number of buffers. */
+#define NBUFS 4
+
+/* Alignment of buffers, which is enough for direct I/O on most systems. */
+#define BUF_ALIGNMENT 4096
+
+/* Piece of data queued for hashing. */
+typedef struct
+{
+	int buf;       /* Index of the buffer. */
+	size_t offset; /* Offset of the data in the buffer. */
+	size_t len;    /* Length of the data. */
+}
+chunk_t;
+
+struct hasher_t
+{
+	pthread_t thread;   /* Hashing thread. */
+	checksum_t cs;      /* State of computation, used only by the thread. */
+	char *bufs[NBUFS];  /* Buffers. */
+
+	pthread_mutex_t lock;  /* Protects fields below. */
+	pthread_cond_t cond;   /* Signaled on any change of the state. */
+	int free[NBUFS];       /* Stack of indexes of free buffers. */
+	int nfree;             /* Number of free buffers. */
+	chunk_t queue[NBUFS];  /* Ring of chunks queued for hashing. */
+	int head;              /* Index of the first queued chunk. */
+	int nqueued;           /* Number of queued chunks. */
+	int finishing;         /* Whether no more data will be queued. */
+};
+
+static void * hasher_thread(void *arg);
+static void free_hasher(hasher_t *hasher);
+
+hasher_t *
+hasher_create(ChecksumKind kind, size_t buf_size)
+{
+	int i;
+	hasher_t *const hasher = calloc(1, sizeof(*hasher));
+	if(hasher == NULL)
+	{
+		return NULL;
+	}
+
+	for(i = 0; i < NBUFS; ++i)
+	{
+		void *buf;
+		if(posix_memalign(&buf, BUF_ALIGNMENT, buf_size) != 0)
+		{
+			free_hasher(hasher);
+			return NULL;
+		}
+		hasher->bufs[i] = buf;
+		hasher->free[hasher->nfree++] = i;
+	}
+
+	checksum_init(&hasher->cs, kind);
+	pthread_mutex_init(&hasher->lock, NULL);
+	pthread_cond_init(&hasher->cond, NULL);
+
+	if(pthread_create(&hasher->thread, NULL, &hasher_thread, hasher) != 0)
+	{
+		pthread_cond_destroy(&hasher->cond);
+		pthread_mutex_destroy(&hasher->lock);
+		free_hasher(hasher);
+		return NULL;
+	}
+
+	return hasher;
+}
+
+char *
+hasher_get_buf(hasher_t *hasher)
+{
+	char *buf;
+
+	pthread_mutex_lock(&hasher->lock);
+	while(hasher->nfree == 0)
+	{
+		pthread_cond_wait(&hasher->cond, &hasher->lock);
+	}
+	buf = hasher->bufs[hasher->free[--hasher->nfree]];
+	pthread_mutex_unlock(&hasher->lock);
+
+	return buf;
+}
+
+void
+hasher_put_buf(hasher_t *hasher, char buf[], size_t offset, size_t len)
+{
+	int i = 0;
+	while(hasher->bufs[i] != buf)
+	{
+		++i;
+	}
+
+	pthread_mutex_lock(&hasher->lock);
+	if(len == 0U)
+	{
+		hasher->free[hasher->nfree++] = i;
+	}
+	else
+	{
+		const int tail = (hasher->head + hasher->nqueued)%NBUFS;
+		chunk_t *const chunk = &hasher->queue[tail];
+		chunk->buf = i;
+		chunk->offset = offset;
+		chunk->len = len;
+		++hasher->nqueued;
+	}
+	pthread_cond_broadcast(&hasher->cond);
+	pthread_mutex_unlock(&hasher->lock);
+}
+
+size_t
+hasher_finish(hasher_t *hasher, unsigned char digest[CHECKSUM_MAX_LEN])
+{
+	size_t len;
+
+	pthread_mutex_lock(&hasher->lock);
+	hasher->finishing = 1;
+	pthread_cond_broadcast(&hasher->cond);
+	pthread_mutex_unlock(&hasher->lock);
+
+	(void)pthread_join(hasher->thread, NULL);
+
+	len = checksum_final(&hasher->cs, digest);
+
+	pthread_cond_destroy(&hasher->cond);
+	pthread_mutex_destroy(&hasher->lock);
+	free_hasher(hasher);
+	return len;
+}
+
+/* Entry point of hashing thread.  Returns NULL. */
+static void *
+hasher_thread(void *arg)
+{
+	hasher_t *const hasher = arg;
+
+	pthread_mutex_lock(&hasher->lock);
+	while(1)
+	{
+		chunk_t chunk;
+
+		while(hasher->nqueued == 0 && !hasher->finishing)
+		{
+			pthread_cond_wait(&hasher->cond, &hasher->lock);
+		}
+		if(hasher->nqueued == 0)
+		{
+			break;
+		}
+
+		chunk = hasher->queue[hasher->head];
+		hasher->head = (hasher->head + 1)%NBUFS;
+		--hasher->nqueued;
+		pthread_mutex_unlock(&hasher->lock);
+
+		checksum_update(&hasher->cs, hasher->bufs[chunk.buf] + chunk.offset,
+				chunk.len);
+
+		pthread_mutex_lock(&hasher->lock);
+		hasher->free[hasher->nfree++] = chunk.buf;
+		pthread_cond_broadcast(&hasher->cond);
+	}
+	pthread_mutex_unlock(&hasher->lock);
+
+	return NULL;
+}
+
+/* Frees memory of the hasher. */
+static void
+free_hasher(hasher_t *hasher)
+{
+	int i;
+	for(i = 0; i < NBUFS; ++i)
+	{
+		free(hasher->bufs[i]);
+	}
+	free(hasher);
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,51 @@
+/* vifm
+ * Copyright (C) 2026 agent.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef VIFM__IO__PRIVATE__HASHER_H__
+#define VIFM__IO__PRIVATE__HASHER_H__
+
+#include <stddef.h> /* size_t */
+
+#include "../../utils/checksum.h"
+
+/* hasher - computes checksum of a data stream in a separate thread, so that
+ *          hashing overlaps with reading and writing of the data */
+
+/* Opaque declaration of hasher type. */
+typedef struct hasher_t hasher_t;
+
+/* Starts a thread that hashes buffers of buf_size bytes (aligned for direct
+ * I/O) as they are queued.  Returns NULL on error. */
+hasher_t * hasher_create(ChecksumKind kind, size_t buf_size);
+
+/* Retrieves a buffer to fill with data, waiting until one is free.  The buffer
+ * must be given back via hasher_put_buf(). */
+char * hasher_get_buf(hasher_t *hasher);
+
+/* Gives back the buffer queuing len bytes of it starting at offset for
+ * hashing.  Zero len just frees the buffer. */
+void hasher_put_buf(hasher_t *hasher, char buf[], size_t offset, size_t len);
+
+/* Waits for all queued data to be hashed and frees the hasher.  Returns length
+ * of the digest. */
+size_t hasher_finish(hasher_t *hasher, unsigned char digest[CHECKSUM_MAX_LEN]);
+
+#endif /* VIFM__IO__PRIVATE__HASHER_H__ */
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
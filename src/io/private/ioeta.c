@@ -18,13 +18,17 @@
 
 #include "ioeta.h"
 
-#include <stddef.h> /* NULL */
+#include <stddef.h> /* NULL size_t */
 #include <stdint.h> /* uint64_t */
 
 #include "../../utils/fs.h"
+#include "../../utils/macros.h"
 #include "../../utils/str.h"
 #include "../ioeta.h"
 #include "ionotif.h"
+#include "walker.h"
+
+static void sync_totals(ioeta_estim_t *estim);
 
 void
 ioeta_add_item(ioeta_estim_t *estim, const char path[])
@@ -41,7 +45,7 @@ ioeta_add_file(ioeta_estim_t *estim, const char path[])
 {
 	if(!is_symlink(path))
 	{
-		estim->total_bytes += get_file_size(path);
+		estim->total_bytes += get_file_data_size(path);
 	}
 
 	ioeta_add_item(estim, path);
@@ -64,6 +68,8 @@ ioeta_update(ioeta_estim_t *estim, const char path[], const char target[],
 		return;
 	}
 
+	sync_totals(estim);
+
 	estim->current_byte += bytes;
 	estim->current_file_byte += bytes;
 	if(estim->current_byte > estim->total_bytes)
@@ -86,7 +92,7 @@ ioeta_update(ioeta_estim_t *estim, const char path[], const char target[],
 	else if(estim->inspected_items != estim->current_item + 1)
 	{
 		estim->inspected_items = estim->current_item + 1;
-		estim->total_file_bytes = get_file_size(path);
+		estim->total_file_bytes = get_file_data_size(path);
 	}
 
 	if(path != NULL)
@@ -102,6 +108,57 @@ ioeta_update(ioeta_estim_t *estim, const char path[], const char target[],
 	ionotif_notify(IO_PS_IN_PROGRESS, estim);
 }
 
+void
+ioeta_update_batch(ioeta_estim_t *estim, const char path[], size_t nitems,
+		uint64_t nbytes)
+{
+	if(estim == NULL || estim->silent)
+	{
+		return;
+	}
+
+	sync_totals(estim);
+
+	estim->current_item += nitems;
+	estim->current_byte += nbytes;
+	estim->total_items = MAX(estim->total_items, estim->current_item);
+	estim->total_bytes = MAX(estim->total_bytes, estim->current_byte);
+	estim->current_file_byte = 0U;
+	estim->total_file_bytes = 0U;
+
+	replace_string(&estim->item, path);
+	replace_string(&estim->target, path);
+
+	ionotif_notify(IO_PS_IN_PROGRESS, estim);
+}
+
+void
+ioeta_add_found(ioeta_estim_t *estim, size_t nitems, uint64_t nbytes)
+{
+	if(estim != NULL && !estim->silent && estim->shallow)
+	{
+		estim->total_items += nitems;
+		estim->total_bytes += nbytes;
+	}
+}
+
+/* Picks up totals calculated in background so far. */
+static void
+sync_totals(ioeta_estim_t *estim)
+{
+	size_t nitems;
+	uint64_t nbytes;
+
+	if(estim->walker == NULL)
+	{
+		return;
+	}
+
+	walker_get_totals(estim->walker, &nitems, &nbytes);
+	estim->total_items = MAX(estim->total_items, nitems);
+	estim->total_bytes = MAX(estim->total_bytes, nbytes);
+}
+
 int
 ioeta_silent_on(ioeta_estim_t *estim)
 {
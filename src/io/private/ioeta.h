@@ -19,6 +19,7 @@
 #ifndef VIFM__IO__PRIVATE__IOETA_H__
 #define VIFM__IO__PRIVATE__IOETA_H__
 
+#include <stddef.h> /* size_t */
 #include <stdint.h> /* uint64_t */
 
 #include "../ioeta.h"
@@ -44,6 +45,16 @@ void ioeta_add_dir(ioeta_estim_t *estim, const char path[]);
 void ioeta_update(ioeta_estim_t *estim, const char path[], const char target[],
 		int finished, uint64_t bytes);
 
+/* Reports that nitems items of nbytes bytes in total were processed since the
+ * last update, the path becomes current item.  Does nothing if estim is NULL.
+ * Calls progress changed notification handler. */
+void ioeta_update_batch(ioeta_estim_t *estim, const char path[], size_t nitems,
+		uint64_t nbytes);
+
+/* Adds entries found inside directories during operation to totals if
+ * estimation was shallow.  Does nothing if estim is NULL. */
+void ioeta_add_found(ioeta_estim_t *estim, size_t nitems, uint64_t nbytes);
+
 /* Silence future progress reports.  Returns previous state to be passed to
  * ioeta_silent_set() later.  If estim is NULL, returns zero. */
 int ioeta_silent_on(ioeta_estim_t *estim);
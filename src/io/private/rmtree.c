@@ -0,0 +1,810 @@
+/* vifm
+ * Copyright (C) 2026 agent.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+/* Directories are tasks that workers take from a shared stack.  A worker opens
+ * a directory relative to descriptor of its parent, lists it, unlinks its files
+ * relative to its own descriptor and pushes subdirectories as new tasks.
+ * Directory is removed relative to descriptor of its parent by the worker that
+ * finishes the last of its pending parts (the listing and subdirectories),
+ * which then does the same for the parent.  Descriptor of a directory is kept
+ * open until it's removed, because its subdirectories need it.
+ *
+ * Workers only count what they remove, the calling thread reports progress in
+ * batches and checks for cancellation.  This keeps all callbacks on the thread
+ * of the caller.
+ *
+ * When io_uring is available, each worker queries and unlinks entries of a
+ * directory in batches of requests instead of doing a system call per entry. */
+
+#include "rmtree.h"
+
+#include <pthread.h> /* PTHREAD_* pthread_* */
+#include <sys/stat.h> /* S_ISDIR() S_ISLNK() fstatat() stat */
+#include <sys/time.h> /* gettimeofday() timeval */
+#include <fcntl.h> /* AT_FDCWD AT_REMOVEDIR AT_SYMLINK_NOFOLLOW O_* openat() */
+#include <unistd.h> /* close() unlinkat() */
+
+#include <errno.h> /* ENOENT ENOMEM errno */
+#include <stddef.h> /* NULL size_t */
+#include <stdint.h> /* uint64_t */
+#include <stdlib.h> /* calloc() free() malloc() */
+#include <string.h> /* strdup() strerror() strrchr() */
+#include <time.h> /* timespec */
+
+#include "../../ui/cancellation.h"
+#include "../../utils/dirents.h"
+#include "../../utils/fs.h"
+#include "../../utils/macros.h"
+#include "../../utils/str.h"
+#include "../ioc.h"
+#include "../ioe.h"
+#include "../iothrottle.h"
+#include "ioe.h"
+#include "ioeta.h"
+#include "uring.h"
+
+/* Maximum number of threads to use. */
+#define MAX_WORKERS 16
+
+/* Interval between progress reports in milliseconds. */
+#define PROGRESS_INTERVAL_MS 100
+
+/* Number of removed files after which worker publishes its counters. */
+#define BATCH_SIZE 256
+
+/* Maximum number of entries processed by a single batch of requests. */
+#define RING_SIZE 64
+
+/* Depth starting from which descriptors of directories are closed right after
+ * processing their entries so that deep trees don't exhaust descriptors.
+ * Subdirectories of such directories are accessed by full path. */
+#define MAX_OPEN_LEVELS 64
+
+/* Wrappers for atomic accesses. */
+#define ADD(var, val) (void)__atomic_add_fetch(&(var), (val), __ATOMIC_RELAXED)
+#define LOAD(var) __atomic_load_n(&(var), __ATOMIC_RELAXED)
+#define STORE(var, val) __atomic_store_n(&(var), (val), __ATOMIC_RELAXED)
+
+/* Directory that is being removed. */
+typedef struct dir_t
+{
+	char *path;           /* Full path to the directory. */
+	const char *name;     /* Name of the directory inside of the parent. */
+	int fd;               /* Descriptor of the directory or -1. */
+	int depth;            /* Number of parents. */
+	struct dir_t *parent; /* Parent directory or NULL for the root. */
+	struct dir_t *next;   /* Next task in the stack. */
+	int pending;          /* Listing plus number of unfinished subdirs. */
+	int failed;           /* Whether some of the entries weren't removed. */
+}
+dir_t;
+
+/* Counters of processed entries. */
+typedef struct
+{
+	size_t removed_items;   /* Number of removed files and directories. */
+	uint64_t removed_bytes; /* Size of removed files. */
+	size_t found_items;     /* Number of listed files and directories. */
+	uint64_t found_bytes;   /* Size of listed files. */
+}
+counters_t;
+
+/* State of a removal. */
+typedef struct
+{
+	int count_bytes;        /* Whether sizes of files are needed for progress. */
+	int cancellable;        /* Whether removal can be cancelled. */
+	iothrottle_t *throttle; /* Limiter of rate of removals or NULL. */
+
+	pthread_mutex_t lock;     /* Protects fields below. */
+	pthread_cond_t work_cond; /* Signaled on new tasks and on finishing. */
+	pthread_cond_t done_cond; /* Signaled on finishing. */
+	dir_t *tasks;             /* Stack of directories to be listed. */
+	int finished;             /* Whether the root was processed. */
+	int failed;               /* Whether the root wasn't removed. */
+	ioe_errlst_t errors;      /* Errors of workers. */
+
+	int stop;            /* Whether removal should be stopped. */
+	counters_t counters; /* Statistics updated by workers. */
+}
+rm_state_t;
+
+/* Entries of a directory that are processed via a ring of requests. */
+typedef struct
+{
+	uring_t *ring;                /* Ring of the worker or NULL. */
+	int count;                    /* Number of entries in the batch. */
+	const char *names[RING_SIZE]; /* Names of entries, NULL means skipped. */
+	DirEntType types[RING_SIZE];  /* Types of entries. */
+	uint64_t sizes[RING_SIZE];    /* Sizes of entries. */
+	struct stat st[RING_SIZE];    /* Results of queries of entries. */
+	int queued[RING_SIZE];        /* Indexes of entries in the order of queue. */
+	int results[RING_SIZE];       /* Results of requests. */
+}
+batch_t;
+
+static void * worker_thread(void *arg);
+static void run_worker(rm_state_t *state);
+static void process_dir(rm_state_t *state, dir_t *dir, dirents_t *list,
+		batch_t *batch);
+static int process_entry(rm_state_t *state, dir_t *dir, int fd,
+		const char name[], DirEntType type, counters_t *local);
+static int process_batch(rm_state_t *state, dir_t *dir, int fd, batch_t *batch,
+		counters_t *local);
+static int query_batch(rm_state_t *state, dir_t *dir, int fd, batch_t *batch);
+static int unlink_batch(rm_state_t *state, dir_t *dir, int fd, batch_t *batch,
+		counters_t *local);
+static void drop_ring(batch_t *batch);
+static int needs_stat(const rm_state_t *state, DirEntType type);
+static int spawn_subdir(rm_state_t *state, dir_t *dir, const char name[]);
+static void release_dir(rm_state_t *state, dir_t *dir);
+static void publish(rm_state_t *state, counters_t *local);
+static void report_progress(io_args_t *args, rm_state_t *state,
+		counters_t *reported);
+static void add_error(rm_state_t *state, const char dir[], const char name[],
+		int error_code);
+static dir_t * make_dir(char path[], dir_t *parent);
+static int get_base(const dir_t *dir, const char **name);
+static void get_deadline(struct timespec *ts);
+
+int
+rmtree_run(io_args_t *args, int nworkers)
+{
+	pthread_t threads[MAX_WORKERS];
+	int nthreads = 0;
+	int i;
+	size_t j;
+	counters_t reported = { .removed_items = 0U };
+	rm_state_t state = {
+		.count_bytes = (args->estim != NULL),
+		.cancellable = args->cancellable,
+		.throttle = args->throttle,
+		.lock = PTHREAD_MUTEX_INITIALIZER,
+		.work_cond = PTHREAD_COND_INITIALIZER,
+		.done_cond = PTHREAD_COND_INITIALIZER,
+	};
+
+	char *const root_path = strdup(args->arg1.path);
+	dir_t *const root = (root_path == NULL) ? NULL : make_dir(root_path, NULL);
+	if(root == NULL)
+	{
+		free(root_path);
+		(void)ioe_errlst_append(&args->result.errors, args->arg1.path, ENOMEM,
+				strerror(ENOMEM));
+		return 1;
+	}
+
+	ioe_errlst_init(&state.errors);
+	state.errors.active = args->result.errors.active;
+	state.tasks = root;
+
+	nworkers = MIN(nworkers, MAX_WORKERS);
+	for(i = 0; i < nworkers; ++i)
+	{
+		if(pthread_create(&threads[nthreads], NULL, &worker_thread, &state) == 0)
+		{
+			++nthreads;
+		}
+	}
+
+	if(nthreads == 0)
+	{
+		/* Do all the work here without intermediate reports. */
+		run_worker(&state);
+	}
+
+	pthread_mutex_lock(&state.lock);
+	while(!state.finished)
+	{
+		struct timespec deadline;
+		get_deadline(&deadline);
+		(void)pthread_cond_timedwait(&state.done_cond, &state.lock, &deadline);
+		pthread_mutex_unlock(&state.lock);
+
+		report_progress(args, &state, &reported);
+		if(args->cancellable && ui_cancellation_requested())
+		{
+			STORE(state.stop, 1);
+		}
+
+		pthread_mutex_lock(&state.lock);
+	}
+	pthread_mutex_unlock(&state.lock);
+
+	for(i = 0; i < nthreads; ++i)
+	{
+		(void)pthread_join(threads[i], NULL);
+	}
+
+	report_progress(args, &state, &reported);
+
+	for(j = 0U; j < state.errors.error_count; ++j)
+	{
+		const ioe_err_t *const err = &state.errors.errors[j];
+		(void)ioe_errlst_append(&args->result.errors, err->path, err->error_code,
+				err->msg);
+	}
+	ioe_errlst_free(&state.errors);
+
+	pthread_cond_destroy(&state.done_cond);
+	pthread_cond_destroy(&state.work_cond);
+	pthread_mutex_destroy(&state.lock);
+
+	return state.failed;
+}
+
+/* Entry point of worker threads.  Returns NULL. */
+static void *
+worker_thread(void *arg)
+{
+	run_worker(arg);
+	return NULL;
+}
+
+/* Processes directories until the root is removed or removal fails. */
+static void
+run_worker(rm_state_t *state)
+{
+	dirents_t list = { .buf = NULL };
+	batch_t *const batch = malloc(sizeof(*batch));
+	if(batch != NULL)
+	{
+		batch->ring = uring_create(RING_SIZE);
+		batch->count = 0;
+	}
+
+	pthread_mutex_lock(&state->lock);
+	while(1)
+	{
+		dir_t *dir;
+
+		while(state->tasks == NULL && !state->finished)
+		{
+			pthread_cond_wait(&state->work_cond, &state->lock);
+		}
+
+		if(state->finished)
+		{
+			break;
+		}
+
+		dir = state->tasks;
+		state->tasks = dir->next;
+		pthread_mutex_unlock(&state->lock);
+
+		process_dir(state, dir, &list, batch);
+
+		pthread_mutex_lock(&state->lock);
+	}
+	pthread_mutex_unlock(&state->lock);
+
+	dirents_free(&list);
+	if(batch != NULL)
+	{
+		uring_free(batch->ring);
+		free(batch);
+	}
+}
+
+/* Removes files of the directory and spawns tasks for its subdirectories.  The
+ * list is a buffer for entries and the batch is a batch for requests reused by
+ * the worker, the batch can be NULL. */
+static void
+process_dir(rm_state_t *state, dir_t *dir, dirents_t *list, batch_t *batch)
+{
+	const char *name;
+	DirEntType type;
+	size_t pos = 0U;
+	counters_t local = { .removed_items = 0U };
+	int fd = -1;
+
+	if(!LOAD(state->stop))
+	{
+		const int base = get_base(dir, &name);
+		fd = openat(base, name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC |
+		                        O_NOCTTY);
+	}
+	if(fd < 0 || dirents_read(list, fd) != 0)
+	{
+		if(!LOAD(state->stop))
+		{
+			add_error(state, dir->path, NULL, errno);
+		}
+		if(fd >= 0)
+		{
+			(void)close(fd);
+		}
+		STORE(dir->failed, 1);
+		release_dir(state, dir);
+		return;
+	}
+
+	/* Subdirectories are opened relative to this descriptor. */
+	dir->fd = fd;
+
+	while((name = dirents_next(list, &pos, &type)) != NULL)
+	{
+		int failed;
+
+		if(LOAD(state->stop))
+		{
+			STORE(dir->failed, 1);
+			break;
+		}
+
+		if(batch == NULL || batch->ring == NULL)
+		{
+			failed = process_entry(state, dir, fd, name, type, &local);
+		}
+		else
+		{
+			batch->names[batch->count] = name;
+			batch->types[batch->count] = type;
+			++batch->count;
+
+			failed = (batch->count == RING_SIZE)
+			       ? process_batch(state, dir, fd, batch, &local)
+			       : 0;
+		}
+
+		if(failed)
+		{
+			STORE(dir->failed, 1);
+			break;
+		}
+
+		if(local.removed_items >= BATCH_SIZE)
+		{
+			publish(state, &local);
+		}
+	}
+
+	if(batch != NULL && batch->count != 0)
+	{
+		if(name != NULL || process_batch(state, dir, fd, batch, &local) != 0)
+		{
+			STORE(dir->failed, 1);
+		}
+		batch->count = 0;
+	}
+
+	if(dir->depth >= MAX_OPEN_LEVELS)
+	{
+		/* Subdirectories use full paths, see get_base(). */
+		(void)close(fd);
+		dir->fd = -1;
+	}
+
+	publish(state, &local);
+	release_dir(state, dir);
+}
+
+/* Removes a file or spawns task for a subdirectory.  Returns zero on success,
+ * otherwise non-zero is returned. */
+static int
+process_entry(rm_state_t *state, dir_t *dir, int fd, const char name[],
+		DirEntType type, counters_t *local)
+{
+	uint64_t size = 0U;
+
+	if(needs_stat(state, type))
+	{
+		struct stat st;
+		if(fstatat(fd, name, &st, AT_SYMLINK_NOFOLLOW) != 0)
+		{
+			if(errno == ENOENT)
+			{
+				/* Someone else has removed it already. */
+				return 0;
+			}
+			add_error(state, dir->path, name, errno);
+			return 1;
+		}
+
+		if(S_ISDIR(st.st_mode))
+		{
+			type = DET_DIR;
+		}
+		else if(!S_ISLNK(st.st_mode))
+		{
+			/* Count data the same way estimation does. */
+			size = estimate_data_size(st.st_size, (uint64_t)st.st_blocks*512U);
+		}
+	}
+
+	++local->found_items;
+	local->found_bytes += size;
+
+	if(type == DET_DIR)
+	{
+		return spawn_subdir(state, dir, name);
+	}
+
+	(void)iothrottle_charge(state->throttle, 0U, 1U, state->cancellable);
+	/* File that someone else has removed already doesn't need removing. */
+	if(unlinkat(fd, name, 0) != 0 && errno != ENOENT)
+	{
+		add_error(state, dir->path, name, errno);
+		return 1;
+	}
+
+	++local->removed_items;
+	local->removed_bytes += size;
+	return 0;
+}
+
+/* Processes entries of the batch and empties it.  Returns zero on success,
+ * otherwise non-zero is returned. */
+static int
+process_batch(rm_state_t *state, dir_t *dir, int fd, batch_t *batch,
+		counters_t *local)
+{
+	int i;
+	int failed = 0;
+
+	if(query_batch(state, dir, fd, batch) != 0)
+	{
+		batch->count = 0;
+		return 1;
+	}
+
+	if(batch->ring == NULL)
+	{
+		/* The ring broke, redo everything synchronously. */
+		for(i = 0; i < batch->count && !failed; ++i)
+		{
+			failed = process_entry(state, dir, fd, batch->names[i], batch->types[i],
+					local);
+		}
+		batch->count = 0;
+		return failed;
+	}
+
+	failed = unlink_batch(state, dir, fd, batch, local);
+	batch->count = 0;
+	return failed;
+}
+
+/* Determines types and sizes of entries of the batch that need it.  Entries
+ * that disappeared are skipped.  Returns zero on success, otherwise non-zero is
+ * returned. */
+static int
+query_batch(rm_state_t *state, dir_t *dir, int fd, batch_t *batch)
+{
+	int i;
+	int nqueued = 0;
+
+	for(i = 0; i < batch->count; ++i)
+	{
+		batch->sizes[i] = 0U;
+		if(needs_stat(state, batch->types[i]))
+		{
+			(void)uring_lstat(batch->ring, fd, batch->names[i], &batch->st[i]);
+			batch->queued[nqueued++] = i;
+		}
+	}
+
+	if(nqueued == 0)
+	{
+		return 0;
+	}
+
+	if(uring_run(batch->ring, batch->results) != 0)
+	{
+		drop_ring(batch);
+		return 0;
+	}
+
+	for(i = 0; i < nqueued; ++i)
+	{
+		const int entry = batch->queued[i];
+		const struct stat *const st = &batch->st[entry];
+
+		if(batch->results[i] == ENOENT)
+		{
+			/* Someone else has removed it already. */
+			batch->names[entry] = NULL;
+			continue;
+		}
+		if(batch->results[i] != 0)
+		{
+			add_error(state, dir->path, batch->names[entry], batch->results[i]);
+			return 1;
+		}
+
+		if(S_ISDIR(st->st_mode))
+		{
+			batch->types[entry] = DET_DIR;
+		}
+		else if(!S_ISLNK(st->st_mode))
+		{
+			/* Count data the same way estimation does. */
+			batch->sizes[entry] = estimate_data_size(st->st_size,
+					(uint64_t)st->st_blocks*512U);
+		}
+	}
+
+	return 0;
+}
+
+/* Spawns tasks for subdirectories and removes files of the batch.  Returns zero
+ * on success, otherwise non-zero is returned. */
+static int
+unlink_batch(rm_state_t *state, dir_t *dir, int fd, batch_t *batch,
+		counters_t *local)
+{
+	int i;
+	int nqueued = 0;
+
+	for(i = 0; i < batch->count; ++i)
+	{
+		if(batch->names[i] == NULL)
+		{
+			continue;
+		}
+
+		++local->found_items;
+		local->found_bytes += batch->sizes[i];
+
+		if(batch->types[i] == DET_DIR)
+		{
+			if(spawn_subdir(state, dir, batch->names[i]) != 0)
+			{
+				return 1;
+			}
+			continue;
+		}
+
+		(void)uring_unlink(batch->ring, fd, batch->names[i]);
+		batch->queued[nqueued++] = i;
+	}
+
+	if(nqueued == 0)
+	{
+		return 0;
+	}
+
+	(void)iothrottle_charge(state->throttle, 0U, nqueued, state->cancellable);
+	if(uring_run(batch->ring, batch->results) != 0)
+	{
+		drop_ring(batch);
+
+		/* Some of the files might have been removed by the ring already. */
+		for(i = 0; i < nqueued; ++i)
+		{
+			const int entry = batch->queued[i];
+			batch->results[i] = (unlinkat(fd, batch->names[entry], 0) == 0)
+			                  ? 0
+			                  : (errno == ENOENT ? 0 : errno);
+		}
+	}
+
+	for(i = 0; i < nqueued; ++i)
+	{
+		const int entry = batch->queued[i];
+
+		/* File that someone else has removed already doesn't need removing, same
+		 * as in process_entry(). */
+		if(batch->results[i] != 0 && batch->results[i] != ENOENT)
+		{
+			add_error(state, dir->path, batch->names[entry], batch->results[i]);
+			return 1;
+		}
+
+		++local->removed_items;
+		local->removed_bytes += batch->sizes[entry];
+	}
+
+	return 0;
+}
+
+/* Stops using ring of the batch after its failure. */
+static void
+drop_ring(batch_t *batch)
+{
+	uring_free(batch->ring);
+	batch->ring = NULL;
+}
+
+/* Checks whether type or size of an entry need to be queried.  Returns non-zero
+ * if so, otherwise zero is returned. */
+static int
+needs_stat(const rm_state_t *state, DirEntType type)
+{
+	return type == DET_UNKNOWN || (type != DET_DIR && state->count_bytes);
+}
+
+/* Queues subdirectory of the dir for processing.  Returns zero on success,
+ * otherwise non-zero is returned. */
+static int
+spawn_subdir(rm_state_t *state, dir_t *dir, const char name[])
+{
+	char *const path = format_str("%s/%s", dir->path, name);
+	dir_t *const subdir = (path == NULL) ? NULL : make_dir(path, dir);
+	if(subdir == NULL)
+	{
+		free(path);
+		add_error(state, dir->path, name, ENOMEM);
+		return 1;
+	}
+
+	ADD(dir->pending, 1);
+
+	pthread_mutex_lock(&state->lock);
+	subdir->next = state->tasks;
+	state->tasks = subdir;
+	pthread_cond_signal(&state->work_cond);
+	pthread_mutex_unlock(&state->lock);
+	return 0;
+}
+
+/* Marks one of pending parts of the directory as done.  Removes directories
+ * that are done and propagates results to their parents. */
+static void
+release_dir(rm_state_t *state, dir_t *dir)
+{
+	while(dir != NULL &&
+			__atomic_sub_fetch(&dir->pending, 1, __ATOMIC_ACQ_REL) == 0)
+	{
+		dir_t *const parent = dir->parent;
+		int failed = LOAD(dir->failed) || LOAD(state->stop);
+
+		if(dir->fd >= 0)
+		{
+			(void)close(dir->fd);
+		}
+
+		if(!failed)
+		{
+			const char *name;
+			const int base = get_base(dir, &name);
+
+			(void)iothrottle_charge(state->throttle, 0U, 1U, state->cancellable);
+			if(unlinkat(base, name, AT_REMOVEDIR) == 0 || errno == ENOENT)
+			{
+				ADD(state->counters.removed_items, 1U);
+			}
+			else
+			{
+				add_error(state, dir->path, NULL, errno);
+				failed = 1;
+			}
+		}
+
+		if(parent == NULL)
+		{
+			pthread_mutex_lock(&state->lock);
+			state->failed = failed;
+			state->finished = 1;
+			pthread_cond_broadcast(&state->work_cond);
+			pthread_cond_broadcast(&state->done_cond);
+			pthread_mutex_unlock(&state->lock);
+		}
+		else if(failed)
+		{
+			STORE(parent->failed, 1);
+		}
+
+		free(dir->path);
+		free(dir);
+		dir = parent;
+	}
+}
+
+/* Adds local counters of a worker to shared ones and resets them. */
+static void
+publish(rm_state_t *state, counters_t *local)
+{
+	static const counters_t empty_counters;
+
+	ADD(state->counters.found_items, local->found_items);
+	ADD(state->counters.found_bytes, local->found_bytes);
+	ADD(state->counters.removed_items, local->removed_items);
+	ADD(state->counters.removed_bytes, local->removed_bytes);
+
+	*local = empty_counters;
+}
+
+/* Reports progress made since the last report. */
+static void
+report_progress(io_args_t *args, rm_state_t *state, counters_t *reported)
+{
+	counters_t current;
+
+	current.removed_items = LOAD(state->counters.removed_items);
+	current.removed_bytes = LOAD(state->counters.removed_bytes);
+	current.found_items = LOAD(state->counters.found_items);
+	current.found_bytes = LOAD(state->counters.found_bytes);
+
+	ioeta_add_found(args->estim, current.found_items - reported->found_items,
+			current.found_bytes - reported->found_bytes);
+	ioeta_update_batch(args->estim, args->arg1.path,
+			current.removed_items - reported->removed_items,
+			current.removed_bytes - reported->removed_bytes);
+
+	*reported = current;
+}
+
+/* Records an error and makes other workers stop.  The name can be NULL. */
+static void
+add_error(rm_state_t *state, const char dir[], const char name[],
+		int error_code)
+{
+	char *const path = (name == NULL) ? NULL : format_str("%s/%s", dir, name);
+
+	pthread_mutex_lock(&state->lock);
+	(void)ioe_errlst_append(&state->errors, (path == NULL) ? dir : path,
+			error_code, strerror(error_code));
+	pthread_mutex_unlock(&state->lock);
+
+	free(path);
+	STORE(state->stop, 1);
+}
+
+/* Allocates directory with one pending part (its listing).  Takes ownership of
+ * the path.  Returns the directory or NULL on error. */
+static dir_t *
+make_dir(char path[], dir_t *parent)
+{
+	dir_t *const dir = calloc(1U, sizeof(*dir));
+	if(dir != NULL)
+	{
+		dir->path = path;
+		dir->name = (parent == NULL) ? path : strrchr(path, '/') + 1;
+		dir->fd = -1;
+		dir->depth = (parent == NULL) ? 0 : parent->depth + 1;
+		dir->parent = parent;
+		dir->pending = 1;
+	}
+	return dir;
+}
+
+/* Picks how the directory should be accessed: relative to descriptor of its
+ * parent or by full path when the parent is too deep to keep its descriptor
+ * open.  Returns descriptor to be used with *name. */
+static int
+get_base(const dir_t *dir, const char **name)
+{
+	if(dir->parent == NULL || dir->parent->depth >= MAX_OPEN_LEVELS)
+	{
+		*name = dir->path;
+		return AT_FDCWD;
+	}
+
+	*name = dir->name;
+	return dir->parent->fd;
+}
+
+/* Computes time of the next progress report. */
+static void
+get_deadline(struct timespec *ts)
+{
+	struct timeval tv;
+	(void)gettimeofday(&tv, NULL);
+
+	ts->tv_sec = tv.tv_sec + PROGRESS_INTERVAL_MS/1000;
+	ts->tv_nsec = (tv.tv_usec + (PROGRESS_INTERVAL_MS%1000)*1000L)*1000L;
+	if(ts->tv_nsec >= 1000000000L)
+	{
+		ts->tv_sec += 1;
+		ts->tv_nsec -= 1000000000L;
+	}
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,38 @@
+/* vifm
+ * Copyright (C) 2026 agent.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef VIFM__IO__PRIVATE__RMTREE_H__
+#define VIFM__IO__PRIVATE__RMTREE_H__
+
+#include "../ioc.h"
+
+/* rmtree - removal of directory subtrees by several threads */
+
+/* Removes directory at args->arg1.path along with its content using up to
+ * nworkers threads.  Files are unlinked relative to descriptors of their
+ * directories and sibling subtrees are processed concurrently.  Errors are
+ * appended to error list of the args without invoking error callback and the
+ * first one stops removal.  Progress is reported via estimate of the args in
+ * batches and cancellation is checked only from the calling thread.  Returns
+ * zero on success, otherwise non-zero is returned. */
+int rmtree_run(io_args_t *args, int nworkers);
+
+#endif /* VIFM__IO__PRIVATE__RMTREE_H__ */
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -18,16 +18,79 @@
 
 #include "traverser.h"
 
-#include <stddef.h> /* NULL */
-#include <stdlib.h> /* free() */
+#ifndef _WIN32
+#include <sys/stat.h> /* S_ISDIR() S_ISLNK() fstatat() stat */
+#include <fcntl.h> /* AT_FDCWD AT_SYMLINK_NOFOLLOW O_* openat() */
+#include <unistd.h> /* close() */
+#endif
+
+#include <stddef.h> /* NULL size_t */
+#include <stdlib.h> /* calloc() free() realloc() */
+#include <string.h> /* memcpy() strlen() */
 
 #include "../../compat/os.h"
+#include "../../utils/dirents.h"
 #include "../../utils/fs.h"
 #include "../../utils/path.h"
 #include "../../utils/str.h"
 
+/* Directories are opened relative to descriptors of their parents and entries
+ * are queried relative to descriptor of their directory, so paths are never
+ * resolved from the root over and over again.  Path of current entry lives in
+ * a single buffer that is extended on descending and truncated on returning
+ * and listings of directories are kept in buffers reused per level of depth,
+ * so memory isn't allocated per entry. */
+
+/* Depth starting from which descriptors of directories are closed right after
+ * reading their entries so that deep trees don't exhaust descriptors.  Entries
+ * of such directories are accessed by full path. */
+#define MAX_OPEN_LEVELS 64
+
+/* Initial size of the path buffer. */
+#define INITIAL_PATH_CAPACITY 256
+
+/* Increments one of counters of statistics if they are collected. */
+#define COUNT(field, n) \
+	(void)(collect_stats && \
+	       __atomic_add_fetch(&stats.field, (n), __ATOMIC_RELAXED))
+
+#ifndef _WIN32
+
+/* State of a traversal of a subtree. */
+typedef struct
+{
+	subtree_visitor visitor; /* Client's callback. */
+	void *param;             /* Parameter of the callback. */
+
+	char *path;           /* Path to current entry. */
+	size_t path_len;      /* Length of the path. */
+	size_t path_capacity; /* Size of the path buffer. */
+
+	dirents_t **levels; /* Listings of directories, one per level of depth. */
+	size_t nlevels;     /* Number of allocated listings. */
+	size_t capacity;    /* Size of the levels array. */
+}
+walk_t;
+
+static int traverse_dir(walk_t *walk, int fd, size_t depth);
+static int open_dir(int dir_fd, const char path[], int follow);
+static DirEntType query_type(int dir_fd, const char path[]);
+static dirents_t * get_listing(walk_t *walk, size_t depth);
+static int append_name(walk_t *walk, const char name[]);
+static int reserve_path(walk_t *walk, size_t size);
+
+#endif
+
 static int traverse_subtree(const char path[], subtree_visitor visitor,
 		void *param);
+TSTATIC void traverser_reset_stats(void);
+TSTATIC traverser_stats_t traverser_get_stats(void);
+
+/* Counters of performed operations. */
+static traverser_stats_t stats;
+/* Whether counters are updated.  Only tests need them and enable them by
+ * resetting, so regular runs don't perform atomic operations per entry. */
+static int collect_stats;
 
 int
 traverse(const char path[], subtree_visitor visitor, void *param)
@@ -50,6 +113,249 @@ traverse(const char path[], subtree_visitor visitor, void *param)
 	}
 }
 
+#ifndef _WIN32
+
+/* A generic subtree traversing.  Returns zero on success, otherwise non-zero is
+ * returned. */
+static int
+traverse_subtree(const char path[], subtree_visitor visitor, void *param)
+{
+	size_t i;
+	int fd;
+	int result = 1;
+	walk_t walk = {
+		.visitor = visitor,
+		.param = param,
+	};
+
+	if(reserve_path(&walk, strlen(path) + 1U) == 0)
+	{
+		walk.path_len = strlen(path);
+		memcpy(walk.path, path, walk.path_len + 1U);
+
+		fd = open_dir(AT_FDCWD, path, 1);
+		if(fd >= 0)
+		{
+			result = traverse_dir(&walk, fd, 0U);
+		}
+	}
+
+	for(i = 0U; i < walk.nlevels; ++i)
+	{
+		dirents_free(walk.levels[i]);
+		free(walk.levels[i]);
+	}
+	free(walk.levels);
+	free(walk.path);
+
+	return result;
+}
+
+/* Traverses directory opened as fd, whose path is in walk->path.  Closes the
+ * descriptor.  Returns zero on success, otherwise non-zero is returned. */
+static int
+traverse_dir(walk_t *walk, int fd, size_t depth)
+{
+	dirents_t *list;
+	const char *name;
+	DirEntType type;
+	size_t pos = 0U;
+	int result = 0;
+	VisitResult enter_result;
+	const size_t len = walk->path_len;
+
+	enter_result = walk->visitor(walk->path, VA_DIR_ENTER, walk->param);
+	if(enter_result == VR_ERROR)
+	{
+		(void)close(fd);
+		return 1;
+	}
+
+	list = get_listing(walk, depth);
+	if(list == NULL || dirents_read(list, fd) != 0)
+	{
+		(void)close(fd);
+		return 1;
+	}
+	COUNT(reads, list->nreads);
+	COUNT(allocs, list->nallocs);
+
+	if(depth >= MAX_OPEN_LEVELS)
+	{
+		(void)close(fd);
+		fd = AT_FDCWD;
+	}
+
+	while((name = dirents_next(list, &pos, &type)) != NULL)
+	{
+		const char *rel_path;
+
+		if(append_name(walk, name) != 0)
+		{
+			result = 1;
+			break;
+		}
+
+		rel_path = (fd == AT_FDCWD) ? walk->path : name;
+
+		if(type == DET_UNKNOWN)
+		{
+			type = query_type(fd, rel_path);
+		}
+
+		if(type == DET_DIR)
+		{
+			const int sub_fd = open_dir(fd, rel_path, 0);
+			result = (sub_fd < 0) ? 1 : traverse_dir(walk, sub_fd, depth + 1U);
+		}
+		else
+		{
+			/* Treat symbolic links to directories as files as well. */
+			result = walk->visitor(walk->path, VA_FILE, walk->param);
+		}
+
+		walk->path[len] = '\0';
+		walk->path_len = len;
+
+		if(result != 0)
+		{
+			break;
+		}
+	}
+
+	if(fd != AT_FDCWD)
+	{
+		(void)close(fd);
+	}
+
+	if(result == 0 && enter_result != VR_SKIP_DIR_LEAVE &&
+			enter_result != VR_CANCELLED)
+	{
+		result = walk->visitor(walk->path, VA_DIR_LEAVE, walk->param);
+	}
+
+	return result;
+}
+
+/* Opens directory for reading its entries.  Symbolic links are followed only
+ * if follow is non-zero.  Returns the descriptor or -1 on error. */
+static int
+open_dir(int dir_fd, const char path[], int follow)
+{
+	const int flags = O_RDONLY | O_DIRECTORY | O_CLOEXEC | O_NOCTTY;
+	COUNT(opens, 1U);
+	return openat(dir_fd, path, follow ? flags : (flags | O_NOFOLLOW));
+}
+
+/* Queries type of an entry when file system doesn't provide it.  Returns the
+ * type. */
+static DirEntType
+query_type(int dir_fd, const char path[])
+{
+	struct stat st;
+
+	COUNT(stats, 1U);
+	if(fstatat(dir_fd, path, &st, AT_SYMLINK_NOFOLLOW) != 0)
+	{
+		return DET_OTHER;
+	}
+
+	if(S_ISLNK(st.st_mode))
+	{
+		return DET_LINK;
+	}
+	return S_ISDIR(st.st_mode) ? DET_DIR : DET_OTHER;
+}
+
+/* Retrieves listing buffer for the level of depth, which is reused by all
+ * directories of that level.  Returns the buffer or NULL on error. */
+static dirents_t *
+get_listing(walk_t *walk, size_t depth)
+{
+	dirents_t *list;
+
+	if(depth < walk->nlevels)
+	{
+		return walk->levels[depth];
+	}
+
+	if(walk->nlevels == walk->capacity)
+	{
+		const size_t capacity = (walk->capacity == 0U) ? 16U : walk->capacity*2U;
+		dirents_t **const levels = realloc(walk->levels,
+				sizeof(*levels)*capacity);
+		if(levels == NULL)
+		{
+			return NULL;
+		}
+		COUNT(allocs, 1U);
+
+		walk->levels = levels;
+		walk->capacity = capacity;
+	}
+
+	list = calloc(1U, sizeof(*list));
+	if(list == NULL)
+	{
+		return NULL;
+	}
+	COUNT(allocs, 1U);
+
+	walk->levels[walk->nlevels++] = list;
+	return list;
+}
+
+/* Appends name of an entry to path of its directory.  Returns zero on success,
+ * otherwise non-zero is returned. */
+static int
+append_name(walk_t *walk, const char name[])
+{
+	const size_t name_len = strlen(name);
+	if(reserve_path(walk, walk->path_len + 1U + name_len + 1U) != 0)
+	{
+		return 1;
+	}
+
+	walk->path[walk->path_len++] = '/';
+	memcpy(&walk->path[walk->path_len], name, name_len + 1U);
+	walk->path_len += name_len;
+	return 0;
+}
+
+/* Makes sure that path buffer can hold at least size bytes.  Returns zero on
+ * success, otherwise non-zero is returned. */
+static int
+reserve_path(walk_t *walk, size_t size)
+{
+	char *path;
+	size_t capacity;
+
+	if(size <= walk->path_capacity)
+	{
+		return 0;
+	}
+
+	capacity = (walk->path_capacity == 0U) ? INITIAL_PATH_CAPACITY
+	                                       : walk->path_capacity;
+	while(capacity < size)
+	{
+		capacity *= 2U;
+	}
+
+	path = realloc(walk->path, capacity);
+	if(path == NULL)
+	{
+		return 1;
+	}
+	COUNT(allocs, 1U);
+
+	walk->path = path;
+	walk->path_capacity = capacity;
+	return 0;
+}
+
+#else
+
 /* A generic subtree traversing.  Returns zero on success, otherwise non-zero is
  * returned. */
 static int
@@ -65,6 +371,7 @@ traverse_subtree(const char path[], subtree_visitor visitor, void *param)
 	{
 		return 1;
 	}
+	COUNT(opens, 1U);
 
 	enter_result = visitor(path, VA_DIR_ENTER, param);
 	if(enter_result == VR_ERROR)
@@ -84,6 +391,7 @@ traverse_subtree(const char path[], subtree_visitor visitor, void *param)
 		}
 
 		full_path = format_str("%s/%s", path, d->d_name);
+		COUNT(allocs, 1U);
 		if(entry_is_link(full_path, d))
 		{
 			/* Treat symbolic links to directories as files as well. */
@@ -115,5 +423,23 @@ traverse_subtree(const char path[], subtree_visitor visitor, void *param)
 	return result;
 }
 
+#endif
+
+/* Resets counters of performed operations and starts collecting them. */
+TSTATIC void
+traverser_reset_stats(void)
+{
+	static const traverser_stats_t empty_stats;
+	stats = empty_stats;
+	collect_stats = 1;
+}
+
+/* Retrieves counters of performed operations.  Returns the counters. */
+TSTATIC traverser_stats_t
+traverser_get_stats(void)
+{
+	return stats;
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 filetype=c : */
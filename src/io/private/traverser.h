@@ -19,6 +19,8 @@
 #ifndef VIFM__IO__PRIVATE__TRAVERSER_H__
 #define VIFM__IO__PRIVATE__TRAVERSER_H__
 
+#include "../../utils/test_helpers.h"
+
 /* Reason why file system traverse visitor is called. */
 typedef enum
 {
@@ -38,8 +40,19 @@ typedef enum
 }
 VisitResult;
 
+/* Counters of operations performed by traversals. */
+typedef struct
+{
+	unsigned long opens;  /* Number of opened directories. */
+	unsigned long reads;  /* Number of reads of directory entries. */
+	unsigned long stats;  /* Number of queries of types of entries. */
+	unsigned long allocs; /* Number of memory allocations. */
+}
+traverser_stats_t;
+
 /* Generic handler for file system traversing algorithm.  Must return 0 on
- * success, otherwise directory traverse will be stopped. */
+ * success, otherwise directory traverse will be stopped.  The full_path buffer
+ * is valid only during the call. */
 typedef VisitResult (*subtree_visitor)(const char full_path[],
 		VisitAction action, void *param);
 
@@ -47,6 +60,11 @@ typedef VisitResult (*subtree_visitor)(const char full_path[],
  * success, otherwise non-zero is returned. */
 int traverse(const char path[], subtree_visitor visitor, void *param);
 
+TSTATIC_DEFS(
+	void traverser_reset_stats(void);
+	traverser_stats_t traverser_get_stats(void);
+)
+
 #endif // VIFM__IO__PRIVATE__TRAVERSER_H__
 
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
@@ -0,0 +1,372 @@
+/* vifm
+ * Copyright (C) 2026 agent.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "uring.h"
+
+#ifdef HAVE_IO_URING
+#include <linux/io_uring.h> /* IORING_* IO_URING_* io_uring_* */
+#include <linux/stat.h> /* STATX_* statx */
+#include <sys/mman.h> /* MAP_* PROT_* mmap() munmap() */
+#include <sys/syscall.h> /* __NR_io_uring_* */
+#include <fcntl.h> /* AT_SYMLINK_NOFOLLOW */
+#include <unistd.h> /* close() syscall() */
+#endif
+
+#include <sys/stat.h> /* stat */
+
+#include <errno.h> /* EAGAIN EBUSY EINTR errno */
+#include <stddef.h> /* NULL size_t */
+#include <stdint.h> /* uintptr_t */
+#include <stdlib.h> /* calloc() free() */
+#include <string.h> /* memset() */
+
+#include "../../utils/macros.h"
+
+#ifdef HAVE_IO_URING
+
+/* Number of entries of operation probe, which covers all known operations. */
+#define PROBE_OPS 256
+
+/* Data of a queued request that's needed on its completion. */
+typedef struct
+{
+	struct statx stx; /* Buffer for the kernel. */
+	struct stat *st;  /* Where to put result of lstat request or NULL. */
+}
+slot_t;
+
+struct uring_t
+{
+	int fd;              /* File descriptor of the ring. */
+	void *rings;         /* Mapped submission and completion rings. */
+	size_t rings_size;   /* Size of the rings mapping. */
+	struct io_uring_sqe *sqes; /* Mapped submission entries. */
+	size_t sqes_size;    /* Size of the entries mapping. */
+
+	unsigned int *sq_tail;  /* Tail of the submission ring. */
+	unsigned int sq_mask;   /* Mask of indexes of submission ring. */
+	unsigned int *sq_array; /* Indexes of submitted entries. */
+	unsigned int *cq_head;  /* Head of the completion ring. */
+	unsigned int *cq_tail;  /* Tail of the completion ring. */
+	unsigned int cq_mask;   /* Mask of indexes of completion ring. */
+	struct io_uring_cqe *cqes; /* Completion entries. */
+
+	unsigned int size;   /* Maximum number of queued requests. */
+	unsigned int queued; /* Number of queued requests. */
+	slot_t *slots;       /* Per request data. */
+	int broken;          /* Whether the ring failed and can't be used. */
+};
+
+static int is_supported(int fd);
+static struct io_uring_sqe * queue(uring_t *ring, struct stat *st);
+static void reap(uring_t *ring, int results[], unsigned int *completed);
+
+#endif
+
+TSTATIC void uring_disable(int disable);
+
+/* Whether creation of rings is forbidden. */
+static int disabled;
+
+uring_t *
+uring_create(unsigned int size)
+{
+#ifdef HAVE_IO_URING
+	struct io_uring_params params;
+	uring_t *ring;
+	char *rings;
+	size_t sq_size, cq_size;
+
+	if(disabled || size == 0U)
+	{
+		return NULL;
+	}
+
+	ring = calloc(1U, sizeof(*ring));
+	if(ring == NULL)
+	{
+		return NULL;
+	}
+
+	memset(&params, 0, sizeof(params));
+	ring->fd = syscall(__NR_io_uring_setup, size, &params);
+	/* Single mapping of both rings simplifies things and is available since the
+	 * same kernel version that introduced unlinkat operation. */
+	if(ring->fd < 0 || !(params.features & IORING_FEAT_SINGLE_MMAP) ||
+			!is_supported(ring->fd))
+	{
+		if(ring->fd >= 0)
+		{
+			(void)close(ring->fd);
+		}
+		free(ring);
+		return NULL;
+	}
+
+	sq_size = params.sq_off.array + params.sq_entries*sizeof(unsigned int);
+	cq_size = params.cq_off.cqes +
+		params.cq_entries*sizeof(struct io_uring_cqe);
+	ring->rings_size = MAX(sq_size, cq_size);
+	ring->sqes_size = params.sq_entries*sizeof(struct io_uring_sqe);
+
+	ring->rings = mmap(NULL, ring->rings_size, PROT_READ | PROT_WRITE,
+			MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+	ring->sqes = mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE,
+			MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+	ring->size = MIN(size, params.sq_entries);
+	ring->slots = calloc(ring->size, sizeof(*ring->slots));
+	if(ring->rings == MAP_FAILED || ring->sqes == MAP_FAILED ||
+			ring->slots == NULL)
+	{
+		ring->broken = 1;
+		uring_free(ring);
+		return NULL;
+	}
+
+	rings = ring->rings;
+	ring->sq_tail = (unsigned int *)(rings + params.sq_off.tail);
+	ring->sq_mask = *(unsigned int *)(rings + params.sq_off.ring_mask);
+	ring->sq_array = (unsigned int *)(rings + params.sq_off.array);
+	ring->cq_head = (unsigned int *)(rings + params.cq_off.head);
+	ring->cq_tail = (unsigned int *)(rings + params.cq_off.tail);
+	ring->cq_mask = *(unsigned int *)(rings + params.cq_off.ring_mask);
+	ring->cqes = (struct io_uring_cqe *)(rings + params.cq_off.cqes);
+
+	return ring;
+#else
+	return NULL;
+#endif
+}
+
+void
+uring_free(uring_t *ring)
+{
+#ifdef HAVE_IO_URING
+	if(ring == NULL)
+	{
+		return;
+	}
+
+	if(ring->sqes != NULL && ring->sqes != MAP_FAILED)
+	{
+		(void)munmap(ring->sqes, ring->sqes_size);
+	}
+	if(ring->rings != NULL && ring->rings != MAP_FAILED)
+	{
+		(void)munmap(ring->rings, ring->rings_size);
+	}
+	(void)close(ring->fd);
+	free(ring->slots);
+	free(ring);
+#endif
+}
+
+unsigned int
+uring_size(const uring_t *ring)
+{
+#ifdef HAVE_IO_URING
+	return ring->size;
+#else
+	return 0U;
+#endif
+}
+
+int
+uring_lstat(uring_t *ring, int dir_fd, const char name[], struct stat *st)
+{
+#ifdef HAVE_IO_URING
+	struct io_uring_sqe *const sqe = queue(ring, st);
+	if(sqe == NULL)
+	{
+		return 1;
+	}
+
+	sqe->opcode = IORING_OP_STATX;
+	sqe->fd = dir_fd;
+	sqe->addr = (uintptr_t)name;
+	sqe->len = STATX_TYPE | STATX_MODE | STATX_SIZE | STATX_BLOCKS;
+	sqe->off = (uintptr_t)&ring->slots[ring->queued - 1U].stx;
+	sqe->statx_flags = AT_SYMLINK_NOFOLLOW;
+	return 0;
+#else
+	return 1;
+#endif
+}
+
+int
+uring_unlink(uring_t *ring, int dir_fd, const char name[])
+{
+#ifdef HAVE_IO_URING
+	struct io_uring_sqe *const sqe = queue(ring, NULL);
+	if(sqe == NULL)
+	{
+		return 1;
+	}
+
+	sqe->opcode = IORING_OP_UNLINKAT;
+	sqe->fd = dir_fd;
+	sqe->addr = (uintptr_t)name;
+	sqe->unlink_flags = 0;
+	return 0;
+#else
+	return 1;
+#endif
+}
+
+int
+uring_run(uring_t *ring, int results[])
+{
+#ifdef HAVE_IO_URING
+	const unsigned int n = ring->queued;
+	unsigned int submitted = 0U;
+	unsigned int completed = 0U;
+
+	if(ring->broken)
+	{
+		return 1;
+	}
+
+	/* Entries are filled in order, so only the tail needs to be published. */
+	__atomic_store_n(ring->sq_tail, *ring->sq_tail + n, __ATOMIC_RELEASE);
+
+	while(completed < n)
+	{
+		const long ret = syscall(__NR_io_uring_enter, ring->fd, n - submitted, 1U,
+				IORING_ENTER_GETEVENTS, NULL, 0);
+		if(ret < 0)
+		{
+			if(errno == EINTR || errno == EAGAIN || errno == EBUSY)
+			{
+				reap(ring, results, &completed);
+				continue;
+			}
+			ring->broken = 1;
+			return 1;
+		}
+
+		submitted += ret;
+		reap(ring, results, &completed);
+	}
+
+	ring->queued = 0U;
+	return 0;
+#else
+	return 1;
+#endif
+}
+
+void
+uring_disable(int disable)
+{
+	disabled = disable;
+}
+
+#ifdef HAVE_IO_URING
+
+/* Checks that the kernel knows all the operations we need.  Returns non-zero if
+ * so, otherwise zero is returned. */
+static int
+is_supported(int fd)
+{
+	static const int ops[] = { IORING_OP_STATX, IORING_OP_UNLINKAT };
+
+	size_t i;
+	int supported = 1;
+	struct io_uring_probe *const probe =
+		calloc(1U, sizeof(*probe) + PROBE_OPS*sizeof(struct io_uring_probe_op));
+	if(probe == NULL)
+	{
+		return 0;
+	}
+
+	if(syscall(__NR_io_uring_register, fd, IORING_REGISTER_PROBE, probe,
+				PROBE_OPS) != 0)
+	{
+		free(probe);
+		return 0;
+	}
+
+	for(i = 0U; i < ARRAY_LEN(ops); ++i)
+	{
+		if(ops[i] >= probe->ops_len ||
+				!(probe->ops[ops[i]].flags & IO_URING_OP_SUPPORTED))
+		{
+			supported = 0;
+		}
+	}
+
+	free(probe);
+	return supported;
+}
+
+/* Allocates next submission entry and initializes its common fields.  Returns
+ * the entry or NULL if the batch is full. */
+static struct io_uring_sqe *
+queue(uring_t *ring, struct stat *st)
+{
+	const unsigned int index = ring->queued;
+	const unsigned int pos = (*ring->sq_tail + index) & ring->sq_mask;
+	struct io_uring_sqe *sqe;
+
+	if(ring->broken || index == ring->size)
+	{
+		return NULL;
+	}
+
+	sqe = &ring->sqes[pos];
+	memset(sqe, 0, sizeof(*sqe));
+	sqe->user_data = index;
+	ring->sq_array[pos] = pos;
+
+	ring->slots[index].st = st;
+	++ring->queued;
+	return sqe;
+}
+
+/* Takes results out of the completion ring. */
+static void
+reap(uring_t *ring, int results[], unsigned int *completed)
+{
+	unsigned int head = *ring->cq_head;
+	const unsigned int tail = __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE);
+
+	while(head != tail)
+	{
+		const struct io_uring_cqe *const cqe = &ring->cqes[head & ring->cq_mask];
+		const unsigned int index = cqe->user_data;
+		slot_t *const slot = &ring->slots[index];
+
+		results[index] = (cqe->res < 0) ? -cqe->res : 0;
+		if(results[index] == 0 && slot->st != NULL)
+		{
+			slot->st->st_mode = slot->stx.stx_mode;
+			slot->st->st_size = slot->stx.stx_size;
+			slot->st->st_blocks = slot->stx.stx_blocks;
+		}
+
+		++head;
+		++*completed;
+	}
+
+	__atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+}
+
+#endif
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,72 @@
+/* vifm
+ * Copyright (C) 2026 agent.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef VIFM__IO__PRIVATE__URING_H__
+#define VIFM__IO__PRIVATE__URING_H__
+
+#include <sys/stat.h> /* stat */
+
+#include "../../utils/test_helpers.h"
+
+/* uring - batching of file system requests via io_uring */
+
+/* Requests are queued and then submitted to the kernel at once, which replaces
+ * a system call per file with one per batch.  Support is checked at configure
+ * time and again at runtime, so callers must be ready to get NULL out of
+ * uring_create() and do the work synchronously. */
+
+/* Opaque ring of requests. */
+typedef struct uring_t uring_t;
+
+/* Creates ring that can hold up to size requests.  Returns NULL if io_uring or
+ * any of the operations isn't supported or on error. */
+uring_t * uring_create(unsigned int size);
+
+/* Frees the ring.  The ring can be NULL. */
+void uring_free(uring_t *ring);
+
+/* Retrieves maximum number of requests in a batch.  Returns the number. */
+unsigned int uring_size(const uring_t *ring);
+
+/* Queues query of type and size of the name relative to dir_fd without
+ * following symbolic links.  Only st_mode, st_size and st_blocks fields of the
+ * st are filled on success.  The name and st must stay valid until
+ * uring_run().  Returns zero on success and non-zero if the batch is full. */
+int uring_lstat(uring_t *ring, int dir_fd, const char name[], struct stat *st);
+
+/* Queues unlinking of a non-directory name relative to dir_fd.  The name must
+ * stay valid until uring_run().  Returns zero on success and non-zero if the
+ * batch is full. */
+int uring_unlink(uring_t *ring, int dir_fd, const char name[]);
+
+/* Submits queued requests and waits for all of them to complete.  The results
+ * array receives zero or an errno value for each of requests in the order they
+ * were queued.  Returns zero on success, otherwise non-zero is returned, the
+ * ring becomes unusable and state of requests is unknown, so they have to be
+ * redone synchronously. */
+int uring_run(uring_t *ring, int results[]);
+
+TSTATIC_DEFS(
+	/* Makes uring_create() fail to be able to compare the two ways. */
+	void uring_disable(int disable);
+)
+
+#endif /* VIFM__IO__PRIVATE__URING_H__ */
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,595 @@
+/* vifm
+ * Copyright (C) 2026 agent.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+/* Queued paths are walked one by one by a single thread, which uses traverse()
+ * and records what it sees.  Counters are updated as files are found, so
+ * estimates converge while operation is already in progress.
+ *
+ * Recorded entries are handed to a consumer as soon as they become available.
+ * Number of recorded entries that weren't consumed yet is limited: listing that
+ * isn't being consumed is discarded when the limit is reached (consumer
+ * traverses the path on its own then), while walking of a listing that is being
+ * consumed waits for the consumer to catch up. */
+
+#include "walker.h"
+
+#include <pthread.h> /* PTHREAD_* pthread_* */
+
+#include <stddef.h> /* NULL size_t */
+#include <stdint.h> /* uint64_t */
+#include <stdlib.h> /* calloc() free() realloc() */
+#include <string.h> /* strcmp() strdup() */
+
+#include "../../compat/reallocarray.h"
+#include "../../utils/fs.h"
+#include "traverser.h"
+
+/* Maximum number of recorded entries that weren't consumed yet. */
+#define MAX_PENDING_ENTRIES (256U*1024U)
+
+/* Single entry of a listing. */
+typedef struct
+{
+	char *path;         /* Full path to the entry. */
+	VisitAction action; /* How the entry was visited. */
+}
+entry_t;
+
+/* Queued path. */
+typedef struct item_t
+{
+	struct item_t *next; /* Next queued item. */
+	char *path;          /* Path to walk. */
+	int shallow;         /* Whether only the path itself should be counted. */
+	int walked;          /* Whether walking is over. */
+	int failed;          /* Whether traverse() has failed. */
+	int listed;          /* Whether listing is (still) available. */
+	int used;            /* Whether consumer has already reached this item. */
+	int replaying;       /* Whether listing is being consumed. */
+	entry_t *entries;    /* Recorded entries. */
+	size_t nentries;     /* Number of recorded entries. */
+	size_t capacity;     /* Number of allocated entries. */
+	size_t consumed;     /* Number of consumed entries. */
+}
+item_t;
+
+struct walker_t
+{
+	pthread_t thread;  /* Walking thread. */
+	int keep_listings; /* Whether listings are recorded. */
+
+	pthread_mutex_t lock; /* Protects fields below. */
+	pthread_cond_t cond;  /* Signaled on any change of the state. */
+	item_t *head;         /* First queued item. */
+	item_t *tail;         /* Last queued item. */
+	item_t *to_walk;      /* Next item to be walked or NULL. */
+	size_t npending;      /* Number of recorded entries not consumed yet. */
+	size_t nitems;        /* Number of counted files. */
+	uint64_t nbytes;      /* Size of counted files. */
+	int stopping;         /* Whether walking should stop. */
+};
+
+/* Argument of record_visitor(). */
+typedef struct
+{
+	walker_t *walker; /* Owner of the item. */
+	item_t *item;     /* Item being walked. */
+}
+record_state_t;
+
+/* Stack of flags of directories being replayed. */
+typedef struct
+{
+	char *skip_leave; /* Whether leaving directory shouldn't be reported. */
+	size_t depth;     /* Number of elements in the stack. */
+	size_t capacity;  /* Number of allocated elements. */
+}
+dir_stack_t;
+
+static void * walker_thread(void *arg);
+static int walk_item(walker_t *walker, item_t *item);
+static VisitResult record_visitor(const char full_path[], VisitAction action,
+		void *param);
+static int append_entry(item_t *item, const char path[], VisitAction action);
+static item_t * find_item(walker_t *walker, const char path[]);
+static void replay(walker_t *walker, item_t *item, subtree_visitor visitor,
+		void *param, int *result);
+static int replay_entry(const entry_t *entry, subtree_visitor visitor,
+		void *param, dir_stack_t *dirs, int *result);
+static void drop_listing(walker_t *walker, item_t *item);
+static void prune_items(walker_t *walker);
+static void free_item(item_t *item);
+
+walker_t *
+walker_create(int keep_listings, size_t nitems, uint64_t nbytes)
+{
+	walker_t *const walker = calloc(1, sizeof(*walker));
+	if(walker == NULL)
+	{
+		return NULL;
+	}
+
+	walker->keep_listings = keep_listings;
+	walker->nitems = nitems;
+	walker->nbytes = nbytes;
+	pthread_mutex_init(&walker->lock, NULL);
+	pthread_cond_init(&walker->cond, NULL);
+
+	if(pthread_create(&walker->thread, NULL, &walker_thread, walker) != 0)
+	{
+		pthread_cond_destroy(&walker->cond);
+		pthread_mutex_destroy(&walker->lock);
+		free(walker);
+		return NULL;
+	}
+
+	return walker;
+}
+
+void
+walker_free(walker_t *walker)
+{
+	if(walker == NULL)
+	{
+		return;
+	}
+
+	pthread_mutex_lock(&walker->lock);
+	walker->stopping = 1;
+	pthread_cond_broadcast(&walker->cond);
+	pthread_mutex_unlock(&walker->lock);
+
+	(void)pthread_join(walker->thread, NULL);
+
+	while(walker->head != NULL)
+	{
+		item_t *const next = walker->head->next;
+		free_item(walker->head);
+		walker->head = next;
+	}
+
+	pthread_cond_destroy(&walker->cond);
+	pthread_mutex_destroy(&walker->lock);
+	free(walker);
+}
+
+int
+walker_add(walker_t *walker, const char path[], int shallow)
+{
+	item_t *const item = calloc(1, sizeof(*item));
+	if(item == NULL || (item->path = strdup(path)) == NULL)
+	{
+		free(item);
+		return 1;
+	}
+
+	item->shallow = shallow;
+	item->listed = walker->keep_listings && !shallow;
+
+	pthread_mutex_lock(&walker->lock);
+	if(walker->tail == NULL)
+	{
+		walker->head = item;
+	}
+	else
+	{
+		walker->tail->next = item;
+	}
+	walker->tail = item;
+	if(walker->to_walk == NULL)
+	{
+		walker->to_walk = item;
+	}
+	pthread_cond_broadcast(&walker->cond);
+	pthread_mutex_unlock(&walker->lock);
+
+	return 0;
+}
+
+void
+walker_get_totals(walker_t *walker, size_t *nitems, uint64_t *nbytes)
+{
+	pthread_mutex_lock(&walker->lock);
+	*nitems = walker->nitems;
+	*nbytes = walker->nbytes;
+	pthread_mutex_unlock(&walker->lock);
+}
+
+int
+walker_finished(walker_t *walker)
+{
+	int finished;
+
+	pthread_mutex_lock(&walker->lock);
+	finished = (walker->to_walk == NULL);
+	pthread_mutex_unlock(&walker->lock);
+
+	return finished;
+}
+
+int
+walker_replay(walker_t *walker, const char path[], subtree_visitor visitor,
+		void *param, int *result)
+{
+	item_t *item;
+
+	pthread_mutex_lock(&walker->lock);
+
+	item = find_item(walker, path);
+	if(item == NULL || !item->listed)
+	{
+		pthread_mutex_unlock(&walker->lock);
+		return 1;
+	}
+
+	replay(walker, item, visitor, param, result);
+
+	pthread_mutex_unlock(&walker->lock);
+	return 0;
+}
+
+/* Entry point of the walking thread.  Walks items until stopped.  Returns
+ * NULL. */
+static void *
+walker_thread(void *arg)
+{
+	walker_t *const walker = arg;
+
+	pthread_mutex_lock(&walker->lock);
+	while(1)
+	{
+		item_t *item;
+		int failed;
+
+		while(walker->to_walk == NULL && !walker->stopping)
+		{
+			pthread_cond_wait(&walker->cond, &walker->lock);
+		}
+
+		if(walker->stopping)
+		{
+			break;
+		}
+
+		item = walker->to_walk;
+		pthread_mutex_unlock(&walker->lock);
+
+		failed = walk_item(walker, item);
+
+		pthread_mutex_lock(&walker->lock);
+		item->walked = 1;
+		item->failed = failed;
+		walker->to_walk = item->next;
+		prune_items(walker);
+		pthread_cond_broadcast(&walker->cond);
+	}
+	pthread_mutex_unlock(&walker->lock);
+
+	return NULL;
+}
+
+/* Counts files of an item and records its listing if needed.  Returns non-zero
+ * if traversal has failed, otherwise zero is returned. */
+static int
+walk_item(walker_t *walker, item_t *item)
+{
+	record_state_t state = { .walker = walker, .item = item };
+
+	if(item->shallow)
+	{
+		pthread_mutex_lock(&walker->lock);
+		++walker->nitems;
+		pthread_mutex_unlock(&walker->lock);
+		return 0;
+	}
+
+	return traverse(item->path, &record_visitor, &state) != 0;
+}
+
+/* Implementation of traverse() visitor that counts files and records
+ * entries.  Returns VR_OK to continue, otherwise traversal is stopped. */
+static VisitResult
+record_visitor(const char full_path[], VisitAction action, void *param)
+{
+	record_state_t *const state = param;
+	walker_t *const walker = state->walker;
+	item_t *const item = state->item;
+	uint64_t size = 0U;
+	VisitResult result;
+
+	/* Count data the same way ioeta_add_file() does. */
+	if(action == VA_FILE && !is_symlink(full_path))
+	{
+		size = get_file_data_size(full_path);
+	}
+
+	pthread_mutex_lock(&walker->lock);
+
+	if(action == VA_FILE)
+	{
+		++walker->nitems;
+		walker->nbytes += size;
+	}
+
+	while(item->listed && item->replaying &&
+			item->nentries - item->consumed >= MAX_PENDING_ENTRIES &&
+			!walker->stopping)
+	{
+		pthread_cond_wait(&walker->cond, &walker->lock);
+	}
+
+	if(item->listed && !item->replaying &&
+			walker->npending >= MAX_PENDING_ENTRIES)
+	{
+		drop_listing(walker, item);
+	}
+
+	if(item->listed)
+	{
+		if(append_entry(item, full_path, action) == 0)
+		{
+			++walker->npending;
+		}
+		else
+		{
+			drop_listing(walker, item);
+		}
+		pthread_cond_broadcast(&walker->cond);
+	}
+
+	result = walker->stopping ? VR_CANCELLED : VR_OK;
+	pthread_mutex_unlock(&walker->lock);
+
+	return result;
+}
+
+/* Appends entry to listing of the item.  Returns non-zero on error, otherwise
+ * zero is returned. */
+static int
+append_entry(item_t *item, const char path[], VisitAction action)
+{
+	char *path_copy;
+
+	if(item->nentries == item->capacity)
+	{
+		const size_t capacity = (item->capacity == 0U) ? 64U : item->capacity*2U;
+		entry_t *const entries = reallocarray(item->entries, capacity,
+				sizeof(*entries));
+		if(entries == NULL)
+		{
+			return 1;
+		}
+		item->entries = entries;
+		item->capacity = capacity;
+	}
+
+	path_copy = strdup(path);
+	if(path_copy == NULL)
+	{
+		return 1;
+	}
+
+	item->entries[item->nentries].path = path_copy;
+	item->entries[item->nentries].action = action;
+	++item->nentries;
+	return 0;
+}
+
+/* Looks up first item for the path that wasn't reached by the consumer before
+ * and discards listings of all unreached items that precede it.  Must be
+ * called with the lock held.  Returns the item or NULL. */
+static item_t *
+find_item(walker_t *walker, const char path[])
+{
+	item_t *item;
+	item_t *skipped;
+
+	for(item = walker->head; item != NULL; item = item->next)
+	{
+		if(!item->used && strcmp(item->path, path) == 0)
+		{
+			break;
+		}
+	}
+
+	if(item == NULL)
+	{
+		return NULL;
+	}
+
+	/* Items are processed in the order they were queued in, so previous ones
+	 * won't be needed. */
+	for(skipped = walker->head; skipped != item; skipped = skipped->next)
+	{
+		if(!skipped->used)
+		{
+			skipped->used = 1;
+			drop_listing(walker, skipped);
+		}
+	}
+
+	item->used = 1;
+	return item;
+}
+
+/* Feeds listing of the item to the visitor as it's being recorded.  Must be
+ * called with the lock held. */
+static void
+replay(walker_t *walker, item_t *item, subtree_visitor visitor, void *param,
+		int *result)
+{
+	dir_stack_t dirs = { };
+
+	item->replaying = 1;
+	while(1)
+	{
+		entry_t entry;
+		int stop;
+
+		while(item->consumed == item->nentries && item->listed && !item->walked &&
+				!walker->stopping)
+		{
+			pthread_cond_wait(&walker->cond, &walker->lock);
+		}
+
+		if(item->consumed == item->nentries)
+		{
+			/* Listing is complete or broken. */
+			*result = (item->walked && item->listed) ? item->failed : 1;
+			break;
+		}
+
+		entry = item->entries[item->consumed];
+		item->entries[item->consumed].path = NULL;
+		++item->consumed;
+		--walker->npending;
+		pthread_cond_broadcast(&walker->cond);
+
+		pthread_mutex_unlock(&walker->lock);
+		stop = replay_entry(&entry, visitor, param, &dirs, result);
+		free(entry.path);
+		pthread_mutex_lock(&walker->lock);
+
+		if(stop)
+		{
+			break;
+		}
+	}
+	item->replaying = 0;
+
+	drop_listing(walker, item);
+	prune_items(walker);
+	pthread_cond_broadcast(&walker->cond);
+
+	free(dirs.skip_leave);
+}
+
+/* Passes single entry to the visitor handling results the same way traverse()
+ * does.  Returns non-zero if traversal should be stopped, *result is set in
+ * this case. */
+static int
+replay_entry(const entry_t *entry, subtree_visitor visitor, void *param,
+		dir_stack_t *dirs, int *result)
+{
+	VisitResult visit_result;
+
+	switch(entry->action)
+	{
+		case VA_DIR_ENTER:
+			visit_result = visitor(entry->path, VA_DIR_ENTER, param);
+			if(visit_result == VR_ERROR)
+			{
+				*result = 1;
+				return 1;
+			}
+
+			if(dirs->depth == dirs->capacity)
+			{
+				const size_t capacity = (dirs->capacity == 0U) ? 16U
+				                                              : dirs->capacity*2U;
+				char *const skip_leave = realloc(dirs->skip_leave, capacity);
+				if(skip_leave == NULL)
+				{
+					*result = 1;
+					return 1;
+				}
+				dirs->skip_leave = skip_leave;
+				dirs->capacity = capacity;
+			}
+
+			dirs->skip_leave[dirs->depth++] = (visit_result == VR_SKIP_DIR_LEAVE ||
+					visit_result == VR_CANCELLED);
+			return 0;
+
+		case VA_FILE:
+			visit_result = visitor(entry->path, VA_FILE, param);
+			break;
+
+		case VA_DIR_LEAVE:
+			if(dirs->depth == 0U || dirs->skip_leave[--dirs->depth])
+			{
+				return 0;
+			}
+			visit_result = visitor(entry->path, VA_DIR_LEAVE, param);
+			break;
+
+		default:
+			visit_result = VR_ERROR;
+			break;
+	}
+
+	*result = visit_result;
+	return visit_result != VR_OK;
+}
+
+/* Frees listing of the item, which is unavailable from now on.  Must be called
+ * with the lock held. */
+static void
+drop_listing(walker_t *walker, item_t *item)
+{
+	size_t i;
+
+	for(i = item->consumed; i < item->nentries; ++i)
+	{
+		free(item->entries[i].path);
+	}
+	walker->npending -= item->nentries - item->consumed;
+
+	free(item->entries);
+	item->entries = NULL;
+	item->nentries = 0U;
+	item->capacity = 0U;
+	item->consumed = 0U;
+	item->listed = 0;
+}
+
+/* Frees items at the head of the queue which aren't needed anymore.  Must be
+ * called with the lock held. */
+static void
+prune_items(walker_t *walker)
+{
+	while(walker->head != NULL && walker->head->walked &&
+			!walker->head->replaying && (walker->head->used || !walker->head->listed))
+	{
+		item_t *const next = walker->head->next;
+		free_item(walker->head);
+		walker->head = next;
+	}
+
+	if(walker->head == NULL)
+	{
+		walker->tail = NULL;
+	}
+}
+
+/* Frees an item along with its listing. */
+static void
+free_item(item_t *item)
+{
+	size_t i;
+	for(i = item->consumed; i < item->nentries; ++i)
+	{
+		free(item->entries[i].path);
+	}
+	free(item->entries);
+	free(item->path);
+	free(item);
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,63 @@
+/* vifm
+ * Copyright (C) 2026 agent.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef VIFM__IO__PRIVATE__WALKER_H__
+#define VIFM__IO__PRIVATE__WALKER_H__
+
+#include <stddef.h> /* size_t */
+#include <stdint.h> /* uint64_t */
+
+#include "traverser.h"
+
+/* walker - background walker of subtrees, which counts their files and
+ *          optionally records listings for later use */
+
+/* Opaque declaration of walker type. */
+typedef struct walker_t walker_t;
+
+/* Starts a thread that walks queued paths one by one.  Counting starts from
+ * nitems and nbytes.  Listings are recorded only when keep_listings is
+ * non-zero.  Returns NULL on error. */
+walker_t * walker_create(int keep_listings, size_t nitems, uint64_t nbytes);
+
+/* Stops walking and frees all resources.  The walker can be NULL. */
+void walker_free(walker_t *walker);
+
+/* Queues path for walking.  Shallow walk counts the path as a single item
+ * without looking inside of it.  Returns non-zero on error, otherwise zero is
+ * returned. */
+int walker_add(walker_t *walker, const char path[], int shallow);
+
+/* Retrieves number of files and their size counted so far. */
+void walker_get_totals(walker_t *walker, size_t *nitems, uint64_t *nbytes);
+
+/* Checks whether all queued paths were walked.  Returns non-zero if so. */
+int walker_finished(walker_t *walker);
+
+/* Visits subtree at the path with the visitor exactly like traverse() would,
+ * but takes entries from listing of the path recorded by the walker waiting
+ * for them if necessary.  Listings of paths queued before the path are
+ * discarded.  Returns non-zero if there is no listing for the path, otherwise
+ * zero is returned and *result is set to what traverse() would return. */
+int walker_replay(walker_t *walker, const char path[], subtree_visitor visitor,
+		void *param, int *result);
+
+#endif /* VIFM__IO__PRIVATE__WALKER_H__ */
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
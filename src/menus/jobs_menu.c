@@ -26,6 +26,7 @@
 #include "../ui/ui.h"
 #include "../utils/str.h"
 #include "../utils/string_array.h"
+#include "../utils/utils.h"
 #include "../background.h"
 #include "menus.h"
 
@@ -53,7 +54,7 @@ show_jobs_menu(FileView *view)
 	{
 		if(p->running)
 		{
-			char info_buf[24];
+			char info_buf[48];
 			char item_buf[sizeof(info_buf) + strlen(p->cmd)];
 
 			if(p->type == BJT_COMMAND)
@@ -65,11 +66,18 @@ show_jobs_menu(FileView *view)
 			{
 				snprintf(info_buf, sizeof(info_buf), "n/a");
 			}
-			else
+			else if(p->bg_op.rate == 0U)
 			{
 				snprintf(info_buf, sizeof(info_buf), "%d/%d", p->bg_op.done + 1,
 						p->bg_op.total);
 			}
+			else
+			{
+				char rate[16];
+				(void)friendly_size_notation(p->bg_op.rate, sizeof(rate), rate);
+				snprintf(info_buf, sizeof(info_buf), "%d/%d, %s/s",
+						p->bg_op.done + 1, p->bg_op.total, rate);
+			}
 
 			snprintf(item_buf, sizeof(item_buf), "%-8s  %s", info_buf, p->cmd);
 			i = add_to_string_array(&m.items, i, 1, item_buf);
@@ -24,15 +24,15 @@
 #include <unistd.h> /* usleep() */
 
 #include <assert.h> /* assert() */
-#include <stddef.h> /* ptrdiff_t size_t */
-#include <string.h> /* memset() strdup() */
+#include <limits.h> /* INT_MAX */
+#include <stddef.h> /* NULL size_t */
+#include <string.h> /* memcpy() memset() strdup() */
 #include <stdio.h>  /* fclose() snprintf() */
-#include <stdlib.h> /* free() */
+#include <stdlib.h> /* free() realloc() */
 
 #include "../cfg/config.h"
 #include "../compat/fs_limits.h"
 #include "../compat/os.h"
-#include "../compat/reallocarray.h"
 #include "../engine/keys.h"
 #include "../engine/mode.h"
 #include "../int/vim.h"
@@ -44,8 +44,10 @@
 #include "../ui/quickview.h"
 #include "../ui/statusbar.h"
 #include "../ui/ui.h"
-#include "../utils/filemon.h"
+#include "../ui/view_search.h"
+#include "../utils/file_lines.h"
 #include "../utils/fs.h"
+#include "../utils/fswatch.h"
 #include "../utils/macros.h"
 #include "../utils/path.h"
 #include "../utils/regexp.h"
@@ -62,6 +64,13 @@
 #include "modes.h"
 #include "normal.h"
 
+/* Number of lines of a regular file indexed on opening it, which makes total
+ * number of lines known right away for files of moderate size. */
+#define EAGER_INDEX_LINES 65536
+
+/* Number of highlighted lines that are cached. */
+#define HL_CACHE_SIZE 64
+
 /* Named boolean values of "silent" parameter for better readability. */
 enum
 {
@@ -69,37 +78,49 @@ enum
 	SILENT,   /* Do not display error message dialog. */
 };
 
+/* Line with highlighted matches of search pattern. */
+typedef struct
+{
+	int line;   /* Number of the line. */
+	char *text; /* Highlighted line or NULL. */
+}
+hl_line_t;
+
 /* Describes view state and its properties. */
 typedef struct
 {
 	/* Data of the view. */
-	char **lines;     /* List of real lines. */
-	int (*widths)[2]; /* (virtual line, screen width) pair per real line. */
-	int nlines;       /* Number of real lines. */
-	int nlinesv;      /* Number of virtual (possibly wrapped) lines. */
-	int line;         /* Current real line number. */
-	int linev;        /* Current virtual line number. */
+	char **lines;           /* List of real lines (when file isn't indexed). */
+	int nlines;             /* Number of real lines (when file isn't indexed). */
+	file_lines_t *file;     /* Lazily indexed file or NULL. */
+	char *line_buf;         /* Null-terminated copy of a line of indexed file. */
+	size_t line_buf_len;    /* Size of line_buf. */
+	int line;               /* Current real line number. */
+	int row;                /* First visible screen line of the current line. */
 
 	/* Dimensions, units of actions. */
 	int win_size; /* Scroll window size. */
 	int half_win; /* Height of a "page" (can be changed). */
-	int width;    /* Last width used for breaking lines. */
 
 	/* Monitoring of changes for automatic forwarding. */
-	int auto_forward;   /* Whether auto forwarding (tail -F) is enabled. */
-	filemon_t file_mon; /* File monitor for auto forwarding mode. */
+	int auto_forward; /* Whether auto forwarding (tail -F) is enabled. */
+	fswatch_t *watch; /* Watcher of the file or NULL. */
 
 	/* Related to search. */
 	regex_t re;               /* Search regular expression. */
 	int last_search_backward; /* Value -1 means no search was performed. */
 	int search_repeat;        /* Saved count prefix of search commands. */
+	char *pattern;            /* Pattern of the last search. */
+	int cflags;               /* Flags the pattern was compiled with. */
+	vs_counter_t *counter;    /* Counter of matches or NULL. */
+	int report_matches;       /* Whether number of matches is displayed. */
+	hl_line_t hl_cache[HL_CACHE_SIZE]; /* Cache of highlighted lines. */
 
 	/* The rest of the state. */
 	FileView *view; /* File view association with the view. */
 	char *filename; /* Full path to the file being viewed. */
 	int abandoned;  /* Whether view mode was abandoned. */
 	int graphics;   /* Whether viewer presumably displays graphics. */
-	int wrap;       /* Whether lines are wrapped. */
 }
 view_info_t;
 
@@ -118,11 +139,21 @@ static void reset_view_info(view_info_t *vi);
 static void init_view_info(view_info_t *vi);
 static void free_view_info(view_info_t *vi);
 static void redraw(void);
-static void calc_vlines(void);
-static void calc_vlines_wrapped(view_info_t *vi);
-static void calc_vlines_non_wrapped(view_info_t *vi);
+static void fix_position(view_info_t *vi);
 static void draw(void);
-static int get_part(const char line[], int offset, size_t max_len, char part[]);
+static const char * get_line(view_info_t *vi, int line);
+static int has_line(view_info_t *vi, int line);
+static int total_lines(view_info_t *vi);
+static int line_height(view_info_t *vi, int line);
+static int text_height(const view_info_t *vi, const char text[]);
+static int count_rows(view_info_t *vi, int limit);
+static int step_down(view_info_t *vi);
+static int step_up(view_info_t *vi);
+static void place_bottom(view_info_t *vi);
+static const char * get_highlighted(view_info_t *vi, int line,
+		const char text[]);
+static void reset_highlights(view_info_t *vi);
+static vs_layout_t get_layout(const view_info_t *vi);
 static void display_error(const char error_msg[]);
 static void cmd_ctrl_l(key_info_t key_info, keys_info_t *keys_info);
 static void cmd_ctrl_wH(key_info_t key_info, keys_info_t *keys_info);
@@ -169,7 +200,9 @@ static void cmd_k(key_info_t key_info, keys_info_t *keys_info);
 static void cmd_n(key_info_t key_info, keys_info_t *keys_info);
 static void goto_search_result(int repeat_count, int inverse_direction);
 static void search(int repeat_count, int backward);
-static void find_previous(int vline_offset);
+static void update_counter(view_info_t *vi);
+static void report_matches(view_info_t *vi);
+static void find_previous(void);
 static void find_next(void);
 static void cmd_q(key_info_t key_info, keys_info_t *keys_info);
 static void cmd_u(key_info_t key_info, keys_info_t *keys_info);
@@ -391,6 +424,13 @@ try_activate_view_mode(void)
 void
 view_pre(void)
 {
+	fix_position(vi);
+
+	if(vi->report_matches > 0)
+	{
+		--vi->report_matches;
+	}
+
 	if(curr_stats.save_msg == 0)
 	{
 		const char *const suffix = vi->auto_forward ? "(auto forwarding)" : "";
@@ -410,7 +450,17 @@ void
 view_ruler_update(void)
 {
 	char buf[POS_WIN_MIN_WIDTH + 1];
-	snprintf(buf, sizeof(buf), "%d-%d ", vi->line + 1, vi->nlines);
+	size_t nlines = vi->nlines;
+
+	if(vi->file != NULL && fl_known_count(vi->file, &nlines) != 0)
+	{
+		snprintf(buf, sizeof(buf), "%d-? ", vi->line + 1);
+	}
+	else
+	{
+		snprintf(buf, sizeof(buf), "%d-%" PRINTF_ULL " ", vi->line + 1,
+				(unsigned long long)nlines);
+	}
 
 	ui_ruler_set(buf);
 }
@@ -500,7 +550,6 @@ init_view_info(view_info_t *vi)
 	memset(vi, '\0', sizeof(*vi));
 	vi->win_size = -1;
 	vi->half_win = -1;
-	vi->width = -1;
 	vi->last_search_backward = -1;
 	vi->search_repeat = NO_COUNT_GIVEN;
 }
@@ -510,72 +559,44 @@ static void
 free_view_info(view_info_t *vi)
 {
 	free_string_array(vi->lines, vi->nlines);
-	free(vi->widths);
+	fl_close(vi->file);
+	free(vi->line_buf);
 	if(vi->last_search_backward != -1)
 	{
 		regfree(&vi->re);
 	}
+	free(vi->pattern);
+	vs_counter_free(vi->counter);
+	reset_highlights(vi);
+	fswatch_free(vi->watch);
 	free(vi->filename);
 }
 
-/* Updates line width and redraws the view. */
+/* Validates position and redraws the view. */
 static void
 redraw(void)
 {
 	ui_view_title_update(vi->view);
-	calc_vlines();
+	fix_position(vi);
 	draw();
 }
 
-/* Recalculates virtual lines of a view if display options require it. */
-static void
-calc_vlines(void)
-{
-	/* Skip the recalculation if window size and wrapping options are the same. */
-	if(ui_qv_width(vi->view) == vi->width && vi->wrap == cfg.wrap_quick_view)
-	{
-		return;
-	}
-
-	vi->width = ui_qv_width(vi->view);
-	vi->wrap = cfg.wrap_quick_view;
-
-	if(vi->wrap)
-	{
-		calc_vlines_wrapped(vi);
-	}
-	else
-	{
-		calc_vlines_non_wrapped(vi);
-	}
-}
-
-/* Recalculates virtual lines of a view with line wrapping. */
+/* Makes sure that position of a view is valid after the file got truncated or
+ * size of the window or wrapping options have changed. */
 static void
-calc_vlines_wrapped(view_info_t *vi)
+fix_position(view_info_t *vi)
 {
-	int i;
-	vi->nlinesv = 0;
-	for(i = 0; i < vi->nlines; i++)
+	if(vi->file != NULL)
 	{
-		vi->widths[i][0] = vi->nlinesv++;
-		vi->widths[i][1] = utf8_strsw_with_tabs(vi->lines[i], cfg.tab_stop) -
-			esc_str_overhead(vi->lines[i]);
-		vi->nlinesv += vi->widths[i][1]/vi->width;
+		(void)fl_sync(vi->file);
 	}
-}
 
-/* Recalculates virtual lines of a view without line wrapping. */
-static void
-calc_vlines_non_wrapped(view_info_t *vi)
-{
-	int i;
-	vi->nlinesv = vi->nlines;
-	for(i = 0; i < vi->nlines; i++)
+	if(!has_line(vi, vi->line))
 	{
-		vi->widths[i][0] = i;
-		vi->widths[i][1] = vi->width;
+		vi->line = MAX(total_lines(vi) - 1, 0);
+		vi->row = 0;
 	}
+	vi->row = MIN(vi->row, line_height(vi, vi->line) - 1);
 }
 
 static void
@@ -585,7 +606,6 @@ draw(void)
 	const col_scheme_t *cs = ui_view_get_cs(vi->view);
 	const int height = ui_qv_height(vi->view);
 	const int width = ui_qv_width(vi->view);
-	const int max_l = MIN(vi->line + height, vi->nlines);
 	const int searched = (vi->last_search_backward != -1);
 	esc_state state;
 
@@ -596,6 +616,7 @@ draw(void)
 		qv_cleanup(vi->view, cmd);
 
 		free_string_array(vi->lines, vi->nlines);
+		reset_highlights(vi);
 		(void)get_view_data(vi, vi->filename);
 		return;
 	}
@@ -604,29 +625,242 @@ draw(void)
 
 	ui_view_erase(vi->view);
 
-	for(vl = 0, l = vi->line; l < max_l && vl < height; ++l)
+	for(vl = 0, l = vi->line; vl < height; ++l)
 	{
 		int offset = 0;
 		int processed = 0;
-		char *const line = vi->lines[l];
-		char *p = searched ? esc_highlight_pattern(line, &vi->re) : line;
+		const char *p = get_line(vi, l);
+		if(p == NULL)
+		{
+			break;
+		}
+
+		if(searched)
+		{
+			p = get_highlighted(vi, l, p);
+		}
+
 		do
 		{
 			int printed;
-			const int vis = l != vi->line
-			             || vl + processed >= vi->linev - vi->widths[vi->line][0];
+			const int vis = l != vi->line || processed >= vi->row;
 			offset += esc_print_line(p + offset, vi->view->win, ui_qv_left(vi->view),
 					ui_qv_top(vi->view) + vl, width, !vis, &state, &printed);
 			vl += vis;
 			++processed;
 		}
-		while(vi->wrap && p[offset] != '\0' && vl < height);
-		if(searched)
+		while(cfg.wrap_quick_view && p[offset] != '\0' && vl < height);
+	}
+	refresh_view_win(vi->view);
+}
+
+/* Retrieves line of a view.  Returns pointer to null-terminated string, which
+ * is valid until the next call, or NULL if there is no such line. */
+static const char *
+get_line(view_info_t *vi, int line)
+{
+	const char *data;
+	size_t len;
+
+	if(vi->file == NULL)
+	{
+		return (line >= 0 && line < vi->nlines) ? vi->lines[line] : NULL;
+	}
+
+	data = (line >= 0) ? fl_get(vi->file, line, &len) : NULL;
+	if(data == NULL)
+	{
+		return NULL;
+	}
+
+	if(len + 1 > vi->line_buf_len)
+	{
+		char *const buf = realloc(vi->line_buf, len + 1);
+		if(buf == NULL)
+		{
+			/* Display as much of the line as possible. */
+			if(vi->line_buf_len == 0U)
+			{
+				return "";
+			}
+			len = vi->line_buf_len - 1U;
+		}
+		else
 		{
-			free(p);
+			vi->line_buf = buf;
+			vi->line_buf_len = len + 1;
 		}
 	}
-	refresh_view_win(vi->view);
+
+	memcpy(vi->line_buf, data, len);
+	vi->line_buf[len] = '\0';
+	return vi->line_buf;
+}
+
+/* Checks whether view has line with specified number.  Returns non-zero if so,
+ * otherwise zero is returned. */
+static int
+has_line(view_info_t *vi, int line)
+{
+	if(vi->file == NULL)
+	{
+		return (line >= 0 && line < vi->nlines);
+	}
+	return (line >= 0 && fl_has_line(vi->file, line));
+}
+
+/* Counts lines of a view, which requires indexing whole file.  Returns
+ * the number, which is limited to the range of line numbers of the view. */
+static int
+total_lines(view_info_t *vi)
+{
+	size_t count;
+
+	if(vi->file == NULL)
+	{
+		return vi->nlines;
+	}
+
+	count = fl_count(vi->file);
+	return (count > INT_MAX) ? INT_MAX : (int)count;
+}
+
+/* Computes number of screen lines occupied by a line of a view.  Returns the
+ * number. */
+static int
+line_height(view_info_t *vi, int line)
+{
+	const char *const text = get_line(vi, line);
+	return (text == NULL) ? 1 : text_height(vi, text);
+}
+
+/* Computes number of screen lines occupied by the text.  Returns the number. */
+static int
+text_height(const view_info_t *vi, const char text[])
+{
+	const int width = ui_qv_width(vi->view);
+	int text_width;
+
+	if(!cfg.wrap_quick_view || width <= 0)
+	{
+		return 1;
+	}
+
+	text_width = utf8_strsw_with_tabs(text, cfg.tab_stop)
+	           - esc_str_overhead(text);
+	return MAX(DIV_ROUND_UP(text_width, width), 1);
+}
+
+/* Counts screen lines starting with the current one till the end of a view,
+ * but stops when the limit is reached.  Returns the number. */
+static int
+count_rows(view_info_t *vi, int limit)
+{
+	int line = vi->line;
+	int rows = line_height(vi, line) - vi->row;
+	while(rows < limit && has_line(vi, ++line))
+	{
+		rows += line_height(vi, line);
+	}
+	return MIN(rows, limit);
+}
+
+/* Moves position of a view one screen line down.  Returns non-zero on success
+ * and zero at the end of the view. */
+static int
+step_down(view_info_t *vi)
+{
+	if(vi->row + 1 < line_height(vi, vi->line))
+	{
+		++vi->row;
+		return 1;
+	}
+
+	if(!has_line(vi, vi->line + 1))
+	{
+		return 0;
+	}
+
+	++vi->line;
+	vi->row = 0;
+	return 1;
+}
+
+/* Moves position of a view one screen line up.  Returns non-zero on success
+ * and zero at the top of the view. */
+static int
+step_up(view_info_t *vi)
+{
+	if(vi->row > 0)
+	{
+		--vi->row;
+		return 1;
+	}
+
+	if(vi->line == 0)
+	{
+		return 0;
+	}
+
+	--vi->line;
+	vi->row = line_height(vi, vi->line) - 1;
+	return 1;
+}
+
+/* Positions the view so that its last screen line is at the bottom of the
+ * window. */
+static void
+place_bottom(view_info_t *vi)
+{
+	int n = ui_qv_height(vi->view) - 1;
+
+	vi->line = MAX(total_lines(vi) - 1, 0);
+	vi->row = line_height(vi, vi->line) - 1;
+
+	while(n-- > 0 && step_up(vi))
+	{
+		/* Do nothing. */
+	}
+}
+
+/* Retrieves line with highlighted matches of the last search pattern.  Returns
+ * pointer to the line, which is valid until the cache is reset. */
+static const char *
+get_highlighted(view_info_t *vi, int line, const char text[])
+{
+	hl_line_t *const entry = &vi->hl_cache[line%HL_CACHE_SIZE];
+	if(entry->text == NULL || entry->line != line)
+	{
+		free(entry->text);
+		entry->text = esc_highlight_pattern(text, &vi->re);
+		entry->line = line;
+	}
+	return (entry->text == NULL) ? text : entry->text;
+}
+
+/* Empties cache of highlighted lines. */
+static void
+reset_highlights(view_info_t *vi)
+{
+	size_t i;
+	for(i = 0U; i < ARRAY_LEN(vi->hl_cache); ++i)
+	{
+		free(vi->hl_cache[i].text);
+		vi->hl_cache[i].text = NULL;
+	}
+}
+
+/* Retrieves parameters of breaking lines of a view into screen lines.  Returns
+ * the parameters. */
+static vs_layout_t
+get_layout(const view_info_t *vi)
+{
+	const vs_layout_t layout = {
+		.width = ui_qv_width(vi->view),
+		.tab_stop = cfg.tab_stop,
+		.wrap = cfg.wrap_quick_view,
+	};
+	return layout;
 }
 
 int
@@ -640,7 +874,15 @@ find_vwpattern(const char *pattern, int backward)
 	if(vi->last_search_backward != -1)
 		regfree(&vi->re);
 	vi->last_search_backward = -1;
-	if((err = regcomp(&vi->re, pattern, get_regexp_cflags(pattern))) != 0)
+
+	free(vi->pattern);
+	vi->pattern = NULL;
+	vs_counter_free(vi->counter);
+	vi->counter = NULL;
+	reset_highlights(vi);
+
+	vi->cflags = get_regexp_cflags(pattern);
+	if((err = regcomp(&vi->re, pattern, vi->cflags)) != 0)
 	{
 		status_bar_errorf("Invalid pattern: %s", get_regexp_error(err, &vi->re));
 		regfree(&vi->re);
@@ -648,6 +890,7 @@ find_vwpattern(const char *pattern, int backward)
 		return 1;
 	}
 
+	vi->pattern = strdup(pattern);
 	vi->last_search_backward = backward;
 
 	search(vi->search_repeat, backward);
@@ -887,10 +1130,10 @@ cmd_percent(key_info_t key_info, keys_info_t *keys_info)
 	if(key_info.count > 100)
 		key_info.count = 100;
 
-	vi->line = (key_info.count*vi->nlinesv)/100;
-	if(vi->line >= vi->nlines)
-		vi->line = vi->nlines - 1;
-	vi->linev = vi->widths[vi->line][0];
+	vi->line = ((long long)key_info.count*total_lines(vi))/100;
+	if(!has_line(vi, vi->line))
+		vi->line = MAX(total_lines(vi) - 1, 0);
+	vi->row = 0;
 	draw();
 }
 
@@ -948,6 +1191,11 @@ cmd_F(key_info_t key_info, keys_info_t *keys_info)
 			draw();
 		}
 	}
+	else
+	{
+		fswatch_free(vi->watch);
+		vi->watch = NULL;
+	}
 }
 
 /* Either scrolls to specific line number (when specified) or to the bottom of
@@ -1014,21 +1262,13 @@ load_view_data(view_info_t *vi, const char action[], const char file_to_view[],
 			return 1;
 	}
 
-	vi->widths = reallocarray(NULL, vi->nlines, sizeof(*vi->widths));
-	if(vi->widths == NULL)
-	{
-		free_string_array(vi->lines, vi->nlines);
-		vi->lines = NULL;
-		vi->nlines = 0;
-		show_error_msg(action, "Not enough memory");
-		return 1;
-	}
-
 	return 0;
 }
 
-/* Reads data to be displayed handling error cases.  Returns zero on success, 2
- * on file reading error, 3 on issues with viewer or 4 on empty input. */
+/* Reads data to be displayed handling error cases.  Regular files are indexed
+ * and read lazily instead of being read whole when possible.  Returns zero on
+ * success, 2 on file reading error, 3 on issues with viewer or 4 on empty
+ * input. */
 static int
 get_view_data(view_info_t *vi, const char file_to_view[])
 {
@@ -1043,6 +1283,13 @@ get_view_data(view_info_t *vi, const char file_to_view[])
 		}
 		else
 		{
+			vi->file = fl_open(file_to_view);
+			if(vi->file != NULL)
+			{
+				(void)fl_has_line(vi->file, EAGER_INDEX_LINES);
+				return 0;
+			}
+
 			fp = os_fopen(file_to_view, "rb");
 		}
 
@@ -1107,19 +1354,25 @@ replace_vi(view_info_t *const orig, view_info_t *const new)
 	{
 		new->last_search_backward = orig->last_search_backward;
 		new->re = orig->re;
+		new->pattern = orig->pattern;
+		new->cflags = orig->cflags;
 		orig->last_search_backward = -1;
+		orig->pattern = NULL;
 	}
 
 	new->win_size = orig->win_size;
 	new->half_win = orig->half_win;
 	new->line = orig->line;
-	new->linev = orig->linev;
+	new->row = orig->row;
 	new->view = orig->view;
 	new->auto_forward = orig->auto_forward;
-	filemon_assign(&new->file_mon, &orig->file_mon);
+	new->watch = orig->watch;
+	orig->watch = NULL;
 
 	free_view_info(orig);
 	*orig = *new;
+
+	fix_position(orig);
 }
 
 static void
@@ -1156,49 +1409,45 @@ check_and_set_from_default_win(key_info_t *const key_info)
 static void
 cmd_g(key_info_t key_info, keys_info_t *keys_info)
 {
+	const int height = ui_qv_height(vi->view);
+	const int line = vi->line;
+	const int row = vi->row;
+
 	if(key_info.count == NO_COUNT_GIVEN)
 		key_info.count = 1;
 
-	key_info.count = MIN(vi->nlinesv - ui_qv_height(vi->view), key_info.count);
-	key_info.count = MAX(1, key_info.count);
+	vi->line = MAX(1, key_info.count) - 1;
+	vi->row = 0;
+	if(!has_line(vi, vi->line) || count_rows(vi, height) < height)
+		place_bottom(vi);
 
-	if(vi->linev == vi->widths[key_info.count - 1][0])
+	if(vi->line == line && vi->row == row)
 		return;
-	vi->line = key_info.count - 1;
-	vi->linev = vi->widths[vi->line][0];
 	draw();
 }
 
 static void
 cmd_j(key_info_t key_info, keys_info_t *keys_info)
 {
-	if(key_info.reg == NO_REG_GIVEN)
-	{
-		if((vi->linev + 1) + ui_qv_height(vi->view) > vi->nlinesv)
-			return;
-	}
-	else
-	{
-		if(vi->linev + 1 > vi->nlinesv)
-			return;
-	}
+	const int height = ui_qv_height(vi->view);
+	int room;
 
 	if(key_info.count == NO_COUNT_GIVEN)
 		key_info.count = 1;
+
+	/* Without register last screen line is kept at the bottom of the window,
+	 * otherwise view can be scrolled until only that line is visible. */
 	if(key_info.reg == NO_REG_GIVEN)
-		key_info.count = MIN(key_info.count,
-				vi->nlinesv - ui_qv_height(vi->view) - vi->linev);
+		room = count_rows(vi, height + key_info.count) - height;
 	else
-		key_info.count = MIN(key_info.count, vi->nlinesv - vi->linev - 1);
+		room = count_rows(vi, 1 + key_info.count) - 1;
 
-	while(key_info.count-- > 0)
-	{
-		const int height = MAX(DIV_ROUND_UP(vi->widths[vi->line][1], vi->width), 1);
-		if(vi->linev + 1 >= vi->widths[vi->line][0] + height)
-			++vi->line;
+	if(room <= 0)
+		return;
 
-		++vi->linev;
-	}
+	key_info.count = MIN(key_info.count, room);
+	while(key_info.count-- > 0)
+		(void)step_down(vi);
 
 	draw();
 }
@@ -1206,19 +1455,15 @@ cmd_j(key_info_t key_info, keys_info_t *keys_info)
 static void
 cmd_k(key_info_t key_info, keys_info_t *keys_info)
 {
-	if(vi->linev == 0)
+	if(vi->line == 0 && vi->row == 0)
 		return;
 
 	if(key_info.count == NO_COUNT_GIVEN)
 		key_info.count = 1;
-	key_info.count = MIN(key_info.count, vi->linev);
 
-	while(key_info.count-- > 0)
+	while(key_info.count-- > 0 && step_up(vi))
 	{
-		if(vi->linev - 1 < vi->widths[vi->line][0])
-			--vi->line;
-
-		--vi->linev;
+		/* Do nothing. */
 	}
 
 	draw();
@@ -1253,122 +1498,192 @@ search(int repeat_count, int backward)
 		repeat_count = 1;
 	}
 
+	update_counter(vi);
+
 	while(repeat_count-- > 0 && curr_stats.save_msg == 0)
 	{
 		if(backward)
 		{
-			find_previous(1);
+			find_previous();
 		}
 		else
 		{
 			find_next();
 		}
 	}
+
+	if(curr_stats.save_msg == 0)
+	{
+		report_matches(vi);
+		vi->report_matches = 2;
+	}
 }
 
+/* Makes sure that matches of the last search pattern are counted for current
+ * layout of the view. */
 static void
-find_previous(int vline_offset)
+update_counter(view_info_t *vi)
 {
-	int i;
-	int offset = 0;
-	char buf[ui_qv_width(vi->view)*4];
-	int vl, l;
+	const vs_layout_t layout = get_layout(vi);
 
-	vl = vi->linev - vline_offset;
-	l = vi->line;
+	if(vi->counter != NULL && vs_counter_fits(vi->counter, &layout))
+	{
+		return;
+	}
 
-	if(l > 0 && vl < vi->widths[l][0])
-		l--;
+	vs_counter_free(vi->counter);
+	if(vi->file == NULL)
+	{
+		vi->counter = vs_counter_count(vi->lines, vi->nlines, &vi->re, &layout);
+	}
+	else if(vi->pattern != NULL)
+	{
+		vi->counter = vs_counter_start(vi->filename, vi->pattern, vi->cflags,
+				&layout);
+	}
+	else
+	{
+		vi->counter = NULL;
+	}
+}
+
+/* Displays number of current match and number of matches in the status
+ * bar. */
+static void
+report_matches(view_info_t *vi)
+{
+	const vs_pos_t pos = { .line = vi->line, .row = vi->row };
+	int index, total, done;
+	char index_str[32];
 
-	for(i = 0; i <= vl - vi->widths[l][0]; i++)
-		offset = get_part(vi->lines[l], offset, ui_qv_width(vi->view), buf);
+	if(vi->counter == NULL)
+	{
+		return;
+	}
 
-	/* Don't stop until we go above first virtual line of the first line. */
-	while(l >= 0 && vl >= 0)
+	vs_counter_stats(vi->counter, pos, &index, &total, &done);
+	if(index < 0)
 	{
-		if(regexec(&vi->re, buf, 0, NULL, 0) == 0)
-		{
-			vi->linev = vl;
-			vi->line = l;
-			break;
-		}
-		if(l > 0 && vl - 1 < vi->widths[l][0])
+		copy_str(index_str, sizeof(index_str), "?");
+	}
+	else
+	{
+		snprintf(index_str, sizeof(index_str), "%d", index + 1);
+	}
+
+	status_bar_messagef("Match %s of %d%s", index_str, total, done ? "" : "+");
+	curr_stats.save_msg = 1;
+}
+
+/* Looks for a match of the last search pattern above current position and
+ * moves to it. */
+static void
+find_previous(void)
+{
+	const vs_layout_t layout = get_layout(vi);
+	const vs_pos_t pos = { .line = vi->line, .row = vi->row };
+	vs_pos_t match;
+	int found = (vi->counter == NULL)
+	          ? -1
+	          : vs_counter_find(vi->counter, pos, 1, &match);
+
+	if(found < 0)
+	{
+		int l = vi->line;
+		int last = vi->row - 1;
+
+		/* Don't stop until we go above first screen line of the first line. */
+		found = 0;
+		while(l >= 0)
 		{
-			l--;
-			offset = 0;
-			for(i = 0; i <= vl - 1 - vi->widths[l][0]; i++)
-				offset = get_part(vi->lines[l], offset, ui_qv_width(vi->view), buf);
+			if(last >= 0)
+			{
+				match.line = l;
+				match.row = vs_match_line(&vi->re, &layout, get_line(vi, l), 0, last,
+						1);
+				if(match.row >= 0)
+				{
+					found = 1;
+					break;
+				}
+			}
+
+			--l;
+			last = INT_MAX;
 		}
-		else
-			offset = get_part(vi->lines[l], offset, ui_qv_width(vi->view), buf);
-		vl--;
 	}
+
+	if(found)
+	{
+		vi->line = match.line;
+		vi->row = match.row;
+	}
+
 	draw();
-	if(vi->line != l)
+	if(!found)
 	{
 		display_error("Pattern not found");
 	}
 }
 
+/* Looks for a match of the last search pattern below current position and
+ * moves to it. */
 static void
 find_next(void)
 {
-	int i;
-	int offset = 0;
-	char buf[ui_qv_width(vi->view)*4];
-	int vl, l;
+	const vs_layout_t layout = get_layout(vi);
+	const vs_pos_t pos = { .line = vi->line, .row = vi->row };
+	vs_pos_t match;
+	int found = (vi->counter == NULL)
+	          ? -1
+	          : vs_counter_find(vi->counter, pos, 0, &match);
 
-	vl = vi->linev + 1;
-	l = vi->line;
-
-	if(l < vi->nlines - 1 && vl == vi->widths[l + 1][0])
-		l++;
-
-	for(i = 0; i <= vl - vi->widths[l][0]; i++)
-		offset = get_part(vi->lines[l], offset, ui_qv_width(vi->view), buf);
-
-	while(l < vi->nlines)
+	if(found < 0)
 	{
-		if(regexec(&vi->re, buf, 0, NULL, 0) == 0)
+		const char *line;
+		int first = vi->row + 1;
+		vs_finder_t finder;
+		const int literal = vi->file != NULL
+		                 && vi->pattern != NULL
+		                 && vs_is_literal(vi->pattern, vi->cflags);
+
+		if(literal)
 		{
-			vi->linev = vl;
-			vi->line = l;
-			break;
+			vs_finder_init(&finder, vi->file, vi->pattern);
 		}
-		if(l < vi->nlines && (l == vi->nlines - 1 ||
-				vl + 1 >= vi->widths[l + 1][0]))
+
+		found = 0;
+		match.line = vi->line;
+		while(match.line >= 0 && (line = get_line(vi, match.line)) != NULL)
 		{
-			if(l == vi->nlines - 1)
+			match.row = vs_match_line(&vi->re, &layout, line, first, INT_MAX, 0);
+			if(match.row >= 0)
+			{
+				found = 1;
 				break;
-			l++;
-			offset = 0;
+			}
+
+			/* Skip lines that can't contain the literal. */
+			match.line = literal
+			           ? vs_finder_next(&finder, match.line + 1)
+			           : match.line + 1;
+			first = 0;
 		}
-		offset = get_part(vi->lines[l], offset, ui_qv_width(vi->view), buf);
-		vl++;
 	}
+
+	if(found)
+	{
+		vi->line = match.line;
+		vi->row = match.row;
+	}
+
 	draw();
-	if(vi->line != l)
+	if(!found)
 	{
 		display_error("Pattern not found");
 	}
 }
 
-/* Extracts part of the line replacing all occurrences of horizontal tabulation
- * character with appropriate number of spaces.  The offset specifies beginning
- * of the part in the line.  The max_len parameter designates the maximum number
- * of screen characters to put into the part.  Returns number of processed items
- * of the line. */
-static int
-get_part(const char line[], int offset, size_t max_len, char part[])
-{
-	char *const no_esc = esc_remove(line);
-	const char *const begin = no_esc + offset;
-	const char *const end = expand_tabulation(begin, max_len, cfg.tab_stop, part);
-	const ptrdiff_t processed_chars = end - no_esc;
-	free(no_esc);
-	return processed_chars;
-}
-
 /* Displays the error message in the status bar. */
 static void
 display_error(const char error_msg[])
@@ -1531,6 +1846,13 @@ view_check_for_updates(void)
 {
 	int need_redraw = 0;
 
+	/* Keep number of matches up to date while they are being counted. */
+	if(vle_mode_is(VIEW_MODE) && vi->report_matches && vi->counter != NULL &&
+			vs_counter_progressed(vi->counter))
+	{
+		report_matches(vi);
+	}
+
 	need_redraw += forward_if_changed(&view_info[VI_QV]);
 	need_redraw += forward_if_changed(&view_info[VI_LWIN]);
 	need_redraw += forward_if_changed(&view_info[VI_RWIN]);
@@ -1541,53 +1863,73 @@ view_check_for_updates(void)
 	}
 }
 
-/* Forwards the view if underlying file changed.  Returns non-zero if reload
- * occurred, otherwise zero is returned. */
+/* Forwards the view if underlying file changed.  Only data appended to an
+ * indexed file is processed, other changes cause reload.  Returns non-zero if
+ * the view needs to be redrawn, otherwise zero is returned. */
 static int
 forward_if_changed(view_info_t *vi)
 {
-	filemon_t mon;
+	int error;
 
 	if(!vi->auto_forward)
 	{
 		return 0;
 	}
 
-	if(filemon_from_file(vi->filename, &mon) != 0)
+	if(vi->watch == NULL)
+	{
+		/* File might be missing for a while on rotation. */
+		vi->watch = fswatch_create(vi->filename);
+		if(vi->watch == NULL)
+		{
+			return 0;
+		}
+	}
+	else if(!fswatch_changed(vi->watch, &error) && !error)
 	{
 		return 0;
 	}
 
-	if(filemon_equal(&mon, &vi->file_mon))
+	if(vi->file != NULL && fl_is_same_file(vi->file, vi->filename))
 	{
-		return 0;
+		const int shrunk = fl_sync(vi->file);
+		if(!fl_grow(vi->file) && !shrunk)
+		{
+			return 0;
+		}
+
+		/* Contents of lines might have changed. */
+		reset_highlights(vi);
+		vs_counter_free(vi->counter);
+		vi->counter = NULL;
+		fix_position(vi);
+		(void)scroll_to_bottom(vi);
+		return 1;
+	}
+	else
+	{
+		/* Path can refer to a different file now. */
+		fswatch_free(vi->watch);
+		vi->watch = fswatch_create(vi->filename);
+
+		reload_view(vi, SILENT);
+		/* Reloading fails on file becoming empty, make sure old data isn't used. */
+		fix_position(vi);
 	}
 
-	filemon_assign(&vi->file_mon, &mon);
-	reload_view(vi, SILENT);
 	return scroll_to_bottom(vi);
 }
 
-/* Scrolls view to the bottom if there is any room for that.  Returns non-zero
- * if position was changed, otherwise zero is returned. */
+/* Scrolls view so that its last line is at the bottom of the window.  Returns
+ * non-zero if position was changed, otherwise zero is returned. */
 static int
 scroll_to_bottom(view_info_t *vi)
 {
-	if(vi->linev + 1 + ui_qv_height(vi->view) > vi->nlinesv)
-	{
-		return 0;
-	}
-
-	vi->linev = vi->nlinesv - ui_qv_height(vi->view);
-	for(vi->line = 0; vi->line < vi->nlines - 1; ++vi->line)
-	{
-		if(vi->linev < vi->widths[vi->line + 1][0])
-		{
-			break;
-		}
-	}
+	const int line = vi->line;
+	const int row = vi->row;
 
-	return 1;
+	place_bottom(vi);
+	return (vi->line != line || vi->row != row);
 }
 
 /* Reloads contents of the specified view by rerunning corresponding viewer or
@@ -41,6 +41,7 @@
 #include "io/ioeta.h"
 #include "io/iop.h"
 #include "io/ior.h"
+#include "io/iothrottle.h"
 #include "modes/dialogs/msg_dialog.h"
 #include "ui/cancellation.h"
 #include "utils/fs.h"
@@ -102,6 +103,7 @@ static int op_movea(ops_t *ops, void *data, const char src[], const char dst[]);
 static int op_mv(ops_t *ops, void *data, const char src[], const char dst[],
 		ConflictAction conflict_action);
 static IoCrs ca_to_crs(ConflictAction conflict_action);
+static IoVerify get_io_verify(void);
 static int op_chown(ops_t *ops, void *data, const char *src, const char *dst);
 static int op_chgrp(ops_t *ops, void *data, const char *src, const char *dst);
 #ifndef _WIN32
@@ -170,6 +172,13 @@ ops_alloc(OPS main_op, int bg, const char descr[], const char base_dir[],
 	ops->base_dir = strdup(base_dir);
 	ops->target_dir = strdup(target_dir);
 	ops->bg = bg;
+	if(bg)
+	{
+		/* Each operation is limited on its own and by limits shared by all of
+		 * them. */
+		ops->throttle = iothrottle_create(cfg.io_job_rate, cfg.io_job_ops_rate,
+				iothrottle_global());
+	}
 	return ops;
 }
 
@@ -179,6 +188,36 @@ ops_describe(const ops_t *ops)
 	return ops->descr;
 }
 
+void
+ops_stream_eta(ops_t *ops)
+{
+	int copying;
+
+	if(ops->estim == NULL)
+	{
+		return;
+	}
+
+	switch(ops->main_op)
+	{
+		case OP_COPY:
+		case OP_COPYF:
+		case OP_COPYA:
+		case OP_MOVE:
+		case OP_MOVEF:
+		case OP_MOVEA:
+			/* Subtrees will be traversed again to copy them. */
+			copying = 1;
+			break;
+
+		default:
+			copying = 0;
+			break;
+	}
+
+	ioeta_stream(ops->estim, copying);
+}
+
 void
 ops_enqueue(ops_t *ops, const char src[], const char dst[])
 {
@@ -190,7 +229,7 @@ ops_enqueue(ops_t *ops, const char src[], const char dst[])
 	}
 
 	/* Check once and cache result, it should be the same for each invocation. */
-	if(ops->estim->total_items == 0)
+	if(ops->total == 1)
 	{
 		switch(ops->main_op)
 		{
@@ -215,6 +254,16 @@ ops_enqueue(ops_t *ops, const char src[], const char dst[])
 				ops->shallow_eta = 1;
 				break;
 
+			case OP_REMOVESL:
+				if(ops->bg && cfg.use_system_calls && cfg.delete_prg[0] == '\0' &&
+						cfg.io_workers > 1)
+				{
+					/* Removal in background lists directories anyway and adds what it
+					 * finds to totals, so don't traverse them in advance. */
+					ops->shallow_eta = 1;
+				}
+				break;
+
 			default:
 				/* No optimizations for other operations. */
 				break;
@@ -250,6 +299,7 @@ ops_free(ops_t *ops)
 	}
 
 	ioeta_free(ops->estim);
+	iothrottle_free(ops->throttle);
 	free(ops->errors);
 	free(ops->base_dir);
 	free(ops->target_dir);
@@ -383,6 +433,7 @@ op_removesl(ops_t *ops, void *data, const char *src, const char *dst)
 		.arg1.path = src,
 
 		.cancellable = data == NULL,
+		.nworkers = cfg.io_workers,
 	};
 	return exec_io_op(ops, &ior_rm, &args);
 }
@@ -484,6 +535,8 @@ op_cp(ops_t *ops, void *data, const char src[], const char dst[],
 		.arg4.fast_file_cloning = cfg.fast_file_cloning,
 
 		.cancellable = data == NULL,
+		.nworkers = cfg.io_workers,
+		.verify = get_io_verify(),
 	};
 	return exec_io_op(ops, &ior_cp, &args);
 }
@@ -587,6 +640,8 @@ op_mv(ops_t *ops, void *data, const char src[], const char dst[],
 			.arg4.fast_file_cloning = 1,
 
 			.cancellable = data == NULL,
+			.nworkers = cfg.io_workers,
+			.verify = get_io_verify(),
 		};
 		result = exec_io_op(ops, &ior_mv, &args);
 	}
@@ -615,6 +670,21 @@ ca_to_crs(ConflictAction conflict_action)
 	return IO_CRS_FAIL;
 }
 
+/* Maps verification setting to its counterpart of i/o modules.  Returns
+ * verification type. */
+static IoVerify
+get_io_verify(void)
+{
+	switch(cfg.verify_copies)
+	{
+		case VC_NONE:   return IO_VERIFY_NONE;
+		case VC_FAST:   return IO_VERIFY_FAST;
+		case VC_SHA256: return IO_VERIFY_SHA256;
+	}
+	assert(0 && "Unhandled verification type.");
+	return IO_VERIFY_NONE;
+}
+
 static int
 op_chown(ops_t *ops, void *data, const char *src, const char *dst)
 {
@@ -907,6 +977,8 @@ exec_io_op(ops_t *ops, int (*func)(io_args_t *const), io_args_t *const args)
 	int result;
 
 	args->estim = (ops == NULL) ? NULL : ops->estim;
+	args->journal = (ops == NULL) ? NULL : ops->journal;
+	args->throttle = (ops == NULL) ? NULL : ops->throttle;
 
 	if(ops != NULL)
 	{
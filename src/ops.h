@@ -20,6 +20,8 @@
 #define VIFM__OPS_H__
 
 #include "io/ioeta.h"
+#include "io/iojournal.h"
+#include "io/iothrottle.h"
 
 /* Kinds of operations on files. */
 typedef enum
@@ -86,8 +88,12 @@ typedef struct
 	const char *descr;    /* Description of operations. */
 	int shallow_eta;      /* Count only top level items, without recursion. */
 	int bg;               /* Executed in background (no user interaction). */
+	iojournal_t *journal; /* Journal of the operation or NULL, not owned. */
 	char *errors;         /* Multi-line string of errors. */
 
+	/* Rate limiter of background operation or NULL.  Freed by ops_free(). */
+	iothrottle_t *throttle;
+
 	char *base_dir;   /* Base directory in which operation is taking place. */
 	char *target_dir; /* Target directory of the operation (same as base_dir if
 	                     none). */
@@ -106,6 +112,11 @@ ops_t * ops_alloc(OPS main_op, int bg, const char descr[],
 /* Describes main operation with one generic word.  Returns the description. */
 const char * ops_describe(const ops_t *ops);
 
+/* Makes estimates be calculated in background while items are processed
+ * instead of doing it upfront.  Should be called before the first
+ * ops_enqueue(). */
+void ops_stream_eta(ops_t *ops);
+
 /* Puts new item to the ops.  Destination argument is a hint to optimize
  * estimating performance, it can be NULL. */
 void ops_enqueue(ops_t *ops, const char src[], const char dst[]);
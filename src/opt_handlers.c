@@ -25,8 +25,9 @@
 #include <ctype.h> /* isdigit() */
 #include <limits.h> /* INT_MIN */
 #include <stddef.h> /* NULL size_t */
+#include <stdint.h> /* uint64_t */
 #include <stdio.h> /* snprintf() */
-#include <stdlib.h> /* abs() free() */
+#include <stdlib.h> /* abs() free() strtoull() */
 #include <string.h> /* memcpy() memmove() strchr() strdup() strlen() strncat()
                        strstr() */
 
@@ -34,10 +35,12 @@
 #include "engine/options.h"
 #include "engine/text_buffer.h"
 #include "int/term_title.h"
+#include "io/iothrottle.h"
 #include "modes/view.h"
 #include "ui/column_view.h"
 #include "ui/fileview.h"
 #include "ui/quickview.h"
+#include "ui/qv_cache.h"
 #include "ui/statusbar.h"
 #include "ui/ui.h"
 #include "utils/log.h"
@@ -59,6 +62,9 @@
 /* Default value of 'viewcolumns' option, used when it's empty. */
 #define DEFAULT_VIEW_COLUMNS "-{name},{}"
 
+/* Maximum number of files in each direction for 'previewprefetch' option. */
+#define MAX_PREFETCH_ENTRIES 16
+
 typedef union
 {
 	int *bool_val;
@@ -87,6 +93,9 @@ static void init_trashdir(optval_t *val);
 static void init_lsview(optval_t *val);
 static void init_shortmess(optval_t *val);
 static void init_iooptions(optval_t *val);
+#ifndef _WIN32
+static void init_previewprefetch(optval_t *val);
+#endif
 static void init_number(optval_t *val);
 static void init_numberwidth(optval_t *val);
 static void init_relativenumber(optval_t *val);
@@ -124,13 +133,22 @@ static void hlsearch_handler(OPT_OP op, optval_t val);
 static void iec_handler(OPT_OP op, optval_t val);
 static void ignorecase_handler(OPT_OP op, optval_t val);
 static void incsearch_handler(OPT_OP op, optval_t val);
+static void iolimits_handler(OPT_OP op, optval_t val);
+static int parse_rate(const char str[], uint64_t *rate);
+static void reset_iolimits(void);
 static void iooptions_handler(OPT_OP op, optval_t val);
+static void ioworkers_handler(OPT_OP op, optval_t val);
 static int parse_range(const char range[], int *from, int *to);
 static int parse_endpoint(const char **str, int *endpoint);
 static void laststatus_handler(OPT_OP op, optval_t val);
 static void lines_handler(OPT_OP op, optval_t val);
 static void locateprg_handler(OPT_OP op, optval_t val);
 static void mintimeoutlen_handler(OPT_OP op, optval_t val);
+#ifndef _WIN32
+static void previewprefetch_handler(OPT_OP op, optval_t val);
+static void reset_previewprefetch(void);
+static char * format_previewprefetch(void);
+#endif
 static void scroll_line_down(FileView *view);
 static void rulerformat_handler(OPT_OP op, optval_t val);
 static void runexec_handler(OPT_OP op, optval_t val);
@@ -231,9 +249,29 @@ static const char *dotdirs_vals[] = {
 };
 ARRAY_GUARD(dotdirs_vals, NUM_DOT_DIRS);
 
+/* Possible keys of 'iolimits' option. */
+static const char *iolimits_enum[] = {
+	"rate:",
+	"ops:",
+	"jobrate:",
+	"jobops:",
+};
+
+#ifndef _WIN32
+/* Possible keys of 'previewprefetch' option. */
+static const char *previewprefetch_enum[] = {
+	"entries:",
+	"jobs:",
+	"memory:",
+};
+#endif
+
 /* Possible flags of 'iooptions'. */
 static const char *iooptions_vals[] = {
 	"fastfilecloning",
+	"verify",
+	"verifysha256",
+	"idleprio",
 };
 
 /* Possible flags of 'shortmess' and their count. */
@@ -420,11 +458,20 @@ options[] = {
 	  OPT_BOOL, 0, NULL, &incsearch_handler , NULL,
 	  { .ref.bool_val = &cfg.inc_search },
 	},
+	{ "iolimits", "",
+		OPT_STRLIST, ARRAY_LEN(iolimits_enum), iolimits_enum, &iolimits_handler,
+		NULL,
+	  { .ref.str_val = &empty },
+	},
 	{ "iooptions", "",
 	  OPT_SET, ARRAY_LEN(iooptions_vals), iooptions_vals, &iooptions_handler,
 		NULL,
 	  { .init = &init_iooptions },
 	},
+	{ "ioworkers", "",
+	  OPT_INT, 0, NULL, &ioworkers_handler, NULL,
+	  { .ref.int_val = &cfg.io_workers },
+	},
 	{ "laststatus", "ls",
 	  OPT_BOOL, 0, NULL, &laststatus_handler, NULL,
 	  { .ref.bool_val = &cfg.display_statusline },
@@ -441,6 +488,13 @@ options[] = {
 	  OPT_INT, 0, NULL, &mintimeoutlen_handler, NULL,
 	  { .ref.int_val = &cfg.min_timeout_len },
 	},
+#ifndef _WIN32
+	{ "previewprefetch", "",
+	  OPT_STRLIST, ARRAY_LEN(previewprefetch_enum), previewprefetch_enum,
+		&previewprefetch_handler, NULL,
+	  { .init = &init_previewprefetch },
+	},
+#endif
 	{ "rulerformat", "ruf",
 	  OPT_STR, 0, NULL, &rulerformat_handler, NULL,
 	  { .ref.str_val = &cfg.ruler_format },
@@ -695,9 +749,21 @@ init_shortmess(optval_t *val)
 static void
 init_iooptions(optval_t *val)
 {
-	val->set_items = (cfg.fast_file_cloning != 0) << 0;
+	val->set_items = ((cfg.fast_file_cloning != 0) << 0) |
+		((cfg.verify_copies == VC_FAST) << 1) |
+		((cfg.verify_copies == VC_SHA256) << 2) |
+		((cfg.io_idle_prio != 0) << 3);
 }
 
+#ifndef _WIN32
+/* Initializes value of 'previewprefetch' from configuration. */
+static void
+init_previewprefetch(optval_t *val)
+{
+	val->str_val = format_previewprefetch();
+}
+#endif
+
 /* Default-initializes whether to display file numbers. */
 static void
 init_number(optval_t *val)
@@ -1383,11 +1449,153 @@ incsearch_handler(OPT_OP op, optval_t val)
 	cfg.inc_search = val.bool_val;
 }
 
+/* Handles new value for 'iolimits' option.  Limits for all operations apply
+ * immediately, limits for a single operation affect operations started
+ * afterwards. */
+static void
+iolimits_handler(OPT_OP op, optval_t val)
+{
+	uint64_t limits[ARRAY_LEN(iolimits_enum)] = {};
+	char *new_val = strdup(val.str_val);
+	char *part = new_val, *state = NULL;
+
+	while((part = split_and_get(part, ',', &state)) != NULL)
+	{
+		size_t i;
+		for(i = 0U; i < ARRAY_LEN(iolimits_enum); ++i)
+		{
+			if(starts_with(part, iolimits_enum[i]))
+			{
+				break;
+			}
+		}
+
+		if(i == ARRAY_LEN(iolimits_enum))
+		{
+			break_at(part, ':');
+			vle_tb_append_linef(vle_err, "Unknown key for 'iolimits' option: %s",
+					part);
+			break;
+		}
+
+		if(parse_rate(part + strlen(iolimits_enum[i]), &limits[i]) != 0)
+		{
+			vle_tb_append_linef(vle_err, "Wrong rate for 'iolimits' option: %s",
+					part);
+			break;
+		}
+	}
+	free(new_val);
+
+	if(part != NULL)
+	{
+		error = 1;
+		reset_iolimits();
+		return;
+	}
+
+	cfg.io_rate = limits[0];
+	cfg.io_ops_rate = limits[1];
+	cfg.io_job_rate = limits[2];
+	cfg.io_job_ops_rate = limits[3];
+	iothrottle_set_limits(iothrottle_global(), cfg.io_rate, cfg.io_ops_rate);
+}
+
+/* Parses rate, which can have K, M or G suffix (powers of 1024).  Returns zero
+ * on success, otherwise non-zero is returned. */
+static int
+parse_rate(const char str[], uint64_t *rate)
+{
+	char *end;
+	uint64_t value;
+
+	if(!isdigit(str[0]))
+	{
+		return 1;
+	}
+
+	value = strtoull(str, &end, 10);
+	switch(*end)
+	{
+		case 'K': value <<= 10; ++end; break;
+		case 'M': value <<= 20; ++end; break;
+		case 'G': value <<= 30; ++end; break;
+	}
+
+	if(*end != '\0')
+	{
+		return 1;
+	}
+
+	*rate = value;
+	return 0;
+}
+
+/* Resets value of 'iolimits' option by composing it from current
+ * configuration. */
+static void
+reset_iolimits(void)
+{
+	const uint64_t limits[] = {
+		cfg.io_rate, cfg.io_ops_rate, cfg.io_job_rate, cfg.io_job_ops_rate
+	};
+
+	optval_t val;
+	char value[128];
+	size_t len = 0U;
+	size_t i;
+
+	value[0] = '\0';
+	for(i = 0U; i < ARRAY_LEN(limits); ++i)
+	{
+		if(limits[i] != 0U)
+		{
+			len += snprintf(value + len, sizeof(value) - len, "%s%s%" PRINTF_ULL,
+					(len == 0U) ? "" : ",", iolimits_enum[i],
+					(unsigned long long)limits[i]);
+		}
+	}
+
+	val.str_val = value;
+	set_option("iolimits", val, OPT_GLOBAL);
+}
+
 /* Handles changes of 'iooptions'.  Updates related configuration values. */
 static void
 iooptions_handler(OPT_OP op, optval_t val)
 {
 	cfg.fast_file_cloning = ((val.set_items & 1) != 0);
+
+	/* SHA-256 takes precedence as the stronger check. */
+	if(val.set_items & 4)
+	{
+		cfg.verify_copies = VC_SHA256;
+	}
+	else if(val.set_items & 2)
+	{
+		cfg.verify_copies = VC_FAST;
+	}
+	else
+	{
+		cfg.verify_copies = VC_NONE;
+	}
+
+	cfg.io_idle_prio = ((val.set_items & 8) != 0);
+}
+
+/* Handles changes of 'ioworkers'.  Rejects values that make no sense. */
+static void
+ioworkers_handler(OPT_OP op, optval_t val)
+{
+	if(val.int_val <= 0)
+	{
+		vle_tb_append_linef(vle_err, "Argument must be positive: %d", val.int_val);
+		error = 1;
+		reset_option_to_default("ioworkers", OPT_GLOBAL);
+		return;
+	}
+
+	cfg.io_workers = val.int_val;
 }
 
 /* Parses range, which can be shortened to single endpoint if first element
@@ -1529,6 +1737,97 @@ mintimeoutlen_handler(OPT_OP op, optval_t val)
 	cfg.min_timeout_len = val.int_val;
 }
 
+#ifndef _WIN32
+/* Handles new value for 'previewprefetch' option.  Keys that aren't specified
+ * get their default values. */
+static void
+previewprefetch_handler(OPT_OP op, optval_t val)
+{
+	uint64_t values[ARRAY_LEN(previewprefetch_enum)] = { 0U, 1U, 8*1024*1024 };
+	char *new_val = strdup(val.str_val);
+	char *part = new_val, *state = NULL;
+
+	while((part = split_and_get(part, ',', &state)) != NULL)
+	{
+		size_t i;
+		for(i = 0U; i < ARRAY_LEN(previewprefetch_enum); ++i)
+		{
+			if(starts_with(part, previewprefetch_enum[i]))
+			{
+				break;
+			}
+		}
+
+		if(i == ARRAY_LEN(previewprefetch_enum))
+		{
+			break_at(part, ':');
+			vle_tb_append_linef(vle_err,
+					"Unknown key for 'previewprefetch' option: %s", part);
+			break;
+		}
+
+		if(parse_rate(part + strlen(previewprefetch_enum[i]), &values[i]) != 0 ||
+				(i == 0U && values[i] > MAX_PREFETCH_ENTRIES) ||
+				(i == 1U && (values[i] < 1U || values[i] > QVC_MAX_JOBS)))
+		{
+			vle_tb_append_linef(vle_err,
+					"Wrong value for 'previewprefetch' option: %s", part);
+			break;
+		}
+	}
+	free(new_val);
+
+	if(part != NULL)
+	{
+		error = 1;
+		reset_previewprefetch();
+		return;
+	}
+
+	cfg.prefetch_entries = values[0];
+	cfg.prefetch_jobs = values[1];
+	cfg.preview_cache_size = values[2];
+	qvc_set_limits(cfg.prefetch_jobs, cfg.preview_cache_size);
+
+	/* Normalize the value. */
+	reset_previewprefetch();
+}
+
+/* Resets value of 'previewprefetch' option by composing it from current
+ * configuration. */
+static void
+reset_previewprefetch(void)
+{
+	optval_t val;
+	val.str_val = format_previewprefetch();
+	set_option("previewprefetch", val, OPT_GLOBAL);
+}
+
+/* Formats value of 'previewprefetch' option from configuration.  Returns
+ * pointer to a statically allocated buffer. */
+static char *
+format_previewprefetch(void)
+{
+	static char buf[64];
+
+	uint64_t memory = cfg.preview_cache_size;
+	char suffix[2] = "";
+	const char *s;
+
+	/* Use the largest suffix that represents the size exactly. */
+	for(s = "KMG"; *s != '\0' && memory != 0U && memory%1024U == 0U; ++s)
+	{
+		memory /= 1024U;
+		suffix[0] = *s;
+	}
+
+	snprintf(buf, sizeof(buf), "entries:%d,jobs:%d,memory:%" PRINTF_ULL "%s",
+			cfg.prefetch_entries, cfg.prefetch_jobs, (unsigned long long)memory,
+			suffix);
+	return buf;
+}
+#endif
+
 static void
 scroll_line_down(FileView *view)
 {
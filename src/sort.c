@@ -19,15 +19,19 @@
 
 #include "sort.h"
 
+#include <pthread.h> /* pthread_create() pthread_join() pthread_t */
 #include <regex.h> /* regex_t regcomp() regexec() regfree() */
+#include <unistd.h> /* _SC_NPROCESSORS_ONLN sysconf() */
 
 #include <assert.h> /* assert() */
 #include <ctype.h>
-#include <stdlib.h> /* abs() qsort() */
-#include <string.h> /* strcmp() strrchr() */
+#include <stddef.h> /* size_t */
+#include <stdlib.h> /* abs() free() realloc() */
+#include <string.h> /* memcmp() memcpy() strcmp() strlen() strrchr() */
 
 #include "cfg/config.h"
 #include "compat/fs_limits.h"
+#include "compat/reallocarray.h"
 #include "ui/ui.h"
 #include "utils/fsdata.h"
 #include "utils/path.h"
@@ -40,19 +44,107 @@
 #include "status.h"
 #include "types.h"
 
-/* View which is being sorted. */
-static FileView* view;
-/* Whether the view displays custom file list. */
-static int custom_view;
-static int sort_descending;
-/* Key used to sort entries in current sorting round. */
-static SortingKey sort_type;
-/* Sorting key specific data. */
-static void *sort_data;
-
-static void sort_by_groups(void);
-static void sort_by_key(char key, void *data);
-static int sort_dir_list(const void *one, const void *two);
+/* Lists of at least this size are sorted by several threads. */
+#define PARALLEL_SORT_THRESHOLD (16*1024)
+
+/* Maximum number of threads sorting single list. */
+#define MAX_SORT_WORKERS 8
+
+/* Lists of at most this size are sorted by insertion. */
+#define INSERTION_SORT_THRESHOLD 16
+
+/* Precomputed data of an entry for comparing names.  Offsets point into
+ * collation buffer. */
+typedef struct
+{
+	size_t str; /* Offset of compared string or NO_OFFSET to use entry name. */
+	size_t key; /* Offset of collation key or NO_OFFSET if there is none. */
+	size_t len; /* Length of collation key. */
+}
+coll_key_t;
+
+/* Value of coll_key_t fields for missing data. */
+#define NO_OFFSET ((size_t)-1)
+
+/* State of sorting, which is passed to comparison functions.  It's not
+ * modified while entries are being compared, so comparisons can be done from
+ * several threads at the same time. */
+typedef struct
+{
+	FileView *view;       /* View which is being sorted. */
+	int custom_view;      /* Whether the view displays custom file list. */
+	int descending;       /* Whether current sorting round is in reverse. */
+	SortingKey type;      /* Key used to sort entries in current sorting round. */
+	void *data;           /* Sorting key specific data. */
+	coll_key_t *keys;     /* Collation keys of entries indexed by list_num. */
+	char *keys_buf;       /* Storage of strings and keys referenced by keys. */
+	const char *all_keys; /* Keys to compare by at once or NULL. */
+	int nall_keys;        /* Number of elements in all_keys. */
+}
+sort_ctx_t;
+
+/* Part of a list that is sorted by a single thread. */
+typedef struct
+{
+	dir_entry_t **data;     /* Pointers to entries. */
+	dir_entry_t **tmp;      /* Scratch space of the same size. */
+	int count;              /* Number of elements in data and tmp. */
+	const sort_ctx_t *ctx;  /* Sorting state. */
+}
+sort_part_t;
+
+/* Two adjacent sorted parts of a list that are merged by a single thread. */
+typedef struct
+{
+	dir_entry_t **src;      /* Pointers to entries of both parts. */
+	dir_entry_t **dst;      /* Where merged sequence is stored. */
+	int left;               /* Number of elements in the first part. */
+	int count;              /* Number of elements in both parts. */
+	const sort_ctx_t *ctx;  /* Sorting state. */
+}
+merge_part_t;
+
+/* Whether collation keys should be used, can be turned off for testing. */
+static int use_coll_keys = 1;
+/* Number of threads to use for sorting large lists, zero means to pick it
+ * automatically.  Set only by tests. */
+static int forced_workers;
+/* Whether sorting should be done as if there is no memory for pointers.  Set
+ * only by tests. */
+static int forced_in_place;
+
+static void sort_by_groups(sort_ctx_t *ctx);
+static void sort_by_key(sort_ctx_t *ctx, char key, void *data);
+static void apply_permutation(dir_entry_t entries[], dir_entry_t *ptrs[],
+		int count);
+static void heap_sort(dir_entry_t entries[], int count,
+		const sort_ctx_t *ctx);
+static void sift_down(dir_entry_t entries[], int root, int count,
+		const sort_ctx_t *ctx);
+static void parallel_merge_sort(dir_entry_t *data[], dir_entry_t *tmp[],
+		int count, const sort_ctx_t *ctx);
+static int get_sort_workers(void);
+static void run_in_parallel(void * (*func)(void *), void *args, size_t arg_size,
+		int count);
+static void * sort_part(void *arg);
+static void * merge_parts(void *arg);
+static void merge_sort(dir_entry_t *data[], dir_entry_t *tmp[], int count,
+		const sort_ctx_t *ctx);
+static void sort_run(dir_entry_t *src[], dir_entry_t *dst[], int count,
+		const sort_ctx_t *ctx);
+static void merge(dir_entry_t *left[], int nleft, dir_entry_t *right[],
+		int nright, dir_entry_t *out[], const sort_ctx_t *ctx);
+static int build_coll_keys(sort_ctx_t *ctx, int ignore_case);
+static size_t append_coll_data(char **buf, size_t *len, size_t *size,
+		const char data[], size_t data_len);
+static int make_coll_key(const char str[], char key[], size_t key_size);
+static void free_coll_keys(sort_ctx_t *ctx);
+TSTATIC void sort_use_coll_keys(int use);
+TSTATIC void sort_force_workers(int count);
+static int compare_entries(const dir_entry_t *first,
+		const dir_entry_t *second, const sort_ctx_t *ctx);
+static int compare_by_key(const dir_entry_t *first, const dir_entry_t *second,
+		SortingKey type, int descending, const sort_ctx_t *ctx);
 TSTATIC int strnumcmp(const char s[], const char t[]);
 #if !defined(HAVE_STRVERSCMP_FUNC) || !HAVE_STRVERSCMP_FUNC
 static int vercmp(const char s[], const char t[]);
@@ -60,19 +152,22 @@ static int vercmp(const char s[], const char t[]);
 static char * skip_leading_zeros(const char str[]);
 #endif
 static int compare_entry_names(const dir_entry_t *a, const dir_entry_t *b,
-		int ignore_case);
+		int ignore_case, const sort_ctx_t *ctx);
+static int compare_coll_keys(const dir_entry_t *a, const dir_entry_t *b,
+		int ignore_case, const sort_ctx_t *ctx);
 static int compare_full_file_names(const char s[], const char t[],
 		int ignore_case);
 static int compare_file_names(const char s[], const char t[], int ignore_case);
 static int compare_file_sizes(const dir_entry_t *f, int fdir,
 		const dir_entry_t *s, int sdir);
 static int compare_item_count(const dir_entry_t *f, int fdir,
-		const dir_entry_t *s, int sdir);
+		const dir_entry_t *s, int sdir, const sort_ctx_t *ctx);
 static int compare_group(const char f[], const char s[], regex_t *regex);
 
 void
 sort_view(FileView *v)
 {
+	sort_ctx_t ctx = { .view = v };
 	int i;
 
 	if(v->sort[0] > SK_LAST)
@@ -81,13 +176,12 @@ sort_view(FileView *v)
 		return;
 	}
 
-	view = v;
-	custom_view = flist_custom_active(v);
+	ctx.custom_view = flist_custom_active(v);
 
 	i = SK_COUNT;
 	while(--i >= 0)
 	{
-		const char sorting_key = view->sort[i];
+		const char sorting_key = v->sort[i];
 
 		if(abs(sorting_key) > SK_LAST)
 		{
@@ -96,28 +190,150 @@ sort_view(FileView *v)
 
 		if(sorting_key == SK_BY_GROUPS)
 		{
-			sort_by_groups();
+			sort_by_groups(&ctx);
 			continue;
 		}
 
-		sort_by_key(sorting_key, NULL);
+		sort_by_key(&ctx, sorting_key, NULL);
 	}
 
 	if(!ui_view_sort_list_contains(v->sort, SK_BY_DIR))
 	{
-		sort_by_key(SK_BY_DIR, NULL);
+		sort_by_key(&ctx, SK_BY_DIR, NULL);
 	}
 }
 
+int
+sort_merge_into_view(FileView *v, dir_entry_t *sorted[], int nsorted,
+		dir_entry_t *added[], int nadded)
+{
+	sort_ctx_t ctx = { .view = v, .custom_view = flist_custom_active(v) };
+	char keys[SK_COUNT + 1];
+	dir_entry_t **tmp, **out;
+	int i, j, k;
+
+	if(v->sort[0] > SK_LAST)
+	{
+		/* Entries are not sorted at all. */
+		return 1;
+	}
+
+	/* Form list of keys in the order of decreasing significance, which is the
+	 * reverse of the order in which sort_view() sorts by them. */
+	ctx.all_keys = keys;
+	if(!ui_view_sort_list_contains(v->sort, SK_BY_DIR))
+	{
+		keys[ctx.nall_keys++] = SK_BY_DIR;
+	}
+	for(i = 0; i < SK_COUNT; ++i)
+	{
+		const char sorting_key = v->sort[i];
+
+		if(abs(sorting_key) > SK_LAST)
+		{
+			continue;
+		}
+
+		if(sorting_key == SK_BY_GROUPS)
+		{
+			/* Too complicated to support, not worth it. */
+			return 1;
+		}
+
+		keys[ctx.nall_keys++] = sorting_key;
+	}
+
+	/* Entries that compare equal are ordered by their position in a list, which
+	 * isn't preserved here, so bail out if there are any of them.  Entries
+	 * that are expected to be sorted might not be anymore (e.g., if they were
+	 * renamed) and that's checked as well. */
+	for(i = 1; i < nsorted; ++i)
+	{
+		if(compare_entries(sorted[i - 1], sorted[i], &ctx) >= 0)
+		{
+			return 1;
+		}
+	}
+
+	tmp = reallocarray(NULL, MAX(nadded, 1), sizeof(*tmp));
+	out = reallocarray(NULL, nsorted + nadded, sizeof(*out));
+	if(tmp == NULL || out == NULL)
+	{
+		free(tmp);
+		free(out);
+		return 1;
+	}
+
+	merge_sort(added, tmp, nadded, &ctx);
+	free(tmp);
+
+	/* Put every added entry after all sorted entries that are less than it using
+	 * binary search. */
+	j = 0;
+	k = 0;
+	for(i = 0; i < nadded; ++i)
+	{
+		int lo = j, hi = nsorted;
+
+		if(i > 0 && compare_entries(added[i - 1], added[i], &ctx) == 0)
+		{
+			break;
+		}
+
+		while(lo < hi)
+		{
+			const int mid = lo + (hi - lo)/2;
+			const int cmp = compare_entries(sorted[mid], added[i], &ctx);
+			if(cmp == 0)
+			{
+				break;
+			}
+			if(cmp < 0)
+			{
+				lo = mid + 1;
+			}
+			else
+			{
+				hi = mid;
+			}
+		}
+		if(lo < hi)
+		{
+			break;
+		}
+
+		while(j < lo)
+		{
+			out[k++] = sorted[j++];
+		}
+		out[k++] = added[i];
+	}
+
+	if(i != nadded)
+	{
+		free(out);
+		return 1;
+	}
+
+	while(j < nsorted)
+	{
+		out[k++] = sorted[j++];
+	}
+
+	apply_permutation(v->dir_entry, out, k);
+	free(out);
+	return 0;
+}
+
 /* Sorts view according to sorting groups option. */
 static void
-sort_by_groups(void)
+sort_by_groups(sort_ctx_t *ctx)
 {
 	char **groups = NULL;
 	int ngroups = 0;
 	int i;
 
-	char *const copy = strdup(view->sort_groups);
+	char *const copy = strdup(ctx->view->sort_groups);
 	char *group = copy, *state = NULL;
 	while((group = split_and_get(group, ',', &state)) != NULL)
 	{
@@ -129,12 +345,12 @@ sort_by_groups(void)
 	{
 		regex_t regex;
 		(void)regcomp(&regex, groups[i], REG_EXTENDED | REG_ICASE);
-		sort_by_key(SK_BY_GROUPS, &regex);
+		sort_by_key(ctx, SK_BY_GROUPS, &regex);
 		regfree(&regex);
 	}
 	if(ngroups != 0)
 	{
-		sort_by_key(SK_BY_GROUPS, &view->primary_group);
+		sort_by_key(ctx, SK_BY_GROUPS, &ctx->view->primary_group);
 	}
 
 	free_string_array(groups, ngroups);
@@ -142,25 +358,575 @@ sort_by_groups(void)
 
 /* Sorts view by the key in a stable way. */
 static void
-sort_by_key(char key, void *data)
+sort_by_key(sort_ctx_t *ctx, char key, void *data)
 {
+	FileView *const view = ctx->view;
 	int j;
+	dir_entry_t **ptrs;
+	dir_entry_t **tmp;
+
+	ctx->descending = (key < 0);
+	ctx->type = (SortingKey)abs(key);
+	ctx->data = data;
 
-	sort_descending = (key < 0);
-	sort_type = (SortingKey)abs(key);
-	sort_data = data;
+	if(view->list_rows == 0)
+	{
+		return;
+	}
 
 	for(j = 0; j < view->list_rows; ++j)
 	{
 		view->dir_entry[j].list_num = j;
 	}
 
-	if(view->list_rows != 0)
+	ptrs = reallocarray(NULL, view->list_rows, sizeof(*ptrs));
+	tmp = reallocarray(NULL, view->list_rows, sizeof(*tmp));
+	if(ptrs == NULL || tmp == NULL || forced_in_place)
+	{
+		/* Not enough memory for pointers, sort entries themselves.  This is
+		 * slower, but needs no extra memory and is still stable, because ties are
+		 * broken by list_num. */
+		free(ptrs);
+		free(tmp);
+
+		heap_sort(view->dir_entry, view->list_rows, ctx);
+		return;
+	}
+
+	/* Parsing and case folding of names is too expensive to be done on every
+	 * comparison, so do it once per entry.  On failure names are compared
+	 * directly. */
+	if(use_coll_keys && (ctx->type == SK_BY_NAME || ctx->type == SK_BY_INAME))
 	{
-		qsort(view->dir_entry, view->list_rows, sizeof(dir_entry_t), sort_dir_list);
+		(void)build_coll_keys(ctx, ctx->type == SK_BY_INAME);
+	}
+
+	/* Entries are big and each of them would be moved many times while
+	 * sorting, so sort pointers and move every entry only once afterwards. */
+	for(j = 0; j < view->list_rows; ++j)
+	{
+		ptrs[j] = &view->dir_entry[j];
+	}
+	if(view->list_rows >= PARALLEL_SORT_THRESHOLD)
+	{
+		parallel_merge_sort(ptrs, tmp, view->list_rows, ctx);
+	}
+	else
+	{
+		merge_sort(ptrs, tmp, view->list_rows, ctx);
+	}
+	apply_permutation(view->dir_entry, ptrs, view->list_rows);
+
+	free(tmp);
+	free(ptrs);
+	free_coll_keys(ctx);
+}
+
+/* Reorders entries in place so that i-th of them is the one *ptrs[i] pointed
+ * to.  Contents of ptrs array is destroyed. */
+static void
+apply_permutation(dir_entry_t entries[], dir_entry_t *ptrs[], int count)
+{
+	int i;
+	for(i = 0; i < count; ++i)
+	{
+		dir_entry_t tmp;
+		int j;
+
+		if(ptrs[i] == &entries[i])
+		{
+			continue;
+		}
+
+		/* Rotate elements of the cycle that starts at i and mark each of them as
+		 * being in place. */
+		tmp = entries[i];
+		j = i;
+		while(ptrs[j] != &entries[i])
+		{
+			const int next = ptrs[j] - entries;
+			entries[j] = entries[next];
+			ptrs[j] = &entries[j];
+			j = next;
+		}
+		entries[j] = tmp;
+		ptrs[j] = &entries[j];
+	}
+}
+
+/* Sorts entries in place without allocating memory.  The sort isn't stable by
+ * itself, but compare_entries() breaks ties by list_num. */
+static void
+heap_sort(dir_entry_t entries[], int count, const sort_ctx_t *ctx)
+{
+	int i;
+
+	for(i = count/2 - 1; i >= 0; --i)
+	{
+		sift_down(entries, i, count, ctx);
+	}
+
+	for(i = count - 1; i > 0; --i)
+	{
+		const dir_entry_t tmp = entries[0];
+		entries[0] = entries[i];
+		entries[i] = tmp;
+		sift_down(entries, 0, i, ctx);
+	}
+}
+
+/* Restores max-heap property of the subtree rooted at the root element of the
+ * first count entries. */
+static void
+sift_down(dir_entry_t entries[], int root, int count, const sort_ctx_t *ctx)
+{
+	while(root*2 + 1 < count)
+	{
+		dir_entry_t tmp;
+		int child = root*2 + 1;
+		if(child + 1 < count &&
+				compare_entries(&entries[child], &entries[child + 1], ctx) < 0)
+		{
+			++child;
+		}
+
+		if(compare_entries(&entries[root], &entries[child], ctx) >= 0)
+		{
+			break;
+		}
+
+		tmp = entries[root];
+		entries[root] = entries[child];
+		entries[child] = tmp;
+		root = child;
 	}
 }
 
+/* Sorts array of pointers to entries in a stable way by sorting its parts in
+ * several threads and then merging them (also in parallel while there are
+ * several pairs to merge).  tmp is a scratch space of the same size. */
+static void
+parallel_merge_sort(dir_entry_t *data[], dir_entry_t *tmp[], int count,
+		const sort_ctx_t *ctx)
+{
+	sort_part_t parts[MAX_SORT_WORKERS];
+	merge_part_t merges[MAX_SORT_WORKERS/2];
+	int bounds[MAX_SORT_WORKERS + 1];
+	dir_entry_t **src = data, **dst = tmp;
+	const int nparts = get_sort_workers();
+	int width;
+	int i;
+
+	for(i = 0; i <= nparts; ++i)
+	{
+		bounds[i] = (int)((long long)count*i/nparts);
+	}
+
+	for(i = 0; i < nparts; ++i)
+	{
+		parts[i].data = &data[bounds[i]];
+		parts[i].tmp = &tmp[bounds[i]];
+		parts[i].count = bounds[i + 1] - bounds[i];
+		parts[i].ctx = ctx;
+	}
+	run_in_parallel(&sort_part, parts, sizeof(parts[0]), nparts);
+
+	/* Number of parts is a power of two, so they can be merged pairwise. */
+	for(width = 1; width < nparts; width *= 2)
+	{
+		dir_entry_t **t;
+		int nmerges = 0;
+
+		for(i = 0; i < nparts; i += 2*width)
+		{
+			merge_part_t *const merge = &merges[nmerges++];
+			merge->src = &src[bounds[i]];
+			merge->dst = &dst[bounds[i]];
+			merge->left = bounds[i + width] - bounds[i];
+			merge->count = bounds[i + 2*width] - bounds[i];
+			merge->ctx = ctx;
+		}
+		run_in_parallel(&merge_parts, merges, sizeof(merges[0]), nmerges);
+
+		t = src;
+		src = dst;
+		dst = t;
+	}
+
+	if(src != data)
+	{
+		memcpy(data, src, sizeof(*data)*count);
+	}
+}
+
+/* Retrieves number of threads to use for sorting.  Returns power of two. */
+static int
+get_sort_workers(void)
+{
+	int nworkers = 1;
+#ifdef _SC_NPROCESSORS_ONLN
+	const long ncpus = (forced_workers != 0) ? forced_workers
+	                                         : sysconf(_SC_NPROCESSORS_ONLN);
+#else
+	const long ncpus = (forced_workers != 0) ? forced_workers : 2;
+#endif
+
+	while(nworkers*2 <= MIN(ncpus, MAX_SORT_WORKERS))
+	{
+		nworkers *= 2;
+	}
+	return nworkers;
+}
+
+/* Calls the func for each of count arguments of arg_size size stored in args
+ * array at the same time in separate threads.  The current thread is one of
+ * them, if a thread can't be created, the current one does its job too. */
+static void
+run_in_parallel(void * (*func)(void *), void *args, size_t arg_size, int count)
+{
+	pthread_t threads[MAX_SORT_WORKERS];
+	int started[MAX_SORT_WORKERS];
+	int i;
+
+	for(i = 1; i < count; ++i)
+	{
+		started[i] =
+			(pthread_create(&threads[i], NULL, func, (char *)args + i*arg_size) == 0);
+	}
+
+	(void)func(args);
+
+	for(i = 1; i < count; ++i)
+	{
+		if(started[i])
+		{
+			(void)pthread_join(threads[i], NULL);
+		}
+		else
+		{
+			(void)func((char *)args + i*arg_size);
+		}
+	}
+}
+
+/* Thread entry point that sorts one part of a list.  Returns NULL. */
+static void *
+sort_part(void *arg)
+{
+	sort_part_t *const part = arg;
+	merge_sort(part->data, part->tmp, part->count, part->ctx);
+	return NULL;
+}
+
+/* Thread entry point that merges two adjacent sorted parts of a list.  Returns
+ * NULL. */
+static void *
+merge_parts(void *arg)
+{
+	merge_part_t *const part = arg;
+	merge(part->src, part->left, part->src + part->left,
+			part->count - part->left, part->dst, part->ctx);
+	return NULL;
+}
+
+/* Sorts array of pointers to entries in a stable way.  tmp is a scratch space
+ * of the same size. */
+static void
+merge_sort(dir_entry_t *data[], dir_entry_t *tmp[], int count,
+		const sort_ctx_t *ctx)
+{
+	memcpy(tmp, data, sizeof(*data)*count);
+	sort_run(tmp, data, count, ctx);
+}
+
+/* Sorts elements into dst using src as a scratch space.  Both arrays must
+ * initially contain the same elements, this way results of sorting halves in
+ * one of them can be merged into the other one without extra copying. */
+static void
+sort_run(dir_entry_t *src[], dir_entry_t *dst[], int count,
+		const sort_ctx_t *ctx)
+{
+	int mid;
+
+	if(count <= INSERTION_SORT_THRESHOLD)
+	{
+		int i;
+		for(i = 1; i < count; ++i)
+		{
+			dir_entry_t *const entry = dst[i];
+			int j = i;
+			while(j > 0 && compare_entries(dst[j - 1], entry, ctx) > 0)
+			{
+				dst[j] = dst[j - 1];
+				--j;
+			}
+			dst[j] = entry;
+		}
+		return;
+	}
+
+	mid = count/2;
+	sort_run(dst, src, mid, ctx);
+	sort_run(dst + mid, src + mid, count - mid, ctx);
+	merge(src, mid, src + mid, count - mid, dst, ctx);
+}
+
+/* Merges two sorted arrays into out, which shouldn't overlap with them.  On
+ * ties elements of the left array go first. */
+static void
+merge(dir_entry_t *left[], int nleft, dir_entry_t *right[], int nright,
+		dir_entry_t *out[], const sort_ctx_t *ctx)
+{
+	int l = 0, r = 0;
+
+	while(l < nleft && r < nright)
+	{
+		if(compare_entries(left[l], right[r], ctx) <= 0)
+		{
+			*out++ = left[l++];
+		}
+		else
+		{
+			*out++ = right[r++];
+		}
+	}
+
+	memcpy(out, &left[l], sizeof(*out)*(nleft - l));
+	memcpy(out + (nleft - l), &right[r], sizeof(*out)*(nright - r));
+}
+
+/* Fills keys and keys_buf fields of the context for entries of the view.
+ * Returns zero on success, otherwise non-zero is returned and nothing is
+ * allocated. */
+static int
+build_coll_keys(sort_ctx_t *ctx, int ignore_case)
+{
+	const FileView *const view = ctx->view;
+	size_t len = 0U, size = 0U;
+	char *buf = NULL;
+	coll_key_t *coll_keys;
+	int i;
+
+	coll_keys = reallocarray(NULL, view->list_rows, sizeof(*coll_keys));
+	if(coll_keys == NULL)
+	{
+		return 1;
+	}
+
+	for(i = 0; i < view->list_rows; ++i)
+	{
+		const dir_entry_t *const entry = &view->dir_entry[i];
+		coll_key_t *const coll_key = &coll_keys[i];
+		const char *str = entry->name;
+		char short_path[PATH_MAX];
+		char folded[NAME_MAX];
+		char key[3*NAME_MAX];
+		int key_len;
+
+		coll_key->str = NO_OFFSET;
+		if(ctx->custom_view)
+		{
+			get_short_path_of(view, entry, 0, sizeof(short_path), short_path);
+			str = short_path;
+			coll_key->str = append_coll_data(&buf, &len, &size, str,
+					strlen(str) + 1U);
+			if(coll_key->str == NO_OFFSET)
+			{
+				break;
+			}
+		}
+
+		if(ignore_case)
+		{
+			/* Same as in compare_file_names(). */
+			(void)str_to_lower(str, folded, sizeof(folded));
+			str = folded;
+		}
+
+		coll_key->key = NO_OFFSET;
+		coll_key->len = 0U;
+		key_len = make_coll_key(str, key, sizeof(key));
+		if(key_len >= 0)
+		{
+			coll_key->key = append_coll_data(&buf, &len, &size, key, key_len);
+			coll_key->len = key_len;
+			if(coll_key->key == NO_OFFSET)
+			{
+				break;
+			}
+		}
+	}
+
+	if(i != view->list_rows)
+	{
+		free(buf);
+		free(coll_keys);
+		return 1;
+	}
+
+	ctx->keys = coll_keys;
+	ctx->keys_buf = buf;
+	return 0;
+}
+
+/* Appends data to dynamically growing buffer.  Returns offset of the data in
+ * the buffer or NO_OFFSET on memory allocation error. */
+static size_t
+append_coll_data(char **buf, size_t *len, size_t *size, const char data[],
+		size_t data_len)
+{
+	const size_t offset = *len;
+
+	if(*size - *len < data_len)
+	{
+		const size_t new_size = MAX(*size*2U, *len + data_len + 4096U);
+		char *const new_buf = realloc(*buf, new_size);
+		if(new_buf == NULL)
+		{
+			return NO_OFFSET;
+		}
+		*buf = new_buf;
+		*size = new_size;
+	}
+
+	memcpy(*buf + offset, data, data_len);
+	*len += data_len;
+	return offset;
+}
+
+/* Makes collation key that compares with memcmp() exactly like the string
+ * compares with strnumcmp() or strcmp() depending on 'sortnumbers' option.
+ * Numbers are replaced with a digit followed by length of the number and its
+ * digits, which orders them numerically among themselves and as digits
+ * relative to other characters.  Returns length of the key or -1 if the string
+ * has parts for which such key can't be built. */
+static int
+make_coll_key(const char str[], char key[], size_t key_size)
+{
+	size_t len = 0U;
+
+	if(!cfg.sort_numbers)
+	{
+		const size_t str_len = strlen(str);
+		if(str_len > key_size)
+		{
+			return -1;
+		}
+		memcpy(key, str, str_len);
+		return str_len;
+	}
+
+#if defined(HAVE_STRVERSCMP_FUNC) && HAVE_STRVERSCMP_FUNC
+	str = skip_leading_zeros(str);
+#endif
+
+	while(*str != '\0')
+	{
+		if(*str >= '0' && *str <= '9')
+		{
+			size_t n = 1U;
+			while(str[n] >= '0' && str[n] <= '9')
+			{
+				++n;
+			}
+
+#if defined(HAVE_STRVERSCMP_FUNC) && HAVE_STRVERSCMP_FUNC
+			/* strverscmp() treats numbers with leading zeroes as fractional parts,
+			 * which are less than integers and compare smaller the more leading
+			 * zeroes they have.  Among those with the same number of zeroes the ones
+			 * that consist only of zeroes are the greatest, the rest compare like
+			 * regular strings. */
+			if(str[0] == '0')
+			{
+				size_t zeroes = 1U;
+				while(str[zeroes] == '0')
+				{
+					++zeroes;
+				}
+				if(zeroes > 255U || key_size - len < 3U + (n - zeroes))
+				{
+					return -1;
+				}
+				key[len++] = '0';
+				key[len++] = (char)(255U - zeroes);
+				key[len++] = (zeroes == n);
+				memcpy(&key[len], str + zeroes, n - zeroes);
+				len += n - zeroes;
+				str += n;
+				continue;
+			}
+#else
+			/* vercmp() parses numbers into an int and has its own way of handling
+			 * leading zeroes. */
+			if(str[0] == '0' || n > 9U)
+			{
+				return -1;
+			}
+#endif
+
+			if(key_size - len < 3U + n)
+			{
+				return -1;
+			}
+			key[len++] = '1';
+			key[len++] = (char)(n >> 8);
+			key[len++] = (char)(n & 0xff);
+			memcpy(&key[len], str, n);
+			len += n;
+			str += n;
+			continue;
+		}
+
+#if !defined(HAVE_STRVERSCMP_FUNC) || !HAVE_STRVERSCMP_FUNC
+		/* vercmp() compares characters as signed ones. */
+		if((unsigned char)*str >= 0x80)
+		{
+			return -1;
+		}
+#endif
+
+		if(len == key_size)
+		{
+			return -1;
+		}
+		key[len++] = *str++;
+	}
+
+	return len;
+}
+
+/* Frees collation keys if they were built. */
+static void
+free_coll_keys(sort_ctx_t *ctx)
+{
+	free(ctx->keys);
+	ctx->keys = NULL;
+	free(ctx->keys_buf);
+	ctx->keys_buf = NULL;
+}
+
+/* Enables or disables use of collation keys. */
+TSTATIC void
+sort_use_coll_keys(int use)
+{
+	use_coll_keys = use;
+}
+
+/* Sets number of threads used to sort large lists, zero restores default. */
+TSTATIC void
+sort_force_workers(int count)
+{
+	forced_workers = count;
+}
+
+/* Makes sorting fall back to sorting entries in place as if memory for
+ * pointers couldn't be allocated. */
+TSTATIC void
+sort_force_in_place(int in_place)
+{
+	forced_in_place = in_place;
+}
+
 /* Compares file names containing numbers correctly. */
 TSTATIC int
 strnumcmp(const char s[], const char t[])
@@ -222,15 +988,46 @@ skip_leading_zeros(const char str[])
 }
 #endif
 
+/* Compares two entries according to current sorting round or by all keys at
+ * once if they are set in the context.  In the former case equal entries are
+ * ordered by their position before sorting.  Returns standard -1, 0, 1 for
+ * comparisons. */
+static int
+compare_entries(const dir_entry_t *first, const dir_entry_t *second,
+		const sort_ctx_t *ctx)
+{
+	int retval;
+
+	if(ctx->nall_keys != 0)
+	{
+		int i;
+		for(i = 0; i < ctx->nall_keys; ++i)
+		{
+			const char key = ctx->all_keys[i];
+			retval = compare_by_key(first, second, (SortingKey)abs(key), key < 0,
+					ctx);
+			if(retval != 0)
+			{
+				break;
+			}
+		}
+		return retval;
+	}
+
+	retval = compare_by_key(first, second, ctx->type, ctx->descending, ctx);
+	return (retval == 0) ? first->list_num - second->list_num : retval;
+}
+
+/* Compares two entries by a single key.  Returns standard -1, 0, 1 for
+ * comparisons. */
 static int
-sort_dir_list(const void *one, const void *two)
+compare_by_key(const dir_entry_t *first, const dir_entry_t *second,
+		SortingKey type, int descending, const sort_ctx_t *ctx)
 {
-	/* TODO: refactor this function sort_dir_list(). */
+	/* TODO: refactor this function compare_by_key(). */
 
 	int retval;
 	char *pfirst, *psecond;
-	const dir_entry_t *const first = (dir_entry_t *)one;
-	const dir_entry_t *const second = (dir_entry_t *)two;
 	int first_is_dir;
 	int second_is_dir;
 
@@ -247,18 +1044,22 @@ sort_dir_list(const void *one, const void *two)
 	second_is_dir = is_directory_entry(second);
 
 	retval = 0;
-	switch(sort_type)
+	switch(type)
 	{
 		case SK_BY_NAME:
 		case SK_BY_INAME:
-			if(custom_view)
+			if(ctx->keys != NULL)
 			{
-				retval = compare_entry_names(first, second, sort_type == SK_BY_INAME);
+				retval = compare_coll_keys(first, second, type == SK_BY_INAME, ctx);
+			}
+			else if(ctx->custom_view)
+			{
+				retval = compare_entry_names(first, second, type == SK_BY_INAME, ctx);
 			}
 			else
 			{
 				retval = compare_full_file_names(first->name, second->name,
-						sort_type == SK_BY_INAME);
+						type == SK_BY_INAME);
 			}
 			break;
 
@@ -278,11 +1079,11 @@ sort_dir_list(const void *one, const void *two)
 			pfirst = strrchr(first->name,  '.');
 			psecond = strrchr(second->name, '.');
 
-			if(first_is_dir && second_is_dir && sort_type == SK_BY_FILEEXT)
+			if(first_is_dir && second_is_dir && type == SK_BY_FILEEXT)
 			{
 				retval = compare_file_names(first->name, second->name, 0);
 			}
-			else if(first_is_dir != second_is_dir && sort_type == SK_BY_FILEEXT)
+			else if(first_is_dir != second_is_dir && type == SK_BY_FILEEXT)
 			{
 				retval = first_is_dir ? -1 : 1;
 			}
@@ -312,11 +1113,12 @@ sort_dir_list(const void *one, const void *two)
 			break;
 
 		case SK_BY_NITEMS:
-			retval = compare_item_count(first, first_is_dir, second, second_is_dir);
+			retval = compare_item_count(first, first_is_dir, second, second_is_dir,
+					ctx);
 			break;
 
 		case SK_BY_GROUPS:
-			retval = compare_group(first->name, second->name, sort_data);
+			retval = compare_group(first->name, second->name, ctx->data);
 			break;
 
 		case SK_BY_TIME_MODIFIED:
@@ -361,16 +1163,7 @@ sort_dir_list(const void *one, const void *two)
 #endif
 	}
 
-	if(retval == 0)
-	{
-		retval = first->list_num - second->list_num;
-	}
-	else if(sort_descending)
-	{
-		retval = -retval;
-	}
-
-	return retval;
+	return descending ? -retval : retval;
 }
 
 /* Compares two file sizes.  Returns standard -1, 0, 1 for comparisons. */
@@ -408,13 +1201,13 @@ compare_file_sizes(const dir_entry_t *f, int fdir, const dir_entry_t *s,
  * Returns standard -1, 0, 1 for comparisons. */
 static int
 compare_item_count(const dir_entry_t *f, int fdir, const dir_entry_t *s,
-		int sdir)
+		int sdir, const sort_ctx_t *ctx)
 {
 	/* We don't want to call entry_get_nitems() for files as sorting huge lists
 	 * of files can call this function a lot of times, thus even small extra
 	 * performance overhead is not desirable. */
-	const uint64_t fsize = fdir ? entry_get_nitems(view, f) : 0U;
-	const uint64_t ssize = sdir ? entry_get_nitems(view, s) : 0U;
+	const uint64_t fsize = fdir ? entry_get_nitems(ctx->view, f) : 0U;
+	const uint64_t ssize = sdir ? entry_get_nitems(ctx->view, s) : 0U;
 	return (fsize > ssize) ? 1 : (fsize < ssize) ? -1 : 0;
 }
 
@@ -438,17 +1231,62 @@ compare_group(const char f[], const char s[], regex_t *regex)
 /* Compares names of two file entries.  Returns positive value if a is greater
  * than b, zero if they are equal, otherwise negative value is returned. */
 static int
-compare_entry_names(const dir_entry_t *a, const dir_entry_t *b, int ignore_case)
+compare_entry_names(const dir_entry_t *a, const dir_entry_t *b, int ignore_case,
+		const sort_ctx_t *ctx)
 {
 	char a_short_path[PATH_MAX];
 	char b_short_path[PATH_MAX];
 
-	get_short_path_of(view, a, 0, sizeof(a_short_path), a_short_path);
-	get_short_path_of(view, b, 0, sizeof(b_short_path), b_short_path);
+	get_short_path_of(ctx->view, a, 0, sizeof(a_short_path), a_short_path);
+	get_short_path_of(ctx->view, b, 0, sizeof(b_short_path), b_short_path);
 
 	return compare_full_file_names(a_short_path, b_short_path, ignore_case);
 }
 
+/* Compares names of two file entries using their collation keys, which must be
+ * available.  Returns positive value if a is greater than b, zero if they are
+ * equal, otherwise negative value is returned. */
+static int
+compare_coll_keys(const dir_entry_t *a, const dir_entry_t *b, int ignore_case,
+		const sort_ctx_t *ctx)
+{
+	const coll_key_t *const a_key = &ctx->keys[a->list_num];
+	const coll_key_t *const b_key = &ctx->keys[b->list_num];
+	const char *const s = (a_key->str == NO_OFFSET) ? a->name
+	                                                : &ctx->keys_buf[a_key->str];
+	const char *const t = (b_key->str == NO_OFFSET) ? b->name
+	                                                : &ctx->keys_buf[b_key->str];
+	int result;
+
+	if(a_key->key == NO_OFFSET || b_key->key == NO_OFFSET)
+	{
+		return compare_full_file_names(s, t, ignore_case);
+	}
+
+	/* Same as in compare_full_file_names(). */
+	if(s[0] == '.' && t[0] != '.')
+	{
+		return -1;
+	}
+	else if(s[0] != '.' && t[0] == '.')
+	{
+		return 1;
+	}
+
+	result = memcmp(&ctx->keys_buf[a_key->key], &ctx->keys_buf[b_key->key],
+			MIN(a_key->len, b_key->len));
+	if(result == 0)
+	{
+		result = (a_key->len > b_key->len) - (a_key->len < b_key->len);
+	}
+	if(result == 0 && ignore_case)
+	{
+		/* Same as in compare_file_names(). */
+		result = strcmp(s, t);
+	}
+	return result;
+}
+
 /* Compares two full filenames and assumes that dot character is smaller than
  * any other character.  Returns positive value if s is greater than t, zero if
  * they are equal, otherwise negative value is returned. */
@@ -25,12 +25,29 @@
 
 void sort_view(FileView *view);
 
+/* Reorders entries of the view by merging two lists of pointers to them, which
+ * together must cover all entries: the sorted array, which should be in order
+ * already, and the added one, which needs sorting.  Fails if the sorted
+ * entries are out of order, if some entries compare equal or if the view is
+ * sorted in a way which isn't supported.  Arrays can be modified.  Returns
+ * zero on success, otherwise non-zero is returned and order of entries of the
+ * view is left unchanged. */
+int sort_merge_into_view(FileView *view, dir_entry_t *sorted[], int nsorted,
+		dir_entry_t *added[], int nadded);
+
 /* Maps primary sort key to second column type.  Returns secondary key that
  * corresponds to the primary one. */
 SortingKey get_secondary_key(SortingKey primary_key);
 
 TSTATIC_DEFS(
 	int strnumcmp(const char s[], const char t[]);
+	/* Enables or disables use of precomputed keys to sort entries by name. */
+	void sort_use_coll_keys(int use);
+	/* Sets number of threads used to sort large lists, zero restores default. */
+	void sort_force_workers(int count);
+	/* Makes sorting fall back to sorting entries in place as if memory for
+	 * pointers couldn't be allocated. */
+	void sort_force_in_place(int in_place);
 )
 
 #endif /* VIFM__SORT_H__ */
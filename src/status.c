@@ -75,9 +75,9 @@ static int pending_redraw;
 static int inside_screen;
 static int inside_tmux;
 
-/* Thread-safety guard for dcache_size variable. */
+/* Serializes modifications of dcache_size variable, reading doesn't lock. */
 static pthread_mutex_t dcache_size_mutex = PTHREAD_MUTEX_INITIALIZER;
-/* Thread-safety guard for dcache_nitems variable. */
+/* Serializes modifications of dcache_nitems variable, reading doesn't lock. */
 static pthread_mutex_t dcache_nitems_mutex = PTHREAD_MUTEX_INITIALIZER;
 /* Cache for directory sizes. */
 static fsdata_t *dcache_size;
@@ -359,7 +359,6 @@ dcache_get(const char path[], uint64_t *size, uint64_t *nitems, time_t ts)
 	dcache_data_t size_data = { .timestamp = ts };
 	dcache_data_t nitems_data;
 
-	pthread_mutex_lock(&dcache_size_mutex);
 	if(fsdata_get(dcache_size, path, &size_data, sizeof(size_data)) != 0 ||
 			(ts != 0 && ts > size_data.timestamp))
 	{
@@ -367,18 +366,17 @@ dcache_get(const char path[], uint64_t *size, uint64_t *nitems, time_t ts)
 
 		if(ts != 0 && ts > size_data.timestamp)
 		{
+			pthread_mutex_lock(&dcache_size_mutex);
 			fsdata_invalidate(dcache_size, path);
+			pthread_mutex_unlock(&dcache_size_mutex);
 		}
 	}
-	pthread_mutex_unlock(&dcache_size_mutex);
 
-	pthread_mutex_lock(&dcache_nitems_mutex);
 	if(fsdata_get(dcache_nitems, path, &nitems_data, sizeof(nitems_data)) != 0 ||
 			(ts != 0 && ts > nitems_data.timestamp))
 	{
 		nitems_data.value = DCACHE_UNKNOWN;
 	}
-	pthread_mutex_unlock(&dcache_nitems_mutex);
 
 	if(size != NULL)
 	{
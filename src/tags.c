@@ -62,6 +62,7 @@ const char *tags[] = {
 	"vifm-'ignorecase'",
 	"vifm-'incsearch'",
 	"vifm-'iooptions'",
+	"vifm-'ioworkers'",
 	"vifm-'is'",
 	"vifm-'laststatus'",
 	"vifm-'lines'",
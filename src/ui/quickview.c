@@ -24,14 +24,15 @@
 
 #include <limits.h> /* INT_MAX */
 #include <stddef.h> /* NULL size_t */
-#include <stdio.h> /* FILE SEEK_SET fclose() fdopen() feof() fseek()
-                      tmpfile() */
+#include <stdio.h> /* FILE SEEK_SET fclose() fdopen() feof() fseek() fwrite()
+                      rewind() tmpfile() */
 #include <stdlib.h> /* free() qsort() */
-#include <string.h> /* memmove() strcat() strlen() strncat() */
+#include <string.h> /* memmove() strcat() strdup() strlen() strncat() */
 
 #include "../cfg/config.h"
 #include "../compat/fs_limits.h"
 #include "../compat/os.h"
+#include "../compat/reallocarray.h"
 #include "../engine/mode.h"
 #include "../modes/dialogs/msg_dialog.h"
 #include "../modes/modes.h"
@@ -54,6 +55,7 @@
 #include "colors.h"
 #include "escape.h"
 #include "fileview.h"
+#include "qv_cache.h"
 #include "ui.h"
 
 /* Size of buffer holding preview line (in characters). */
@@ -72,6 +74,11 @@ typedef struct
 tree_print_state_t;
 
 static void view_file(const char path[]);
+static FILE * get_viewer_output(const char path[], const char viewer[],
+		int *loading);
+static void prefetch_neighbours(FileView *view);
+static int make_prefetch_item(FileView *view, int pos, char **path,
+		const char **viewer, char **cmd);
 static FILE * view_dir(const char path[], int max_lines);
 static int print_dir_tree(tree_print_state_t *s, const char path[], int last);
 static int enter_dir(tree_print_state_t *s, const char path[], int last);
@@ -115,6 +122,10 @@ toggle_quick_view(void)
 
 		update_string(&curr_stats.preview_cleanup, NULL);
 		curr_stats.graphics_preview = 0;
+
+#ifndef _WIN32
+		qvc_cancel();
+#endif
 	}
 	else
 	{
@@ -175,6 +186,8 @@ quick_view_file(FileView *view)
 	refresh_view_win(other_view);
 
 	ui_view_title_update(other_view);
+
+	prefetch_neighbours(view);
 }
 
 /* Displays contents of file or output of its viewer in the other pane
@@ -183,6 +196,7 @@ static void
 view_file(const char path[])
 {
 	int graphics = 0;
+	int loading = 0;
 	const char *viewer;
 	const char *clean_cmd;
 	FILE *fp;
@@ -217,10 +231,13 @@ view_file(const char path[])
 			qv_cleanup(other_view, curr_stats.preview_cleanup);
 			usleep(50000);
 		}
-		fp = use_info_prog(viewer);
+		fp = graphics
+		   ? use_info_prog(viewer)
+		   : get_viewer_output(path, viewer, &loading);
 		if(fp == NULL)
 		{
-			write_message("Cannot read viewer output");
+			write_message(loading ? "Loading preview..."
+			                      : "Cannot read viewer output");
 			return;
 		}
 	}
@@ -241,6 +258,180 @@ view_file(const char path[])
 	fclose(fp);
 }
 
+/* Retrieves output of a text viewer.  Viewers are run in background and their
+ * output is cached, *loading is set if preview isn't available yet.  Returns
+ * the stream or NULL on error. */
+static FILE *
+get_viewer_output(const char path[], const char viewer[], int *loading)
+{
+#ifndef _WIN32
+	const qvc_key_t key = {
+		.path = path,
+		.viewer = viewer,
+		.width = ui_qv_width(other_view),
+		.height = ui_qv_height(other_view),
+	};
+	char *data;
+	size_t len;
+	FILE *fp;
+	char *cmd;
+
+	switch(qvc_lookup(&key, &data, &len))
+	{
+		case QVC_READY:
+			fp = os_tmpfile();
+			if(fp != NULL)
+			{
+				if(fwrite(data, 1U, len, fp) == len)
+				{
+					rewind(fp);
+				}
+				else
+				{
+					fclose(fp);
+					fp = NULL;
+				}
+			}
+			free(data);
+			return fp;
+		case QVC_FAILED:
+			return NULL;
+		case QVC_MISSING:
+			break;
+	}
+
+	cmd = get_viewer_command(viewer);
+	qvc_request(&key, cmd);
+	free(cmd);
+
+	*loading = 1;
+	return NULL;
+#else
+	return use_info_prog(viewer);
+#endif
+}
+
+/* Queues previews of files around the cursor for prefetching.  Files in the
+ * direction of the last cursor movement go first. */
+static void
+prefetch_neighbours(FileView *view)
+{
+#ifndef _WIN32
+	static const FileView *last_view;
+	static int last_pos;
+	static int direction = 1;
+
+	const int n = cfg.prefetch_entries;
+	qvc_key_t *keys;
+	char **paths;
+	char **cmds;
+	int count = 0;
+	int i;
+
+	if(view == last_view && view->list_pos != last_pos)
+	{
+		direction = (view->list_pos > last_pos) ? 1 : -1;
+	}
+	last_view = view;
+	last_pos = view->list_pos;
+
+	/* Viewer commands are expanded for the current view. */
+	if(n == 0 || view != curr_view || curr_stats.preview_hint != NULL)
+	{
+		qvc_prefetch(NULL, NULL, 0);
+		return;
+	}
+
+	keys = reallocarray(NULL, 2*n, sizeof(*keys));
+	paths = reallocarray(NULL, 2*n, sizeof(*paths));
+	cmds = reallocarray(NULL, 2*n, sizeof(*cmds));
+
+	for(i = 0; i < 2*n && keys != NULL && paths != NULL && cmds != NULL; ++i)
+	{
+		const int step = (i < n) ? direction : -direction;
+		const int pos = view->list_pos + step*(i%n + 1);
+
+		if(make_prefetch_item(view, pos, &paths[count], &keys[count].viewer,
+					&cmds[count]) == 0)
+		{
+			keys[count].path = paths[count];
+			keys[count].width = ui_qv_width(other_view);
+			keys[count].height = ui_qv_height(other_view);
+			++count;
+		}
+	}
+
+	qvc_prefetch(keys, cmds, count);
+
+	free_string_array(paths, count);
+	free_string_array(cmds, count);
+	free(keys);
+#endif
+}
+
+/* Prepares data for prefetching preview of a file at specified position.
+ * Returns zero on success and non-zero if the file shouldn't be prefetched. */
+static int
+make_prefetch_item(FileView *view, int pos, char **path, const char **viewer,
+		char **cmd)
+{
+	char full_path[PATH_MAX];
+	const dir_entry_t *entry;
+	int curr_pos;
+
+	if(pos < 0 || pos >= view->list_rows)
+	{
+		return 1;
+	}
+
+	entry = &view->dir_entry[pos];
+	if(entry->type != FT_REG)
+	{
+		return 1;
+	}
+
+	get_full_path_of(entry, sizeof(full_path), full_path);
+	*viewer = qv_get_viewer(full_path);
+	if(is_null_or_empty(*viewer) || is_graphics_viewer(*viewer))
+	{
+		return 1;
+	}
+
+	*path = strdup(full_path);
+	if(*path == NULL)
+	{
+		return 1;
+	}
+
+	/* Macros are expanded as if cursor was at the file. */
+	curr_pos = view->list_pos;
+	view->list_pos = pos;
+	*cmd = get_viewer_command(*viewer);
+	view->list_pos = curr_pos;
+
+	if(*cmd == NULL)
+	{
+		free(*path);
+		return 1;
+	}
+	return 0;
+}
+
+int
+qv_check_for_updates(int idle)
+{
+#ifndef _WIN32
+	qvc_pause_prefetch(!idle);
+
+	if(qvc_fetch_ready() && curr_stats.view)
+	{
+		quick_view_file(curr_view);
+		return 1;
+	}
+#endif
+	return 0;
+}
+
 FILE *
 qv_view_dir(const char path[])
 {
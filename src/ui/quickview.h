@@ -46,6 +46,11 @@ const char * qv_get_viewer(const char path[]);
  * Returns the stream or NULL on error. */
 FILE * qv_view_dir(const char path[]);
 
+/* Redraws preview if output of a viewer that was run in background has become
+ * available.  Prefetching of previews is paused unless idle is non-zero.
+ * Returns non-zero if preview was redrawn, otherwise zero is returned. */
+int qv_check_for_updates(int idle);
+
 TSTATIC_DEFS(
 	void view_stream(FILE *fp, int wrapped);
 );
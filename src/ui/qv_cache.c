@@ -0,0 +1,843 @@
+/* vifm
+ * Copyright (C) 2026 agent.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "qv_cache.h"
+
+#include <pthread.h> /* PTHREAD_* pthread_*() */
+#include <sys/stat.h> /* stat */
+#include <sys/types.h> /* pid_t */
+
+#include <signal.h> /* SIGTERM kill() */
+#include <stddef.h> /* NULL size_t */
+#include <stdint.h> /* uint64_t */
+#include <stdio.h> /* FILE fclose() getc() */
+#include <stdlib.h> /* free() malloc() realloc() */
+#include <string.h> /* memcpy() memset() strcmp() strdup() */
+#include <time.h> /* time_t */
+
+#include "../compat/os.h"
+#include "../utils/str.h"
+#include "../utils/utils_nix.h"
+
+/* Maximum number of cached previews. */
+#define MAX_ENTRIES 64
+
+/* Default limit on total size of cached output in bytes. */
+#define DEFAULT_CACHE_SIZE (8*1024*1024)
+
+/* Maximum number of bytes of output of a single viewer that is kept. */
+#define MAX_OUTPUT_SIZE (512*1024)
+
+/* Key of cache entry. */
+typedef struct
+{
+	char *path;     /* Path to the previewed file. */
+	char *viewer;   /* Viewer as it's specified by the user. */
+	int width;      /* Width of preview area. */
+	int height;     /* Height of preview area. */
+	time_t mtime;   /* Modification time of the file. */
+	uint64_t size;  /* Size of the file. */
+}
+entry_key_t;
+
+/* Cached preview. */
+typedef struct
+{
+	entry_key_t key;    /* What this preview is for. */
+	char *data;         /* Output of the viewer. */
+	size_t len;         /* Length of the output. */
+	int failed;         /* Whether viewer couldn't be run. */
+	uint64_t last_used; /* Value of use_clock on the last lookup. */
+}
+entry_t;
+
+/* Preview that is being produced. */
+typedef struct
+{
+	int active;        /* Whether there is a request. */
+	int pending;       /* Whether the request wasn't picked by worker yet. */
+	entry_key_t key;   /* What is being previewed. */
+	char *cmd;         /* Command to run, owned by worker after picking. */
+	unsigned int gen;  /* Generation of the request to detect cancellation. */
+	pid_t pgid;        /* Process group of running viewer or zero. */
+}
+request_t;
+
+/* Element of prefetch queue. */
+typedef struct
+{
+	entry_key_t key; /* What is to be previewed. */
+	char *cmd;       /* Command to run. */
+}
+prefetch_item_t;
+
+/* State of a prefetching thread. */
+typedef struct
+{
+	int busy;        /* Whether the thread runs a viewer. */
+	int cancelled;   /* Whether output of the viewer should be dropped. */
+	entry_key_t key; /* What is being previewed. */
+	pid_t pgid;      /* Process group of running viewer or zero. */
+}
+prefetch_job_t;
+
+static void * worker_thread(void *arg);
+static void run_request(entry_key_t *key, char cmd[], unsigned int gen);
+static void * prefetch_thread(void *arg);
+static void run_prefetch(prefetch_job_t *job, char cmd[]);
+static int start_thread(void * (*func)(void *), void *arg);
+static int can_prefetch(void);
+static int is_known(const entry_key_t *key);
+static prefetch_job_t * find_job(const entry_key_t *key);
+static void clear_prefetch_queue(void);
+static char * read_output(FILE *fp, int max_lines, size_t *len);
+static void cancel_request(void);
+static void store_entry(entry_key_t *key, char data[], size_t len, int failed);
+static void evict_lru(void);
+static entry_t * find_entry(const entry_key_t *key);
+static int keys_equal(const entry_key_t *lhs, const entry_key_t *rhs);
+static void make_key(entry_key_t *key, const qvc_key_t *src);
+static int copy_key(entry_key_t *dst, const entry_key_t *src);
+static void free_key(entry_key_t *key);
+
+/* Protects all of the state below. */
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+/* Signaled on new requests. */
+static pthread_cond_t request_cond = PTHREAD_COND_INITIALIZER;
+/* Signaled on changes that might let prefetching threads proceed. */
+static pthread_cond_t prefetch_cond = PTHREAD_COND_INITIALIZER;
+
+/* Cached previews. */
+static entry_t entries[MAX_ENTRIES];
+/* Number of used elements of entries array. */
+static int nentries;
+/* Total size of output stored in the cache. */
+static size_t cache_size;
+/* Limit on cache_size. */
+static uint64_t max_cache_size = DEFAULT_CACHE_SIZE;
+/* Counter that orders uses of entries. */
+static uint64_t use_clock;
+
+/* Current request. */
+static request_t request;
+/* Whether requested preview was stored in the cache. */
+static int ready;
+/* Whether worker thread was started. */
+static int worker_started;
+
+/* Previews to produce speculatively. */
+static prefetch_item_t *queue;
+/* Number of elements in the queue. */
+static int queue_len;
+/* Index of the next element of the queue to process. */
+static int queue_pos;
+/* Whether prefetching is paused. */
+static int prefetch_paused;
+/* State of prefetching threads. */
+static prefetch_job_t jobs[QVC_MAX_JOBS];
+/* Number of started prefetching threads. */
+static int nthreads;
+/* Number of viewers that are run for prefetching right now. */
+static int nrunning;
+/* Maximum value of nrunning. */
+static int max_jobs = 1;
+
+QvcStatus
+qvc_lookup(const qvc_key_t *key, char **data, size_t *len)
+{
+	QvcStatus status = QVC_MISSING;
+	entry_key_t k;
+	entry_t *entry;
+
+	make_key(&k, key);
+
+	pthread_mutex_lock(&lock);
+
+	entry = find_entry(&k);
+	if(entry != NULL)
+	{
+		entry->last_used = ++use_clock;
+		status = QVC_FAILED;
+
+		if(!entry->failed)
+		{
+			*data = malloc(entry->len + 1U);
+			if(*data != NULL)
+			{
+				memcpy(*data, entry->data, entry->len);
+				(*data)[entry->len] = '\0';
+				*len = entry->len;
+				status = QVC_READY;
+			}
+		}
+	}
+
+	pthread_mutex_unlock(&lock);
+
+	return status;
+}
+
+void
+qvc_request(const qvc_key_t *key, const char cmd[])
+{
+	entry_key_t k;
+	char *const cmd_copy = strdup(cmd);
+	if(cmd_copy == NULL)
+	{
+		return;
+	}
+
+	make_key(&k, key);
+
+	pthread_mutex_lock(&lock);
+
+	if(request.active && keys_equal(&request.key, &k))
+	{
+		/* This preview is already being produced. */
+		pthread_mutex_unlock(&lock);
+		free(cmd_copy);
+		return;
+	}
+
+	if(!worker_started)
+	{
+		worker_started = (start_thread(&worker_thread, NULL) == 0);
+	}
+
+	cancel_request();
+
+	if(!worker_started || copy_key(&request.key, &k) != 0)
+	{
+		pthread_mutex_unlock(&lock);
+		free(cmd_copy);
+		return;
+	}
+
+	request.active = 1;
+
+	if(find_job(&k) != NULL)
+	{
+		/* Prefetching thread will complete the request. */
+		free(cmd_copy);
+	}
+	else
+	{
+		request.pending = 1;
+		request.cmd = cmd_copy;
+		pthread_cond_signal(&request_cond);
+	}
+
+	pthread_mutex_unlock(&lock);
+}
+
+void
+qvc_prefetch(const qvc_key_t keys[], char *cmds[], int count)
+{
+	int i;
+	int len = 0;
+	prefetch_item_t *const items = malloc(sizeof(*items)*(count + 1));
+	if(items == NULL)
+	{
+		return;
+	}
+
+	/* Files are queried without holding the lock. */
+	for(i = 0; i < count; ++i)
+	{
+		entry_key_t k;
+		make_key(&k, &keys[i]);
+
+		items[len].cmd = strdup(cmds[i]);
+		if(items[len].cmd == NULL)
+		{
+			continue;
+		}
+		if(copy_key(&items[len].key, &k) != 0)
+		{
+			free(items[len].cmd);
+			continue;
+		}
+		++len;
+	}
+
+	pthread_mutex_lock(&lock);
+
+	clear_prefetch_queue();
+	queue = items;
+	queue_len = len;
+	queue_pos = 0;
+
+	while(nthreads < max_jobs && len != 0)
+	{
+		if(start_thread(&prefetch_thread, &jobs[nthreads]) != 0)
+		{
+			break;
+		}
+		++nthreads;
+	}
+
+	pthread_cond_broadcast(&prefetch_cond);
+	pthread_mutex_unlock(&lock);
+}
+
+void
+qvc_pause_prefetch(int pause)
+{
+	pthread_mutex_lock(&lock);
+
+	if(prefetch_paused != pause)
+	{
+		prefetch_paused = pause;
+		pthread_cond_broadcast(&prefetch_cond);
+	}
+
+	pthread_mutex_unlock(&lock);
+}
+
+void
+qvc_set_limits(int jobs_limit, uint64_t memory_limit)
+{
+	pthread_mutex_lock(&lock);
+
+	max_jobs = (jobs_limit < 1) ? 1
+	         : (jobs_limit > QVC_MAX_JOBS) ? QVC_MAX_JOBS
+	         : jobs_limit;
+
+	max_cache_size = memory_limit;
+	while(nentries != 0 && cache_size > max_cache_size)
+	{
+		evict_lru();
+	}
+
+	pthread_cond_broadcast(&prefetch_cond);
+	pthread_mutex_unlock(&lock);
+}
+
+void
+qvc_cancel(void)
+{
+	int i;
+
+	pthread_mutex_lock(&lock);
+
+	cancel_request();
+	clear_prefetch_queue();
+
+	for(i = 0; i < nthreads; ++i)
+	{
+		if(jobs[i].busy)
+		{
+			jobs[i].cancelled = 1;
+			if(jobs[i].pgid != 0)
+			{
+				(void)kill(-jobs[i].pgid, SIGTERM);
+				jobs[i].pgid = 0;
+			}
+		}
+	}
+
+	pthread_mutex_unlock(&lock);
+}
+
+int
+qvc_fetch_ready(void)
+{
+	int result;
+
+	pthread_mutex_lock(&lock);
+	result = ready;
+	ready = 0;
+	pthread_mutex_unlock(&lock);
+
+	return result;
+}
+
+void
+qvc_clear(void)
+{
+	pthread_mutex_lock(&lock);
+
+	while(nentries != 0)
+	{
+		evict_lru();
+	}
+
+	pthread_mutex_unlock(&lock);
+}
+
+/* Entry point of the worker thread, which runs viewers one by one.  Never
+ * returns. */
+static void *
+worker_thread(void *arg)
+{
+	pthread_mutex_lock(&lock);
+
+	while(1)
+	{
+		entry_key_t key;
+		char *cmd;
+		unsigned int gen;
+
+		while(!request.pending)
+		{
+			pthread_cond_wait(&request_cond, &lock);
+		}
+
+		request.pending = 0;
+		cmd = request.cmd;
+		request.cmd = NULL;
+		gen = request.gen;
+
+		if(copy_key(&key, &request.key) != 0)
+		{
+			request.active = 0;
+			free_key(&request.key);
+			free(cmd);
+			continue;
+		}
+
+		pthread_mutex_unlock(&lock);
+		run_request(&key, cmd, gen);
+		pthread_mutex_lock(&lock);
+	}
+
+	return NULL;
+}
+
+/* Runs viewer and stores its output unless the request is cancelled.  Frees
+ * the key and the command. */
+static void
+run_request(entry_key_t *key, char cmd[], unsigned int gen)
+{
+	pid_t pgid;
+	char *data = NULL;
+	size_t len = 0U;
+
+	FILE *const fp = read_cmd_output_grouped(cmd, 0, &pgid);
+	free(cmd);
+
+	if(fp != NULL)
+	{
+		pthread_mutex_lock(&lock);
+		if(gen == request.gen)
+		{
+			request.pgid = pgid;
+		}
+		else
+		{
+			/* Cancelled while the viewer was being started. */
+			(void)kill(-pgid, SIGTERM);
+		}
+		pthread_mutex_unlock(&lock);
+
+		data = read_output(fp, key->height, &len);
+		fclose(fp);
+	}
+
+	pthread_mutex_lock(&lock);
+
+	if(gen == request.gen)
+	{
+		request.pgid = 0;
+		request.active = 0;
+		free_key(&request.key);
+
+		/* Prefetching of the same file might have finished first. */
+		if(find_entry(key) != NULL)
+		{
+			free_key(key);
+			free(data);
+		}
+		else
+		{
+			store_entry(key, data, len, fp == NULL || data == NULL);
+		}
+		ready = 1;
+	}
+	else
+	{
+		free_key(key);
+		free(data);
+	}
+
+	pthread_mutex_unlock(&lock);
+}
+
+/* Entry point of a prefetching thread, which produces previews from the queue
+ * while prefetching isn't paused.  Never returns. */
+static void *
+prefetch_thread(void *arg)
+{
+	prefetch_job_t *const job = arg;
+
+	pthread_mutex_lock(&lock);
+
+	while(1)
+	{
+		prefetch_item_t item;
+
+		while(!can_prefetch())
+		{
+			pthread_cond_wait(&prefetch_cond, &lock);
+		}
+
+		item = queue[queue_pos++];
+		if(is_known(&item.key))
+		{
+			free_key(&item.key);
+			free(item.cmd);
+			continue;
+		}
+
+		job->busy = 1;
+		job->cancelled = 0;
+		job->key = item.key;
+		job->pgid = 0;
+		++nrunning;
+
+		pthread_mutex_unlock(&lock);
+		run_prefetch(job, item.cmd);
+		pthread_mutex_lock(&lock);
+	}
+
+	return NULL;
+}
+
+/* Runs viewer with low priority and stores its output unless it's cancelled.
+ * Completes request for the same preview, if there is one.  Frees the
+ * command. */
+static void
+run_prefetch(prefetch_job_t *job, char cmd[])
+{
+	pid_t pgid;
+	char *data = NULL;
+	size_t len = 0U;
+
+	FILE *const fp = read_cmd_output_grouped(cmd, 1, &pgid);
+	free(cmd);
+
+	if(fp != NULL)
+	{
+		pthread_mutex_lock(&lock);
+		if(job->cancelled)
+		{
+			(void)kill(-pgid, SIGTERM);
+		}
+		else
+		{
+			job->pgid = pgid;
+		}
+		pthread_mutex_unlock(&lock);
+
+		/* The key is changed only by this thread. */
+		data = read_output(fp, job->key.height, &len);
+		fclose(fp);
+	}
+
+	pthread_mutex_lock(&lock);
+
+	job->busy = 0;
+	job->pgid = 0;
+	--nrunning;
+
+	if(job->cancelled || find_entry(&job->key) != NULL)
+	{
+		free_key(&job->key);
+		free(data);
+	}
+	else
+	{
+		const int requested = request.active && !request.pending
+		                   && keys_equal(&request.key, &job->key);
+
+		store_entry(&job->key, data, len, fp == NULL || data == NULL);
+
+		if(requested)
+		{
+			request.active = 0;
+			free_key(&request.key);
+			ready = 1;
+		}
+	}
+
+	pthread_cond_broadcast(&prefetch_cond);
+	pthread_mutex_unlock(&lock);
+}
+
+/* Starts detached thread.  Returns zero on success, otherwise non-zero is
+ * returned. */
+static int
+start_thread(void * (*func)(void *), void *arg)
+{
+	pthread_t id;
+	pthread_attr_t attr;
+	int result;
+
+	if(pthread_attr_init(&attr) != 0)
+	{
+		return 1;
+	}
+
+	(void)pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+	result = pthread_create(&id, &attr, func, arg);
+	(void)pthread_attr_destroy(&attr);
+
+	return (result != 0);
+}
+
+/* Checks whether prefetching thread can take the next element of the queue.
+ * Must be called with the lock held.  Returns non-zero if so, otherwise zero
+ * is returned. */
+static int
+can_prefetch(void)
+{
+	return !prefetch_paused
+	    && queue_pos < queue_len
+	    && nrunning < max_jobs;
+}
+
+/* Checks whether preview is cached or is being produced.  Must be called with
+ * the lock held.  Returns non-zero if so, otherwise zero is returned. */
+static int
+is_known(const entry_key_t *key)
+{
+	return find_entry(key) != NULL
+	    || (request.active && keys_equal(&request.key, key))
+	    || find_job(key) != NULL;
+}
+
+/* Finds prefetching thread that produces specified preview.  Must be called
+ * with the lock held.  Returns the job or NULL. */
+static prefetch_job_t *
+find_job(const entry_key_t *key)
+{
+	int i;
+	for(i = 0; i < nthreads; ++i)
+	{
+		if(jobs[i].busy && !jobs[i].cancelled && keys_equal(&jobs[i].key, key))
+		{
+			return &jobs[i];
+		}
+	}
+	return NULL;
+}
+
+/* Empties prefetch queue.  Must be called with the lock held. */
+static void
+clear_prefetch_queue(void)
+{
+	int i;
+	for(i = queue_pos; i < queue_len; ++i)
+	{
+		free_key(&queue[i].key);
+		free(queue[i].cmd);
+	}
+
+	free(queue);
+	queue = NULL;
+	queue_len = 0;
+	queue_pos = 0;
+}
+
+/* Reads output of a viewer up to number of lines that fit on the screen.
+ * Returns newly allocated string of length *len or NULL on error. */
+static char *
+read_output(FILE *fp, int max_lines, size_t *len)
+{
+	char *data = NULL;
+	size_t capacity = 0U;
+	int nlines = 0;
+	int c;
+
+	*len = 0U;
+	while(nlines < max_lines && *len < MAX_OUTPUT_SIZE && (c = getc(fp)) != EOF)
+	{
+		if(*len == capacity)
+		{
+			char *const new_data = realloc(data, capacity + 4096U);
+			if(new_data == NULL)
+			{
+				free(data);
+				return NULL;
+			}
+			data = new_data;
+			capacity += 4096U;
+		}
+
+		data[(*len)++] = c;
+		nlines += (c == '\n');
+	}
+
+	if(data == NULL)
+	{
+		/* Empty output is a valid preview. */
+		data = strdup("");
+	}
+	return data;
+}
+
+/* Cancels current request, if any, killing its viewer.  Must be called with
+ * the lock held. */
+static void
+cancel_request(void)
+{
+	if(!request.active)
+	{
+		return;
+	}
+
+	if(request.pgid != 0)
+	{
+		(void)kill(-request.pgid, SIGTERM);
+		request.pgid = 0;
+	}
+
+	++request.gen;
+	request.active = 0;
+	request.pending = 0;
+	free_key(&request.key);
+	update_string(&request.cmd, NULL);
+}
+
+/* Puts preview into the cache evicting old entries to make space for it.  Takes
+ * ownership of the key and data.  Must be called with the lock held. */
+static void
+store_entry(entry_key_t *key, char data[], size_t len, int failed)
+{
+	entry_t *entry;
+
+	if(failed)
+	{
+		free(data);
+		data = NULL;
+		len = 0U;
+	}
+
+	/* The latest preview is kept even if it alone exceeds the limit. */
+	while(nentries != 0 &&
+			(nentries == MAX_ENTRIES || cache_size + len > max_cache_size))
+	{
+		evict_lru();
+	}
+
+	entry = &entries[nentries++];
+	entry->key = *key;
+	entry->data = data;
+	entry->len = len;
+	entry->failed = failed;
+	entry->last_used = ++use_clock;
+	cache_size += len;
+}
+
+/* Removes least recently used entry from the cache.  Must be called with the
+ * lock held. */
+static void
+evict_lru(void)
+{
+	int i;
+	int lru = 0;
+
+	for(i = 1; i < nentries; ++i)
+	{
+		if(entries[i].last_used < entries[lru].last_used)
+		{
+			lru = i;
+		}
+	}
+
+	cache_size -= entries[lru].len;
+	free_key(&entries[lru].key);
+	free(entries[lru].data);
+
+	entries[lru] = entries[--nentries];
+}
+
+/* Finds entry in the cache.  Must be called with the lock held.  Returns the
+ * entry or NULL. */
+static entry_t *
+find_entry(const entry_key_t *key)
+{
+	int i;
+	for(i = 0; i < nentries; ++i)
+	{
+		if(keys_equal(&entries[i].key, key))
+		{
+			return &entries[i];
+		}
+	}
+	return NULL;
+}
+
+/* Compares keys.  Returns non-zero if they are equal, otherwise zero is
+ * returned. */
+static int
+keys_equal(const entry_key_t *lhs, const entry_key_t *rhs)
+{
+	return lhs->width == rhs->width
+	    && lhs->height == rhs->height
+	    && lhs->mtime == rhs->mtime
+	    && lhs->size == rhs->size
+	    && strcmp(lhs->path, rhs->path) == 0
+	    && strcmp(lhs->viewer, rhs->viewer) == 0;
+}
+
+/* Makes key out of its public version by querying information about the file.
+ * The key refers to strings of the source and must not be freed. */
+static void
+make_key(entry_key_t *key, const qvc_key_t *src)
+{
+	struct stat st;
+	if(os_stat(src->path, &st) != 0)
+	{
+		memset(&st, 0, sizeof(st));
+	}
+
+	key->path = (char *)src->path;
+	key->viewer = (char *)src->viewer;
+	key->width = src->width;
+	key->height = src->height;
+	key->mtime = st.st_mtime;
+	key->size = st.st_size;
+}
+
+/* Makes a deep copy of a key.  Returns zero on success, otherwise non-zero is
+ * returned. */
+static int
+copy_key(entry_key_t *dst, const entry_key_t *src)
+{
+	*dst = *src;
+	dst->path = strdup(src->path);
+	dst->viewer = strdup(src->viewer);
+	if(dst->path == NULL || dst->viewer == NULL)
+	{
+		free_key(dst);
+		return 1;
+	}
+	return 0;
+}
+
+/* Frees memory held by the key. */
+static void
+free_key(entry_key_t *key)
+{
+	update_string(&key->path, NULL);
+	update_string(&key->viewer, NULL);
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
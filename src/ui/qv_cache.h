@@ -0,0 +1,94 @@
+/* vifm
+ * Copyright (C) 2026 agent.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef VIFM__UI__QV_CACHE_H__
+#define VIFM__UI__QV_CACHE_H__
+
+#include <stddef.h> /* size_t */
+#include <stdint.h> /* uint64_t */
+
+/* qv_cache - quick view cache - asynchronous running of viewers with caching of
+ * their output */
+
+/* Output of viewers is produced by a background thread and is stored in a
+ * cache with least recently used eviction.  Only one preview is being produced
+ * at a time, requesting another one cancels the current one and kills its
+ * viewer.  Previews that might be needed soon can be prefetched by a pool of
+ * threads, which run viewers with lower priority.  Not available on
+ * Windows. */
+
+/* Maximum number of viewers that can be run for prefetching at the same
+ * time. */
+#define QVC_MAX_JOBS 8
+
+/* Status of a preview. */
+typedef enum
+{
+	QVC_MISSING, /* Preview isn't in the cache. */
+	QVC_READY,   /* Preview is available. */
+	QVC_FAILED,  /* Running of the viewer has failed. */
+}
+QvcStatus;
+
+/* Identifies preview in the cache. */
+typedef struct
+{
+	const char *path;   /* Path to the previewed file. */
+	const char *viewer; /* Viewer as it's specified by the user. */
+	int width;          /* Width of preview area. */
+	int height;         /* Height of preview area. */
+}
+qvc_key_t;
+
+/* Looks up preview in the cache.  For a ready preview *data is set to a newly
+ * allocated copy of the output of length *len.  Returns status of the
+ * preview. */
+QvcStatus qvc_lookup(const qvc_key_t *key, char **data, size_t *len);
+
+/* Starts producing preview in background by running the command (viewer with
+ * expanded macros).  Cancels previous request if it's for a different
+ * preview. */
+void qvc_request(const qvc_key_t *key, const char cmd[]);
+
+/* Replaces queue of previews to be prefetched with the new one.  Previews are
+ * produced in the order of elements of the arrays, skipping those that are
+ * cached or are being produced already. */
+void qvc_prefetch(const qvc_key_t keys[], char *cmds[], int count);
+
+/* Pauses or resumes prefetching.  Viewers that are already running aren't
+ * affected. */
+void qvc_pause_prefetch(int pause);
+
+/* Sets maximum number of viewers run for prefetching at a time (clamped to
+ * [1; QVC_MAX_JOBS]) and limit on total size of cached output in bytes. */
+void qvc_set_limits(int jobs, uint64_t memory);
+
+/* Cancels current request if there is one along with prefetching. */
+void qvc_cancel(void);
+
+/* Checks whether requested preview was produced since the last call.  Returns
+ * non-zero if so, otherwise zero is returned. */
+int qvc_fetch_ready(void);
+
+/* Drops all cached previews. */
+void qvc_clear(void);
+
+#endif /* VIFM__UI__QV_CACHE_H__ */
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
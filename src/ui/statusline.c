@@ -22,6 +22,7 @@
 
 #include <ctype.h> /* isdigit() */
 #include <stddef.h> /* NULL size_t */
+#include <stdint.h> /* uint64_t */
 #include <string.h> /* strcat() strdup() strlen() */
 #include <unistd.h>
 
@@ -41,6 +42,9 @@
 
 #include "../utils/str.h"
 
+/* Minimal width of description of a job on job bar. */
+#define MIN_JOB_DESCR_WIDTH 10
+
 static void update_stat_window_old(FileView *view);
 TSTATIC char * expand_status_line_macros(FileView *view, const char format[]);
 char * expand_view_macros(FileView *view, const char format[],
@@ -544,22 +548,42 @@ format_job_bar(void)
 	for(i = 0U; i < nbar_jobs; ++i)
 	{
 		const int progress = bar_jobs[i]->progress;
-		const unsigned int reserved = (progress == -1) ? 0U : 5U;
+		const uint64_t rate = bar_jobs[i]->rate;
+		unsigned int reserved = (progress == -1) ? 0U : 5U;
 		char item_text[max_width*MAX_UTF_CHAR_LEN + 1U];
+		char rate_text[32];
+		const char *ellipsis;
 
 		const size_t width = (i == nbar_jobs - 1U)
 		                   ? (max_width - width_used)
 		                   : (max_width/nbar_jobs);
 
-		const char *ellipsis = left_ellipsis(descrs[i], width - 2U - reserved);
+		rate_text[0] = '\0';
+		if(rate != 0U)
+		{
+			char size[16];
+			(void)friendly_size_notation(rate, sizeof(size), size);
+			snprintf(rate_text, sizeof(rate_text), " %s/s", size);
+
+			/* Rate is less important than description, so drop it if there is not
+			 * enough space. */
+			if(width < 2U + reserved + strlen(rate_text) + MIN_JOB_DESCR_WIDTH)
+			{
+				rate_text[0] = '\0';
+			}
+			reserved += strlen(rate_text);
+		}
+
+		ellipsis = left_ellipsis(descrs[i], width - 2U - reserved);
 
 		if(progress == -1)
 		{
-			snprintf(item_text, sizeof(item_text), "[%s]", ellipsis);
+			snprintf(item_text, sizeof(item_text), "[%s%s]", ellipsis, rate_text);
 		}
 		else
 		{
-			snprintf(item_text, sizeof(item_text), "[%s %3d%%]", ellipsis, progress);
+			snprintf(item_text, sizeof(item_text), "[%s %3d%%%s]", ellipsis, progress,
+					rate_text);
 		}
 
 		(void)sstrappend(bar_text, &text_width, sizeof(bar_text), item_text);
@@ -145,9 +145,30 @@ history_t;
 
 typedef struct dir_entry_t
 {
+	/* Fields accessed on every sorting, filtering and drawing of the list go
+	 * first and are kept compact, the rest is grouped after them. */
+
 	char *name;
 	char *origin;     /* Location where this file comes from. */
+	FileType type;
+
+	int list_num;     /* Used by sorting comparer to perform stable sort. */
+	int hi_num;       /* File highlighting parameters cache (initially -1). */
+
+	int search_match;      /* Whether the item matches last search. */
+	short int match_left;  /* Starting position of the match. */
+	short int match_right; /* Ending position of the match. */
+
+	unsigned int selected : 1;
+	unsigned int was_selected : 1;  /* Previous selection state in Visual mode. */
+	unsigned int marked : 1;        /* Whether file should be processed. */
+	unsigned int name_pooled : 1;   /* Whether name is from string pool. */
+	unsigned int origin_pooled : 1; /* Whether origin is from string pool. */
+
 	uint64_t size;
+	time_t mtime;
+	time_t atime;
+	time_t ctime;
 #ifndef _WIN32
 	uid_t uid;
 	gid_t gid;
@@ -155,24 +176,7 @@ typedef struct dir_entry_t
 #else
 	uint32_t attrs;
 #endif
-	time_t mtime;
-	time_t atime;
-	time_t ctime;
-	FileType type;
 	int nlinks;       /* Number of hard links to the entry. */
-
-	int selected;
-	int was_selected; /* Stores previous selection state in Visual mode. */
-
-	int search_match;      /* Whether the item matches last search. */
-	short int match_left;  /* Starting position of the match. */
-	short int match_right; /* Ending position of the match. */
-
-	int list_num;     /* Used by sorting comparer to perform stable sort. */
-
-	int marked;       /* Whether file should be processed. */
-
-	int hi_num;       /* File highlighting parameters cache (initially -1). */
 }
 dir_entry_t;
 
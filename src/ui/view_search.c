@@ -0,0 +1,816 @@
+/* vifm
+ * Copyright (C) 2026 agent.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "view_search.h"
+
+#include <pthread.h> /* PTHREAD_* pthread_*() */
+#include <regex.h> /* regcomp() regexec() regfree() */
+
+#include <limits.h> /* INT_MAX */
+#include <stddef.h> /* NULL size_t */
+#include <stdlib.h> /* free() malloc() realloc() */
+#include <string.h> /* memchr() memcmp() memcpy() strchr() strcspn() strdup()
+                       strlen() strpbrk() */
+
+#include "../utils/str.h"
+#include "escape.h"
+
+/* Maximum number of positions of matches kept by a counter. */
+#define MAX_CACHED_MATCHES (1024*1024)
+
+/* Match counter. */
+struct vs_counter_t
+{
+	pthread_mutex_t lock; /* Protects fields that are shared with the thread. */
+	pthread_t thread;     /* Thread that counts matches. */
+	int has_thread;       /* Whether thread field is initialized. */
+	int cancelled;        /* Whether counting should stop. */
+
+	vs_pos_t *matches; /* Positions of found matches in ascending order. */
+	int nmatches;      /* Number of elements in matches array. */
+	int cap;           /* Capacity of matches array. */
+	int total;         /* Number of found matches. */
+	int scanned;       /* Number of lines that were processed. */
+	int done;          /* Whether all lines were processed. */
+	int reported;      /* Value of total on last progress check. */
+	int reported_done; /* Value of done on last progress check. */
+
+	/* Data that is used only by the thread. */
+	vs_layout_t layout;   /* Layout that is used to compute positions. */
+	file_lines_t *fl;     /* File that is being processed. */
+	regex_t re;           /* Compiled pattern. */
+	char *literal;        /* Pattern if it's a plain string, otherwise NULL. */
+	int context_free;     /* Whether pattern doesn't depend on its context. */
+	char *row;            /* Buffer for a screen line. */
+	int *rows;            /* Matched screen lines of the current line. */
+	int nrows;            /* Number of elements in rows array. */
+	int rows_cap;         /* Capacity of rows array. */
+};
+
+static size_t pick_anchor(const char literal[]);
+static size_t find_literal(const vs_finder_t *finder, size_t from);
+static size_t find_byte(file_lines_t *fl, char c, size_t from, size_t to);
+static int is_byte(file_lines_t *fl, size_t offset, char c);
+static vs_counter_t * alloc_counter(const vs_layout_t *layout);
+static void * count_matches(void *arg);
+static int count_line(vs_counter_t *counter, const regex_t *re,
+		const char text[]);
+static int add_row(vs_counter_t *counter, int row);
+static int publish_matches(vs_counter_t *counter, int line);
+static int is_context_free(const char pattern[]);
+static int add_match(vs_counter_t *counter, vs_pos_t pos);
+static int find_pos(const vs_counter_t *counter, vs_pos_t pos);
+static int pos_cmp(vs_pos_t a, vs_pos_t b);
+
+int
+vs_match_line(const regex_t *re, const vs_layout_t *layout, const char line[],
+		int first, int last, int backward)
+{
+	const int width = (layout->width > 0) ? layout->width : 1;
+	char *const buf = malloc(width*4 + layout->tab_stop + 1);
+	char *const no_esc = esc_remove(line);
+	const char *part = no_esc;
+	int found = -1;
+	int i = 0;
+
+	if(buf == NULL || no_esc == NULL)
+	{
+		free(buf);
+		free(no_esc);
+		return -1;
+	}
+
+	do
+	{
+		part = expand_tabulation(part, width, layout->tab_stop, buf);
+		if(i >= first && regexec(re, buf, 0, NULL, 0) == 0)
+		{
+			found = i;
+			if(!backward)
+			{
+				break;
+			}
+		}
+		++i;
+	}
+	while(layout->wrap && *part != '\0' && i <= last);
+
+	free(no_esc);
+	free(buf);
+	return found;
+}
+
+int
+vs_is_literal(const char pattern[], int cflags)
+{
+	if(pattern[0] == '\0' || (cflags & REG_ICASE))
+	{
+		return 0;
+	}
+
+	/* Tabulation and escape sequences can produce spaces and join pieces of
+	 * text, so only lines with escape sequences need to be checked separately if
+	 * there are no spaces. */
+	return pattern[strcspn(pattern, "\\^$.[]|()*+?{} \t\033")] == '\0';
+}
+
+void
+vs_finder_init(vs_finder_t *finder, file_lines_t *fl, const char literal[])
+{
+	const size_t size = fl_size(fl);
+
+	finder->fl = fl;
+	finder->literal = literal;
+	finder->len = strlen(literal);
+	finder->anchor = pick_anchor(literal);
+	finder->lit_from = size + 1U;
+	finder->lit_at = size;
+	finder->esc_from = size + 1U;
+	finder->esc_at = size;
+}
+
+/* Picks byte of the literal that is likely to be the rarest one in a text, so
+ * that fewer false positives have to be checked.  Returns index of the
+ * byte. */
+static size_t
+pick_anchor(const char literal[])
+{
+	/* Lower case letters from the most frequent one to the least frequent. */
+	static const char letters[] = "etaoinshrdlcumwfgypbvkjxqz";
+
+	size_t i;
+	size_t best = 0U;
+	int best_rank = INT_MAX;
+
+	for(i = 0U; literal[i] != '\0'; ++i)
+	{
+		const char *const letter = strchr(letters, literal[i]);
+		int rank;
+		if(letter != NULL)
+		{
+			rank = 2 + (int)(sizeof(letters) - (letter - letters));
+		}
+		else if(literal[i] >= '0' && literal[i] <= '9')
+		{
+			/* Digits are frequent in logs. */
+			rank = 2 + (int)sizeof(letters)/2;
+		}
+		else
+		{
+			rank = 1;
+		}
+
+		if(rank < best_rank)
+		{
+			best_rank = rank;
+			best = i;
+		}
+	}
+	return best;
+}
+
+int
+vs_finder_next(vs_finder_t *finder, int from)
+{
+	file_lines_t *const fl = finder->fl;
+	size_t start, at, line;
+
+	if(from < 0 || fl_offset(fl, from, &start) != 0)
+	{
+		return -1;
+	}
+
+	/* Reuse results of previous lookups if they cover the range. */
+	if(start < finder->lit_from || start > finder->lit_at)
+	{
+		finder->lit_from = start;
+		finder->lit_at = find_literal(finder, start);
+	}
+
+	if(start < finder->esc_from || start > finder->esc_at)
+	{
+		finder->esc_from = start;
+		finder->esc_at = start;
+	}
+	if(finder->esc_at < finder->lit_at && !is_byte(fl, finder->esc_at, '\033'))
+	{
+		finder->esc_at = find_byte(fl, '\033', finder->esc_at, finder->lit_at);
+	}
+
+	at = finder->lit_at;
+	if(finder->esc_at < at && is_byte(fl, finder->esc_at, '\033'))
+	{
+		at = finder->esc_at;
+	}
+
+	if(fl_line_at(fl, at, &line) != 0 || line > INT_MAX)
+	{
+		return -1;
+	}
+	return line;
+}
+
+/* Looks for the literal in the file starting at specified offset.  Returns
+ * offset of the match or size of the file if there is none. */
+static size_t
+find_literal(const vs_finder_t *finder, size_t from)
+{
+	const char c = finder->literal[finder->anchor];
+
+	while(1)
+	{
+		size_t len;
+		const char *p, *end;
+		/* Reading at least length of the literal makes every its occurrence
+		 * that starts in the data fit into it. */
+		const char *const data = fl_read(finder->fl, from, finder->len, &len);
+		if(data == NULL || len < finder->len)
+		{
+			break;
+		}
+
+		p = data + finder->anchor;
+		end = p + (len - finder->len + 1U);
+		while((p = memchr(p, c, end - p)) != NULL)
+		{
+			const char *const start = p - finder->anchor;
+			if(memcmp(start, finder->literal, finder->len) == 0)
+			{
+				return from + (start - data);
+			}
+			++p;
+		}
+
+		from += len - finder->len + 1U;
+	}
+	return fl_size(finder->fl);
+}
+
+/* Looks for a byte in the file between two offsets.  Returns offset of the byte
+ * or the end offset if there is none. */
+static size_t
+find_byte(file_lines_t *fl, char c, size_t from, size_t to)
+{
+	while(from < to)
+	{
+		size_t len;
+		const char *p;
+		const char *const data = fl_read(fl, from, 1U, &len);
+		if(data == NULL)
+		{
+			break;
+		}
+
+		len = (len < to - from) ? len : to - from;
+		p = memchr(data, c, len);
+		if(p != NULL)
+		{
+			return from + (p - data);
+		}
+		from += len;
+	}
+	return to;
+}
+
+/* Checks whether byte of the file at the offset is the specified one.  Returns
+ * non-zero if so, otherwise zero is returned. */
+static int
+is_byte(file_lines_t *fl, size_t offset, char c)
+{
+	size_t len;
+	const char *const data = fl_read(fl, offset, 1U, &len);
+	return (data != NULL && data[0] == c);
+}
+
+vs_counter_t *
+vs_counter_start(const char path[], const char pattern[], int cflags,
+		const vs_layout_t *layout)
+{
+	vs_counter_t *const counter = alloc_counter(layout);
+	if(counter == NULL)
+	{
+		return NULL;
+	}
+
+	counter->fl = fl_open(path);
+	if(counter->fl == NULL)
+	{
+		vs_counter_free(counter);
+		return NULL;
+	}
+
+	if(regcomp(&counter->re, pattern, cflags) != 0)
+	{
+		fl_close(counter->fl);
+		counter->fl = NULL;
+		vs_counter_free(counter);
+		return NULL;
+	}
+
+	if(vs_is_literal(pattern, cflags))
+	{
+		counter->literal = strdup(pattern);
+	}
+	counter->context_free = is_context_free(pattern);
+
+	if(pthread_create(&counter->thread, NULL, &count_matches, counter) != 0)
+	{
+		vs_counter_free(counter);
+		return NULL;
+	}
+	counter->has_thread = 1;
+
+	return counter;
+}
+
+vs_counter_t *
+vs_counter_count(char *lines[], int nlines, const regex_t *re,
+		const vs_layout_t *layout)
+{
+	int i;
+	vs_counter_t *const counter = alloc_counter(layout);
+	if(counter == NULL)
+	{
+		return NULL;
+	}
+
+	for(i = 0; i < nlines; ++i)
+	{
+		if(count_line(counter, re, lines[i]) != 0 ||
+				publish_matches(counter, i) != 0)
+		{
+			break;
+		}
+	}
+	counter->done = 1;
+
+	return counter;
+}
+
+/* Allocates and initializes counter, which doesn't have a thread yet.  Returns
+ * the counter or NULL on error. */
+static vs_counter_t *
+alloc_counter(const vs_layout_t *layout)
+{
+	const int width = (layout->width > 0) ? layout->width : 1;
+	vs_counter_t *const counter = malloc(sizeof(*counter));
+	if(counter == NULL)
+	{
+		return NULL;
+	}
+
+	counter->row = malloc(width*4 + layout->tab_stop + 1);
+	if(counter->row == NULL)
+	{
+		free(counter);
+		return NULL;
+	}
+
+	if(pthread_mutex_init(&counter->lock, NULL) != 0)
+	{
+		free(counter->row);
+		free(counter);
+		return NULL;
+	}
+
+	counter->has_thread = 0;
+	counter->cancelled = 0;
+	counter->matches = NULL;
+	counter->nmatches = 0;
+	counter->cap = 0;
+	counter->total = 0;
+	counter->scanned = 0;
+	counter->done = 0;
+	counter->reported = 0;
+	counter->reported_done = 0;
+	counter->layout = *layout;
+	counter->fl = NULL;
+	counter->literal = NULL;
+	counter->context_free = 0;
+	counter->rows = NULL;
+	counter->nrows = 0;
+	counter->rows_cap = 0;
+	return counter;
+}
+
+void
+vs_counter_free(vs_counter_t *counter)
+{
+	if(counter == NULL)
+	{
+		return;
+	}
+
+	if(counter->has_thread)
+	{
+		pthread_mutex_lock(&counter->lock);
+		counter->cancelled = 1;
+		pthread_mutex_unlock(&counter->lock);
+
+		(void)pthread_join(counter->thread, NULL);
+	}
+
+	if(counter->fl != NULL)
+	{
+		regfree(&counter->re);
+		fl_close(counter->fl);
+	}
+
+	pthread_mutex_destroy(&counter->lock);
+	free(counter->literal);
+	free(counter->matches);
+	free(counter->row);
+	free(counter->rows);
+	free(counter);
+}
+
+/* Entry point of a thread that counts matches in a file. */
+static void *
+count_matches(void *arg)
+{
+	vs_counter_t *const counter = arg;
+	char *buf = NULL;
+	size_t buf_len = 0U;
+	vs_finder_t finder;
+	int line = 0;
+	int complete = 1;
+
+	if(counter->literal != NULL)
+	{
+		vs_finder_init(&finder, counter->fl, counter->literal);
+	}
+
+	while(1)
+	{
+		size_t len;
+		const char *data;
+		int stop;
+
+		if(counter->literal != NULL)
+		{
+			line = vs_finder_next(&finder, line);
+			if(line < 0)
+			{
+				break;
+			}
+		}
+
+		data = fl_get(counter->fl, line, &len);
+		if(data == NULL)
+		{
+			break;
+		}
+
+		if(len + 1U > buf_len)
+		{
+			char *const new_buf = realloc(buf, len + 1U);
+			if(new_buf == NULL)
+			{
+				break;
+			}
+			buf = new_buf;
+			buf_len = len + 1U;
+		}
+		memcpy(buf, data, len);
+		buf[len] = '\0';
+
+		/* Matching is done on a copy of the line, so the lock is needed only to
+		 * publish its results. */
+		if(count_line(counter, &counter->re, buf) != 0)
+		{
+			break;
+		}
+
+		pthread_mutex_lock(&counter->lock);
+		stop = publish_matches(counter, line) || counter->cancelled;
+		counter->scanned = line + 1;
+		pthread_mutex_unlock(&counter->lock);
+
+		if(stop)
+		{
+			break;
+		}
+
+		if(line == INT_MAX)
+		{
+			complete = 0;
+			break;
+		}
+		++line;
+	}
+
+	free(buf);
+
+	/* Reading stops early if file got truncated, in which case counting isn't
+	 * finished. */
+	if(complete && !fl_sync(counter->fl))
+	{
+		pthread_mutex_lock(&counter->lock);
+		counter->done = 1;
+		pthread_mutex_unlock(&counter->lock);
+	}
+	return NULL;
+}
+
+/* Collects screen lines of the line that match into rows field of the
+ * counter.  Doesn't touch fields shared with the thread, so can be called
+ * without holding the lock.  Returns non-zero on memory error, otherwise zero
+ * is returned. */
+static int
+count_line(vs_counter_t *counter, const regex_t *re, const char text[])
+{
+	const vs_layout_t *const layout = &counter->layout;
+	const int width = (layout->width > 0) ? layout->width : 1;
+	int row = 0;
+	char *no_esc = NULL;
+	const char *part = text;
+
+	counter->nrows = 0;
+
+	if(strchr(text, '\033') != NULL)
+	{
+		no_esc = esc_remove(text);
+		if(no_esc == NULL)
+		{
+			return 0;
+		}
+		part = no_esc;
+	}
+	/* Screen lines are pieces of the line unless tabulation is expanded. */
+	else if(counter->context_free && strchr(text, '\t') == NULL &&
+			regexec(re, text, 0, NULL, 0) != 0)
+	{
+		return 0;
+	}
+
+	do
+	{
+		part = expand_tabulation(part, width, layout->tab_stop, counter->row);
+		if(regexec(re, counter->row, 0, NULL, 0) == 0 &&
+				add_row(counter, row) != 0)
+		{
+			free(no_esc);
+			return 1;
+		}
+		++row;
+	}
+	while(layout->wrap && *part != '\0');
+
+	free(no_esc);
+	return 0;
+}
+
+/* Appends matched screen line to rows field of the counter.  Returns non-zero
+ * on error, otherwise zero is returned. */
+static int
+add_row(vs_counter_t *counter, int row)
+{
+	if(counter->nrows == counter->rows_cap)
+	{
+		const int cap = (counter->rows_cap == 0) ? 16 : counter->rows_cap*2;
+		int *const rows = realloc(counter->rows, sizeof(*rows)*cap);
+		if(rows == NULL)
+		{
+			return 1;
+		}
+
+		counter->rows = rows;
+		counter->rows_cap = cap;
+	}
+
+	counter->rows[counter->nrows++] = row;
+	return 0;
+}
+
+/* Adds matches collected by count_line() for the line to the counter.  Must be
+ * called with the lock held if the counter has a thread.  Returns non-zero if
+ * counting should stop, otherwise zero is returned. */
+static int
+publish_matches(vs_counter_t *counter, int line)
+{
+	int i;
+	for(i = 0; i < counter->nrows; ++i)
+	{
+		const vs_pos_t pos = { .line = line, .row = counter->rows[i] };
+
+		if(counter->total == INT_MAX)
+		{
+			return 1;
+		}
+
+		++counter->total;
+		if(add_match(counter, pos) != 0)
+		{
+			/* Positions of the rest of matches won't be available. */
+			counter->cap = -1;
+		}
+	}
+	return 0;
+}
+
+/* Checks whether pattern matches a piece of text only if it matches the whole
+ * text, which isn't the case for anchors and word boundaries.  Returns non-zero
+ * if so, otherwise zero is returned. */
+static int
+is_context_free(const char pattern[])
+{
+	if(strpbrk(pattern, "^$") != NULL)
+	{
+		return 0;
+	}
+
+	while((pattern = strchr(pattern, '\\')) != NULL)
+	{
+		if(pattern[1] == '\0')
+		{
+			break;
+		}
+		if(strchr("<>bB`'", pattern[1]) != NULL)
+		{
+			return 0;
+		}
+		pattern += 2;
+	}
+	return 1;
+}
+
+/* Remembers position of a match.  Returns non-zero if it wasn't remembered,
+ * otherwise zero is returned. */
+static int
+add_match(vs_counter_t *counter, vs_pos_t pos)
+{
+	if(counter->cap < 0)
+	{
+		return 1;
+	}
+
+	if(counter->nmatches == counter->cap)
+	{
+		const int cap = (counter->cap == 0) ? 64 : counter->cap*2;
+		vs_pos_t *matches;
+
+		if(cap > MAX_CACHED_MATCHES)
+		{
+			return 1;
+		}
+
+		matches = realloc(counter->matches, sizeof(*matches)*cap);
+		if(matches == NULL)
+		{
+			return 1;
+		}
+
+		counter->matches = matches;
+		counter->cap = cap;
+	}
+
+	counter->matches[counter->nmatches++] = pos;
+	return 0;
+}
+
+int
+vs_counter_fits(const vs_counter_t *counter, const vs_layout_t *layout)
+{
+	return counter->layout.width == layout->width
+	    && counter->layout.tab_stop == layout->tab_stop
+	    && counter->layout.wrap == layout->wrap;
+}
+
+void
+vs_counter_stats(vs_counter_t *counter, vs_pos_t pos, int *index, int *total,
+		int *done)
+{
+	pthread_mutex_lock(&counter->lock);
+
+	*total = counter->total;
+	*done = counter->done;
+
+	/* Number of matches before the position is known if all of them are
+	 * remembered. */
+	*index = -1;
+	if(counter->done || pos.line < counter->scanned)
+	{
+		const int i = find_pos(counter, pos);
+		if(counter->cap >= 0 || i < counter->nmatches)
+		{
+			*index = i;
+		}
+	}
+
+	pthread_mutex_unlock(&counter->lock);
+}
+
+int
+vs_counter_find(vs_counter_t *counter, vs_pos_t pos, int backward,
+		vs_pos_t *match)
+{
+	int result = -1;
+	int i;
+
+	pthread_mutex_lock(&counter->lock);
+
+	i = find_pos(counter, pos);
+	if(backward)
+	{
+		const int known = counter->done || pos.line < counter->scanned;
+		if(known && (counter->cap >= 0 || i < counter->nmatches))
+		{
+			result = (i > 0);
+			if(result)
+			{
+				*match = counter->matches[i - 1];
+			}
+		}
+	}
+	else
+	{
+		if(i < counter->nmatches && pos_cmp(counter->matches[i], pos) == 0)
+		{
+			++i;
+		}
+
+		if(i < counter->nmatches)
+		{
+			*match = counter->matches[i];
+			result = 1;
+		}
+		else if(counter->done && counter->cap >= 0)
+		{
+			result = 0;
+		}
+	}
+
+	pthread_mutex_unlock(&counter->lock);
+	return result;
+}
+
+int
+vs_counter_progressed(vs_counter_t *counter)
+{
+	int progressed;
+
+	pthread_mutex_lock(&counter->lock);
+	progressed = (counter->reported != counter->total)
+	          || (counter->reported_done != counter->done);
+	counter->reported = counter->total;
+	counter->reported_done = counter->done;
+	pthread_mutex_unlock(&counter->lock);
+
+	return progressed;
+}
+
+/* Finds number of remembered matches that precede the position.  Returns the
+ * number. */
+static int
+find_pos(const vs_counter_t *counter, vs_pos_t pos)
+{
+	int lo = 0;
+	int hi = counter->nmatches;
+	while(lo < hi)
+	{
+		const int mid = lo + (hi - lo)/2;
+		if(pos_cmp(counter->matches[mid], pos) < 0)
+		{
+			lo = mid + 1;
+		}
+		else
+		{
+			hi = mid;
+		}
+	}
+	return lo;
+}
+
+/* Compares two positions.  Returns negative number, zero or positive number
+ * if the first one is less than, equal to or greater than the second one. */
+static int
+pos_cmp(vs_pos_t a, vs_pos_t b)
+{
+	if(a.line != b.line)
+	{
+		return (a.line < b.line) ? -1 : 1;
+	}
+	if(a.row != b.row)
+	{
+		return (a.row < b.row) ? -1 : 1;
+	}
+	return 0;
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
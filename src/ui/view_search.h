@@ -0,0 +1,123 @@
+/* vifm
+ * Copyright (C) 2026 agent.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef VIFM__UI__VIEW_SEARCH_H__
+#define VIFM__UI__VIEW_SEARCH_H__
+
+#include <regex.h> /* regex_t */
+
+#include <stddef.h> /* size_t */
+
+#include "../utils/file_lines.h"
+
+/* Search in contents of view mode.  Each screen line of a wrapped line is
+ * matched separately, so a match is identified by line and screen line.
+ * Patterns without special characters are looked up in lazily indexed files
+ * as plain strings and only lines that contain them are matched.  Matches can
+ * be counted in background, which also caches their positions. */
+
+/* Parameters of breaking lines into screen lines. */
+typedef struct
+{
+	int width;    /* Width of the view. */
+	int tab_stop; /* Width of tabulation. */
+	int wrap;     /* Whether lines are wrapped. */
+}
+vs_layout_t;
+
+/* Position of a match. */
+typedef struct
+{
+	int line; /* Number of the line. */
+	int row;  /* Number of screen line within the line. */
+}
+vs_pos_t;
+
+/* State of looking up a plain string in a file. */
+typedef struct
+{
+	file_lines_t *fl;    /* File to look in. */
+	const char *literal; /* String to look for. */
+	size_t len;          /* Length of the literal. */
+	size_t anchor;       /* Index of byte of the literal to look for first. */
+	size_t lit_from;     /* Where last lookup of the string started. */
+	size_t lit_at;       /* Where the string was found or size of the file. */
+	size_t esc_from;     /* Where last lookup of escape character started. */
+	size_t esc_at;       /* Where escape character was found or file size. */
+}
+vs_finder_t;
+
+/* Declaration of opaque match counter type. */
+typedef struct vs_counter_t vs_counter_t;
+
+/* Matches screen lines of the line from first to last (inclusive) against the
+ * regular expression.  Returns number of the first matching screen line (last
+ * one when searching backward) or -1 if there is none. */
+int vs_match_line(const regex_t *re, const vs_layout_t *layout,
+		const char line[], int first, int last, int backward);
+
+/* Checks whether a pattern compiled with specified flags matches only itself
+ * and can be looked up as a plain string.  Returns non-zero if so, otherwise
+ * zero is returned. */
+int vs_is_literal(const char pattern[], int cflags);
+
+/* Initializes finder of the literal in the file. */
+void vs_finder_init(vs_finder_t *finder, file_lines_t *fl,
+		const char literal[]);
+
+/* Finds the first line starting with the specified one that might contain a
+ * match of the literal.  Returns the line number or -1 if there is none. */
+int vs_finder_next(vs_finder_t *finder, int from);
+
+/* Starts counting matches of the pattern in a file in background.  Returns the
+ * counter or NULL on error. */
+vs_counter_t * vs_counter_start(const char path[], const char pattern[],
+		int cflags, const vs_layout_t *layout);
+
+/* Counts matches of the regular expression in lines right away.  Returns the
+ * counter or NULL on error. */
+vs_counter_t * vs_counter_count(char *lines[], int nlines, const regex_t *re,
+		const vs_layout_t *layout);
+
+/* Stops counting and frees the counter.  The counter can be NULL. */
+void vs_counter_free(vs_counter_t *counter);
+
+/* Checks whether counter was made for the layout.  Returns non-zero if so,
+ * otherwise zero is returned. */
+int vs_counter_fits(const vs_counter_t *counter, const vs_layout_t *layout);
+
+/* Retrieves number of matches found so far and whether all of them are found.
+ * *index is set to number of matches before the position or to -1 if it's not
+ * known yet. */
+void vs_counter_stats(vs_counter_t *counter, vs_pos_t pos, int *index,
+		int *total, int *done);
+
+/* Looks up a found match that follows (or precedes) the position.  Returns 1
+ * and sets *match if it's found, 0 if there is no such match and -1 if it's
+ * not known yet. */
+int vs_counter_find(vs_counter_t *counter, vs_pos_t pos, int backward,
+		vs_pos_t *match);
+
+/* Checks whether more matches were found or counting was finished since the
+ * last call.  Returns non-zero if so, otherwise zero is returned. */
+int vs_counter_progressed(vs_counter_t *counter);
+
+#endif /* VIFM__UI__VIEW_SEARCH_H__ */
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
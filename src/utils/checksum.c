@@ -0,0 +1,368 @@
+/* vifm
+ * Copyright (C) 2026 agent.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "checksum.h"
+
+#include <stddef.h> /* size_t */
+#include <stdint.h> /* uint32_t uint64_t */
+#include <string.h> /* memcpy() memset() */
+
+/* Size of a block processed at once by XXH64. */
+#define XXH64_BLOCK 32U
+
+/* Size of a block processed at once by SHA-256. */
+#define SHA256_BLOCK 64U
+
+/* Primes of XXH64. */
+#define P1 UINT64_C(0x9E3779B185EBCA87)
+#define P2 UINT64_C(0xC2B2AE3D27D4EB4F)
+#define P3 UINT64_C(0x165667B19E3779F9)
+#define P4 UINT64_C(0x85EBCA77C2B2AE63)
+#define P5 UINT64_C(0x27D4EB2F165667C5)
+
+static void xxh64_block(uint64_t acc[4], const unsigned char data[]);
+static size_t xxh64_final(checksum_t *cs, unsigned char digest[]);
+static uint64_t xxh64_round(uint64_t acc, uint64_t input);
+static uint64_t xxh64_merge(uint64_t acc, uint64_t val);
+static void sha256_block(uint32_t hash[8], const unsigned char data[]);
+static size_t sha256_final(checksum_t *cs, unsigned char digest[]);
+static uint64_t rotl64(uint64_t x, int n);
+static uint32_t rotr32(uint32_t x, int n);
+static uint64_t read_le64(const unsigned char data[]);
+static uint32_t read_le32(const unsigned char data[]);
+static uint32_t read_be32(const unsigned char data[]);
+static void write_be64(unsigned char data[], uint64_t val);
+
+/* Round constants of SHA-256. */
+static const uint32_t sha256_k[64] = {
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1,
+	0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+	0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786,
+	0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+	0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147,
+	0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+	0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b,
+	0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+	0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a,
+	0x5b9cca4f, 0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+	0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+/* Initial hash value of SHA-256. */
+static const uint32_t sha256_init[8] = {
+	0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c,
+	0x1f83d9ab, 0x5be0cd19,
+};
+
+void
+checksum_init(checksum_t *cs, ChecksumKind kind)
+{
+	cs->kind = kind;
+	cs->total_len = 0U;
+	cs->buf_len = 0U;
+
+	if(kind == CK_XXH64)
+	{
+		cs->state.xxh64[0] = P1 + P2;
+		cs->state.xxh64[1] = P2;
+		cs->state.xxh64[2] = 0U;
+		cs->state.xxh64[3] = -P1;
+	}
+	else
+	{
+		memcpy(cs->state.sha256, sha256_init, sizeof(sha256_init));
+	}
+}
+
+void
+checksum_update(checksum_t *cs, const void *data, size_t len)
+{
+	const unsigned char *p = data;
+	const size_t block = (cs->kind == CK_XXH64) ? XXH64_BLOCK : SHA256_BLOCK;
+
+	cs->total_len += len;
+
+	/* Complete previously buffered block first. */
+	if(cs->buf_len != 0U)
+	{
+		const size_t n = (len < block - cs->buf_len) ? len : block - cs->buf_len;
+		memcpy(cs->buf + cs->buf_len, p, n);
+		cs->buf_len += n;
+		p += n;
+		len -= n;
+
+		if(cs->buf_len != block)
+		{
+			return;
+		}
+
+		if(cs->kind == CK_XXH64)
+		{
+			xxh64_block(cs->state.xxh64, cs->buf);
+		}
+		else
+		{
+			sha256_block(cs->state.sha256, cs->buf);
+		}
+		cs->buf_len = 0U;
+	}
+
+	for(; len >= block; p += block, len -= block)
+	{
+		if(cs->kind == CK_XXH64)
+		{
+			xxh64_block(cs->state.xxh64, p);
+		}
+		else
+		{
+			sha256_block(cs->state.sha256, p);
+		}
+	}
+
+	memcpy(cs->buf, p, len);
+	cs->buf_len = len;
+}
+
+size_t
+checksum_final(checksum_t *cs, unsigned char digest[CHECKSUM_MAX_LEN])
+{
+	return (cs->kind == CK_XXH64) ? xxh64_final(cs, digest)
+	                              : sha256_final(cs, digest);
+}
+
+/* Processes single block of XXH64 input. */
+static void
+xxh64_block(uint64_t acc[4], const unsigned char data[])
+{
+	acc[0] = xxh64_round(acc[0], read_le64(data));
+	acc[1] = xxh64_round(acc[1], read_le64(data + 8));
+	acc[2] = xxh64_round(acc[2], read_le64(data + 16));
+	acc[3] = xxh64_round(acc[3], read_le64(data + 24));
+}
+
+/* Finishes computation of XXH64.  Returns length of the digest. */
+static size_t
+xxh64_final(checksum_t *cs, unsigned char digest[])
+{
+	const uint64_t *const acc = cs->state.xxh64;
+	const unsigned char *p = cs->buf;
+	const unsigned char *const end = cs->buf + cs->buf_len;
+	uint64_t h;
+
+	if(cs->total_len >= XXH64_BLOCK)
+	{
+		h = rotl64(acc[0], 1) + rotl64(acc[1], 7) + rotl64(acc[2], 12) +
+			rotl64(acc[3], 18);
+		h = xxh64_merge(h, acc[0]);
+		h = xxh64_merge(h, acc[1]);
+		h = xxh64_merge(h, acc[2]);
+		h = xxh64_merge(h, acc[3]);
+	}
+	else
+	{
+		h = P5;
+	}
+
+	h += cs->total_len;
+
+	for(; p + 8 <= end; p += 8)
+	{
+		h ^= xxh64_round(0U, read_le64(p));
+		h = rotl64(h, 27)*P1 + P4;
+	}
+	if(p + 4 <= end)
+	{
+		h ^= read_le32(p)*P1;
+		h = rotl64(h, 23)*P2 + P3;
+		p += 4;
+	}
+	for(; p < end; ++p)
+	{
+		h ^= *p*P5;
+		h = rotl64(h, 11)*P1;
+	}
+
+	h ^= h >> 33;
+	h *= P2;
+	h ^= h >> 29;
+	h *= P3;
+	h ^= h >> 32;
+
+	write_be64(digest, h);
+	return 8U;
+}
+
+/* Mixes next piece of input into accumulator of XXH64.  Returns new value of
+ * the accumulator. */
+static uint64_t
+xxh64_round(uint64_t acc, uint64_t input)
+{
+	acc += input*P2;
+	acc = rotl64(acc, 31);
+	return acc*P1;
+}
+
+/* Merges accumulator into final hash of XXH64.  Returns new value of the
+ * hash. */
+static uint64_t
+xxh64_merge(uint64_t acc, uint64_t val)
+{
+	acc ^= xxh64_round(0U, val);
+	return acc*P1 + P4;
+}
+
+/* Processes single block of SHA-256 input. */
+static void
+sha256_block(uint32_t hash[8], const unsigned char data[])
+{
+	uint32_t w[64];
+	uint32_t a, b, c, d, e, f, g, h;
+	int i;
+
+	for(i = 0; i < 16; ++i)
+	{
+		w[i] = read_be32(data + 4*i);
+	}
+	for(i = 16; i < 64; ++i)
+	{
+		const uint32_t s0 = rotr32(w[i - 15], 7) ^ rotr32(w[i - 15], 18) ^
+			(w[i - 15] >> 3);
+		const uint32_t s1 = rotr32(w[i - 2], 17) ^ rotr32(w[i - 2], 19) ^
+			(w[i - 2] >> 10);
+		w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+	}
+
+	a = hash[0];
+	b = hash[1];
+	c = hash[2];
+	d = hash[3];
+	e = hash[4];
+	f = hash[5];
+	g = hash[6];
+	h = hash[7];
+
+	for(i = 0; i < 64; ++i)
+	{
+		const uint32_t s1 = rotr32(e, 6) ^ rotr32(e, 11) ^ rotr32(e, 25);
+		const uint32_t ch = (e & f) ^ (~e & g);
+		const uint32_t t1 = h + s1 + ch + sha256_k[i] + w[i];
+		const uint32_t s0 = rotr32(a, 2) ^ rotr32(a, 13) ^ rotr32(a, 22);
+		const uint32_t maj = (a & b) ^ (a & c) ^ (b & c);
+		const uint32_t t2 = s0 + maj;
+
+		h = g;
+		g = f;
+		f = e;
+		e = d + t1;
+		d = c;
+		c = b;
+		b = a;
+		a = t1 + t2;
+	}
+
+	hash[0] += a;
+	hash[1] += b;
+	hash[2] += c;
+	hash[3] += d;
+	hash[4] += e;
+	hash[5] += f;
+	hash[6] += g;
+	hash[7] += h;
+}
+
+/* Finishes computation of SHA-256.  Returns length of the digest. */
+static size_t
+sha256_final(checksum_t *cs, unsigned char digest[])
+{
+	int i;
+	const uint64_t bit_len = cs->total_len*8U;
+
+	/* Padding is a single bit followed by zeroes and length of the message. */
+	cs->buf[cs->buf_len++] = 0x80;
+	if(cs->buf_len > SHA256_BLOCK - 8U)
+	{
+		memset(cs->buf + cs->buf_len, 0, SHA256_BLOCK - cs->buf_len);
+		sha256_block(cs->state.sha256, cs->buf);
+		cs->buf_len = 0U;
+	}
+	memset(cs->buf + cs->buf_len, 0, SHA256_BLOCK - 8U - cs->buf_len);
+	write_be64(cs->buf + SHA256_BLOCK - 8U, bit_len);
+	sha256_block(cs->state.sha256, cs->buf);
+
+	for(i = 0; i < 8; ++i)
+	{
+		const uint32_t v = cs->state.sha256[i];
+		digest[4*i + 0] = v >> 24;
+		digest[4*i + 1] = v >> 16;
+		digest[4*i + 2] = v >> 8;
+		digest[4*i + 3] = v;
+	}
+	return 32U;
+}
+
+/* Rotates 64-bit value left. */
+static uint64_t
+rotl64(uint64_t x, int n)
+{
+	return (x << n) | (x >> (64 - n));
+}
+
+/* Rotates 32-bit value right. */
+static uint32_t
+rotr32(uint32_t x, int n)
+{
+	return (x >> n) | (x << (32 - n));
+}
+
+/* Reads little-endian 64-bit value. */
+static uint64_t
+read_le64(const unsigned char data[])
+{
+	return (uint64_t)read_le32(data) | ((uint64_t)read_le32(data + 4) << 32);
+}
+
+/* Reads little-endian 32-bit value. */
+static uint32_t
+read_le32(const unsigned char data[])
+{
+	return (uint32_t)data[0] | ((uint32_t)data[1] << 8) |
+		((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24);
+}
+
+/* Reads big-endian 32-bit value. */
+static uint32_t
+read_be32(const unsigned char data[])
+{
+	return ((uint32_t)data[0] << 24) | ((uint32_t)data[1] << 16) |
+		((uint32_t)data[2] << 8) | (uint32_t)data[3];
+}
+
+/* Writes big-endian 64-bit value. */
+static void
+write_be64(unsigned char data[], uint64_t val)
+{
+	int i;
+	for(i = 7; i >= 0; --i)
+	{
+		data[i] = val;
+		val >>= 8;
+	}
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
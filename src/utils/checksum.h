@@ -0,0 +1,68 @@
+/* vifm
+ * Copyright (C) 2026 agent.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef VIFM__UTILS__CHECKSUM_H__
+#define VIFM__UTILS__CHECKSUM_H__
+
+#include <stddef.h> /* size_t */
+#include <stdint.h> /* uint32_t uint64_t */
+
+/* Incremental computation of checksums of data streams. */
+
+/* Maximum length of a digest in bytes. */
+#define CHECKSUM_MAX_LEN 32
+
+/* Kind of checksum. */
+typedef enum
+{
+	CK_XXH64,  /* Fast non-cryptographic 64-bit hash (XXH64 with zero seed). */
+	CK_SHA256, /* SHA-256. */
+}
+ChecksumKind;
+
+/* State of checksum computation. */
+typedef struct
+{
+	ChecksumKind kind;     /* Kind of the checksum. */
+	uint64_t total_len;    /* Number of bytes processed so far. */
+	unsigned char buf[64]; /* Data that doesn't fill a whole block yet. */
+	size_t buf_len;        /* Number of bytes in the buf. */
+
+	union
+	{
+		uint64_t xxh64[4];  /* Accumulators of XXH64. */
+		uint32_t sha256[8]; /* Intermediate hash of SHA-256. */
+	}
+	state;
+}
+checksum_t;
+
+/* Starts computation of checksum of the kind. */
+void checksum_init(checksum_t *cs, ChecksumKind kind);
+
+/* Processes next piece of the data stream. */
+void checksum_update(checksum_t *cs, const void *data, size_t len);
+
+/* Finishes computation and writes digest in big-endian form.  Returns length of
+ * the digest. */
+size_t checksum_final(checksum_t *cs, unsigned char digest[CHECKSUM_MAX_LEN]);
+
+#endif /* VIFM__UTILS__CHECKSUM_H__ */
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,264 @@
+/* vifm
+ * Copyright (C) 2026 agent.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "dirents.h"
+
+#ifdef __linux__
+#include <sys/syscall.h> /* SYS_getdents64 */
+#endif
+#ifndef _WIN32
+#include <dirent.h> /* DIR DT_* closedir() dirent fdopendir() readdir() */
+#endif
+#include <unistd.h> /* close() dup() syscall() */
+
+#include <stddef.h> /* NULL size_t */
+#include <stdint.h> /* int64_t uint64_t */
+#include <stdlib.h> /* free() realloc() */
+#include <string.h> /* memcpy() strlen() */
+
+#include "path.h"
+
+#if defined(__linux__) && defined(SYS_getdents64)
+#define USE_GETDENTS
+#endif
+
+/* Size of buffer for a single read of directory entries.  Each read fills
+ * buffer with as many entries as fit in it. */
+#define CHUNK_SIZE (64*1024)
+
+/* Initial size of buffer of packed entries. */
+#define INITIAL_CAPACITY 1024
+
+#ifdef USE_GETDENTS
+/* Record returned by getdents64 system call. */
+struct linux_dirent64
+{
+	uint64_t d_ino;          /* Inode number. */
+	int64_t d_off;           /* Offset of the next record. */
+	unsigned short d_reclen; /* Size of this record. */
+	unsigned char d_type;    /* Type of the entry. */
+	char d_name[];           /* Null-terminated name of the entry. */
+};
+
+static int read_getdents(dirents_t *list, int fd);
+#elif !defined(_WIN32)
+static int read_readdir(dirents_t *list, int fd);
+#endif
+
+#ifndef _WIN32
+static int append_entry(dirents_t *list, const char name[], DirEntType type);
+static DirEntType map_type(unsigned char type);
+#endif
+
+int
+dirents_read(dirents_t *list, int fd)
+{
+	list->len = 0U;
+	list->nreads = 0;
+	list->nallocs = 0;
+
+#if defined(USE_GETDENTS)
+	return read_getdents(list, fd);
+#elif !defined(_WIN32)
+	return read_readdir(list, fd);
+#else
+	/* Directories can't be read via descriptors on Windows. */
+	(void)fd;
+	return 1;
+#endif
+}
+
+#ifdef USE_GETDENTS
+
+/* Reads directory by calling getdents64 system call directly, which avoids
+ * per-entry overhead of readdir() and lets us pick size of the buffer.  Returns
+ * zero on success, otherwise non-zero is returned. */
+static int
+read_getdents(dirents_t *list, int fd)
+{
+	/* The union aligns the buffer for records. */
+	union
+	{
+		uint64_t align;
+		char data[CHUNK_SIZE];
+	}
+	chunk;
+
+	while(1)
+	{
+		long offset;
+		const long n = syscall(SYS_getdents64, fd, chunk.data, sizeof(chunk.data));
+		++list->nreads;
+
+		if(n <= 0)
+		{
+			return (n < 0);
+		}
+
+		for(offset = 0L; offset < n; )
+		{
+			const struct linux_dirent64 *const d = (void *)&chunk.data[offset];
+			offset += d->d_reclen;
+
+			if(is_builtin_dir(d->d_name))
+			{
+				continue;
+			}
+
+			if(append_entry(list, d->d_name, map_type(d->d_type)) != 0)
+			{
+				return 1;
+			}
+		}
+	}
+}
+
+#elif !defined(_WIN32)
+
+/* Reads directory via readdir() on a duplicate of the descriptor.  Returns zero
+ * on success, otherwise non-zero is returned. */
+static int
+read_readdir(dirents_t *list, int fd)
+{
+	DIR *dir;
+	struct dirent *d;
+	int result = 0;
+
+	const int dup_fd = dup(fd);
+	if(dup_fd < 0)
+	{
+		return 1;
+	}
+
+	dir = fdopendir(dup_fd);
+	if(dir == NULL)
+	{
+		(void)close(dup_fd);
+		return 1;
+	}
+
+	++list->nreads;
+	while((d = readdir(dir)) != NULL)
+	{
+		if(is_builtin_dir(d->d_name))
+		{
+			continue;
+		}
+
+#ifdef DT_DIR
+		result = append_entry(list, d->d_name, map_type(d->d_type));
+#else
+		result = append_entry(list, d->d_name, DET_UNKNOWN);
+#endif
+		if(result != 0)
+		{
+			break;
+		}
+	}
+
+	(void)closedir(dir);
+	return result;
+}
+
+#endif
+
+#ifndef _WIN32
+
+/* Packs an entry at the end of the list.  Returns zero on success, otherwise
+ * non-zero is returned. */
+static int
+append_entry(dirents_t *list, const char name[], DirEntType type)
+{
+	const size_t name_len = strlen(name);
+	const size_t size = 1U + name_len + 1U;
+
+	if(list->len + size > list->capacity)
+	{
+		char *buf;
+		size_t capacity = (list->capacity == 0U) ? INITIAL_CAPACITY
+		                                         : list->capacity;
+		while(list->len + size > capacity)
+		{
+			capacity *= 2U;
+		}
+
+		buf = realloc(list->buf, capacity);
+		if(buf == NULL)
+		{
+			return 1;
+		}
+
+		list->buf = buf;
+		list->capacity = capacity;
+		++list->nallocs;
+	}
+
+	list->buf[list->len] = (char)type;
+	memcpy(&list->buf[list->len + 1U], name, name_len + 1U);
+	list->len += size;
+	return 0;
+}
+
+/* Maps d_type field of directory entry onto our type.  Returns the type. */
+static DirEntType
+map_type(unsigned char type)
+{
+#ifdef DT_DIR
+	switch(type)
+	{
+		case DT_DIR:     return DET_DIR;
+		case DT_LNK:     return DET_LINK;
+		case DT_UNKNOWN: return DET_UNKNOWN;
+
+		default:
+			return DET_OTHER;
+	}
+#else
+	return DET_UNKNOWN;
+#endif
+}
+
+#endif
+
+const char *
+dirents_next(const dirents_t *list, size_t *pos, DirEntType *type)
+{
+	const char *name;
+
+	if(*pos >= list->len)
+	{
+		return NULL;
+	}
+
+	*type = (DirEntType)(unsigned char)list->buf[*pos];
+	name = &list->buf[*pos + 1U];
+	*pos += 1U + strlen(name) + 1U;
+	return name;
+}
+
+void
+dirents_free(dirents_t *list)
+{
+	free(list->buf);
+	list->buf = NULL;
+	list->len = 0U;
+	list->capacity = 0U;
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
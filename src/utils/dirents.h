@@ -0,0 +1,65 @@
+/* vifm
+ * Copyright (C) 2026 agent.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef VIFM__UTILS__DIRENTS_H__
+#define VIFM__UTILS__DIRENTS_H__
+
+#include <stddef.h> /* size_t */
+
+/* Bulk reading of directory entries relative to descriptor of a directory.
+ * Entries are read in big chunks and packed into a buffer that is reused
+ * between reads, so no memory is allocated per entry.  Reading isn't
+ * supported on Windows. */
+
+/* Type of a directory entry as reported by the file system. */
+typedef enum
+{
+	DET_UNKNOWN, /* Type isn't known, it needs to be queried. */
+	DET_DIR,     /* A directory. */
+	DET_LINK,    /* A symbolic link. */
+	DET_OTHER,   /* Anything else. */
+}
+DirEntType;
+
+/* List of entries of a directory.  Should be zero-initialized. */
+typedef struct
+{
+	char *buf;       /* Packed entries: type byte followed by name and NUL. */
+	size_t len;      /* Number of used bytes of the buffer. */
+	size_t capacity; /* Size of the buffer. */
+	int nreads;      /* Number of system calls made by the last read. */
+	int nallocs;     /* Number of allocations made by the last read. */
+}
+dirents_t;
+
+/* Replaces contents of the list with entries of directory opened as fd,
+ * excluding "." and "..".  The fd isn't closed.  Returns zero on success,
+ * otherwise non-zero is returned. */
+int dirents_read(dirents_t *list, int fd);
+
+/* Iterates over entries of the list, *pos should be zero initially.  Returns
+ * name of the next entry and sets *type, or returns NULL at the end. */
+const char * dirents_next(const dirents_t *list, size_t *pos, DirEntType *type);
+
+/* Frees resources of the list, which can be reused afterwards. */
+void dirents_free(dirents_t *list);
+
+#endif /* VIFM__UTILS__DIRENTS_H__ */
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,688 @@
+/* vifm
+ * Copyright (C) 2026 agent.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+/* Each directory of the subtree is a task that lists the directory, accounts
+ * its files and spawns tasks for subdirectories.  Every worker has its own
+ * queue of tasks, takes tasks from its end (depth-first, which keeps number of
+ * queued tasks low) and steals from the beginning of queues of other workers
+ * when it runs out of work (this way big subtrees get split).
+ *
+ * A directory is finished when its listing is done and all of its
+ * subdirectories are finished.  At that point its statistics are reported and
+ * added to statistics of the parent. */
+
+#include "dirsize.h"
+
+#include <pthread.h> /* PTHREAD_* pthread_* */
+#include <sys/stat.h> /* S_ISDIR() S_ISLNK() fstatat() stat */
+#include <sys/time.h> /* gettimeofday() timeval */
+#include <dirent.h> /* DIR dirent dirfd() */
+#ifndef _WIN32
+#include <fcntl.h> /* AT_SYMLINK_NOFOLLOW O_* open() */
+#endif
+#include <unistd.h> /* _SC_NPROCESSORS_ONLN close() sysconf() */
+
+#include <stddef.h> /* NULL size_t */
+#include <stdint.h> /* uint64_t */
+#include <stdlib.h> /* free() malloc() realloc() */
+#include <string.h> /* memmove() strdup() */
+#include <time.h> /* timespec */
+
+#include "../compat/os.h"
+#include "dirents.h"
+#include "fs.h"
+#include "macros.h"
+#include "path.h"
+#include "str.h"
+
+/* Maximum number of threads to use. */
+#define MAX_WORKERS 8
+
+/* Interval between calls of progress callback in milliseconds. */
+#define PROGRESS_INTERVAL_MS 100
+
+/* Wrappers for atomic accesses. */
+#define ADD(var, val) (void)__atomic_add_fetch(&(var), (val), __ATOMIC_RELAXED)
+#define LOAD(var) __atomic_load_n(&(var), __ATOMIC_RELAXED)
+
+/* Directory that is being processed. */
+typedef struct dir_t
+{
+	char *path;             /* Full path to the directory. */
+	struct dir_t *parent;   /* Parent directory or NULL for the root. */
+	int pending;            /* Listing plus number of unfinished subdirs. */
+	int failed;             /* Whether directory couldn't be read. */
+	dirsize_stats_t stats;  /* Statistics of the subtree. */
+}
+dir_t;
+
+/* Queue of tasks of a worker. */
+typedef struct
+{
+	dir_t **items;        /* Queued directories. */
+	size_t begin;         /* Index of the first queued item. */
+	size_t end;           /* Index past the last queued item. */
+	size_t capacity;      /* Size of items array. */
+	pthread_mutex_t lock; /* Protects this structure. */
+}
+queue_t;
+
+/* State of a calculation. */
+typedef struct
+{
+	const dirsize_params_t *params; /* Parameters of the calculation. */
+	queue_t queues[MAX_WORKERS];    /* Queues of workers. */
+	int nworkers;                   /* Number of workers (and queues). */
+
+	pthread_mutex_t lock; /* Protects nqueued and finished fields. */
+	pthread_cond_t cond;  /* Signals changes of nqueued and finished fields. */
+	int nqueued;          /* Number of queued tasks. */
+	int finished;         /* Whether all tasks are done. */
+
+	int cancelled;          /* Whether calculation was cancelled. */
+	dirsize_stats_t totals; /* Statistics collected so far. */
+
+	dirsize_stats_t result; /* Statistics of the root, when finished. */
+	int failed;             /* Whether the root couldn't be read. */
+}
+walk_t;
+
+/* Argument of worker threads. */
+typedef struct
+{
+	walk_t *walk; /* State of calculation. */
+	int index;    /* Index of the worker. */
+}
+worker_arg_t;
+
+static int get_workers(void);
+static void run_in_threads(walk_t *walk);
+static void * worker_thread(void *arg);
+static void run_worker(walk_t *walk, int index, int report_progress);
+static int report_progress(walk_t *walk);
+static void process_dir(walk_t *walk, int index, dir_t *dir,
+		dirents_t *list);
+static void add_subdir(walk_t *walk, int index, dir_t *dir, const char name[]);
+static void add_file(walk_t *walk, dir_t *dir, uint64_t size);
+static void release_dir(walk_t *walk, dir_t *dir);
+static dir_t * make_dir(char path[], dir_t *parent);
+static void free_dir(dir_t *dir);
+static int push_task(walk_t *walk, int index, dir_t *dir);
+static dir_t * take_task(walk_t *walk, int index);
+static char * join_paths(const char base[], const char name[]);
+static void get_deadline(struct timespec *ts);
+TSTATIC void dirsize_force_workers(int count);
+
+/* Number of workers to use instead of the default, zero means no override. */
+static int forced_workers;
+
+int
+dirsize_calc(const char path[], const dirsize_params_t *params,
+		dirsize_stats_t *stats)
+{
+	static const dirsize_stats_t empty_stats;
+
+	int i;
+	walk_t walk = {
+		.params = params,
+		.nworkers = get_workers(),
+		.lock = PTHREAD_MUTEX_INITIALIZER,
+		.cond = PTHREAD_COND_INITIALIZER,
+		.failed = 1,
+	};
+
+	char *const root_path = strdup(path);
+	dir_t *const root = (root_path == NULL) ? NULL : make_dir(root_path, NULL);
+	if(root == NULL)
+	{
+		free(root_path);
+		*stats = empty_stats;
+		return 1;
+	}
+
+	for(i = 0; i < walk.nworkers; ++i)
+	{
+		pthread_mutex_init(&walk.queues[i].lock, NULL);
+	}
+
+	if(push_task(&walk, 0, root) != 0)
+	{
+		free_dir(root);
+	}
+	else if(walk.nworkers == 1)
+	{
+		run_worker(&walk, 0, 1);
+	}
+	else
+	{
+		run_in_threads(&walk);
+	}
+
+	for(i = 0; i < walk.nworkers; ++i)
+	{
+		free(walk.queues[i].items);
+		pthread_mutex_destroy(&walk.queues[i].lock);
+	}
+	pthread_cond_destroy(&walk.cond);
+	pthread_mutex_destroy(&walk.lock);
+
+	*stats = walk.result;
+	return walk.failed || walk.cancelled;
+}
+
+/* Retrieves number of threads to use for calculation.  Returns the number. */
+static int
+get_workers(void)
+{
+#ifdef _SC_NPROCESSORS_ONLN
+	const long ncpus = (forced_workers != 0) ? forced_workers
+	                                         : sysconf(_SC_NPROCESSORS_ONLN);
+#else
+	const long ncpus = (forced_workers != 0) ? forced_workers : 2;
+#endif
+	return MAX(1, MIN(ncpus, MAX_WORKERS));
+}
+
+/* Runs workers in separate threads and reports progress from the current one
+ * until all work is done.  If no thread could be created, does all the work in
+ * the current thread. */
+static void
+run_in_threads(walk_t *walk)
+{
+	pthread_t threads[MAX_WORKERS];
+	worker_arg_t args[MAX_WORKERS];
+	int started[MAX_WORKERS];
+	int nstarted = 0;
+	int i;
+
+	for(i = 0; i < walk->nworkers; ++i)
+	{
+		args[i].walk = walk;
+		args[i].index = i;
+		started[i] = (pthread_create(&threads[i], NULL, &worker_thread,
+					&args[i]) == 0);
+		nstarted += started[i];
+	}
+
+	if(nstarted == 0)
+	{
+		run_worker(walk, 0, 1);
+		return;
+	}
+
+	pthread_mutex_lock(&walk->lock);
+	while(!walk->finished)
+	{
+		struct timespec deadline;
+		get_deadline(&deadline);
+		(void)pthread_cond_timedwait(&walk->cond, &walk->lock, &deadline);
+
+		if(!walk->finished)
+		{
+			pthread_mutex_unlock(&walk->lock);
+			(void)report_progress(walk);
+			pthread_mutex_lock(&walk->lock);
+		}
+	}
+	pthread_mutex_unlock(&walk->lock);
+
+	for(i = 0; i < walk->nworkers; ++i)
+	{
+		if(started[i])
+		{
+			(void)pthread_join(threads[i], NULL);
+		}
+	}
+}
+
+/* Entry point of worker threads.  Returns NULL. */
+static void *
+worker_thread(void *arg)
+{
+	worker_arg_t *const worker_arg = arg;
+	run_worker(worker_arg->walk, worker_arg->index, 0);
+	return NULL;
+}
+
+/* Processes tasks until all of them are done.  Optionally reports progress
+ * between tasks. */
+static void
+run_worker(walk_t *walk, int index, int report)
+{
+	struct timespec deadline;
+	dirents_t list = { .buf = NULL };
+	get_deadline(&deadline);
+
+	while(1)
+	{
+		dir_t *const dir = take_task(walk, index);
+		if(dir == NULL)
+		{
+			pthread_mutex_lock(&walk->lock);
+			while(walk->nqueued == 0 && !walk->finished)
+			{
+				pthread_cond_wait(&walk->cond, &walk->lock);
+			}
+			if(walk->finished)
+			{
+				pthread_mutex_unlock(&walk->lock);
+				break;
+			}
+			pthread_mutex_unlock(&walk->lock);
+			continue;
+		}
+
+		process_dir(walk, index, dir, &list);
+
+		if(report)
+		{
+			struct timeval tv;
+			(void)gettimeofday(&tv, NULL);
+			if(tv.tv_sec > deadline.tv_sec ||
+					(tv.tv_sec == deadline.tv_sec && tv.tv_usec*1000L > deadline.tv_nsec))
+			{
+				(void)report_progress(walk);
+				get_deadline(&deadline);
+			}
+		}
+	}
+
+	dirents_free(&list);
+}
+
+/* Invokes progress callback and handles cancellation request.  Returns non-zero
+ * if calculation is cancelled. */
+static int
+report_progress(walk_t *walk)
+{
+	dirsize_stats_t stats;
+
+	if(walk->params->progress == NULL)
+	{
+		return 0;
+	}
+
+	stats.bytes = LOAD(walk->totals.bytes);
+	stats.nfiles = LOAD(walk->totals.nfiles);
+	stats.ndirs = LOAD(walk->totals.ndirs);
+	if(walk->params->progress(&stats, walk->params->arg))
+	{
+		__atomic_store_n(&walk->cancelled, 1, __ATOMIC_RELAXED);
+		return 1;
+	}
+	return 0;
+}
+
+#ifndef _WIN32
+
+/* Lists the directory spawning tasks for its subdirectories.  The list is a
+ * buffer for entries reused by the worker. */
+static void
+process_dir(walk_t *walk, int index, dir_t *dir, dirents_t *list)
+{
+	const char *name;
+	DirEntType type;
+	size_t pos = 0U;
+
+	const int fd = LOAD(walk->cancelled)
+	             ? -1
+	             : open(dir->path, O_RDONLY | O_DIRECTORY | O_CLOEXEC | O_NOCTTY);
+	if(fd < 0 || dirents_read(list, fd) != 0)
+	{
+		if(fd >= 0)
+		{
+			(void)close(fd);
+		}
+		dir->failed = 1;
+		release_dir(walk, dir);
+		return;
+	}
+
+	while((name = dirents_next(list, &pos, &type)) != NULL)
+	{
+		struct stat st;
+
+		if(LOAD(walk->cancelled))
+		{
+			break;
+		}
+
+		/* Directories are opened by their full path anyway, so don't stat them. */
+		if(type == DET_DIR)
+		{
+			add_subdir(walk, index, dir, name);
+			continue;
+		}
+
+		/* Avoid resolving full path for every file by querying it relative to
+		 * the directory. */
+		if(fstatat(fd, name, &st, AT_SYMLINK_NOFOLLOW) != 0)
+		{
+			continue;
+		}
+
+		if(S_ISDIR(st.st_mode))
+		{
+			add_subdir(walk, index, dir, name);
+		}
+		else if(S_ISLNK(st.st_mode) && !walk->params->count_links)
+		{
+			add_file(walk, dir, 0U);
+		}
+		else if(walk->params->data_only)
+		{
+			add_file(walk, dir, estimate_data_size(st.st_size,
+						(uint64_t)st.st_blocks*512U));
+		}
+		else
+		{
+			add_file(walk, dir, st.st_size);
+		}
+	}
+
+	(void)close(fd);
+
+	release_dir(walk, dir);
+}
+
+#else
+
+/* Lists the directory spawning tasks for its subdirectories. */
+static void
+process_dir(walk_t *walk, int index, dir_t *dir, dirents_t *list)
+{
+	DIR *d;
+	struct dirent *entry;
+
+	d = LOAD(walk->cancelled) ? NULL : os_opendir(dir->path);
+	if(d == NULL)
+	{
+		dir->failed = 1;
+		release_dir(walk, dir);
+		return;
+	}
+
+	while((entry = os_readdir(d)) != NULL)
+	{
+		char *full_path;
+
+		if(is_builtin_dir(entry->d_name))
+		{
+			continue;
+		}
+
+		if(LOAD(walk->cancelled))
+		{
+			break;
+		}
+
+		full_path = join_paths(dir->path, entry->d_name);
+		if(full_path == NULL)
+		{
+			continue;
+		}
+
+		if(entry_is_dir(full_path, entry))
+		{
+			add_subdir(walk, index, dir, entry->d_name);
+		}
+		else
+		{
+			const int skip = is_symlink(full_path) && !walk->params->count_links;
+			add_file(walk, dir, skip ? 0U : get_file_size(full_path));
+		}
+		free(full_path);
+	}
+
+	os_closedir(d);
+
+	release_dir(walk, dir);
+}
+
+#endif
+
+/* Accounts subdirectory of the dir either by using its cached size or by
+ * spawning a task for it. */
+static void
+add_subdir(walk_t *walk, int index, dir_t *dir, const char name[])
+{
+	const dirsize_params_t *const params = walk->params;
+	uint64_t size;
+	dir_t *subdir;
+
+	char *const path = join_paths(dir->path, name);
+	if(path == NULL)
+	{
+		return;
+	}
+
+	if(params->get_cached != NULL && params->get_cached(path, &size, params->arg))
+	{
+		free(path);
+		ADD(dir->stats.bytes, size);
+		ADD(dir->stats.ndirs, 1U);
+		ADD(walk->totals.bytes, size);
+		ADD(walk->totals.ndirs, 1U);
+		return;
+	}
+
+	subdir = make_dir(path, dir);
+	if(subdir == NULL)
+	{
+		free(path);
+		return;
+	}
+
+	ADD(dir->pending, 1);
+	if(push_task(walk, index, subdir) != 0)
+	{
+		subdir->failed = 1;
+		release_dir(walk, subdir);
+	}
+}
+
+/* Accounts a file of the dir. */
+static void
+add_file(walk_t *walk, dir_t *dir, uint64_t size)
+{
+	ADD(dir->stats.bytes, size);
+	ADD(dir->stats.nfiles, 1U);
+	ADD(walk->totals.bytes, size);
+	ADD(walk->totals.nfiles, 1U);
+}
+
+/* Releases one reference to the directory.  Finishes it if that was the last
+ * one, which in turn might finish its parent. */
+static void
+release_dir(walk_t *walk, dir_t *dir)
+{
+	const dirsize_params_t *const params = walk->params;
+
+	while(__atomic_sub_fetch(&dir->pending, 1, __ATOMIC_ACQ_REL) == 0)
+	{
+		dir_t *const parent = dir->parent;
+
+		if(!dir->failed && !LOAD(walk->cancelled) && params->dir_done != NULL)
+		{
+			params->dir_done(dir->path, &dir->stats, params->arg);
+		}
+
+		if(parent == NULL)
+		{
+			walk->result = dir->stats;
+			walk->failed = dir->failed;
+			free_dir(dir);
+
+			pthread_mutex_lock(&walk->lock);
+			walk->finished = 1;
+			pthread_cond_broadcast(&walk->cond);
+			pthread_mutex_unlock(&walk->lock);
+			return;
+		}
+
+		if(!dir->failed)
+		{
+			ADD(parent->stats.bytes, dir->stats.bytes);
+			ADD(parent->stats.nfiles, dir->stats.nfiles);
+			ADD(parent->stats.ndirs, dir->stats.ndirs + 1U);
+			ADD(walk->totals.ndirs, 1U);
+		}
+
+		free_dir(dir);
+		dir = parent;
+	}
+}
+
+/* Allocates directory task taking ownership of the path.  Returns the task or
+ * NULL on error. */
+static dir_t *
+make_dir(char path[], dir_t *parent)
+{
+	static const dirsize_stats_t empty_stats;
+
+	dir_t *const dir = malloc(sizeof(*dir));
+	if(dir == NULL)
+	{
+		return NULL;
+	}
+
+	dir->path = path;
+	dir->parent = parent;
+	dir->pending = 1;
+	dir->failed = 0;
+	dir->stats = empty_stats;
+	return dir;
+}
+
+/* Frees directory task. */
+static void
+free_dir(dir_t *dir)
+{
+	free(dir->path);
+	free(dir);
+}
+
+/* Puts the task into queue of the worker and wakes up an idle worker.  Returns
+ * zero on success, otherwise non-zero is returned. */
+static int
+push_task(walk_t *walk, int index, dir_t *dir)
+{
+	queue_t *const queue = &walk->queues[index];
+
+	pthread_mutex_lock(&queue->lock);
+
+	if(queue->end == queue->capacity && queue->begin != 0U)
+	{
+		memmove(queue->items, queue->items + queue->begin,
+				sizeof(*queue->items)*(queue->end - queue->begin));
+		queue->end -= queue->begin;
+		queue->begin = 0U;
+	}
+
+	if(queue->end == queue->capacity)
+	{
+		const size_t capacity = (queue->capacity == 0U) ? 64U : queue->capacity*2U;
+		dir_t **const items = realloc(queue->items, sizeof(*items)*capacity);
+		if(items == NULL)
+		{
+			pthread_mutex_unlock(&queue->lock);
+			return 1;
+		}
+		queue->items = items;
+		queue->capacity = capacity;
+	}
+
+	queue->items[queue->end++] = dir;
+
+	pthread_mutex_unlock(&queue->lock);
+
+	pthread_mutex_lock(&walk->lock);
+	++walk->nqueued;
+	pthread_cond_signal(&walk->cond);
+	pthread_mutex_unlock(&walk->lock);
+	return 0;
+}
+
+/* Takes last task of the worker or steals the first one of another worker.
+ * Returns the task or NULL if there are no tasks. */
+static dir_t *
+take_task(walk_t *walk, int index)
+{
+	dir_t *dir = NULL;
+	int i;
+
+	for(i = 0; i < walk->nworkers && dir == NULL; ++i)
+	{
+		queue_t *const queue = &walk->queues[(index + i)%walk->nworkers];
+
+		pthread_mutex_lock(&queue->lock);
+		if(queue->begin != queue->end)
+		{
+			dir = (i == 0) ? queue->items[--queue->end]
+			               : queue->items[queue->begin++];
+			if(queue->begin == queue->end)
+			{
+				queue->begin = 0U;
+				queue->end = 0U;
+			}
+		}
+		pthread_mutex_unlock(&queue->lock);
+	}
+
+	if(dir != NULL)
+	{
+		pthread_mutex_lock(&walk->lock);
+		--walk->nqueued;
+		pthread_mutex_unlock(&walk->lock);
+	}
+
+	return dir;
+}
+
+/* Appends name to the base path.  Returns newly allocated string or NULL on
+ * error. */
+static char *
+join_paths(const char base[], const char name[])
+{
+	return format_str("%s%s%s", base, ends_with_slash(base) ? "" : "/", name);
+}
+
+/* Computes absolute time of the next progress report. */
+static void
+get_deadline(struct timespec *ts)
+{
+	struct timeval tv;
+	(void)gettimeofday(&tv, NULL);
+
+	ts->tv_sec = tv.tv_sec + PROGRESS_INTERVAL_MS/1000;
+	ts->tv_nsec = (tv.tv_usec + (PROGRESS_INTERVAL_MS%1000)*1000L)*1000L;
+	if(ts->tv_nsec >= 1000000000L)
+	{
+		ts->tv_sec += 1;
+		ts->tv_nsec -= 1000000000L;
+	}
+}
+
+TSTATIC void
+dirsize_force_workers(int count)
+{
+	forced_workers = count;
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,81 @@
+/* vifm
+ * Copyright (C) 2026 agent.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef VIFM__UTILS__DIRSIZE_H__
+#define VIFM__UTILS__DIRSIZE_H__
+
+#include <stdint.h> /* uint64_t */
+
+#include "test_helpers.h"
+
+/* Parallel calculation of size of a file system subtree.  Directories are
+ * distributed among several threads, which steal work from each other. */
+
+/* Statistics of a subtree. */
+typedef struct
+{
+	uint64_t bytes;  /* Sum of sizes of files. */
+	uint64_t nfiles; /* Number of non-directory entries. */
+	uint64_t ndirs;  /* Number of directories excluding root of the subtree. */
+}
+dirsize_stats_t;
+
+/* Parameters of calculation.  Callbacks can be NULL.  Callbacks marked as
+ * concurrent are called from worker threads. */
+typedef struct
+{
+	/* Whether sizes of symbolic links are added to bytes. */
+	int count_links;
+
+	/* Whether only data of sparse files is added to bytes instead of their
+	 * size. */
+	int data_only;
+
+	/* Looks up known size of a subdirectory, which is then not traversed.
+	 * Returns non-zero and sets *size if size is known.  Concurrent. */
+	int (*get_cached)(const char path[], uint64_t *size, void *arg);
+
+	/* Reports statistics of a fully processed directory (unreadable ones aren't
+	 * reported).  Called for root of the subtree too.  Concurrent. */
+	void (*dir_done)(const char path[], const dirsize_stats_t *stats,
+			void *arg);
+
+	/* Periodically reports statistics collected so far.  Called in the thread
+	 * that started calculation.  Should return non-zero to cancel it. */
+	int (*progress)(const dirsize_stats_t *stats, void *arg);
+
+	/* Argument passed to callbacks. */
+	void *arg;
+}
+dirsize_params_t;
+
+/* Calculates statistics of directory at the path.  Symbolic links inside the
+ * subtree aren't followed.  Returns zero on success and non-zero on failure to
+ * read root of the subtree or cancellation, *stats is filled in either case. */
+int dirsize_calc(const char path[], const dirsize_params_t *params,
+		dirsize_stats_t *stats);
+
+TSTATIC_DEFS(
+	/* Sets number of threads used for calculation, zero restores default. */
+	void dirsize_force_workers(int count);
+)
+
+#endif /* VIFM__UTILS__DIRSIZE_H__ */
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
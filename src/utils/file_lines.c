@@ -0,0 +1,632 @@
+/* vifm
+ * Copyright (C) 2026 agent.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "file_lines.h"
+
+#ifndef _WIN32
+#include <sys/stat.h> /* fstat() stat() stat */
+#include <fcntl.h> /* O_RDONLY open() */
+#include <unistd.h> /* close() pread() */
+#endif
+
+#include <errno.h> /* EINTR errno */
+#include <stddef.h> /* NULL size_t */
+#include <stdint.h> /* SIZE_MAX */
+#include <stdlib.h> /* free() malloc() realloc() */
+#include <string.h> /* memcmp() */
+
+#include "macros.h"
+
+/* Number of lines between two remembered line offsets. */
+#define CHECKPOINT_STEP 256U
+
+/* Minimal number of bytes read from the file at once. */
+#define BLOCK_SIZE (256U*1024U)
+
+/* Number of bytes at the end of known part of the file that are used to check
+ * whether it was replaced. */
+#define TAIL_SIZE 64U
+
+/* File along with partial index of its lines. */
+struct file_lines_t
+{
+	int fd;                 /* Descriptor of the file. */
+	size_t size;            /* Size of the file as known to the index. */
+
+	char *buf;              /* Piece of the file that was read last. */
+	size_t buf_offset;      /* Offset of the piece. */
+	size_t buf_len;         /* Length of the piece. */
+	size_t buf_cap;         /* Size of the buffer. */
+
+	size_t *checkpoints;    /* Offsets of every CHECKPOINT_STEP-th line. */
+	size_t ncheckpoints;    /* Number of elements in checkpoints array. */
+	size_t checkpoints_cap; /* Capacity of checkpoints array. */
+	size_t nindexed;        /* Number of lines whose beginnings are known. */
+	size_t next_start;      /* Offset of the first line that isn't indexed. */
+	int complete;           /* Whether whole file is indexed. */
+
+	size_t last_line;       /* Line accessed last or SIZE_MAX. */
+	size_t last_offset;     /* Offset of the last accessed line. */
+
+	char tail[TAIL_SIZE];   /* Last bytes of known part of the file. */
+	size_t tail_len;        /* Number of bytes in tail array. */
+};
+
+static void reset_index(file_lines_t *fl);
+static void remember_tail(file_lines_t *fl);
+static int tail_changed(file_lines_t *fl);
+static size_t read_tail(file_lines_t *fl, char tail[]);
+static void reopen_last_line(file_lines_t *fl);
+static void extend_index(file_lines_t *fl, size_t line);
+static size_t find_line_start(file_lines_t *fl, size_t line);
+static size_t find_line_end(file_lines_t *fl, size_t offset);
+static size_t find_next_line(file_lines_t *fl, size_t offset);
+static int byte_at(file_lines_t *fl, size_t offset);
+static const char * read_at(file_lines_t *fl, size_t offset, size_t len,
+		size_t *avail);
+
+file_lines_t *
+fl_open(const char path[])
+{
+#ifndef _WIN32
+	struct stat st;
+	file_lines_t *fl;
+
+	const int fd = open(path, O_RDONLY);
+	if(fd == -1)
+	{
+		return NULL;
+	}
+
+	if(fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) ||
+			(uintmax_t)st.st_size > SIZE_MAX)
+	{
+		close(fd);
+		return NULL;
+	}
+
+	fl = malloc(sizeof(*fl));
+	if(fl == NULL)
+	{
+		close(fd);
+		return NULL;
+	}
+
+	fl->fd = fd;
+	fl->size = st.st_size;
+	fl->buf = NULL;
+	fl->buf_offset = 0U;
+	fl->buf_len = 0U;
+	fl->buf_cap = 0U;
+	fl->checkpoints = NULL;
+	fl->checkpoints_cap = 0U;
+	reset_index(fl);
+	remember_tail(fl);
+	return fl;
+#else
+	return NULL;
+#endif
+}
+
+void
+fl_close(file_lines_t *fl)
+{
+	if(fl == NULL)
+	{
+		return;
+	}
+
+#ifndef _WIN32
+	close(fl->fd);
+#endif
+	free(fl->buf);
+	free(fl->checkpoints);
+	free(fl);
+}
+
+int
+fl_sync(file_lines_t *fl)
+{
+#ifndef _WIN32
+	struct stat st;
+	if(fstat(fl->fd, &st) != 0)
+	{
+		return 0;
+	}
+
+	if((uintmax_t)st.st_size < fl->size)
+	{
+		fl->size = st.st_size;
+	}
+	else if(!tail_changed(fl))
+	{
+		return 0;
+	}
+
+	/* File was truncated and might have been written anew after that, so
+	 * nothing that was read from it can be trusted. */
+	fl->buf_len = 0U;
+	reset_index(fl);
+	remember_tail(fl);
+	return 1;
+#else
+	return 0;
+#endif
+}
+
+int
+fl_grow(file_lines_t *fl)
+{
+#ifndef _WIN32
+	struct stat st;
+	if(fstat(fl->fd, &st) != 0 || (uintmax_t)st.st_size <= fl->size ||
+			(uintmax_t)st.st_size > SIZE_MAX)
+	{
+		return 0;
+	}
+
+	if(tail_changed(fl))
+	{
+		/* Truncation was followed by writing more data than there was, extending
+		 * the index would mix lines of old and new contents. */
+		fl->buf_len = 0U;
+		fl->size = st.st_size;
+		reset_index(fl);
+	}
+	else
+	{
+		reopen_last_line(fl);
+		fl->size = st.st_size;
+	}
+	remember_tail(fl);
+	return 1;
+#else
+	return 0;
+#endif
+}
+
+int
+fl_is_same_file(const file_lines_t *fl, const char path[])
+{
+#ifndef _WIN32
+	struct stat st, path_st;
+	return fstat(fl->fd, &st) == 0
+	    && stat(path, &path_st) == 0
+	    && st.st_dev == path_st.st_dev
+	    && st.st_ino == path_st.st_ino;
+#else
+	return 0;
+#endif
+}
+
+/* Makes the last line of fully indexed file subject to indexing again, because
+ * data appended to the file can continue it. */
+static void
+reopen_last_line(file_lines_t *fl)
+{
+	if(!fl->complete)
+	{
+		return;
+	}
+
+	fl->complete = 0;
+	if(fl->nindexed == 0U)
+	{
+		return;
+	}
+
+	--fl->nindexed;
+	fl->next_start = find_line_start(fl, fl->nindexed);
+	if(fl->nindexed%CHECKPOINT_STEP == 0U)
+	{
+		/* Checkpoint is added back on indexing the line. */
+		--fl->ncheckpoints;
+	}
+}
+
+/* Forgets everything that is known about lines of the file. */
+static void
+reset_index(file_lines_t *fl)
+{
+	fl->ncheckpoints = 0U;
+	fl->nindexed = 0U;
+	fl->next_start = 0U;
+	fl->complete = (fl->size == 0U);
+	fl->last_line = SIZE_MAX;
+	fl->last_offset = 0U;
+}
+
+/* Stores last bytes of known part of the file for tail_changed(). */
+static void
+remember_tail(file_lines_t *fl)
+{
+	fl->tail_len = read_tail(fl, fl->tail);
+}
+
+/* Checks whether last bytes of known part of the file differ from those seen
+ * on the last remember_tail() call, which happens when the file is truncated
+ * and written again.  Returns non-zero if so, otherwise zero is returned. */
+static int
+tail_changed(file_lines_t *fl)
+{
+	char tail[TAIL_SIZE];
+	return read_tail(fl, tail) != fl->tail_len
+	    || memcmp(tail, fl->tail, fl->tail_len) != 0;
+}
+
+/* Reads up to TAIL_SIZE bytes that end at the known size of the file bypassing
+ * the buffer.  Returns number of bytes that were read, which is smaller than
+ * expected if the file got truncated. */
+static size_t
+read_tail(file_lines_t *fl, char tail[])
+{
+#ifndef _WIN32
+	const size_t len = MIN(fl->size, TAIL_SIZE);
+	const size_t offset = fl->size - len;
+	size_t nread = 0U;
+	while(nread < len)
+	{
+		const ssize_t n = pread(fl->fd, tail + nread, len - nread,
+				offset + nread);
+		if(n < 0 && errno == EINTR)
+		{
+			continue;
+		}
+		if(n <= 0)
+		{
+			break;
+		}
+		nread += n;
+	}
+	return nread;
+#else
+	return 0U;
+#endif
+}
+
+int
+fl_has_line(file_lines_t *fl, size_t line)
+{
+	extend_index(fl, line);
+	return (line < fl->nindexed);
+}
+
+size_t
+fl_count(file_lines_t *fl)
+{
+	while(!fl->complete)
+	{
+		const size_t nindexed = fl->nindexed;
+		extend_index(fl, nindexed + CHECKPOINT_STEP);
+		if(fl->nindexed == nindexed)
+		{
+			/* Out of memory. */
+			break;
+		}
+	}
+	return fl->nindexed;
+}
+
+int
+fl_known_count(const file_lines_t *fl, size_t *count)
+{
+	if(!fl->complete)
+	{
+		return 1;
+	}
+
+	*count = fl->nindexed;
+	return 0;
+}
+
+const char *
+fl_get(file_lines_t *fl, size_t line, size_t *len)
+{
+	size_t start, avail;
+	const char *data;
+
+	if(!fl_has_line(fl, line))
+	{
+		return NULL;
+	}
+
+	start = find_line_start(fl, line);
+	*len = find_line_end(fl, start) - start;
+
+	fl->last_line = line;
+	fl->last_offset = start;
+
+	data = read_at(fl, start, *len, &avail);
+	if(avail < *len)
+	{
+		/* File was truncated or memory is low. */
+		*len = avail;
+	}
+	return (*len == 0U) ? "" : data;
+}
+
+const char *
+fl_read(file_lines_t *fl, size_t offset, size_t min_len, size_t *len)
+{
+	const char *const data = read_at(fl, offset, min_len, len);
+	return (*len == 0U) ? NULL : data;
+}
+
+size_t
+fl_size(const file_lines_t *fl)
+{
+	return fl->size;
+}
+
+int
+fl_offset(file_lines_t *fl, size_t line, size_t *offset)
+{
+	if(!fl_has_line(fl, line))
+	{
+		return 1;
+	}
+
+	*offset = find_line_start(fl, line);
+	return 0;
+}
+
+int
+fl_line_at(file_lines_t *fl, size_t offset, size_t *line)
+{
+	size_t lo, hi;
+	size_t start, next;
+
+	if(offset >= fl->size)
+	{
+		return 1;
+	}
+
+	while(!fl->complete && fl->next_start <= offset)
+	{
+		const size_t nindexed = fl->nindexed;
+		extend_index(fl, nindexed);
+		if(fl->nindexed == nindexed)
+		{
+			/* Out of memory. */
+			return 1;
+		}
+	}
+
+	if(fl->ncheckpoints == 0U)
+	{
+		return 1;
+	}
+
+	/* Find the last checkpoint that isn't past the offset. */
+	lo = 0U;
+	hi = fl->ncheckpoints - 1U;
+	while(lo < hi)
+	{
+		const size_t mid = lo + (hi - lo + 1U)/2U;
+		if(fl->checkpoints[mid] <= offset)
+		{
+			lo = mid;
+		}
+		else
+		{
+			hi = mid - 1U;
+		}
+	}
+
+	*line = lo*CHECKPOINT_STEP;
+	start = fl->checkpoints[lo];
+	while((next = find_next_line(fl, start)) <= offset)
+	{
+		start = next;
+		++*line;
+	}
+
+	fl->last_line = *line;
+	fl->last_offset = start;
+	return 0;
+}
+
+/* Finds beginnings of lines up to the specified one (unless end of file is
+ * reached before that). */
+static void
+extend_index(file_lines_t *fl, size_t line)
+{
+	while(!fl->complete && fl->nindexed <= line)
+	{
+		if(fl->nindexed%CHECKPOINT_STEP == 0U)
+		{
+			if(fl->ncheckpoints == fl->checkpoints_cap)
+			{
+				const size_t cap = (fl->checkpoints_cap == 0U)
+				                 ? 64U
+				                 : fl->checkpoints_cap*2U;
+				size_t *const checkpoints = realloc(fl->checkpoints,
+						sizeof(*checkpoints)*cap);
+				if(checkpoints == NULL)
+				{
+					return;
+				}
+				fl->checkpoints = checkpoints;
+				fl->checkpoints_cap = cap;
+			}
+			fl->checkpoints[fl->ncheckpoints++] = fl->next_start;
+		}
+
+		fl->next_start = find_next_line(fl, fl->next_start);
+		++fl->nindexed;
+		fl->complete = (fl->next_start >= fl->size);
+	}
+}
+
+/* Finds offset of an indexed line starting from the closest known position.
+ * Returns the offset. */
+static size_t
+find_line_start(file_lines_t *fl, size_t line)
+{
+	size_t from = (line/CHECKPOINT_STEP)*CHECKPOINT_STEP;
+	size_t offset = fl->checkpoints[line/CHECKPOINT_STEP];
+
+	/* Sequential access is the most common one. */
+	if(fl->last_line >= from && fl->last_line <= line)
+	{
+		from = fl->last_line;
+		offset = fl->last_offset;
+	}
+
+	while(from < line)
+	{
+		offset = find_next_line(fl, offset);
+		++from;
+	}
+	return offset;
+}
+
+/* Finds end of a line that starts at specified offset.  Returns offset of the
+ * first character past the line. */
+static size_t
+find_line_end(file_lines_t *fl, size_t offset)
+{
+	while(offset < fl->size)
+	{
+		size_t avail, i;
+		const char *const data = read_at(fl, offset, 1U, &avail);
+		if(avail == 0U)
+		{
+			/* The rest of the file can't be read, so it ends here. */
+			break;
+		}
+
+		for(i = 0U; i < avail; ++i)
+		{
+			const char c = data[i];
+			if(c == '\n' || c == '\r' || c == '\0')
+			{
+				return offset + i;
+			}
+		}
+		offset += avail;
+	}
+	return offset;
+}
+
+/* Finds beginning of a line that follows a line starting at specified offset.
+ * Returns the offset, which is equal to size of the file for the last line. */
+static size_t
+find_next_line(file_lines_t *fl, size_t offset)
+{
+	offset = find_line_end(fl, offset);
+	if(offset >= fl->size)
+	{
+		return fl->size;
+	}
+
+	switch(byte_at(fl, offset++))
+	{
+		case '\r':
+			if(byte_at(fl, offset) == '\n')
+			{
+				++offset;
+			}
+			break;
+		case '\0':
+			while(byte_at(fl, offset) == '\0')
+			{
+				++offset;
+			}
+			break;
+		case -1:
+			/* Treat unreadable rest of the file as part of the last line. */
+			return fl->size;
+	}
+	return offset;
+}
+
+/* Retrieves single byte of the file.  Returns the byte or -1 if it can't be
+ * read. */
+static int
+byte_at(file_lines_t *fl, size_t offset)
+{
+	size_t avail;
+	const char *const data = read_at(fl, offset, 1U, &avail);
+	return (avail == 0U) ? -1 : (unsigned char)data[0];
+}
+
+/* Retrieves part of the file that starts at the offset and is at least len
+ * bytes long unless the file ends sooner, reading it if it isn't in the buffer.
+ * Reading instead of mapping the file makes its truncation harmless, missing
+ * data just looks like end of the file.  Returns pointer to *avail bytes, which
+ * is valid until the next read, *avail is zero on error or at the end. */
+static const char *
+read_at(file_lines_t *fl, size_t offset, size_t len, size_t *avail)
+{
+#ifndef _WIN32
+	size_t wanted;
+
+	*avail = 0U;
+	if(offset >= fl->size)
+	{
+		return NULL;
+	}
+
+	len = MIN(len, fl->size - offset);
+	if(offset >= fl->buf_offset && offset - fl->buf_offset < fl->buf_len &&
+			fl->buf_len - (offset - fl->buf_offset) >= len)
+	{
+		*avail = fl->buf_len - (offset - fl->buf_offset);
+		return fl->buf + (offset - fl->buf_offset);
+	}
+
+	wanted = MIN(MAX(len, BLOCK_SIZE), fl->size - offset);
+	if(wanted > fl->buf_cap)
+	{
+		char *const buf = realloc(fl->buf, wanted);
+		if(buf == NULL)
+		{
+			return NULL;
+		}
+		fl->buf = buf;
+		fl->buf_cap = wanted;
+	}
+
+	fl->buf_offset = offset;
+	fl->buf_len = 0U;
+	while(fl->buf_len < wanted)
+	{
+		const ssize_t n = pread(fl->fd, fl->buf + fl->buf_len,
+				wanted - fl->buf_len, offset + fl->buf_len);
+		if(n < 0 && errno == EINTR)
+		{
+			continue;
+		}
+		if(n <= 0)
+		{
+			break;
+		}
+		fl->buf_len += n;
+	}
+
+	*avail = fl->buf_len;
+	return fl->buf;
+#else
+	*avail = 0U;
+	return NULL;
+#endif
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
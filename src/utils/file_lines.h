@@ -0,0 +1,99 @@
+/* vifm
+ * Copyright (C) 2026 agent.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef VIFM__UTILS__FILE_LINES_H__
+#define VIFM__UTILS__FILE_LINES_H__
+
+#include <stddef.h> /* size_t */
+
+/* Read-only view of a file, which is split into lines the same way
+ * read_file_lines() does it.  Offsets of lines are found on demand and only
+ * every N-th of them is remembered, so neither the file nor its index has to
+ * fit into memory.  The file is read in blocks on demand, so it being truncated
+ * meanwhile only makes part of it look missing. */
+
+/* Declaration of opaque file type. */
+typedef struct file_lines_t file_lines_t;
+
+/* Opens file for reading its lines.  The file can be empty, data appended to
+ * it later is picked up by fl_grow().  Returns NULL on error and on systems
+ * where this isn't supported. */
+file_lines_t * fl_open(const char path[]);
+
+/* Closes the file and frees all associated resources.  The fl can be NULL. */
+void fl_close(file_lines_t *fl);
+
+/* Accounts for file being truncated after it was opened by limiting accessible
+ * part of it to its current size.  Truncation followed by writing at least as
+ * much data is detected by comparing last bytes of the known part of the file.
+ * Either way the index is reset.  Returns non-zero if file got smaller or was
+ * rewritten, otherwise zero is returned. */
+int fl_sync(file_lines_t *fl);
+
+/* Accounts for data appended to the file after it was opened.  Lines that are
+ * already indexed are kept, so only new data needs to be processed, unless
+ * last bytes of the known part of the file have changed, in which case the
+ * index is reset.  Returns non-zero if file got bigger, otherwise zero is
+ * returned. */
+int fl_grow(file_lines_t *fl);
+
+/* Checks whether path still refers to the opened file, which isn't the case
+ * after the file is removed or replaced (e.g. on log rotation).  Returns
+ * non-zero if so, otherwise zero is returned. */
+int fl_is_same_file(const file_lines_t *fl, const char path[]);
+
+/* Checks whether line with specified zero-based number exists.  Indexes the
+ * file up to the line if needed.  Returns non-zero if so, otherwise zero is
+ * returned. */
+int fl_has_line(file_lines_t *fl, size_t line);
+
+/* Counts lines of the file indexing it till the end.  Returns the number. */
+size_t fl_count(file_lines_t *fl);
+
+/* Retrieves number of lines if it's already known.  Returns zero and sets
+ * *count if file was indexed till the end, otherwise non-zero is returned. */
+int fl_known_count(const file_lines_t *fl, size_t *count);
+
+/* Retrieves contents of a line, which isn't null-terminated.  Returns pointer
+ * to *len bytes of the line, which is valid until the next call of any of
+ * ml_*() functions, or NULL if there is no such line. */
+const char * fl_get(file_lines_t *fl, size_t line, size_t *len);
+
+/* Retrieves contents of the file starting at the offset.  At least min_len
+ * bytes are retrieved unless the file ends sooner.  Returns pointer to *len
+ * bytes, which is valid until the next call of any of ml_*() functions, or NULL
+ * at the end of the file or on error. */
+const char * fl_read(file_lines_t *fl, size_t offset, size_t min_len,
+		size_t *len);
+
+/* Retrieves size of the file as it's known to the index.  Returns the size. */
+size_t fl_size(const file_lines_t *fl);
+
+/* Finds offset of beginning of a line.  Returns non-zero if there is no such
+ * line, otherwise zero is returned and *offset is set. */
+int fl_offset(file_lines_t *fl, size_t line, size_t *offset);
+
+/* Finds line that contains byte at specified offset indexing the file up to
+ * it.  Returns zero and sets *line on success, otherwise (e.g. if offset is
+ * past the end of the file) non-zero is returned. */
+int fl_line_at(file_lines_t *fl, size_t offset, size_t *line);
+
+#endif /* VIFM__UTILS__FILE_LINES_H__ */
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
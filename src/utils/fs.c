@@ -48,6 +48,10 @@
 #include "string_array.h"
 #include "utils.h"
 
+/* Files that have less data than their size by at most this number of bytes
+ * aren't considered sparse. */
+#define SPARSE_SLACK (64U*1024U)
+
 static int is_dir_fast(const char path[]);
 static int path_exists_internal(const char path[], const char filename[],
 		int deref);
@@ -506,6 +510,29 @@ get_file_size(const char path[])
 #endif
 }
 
+uint64_t
+get_file_data_size(const char path[])
+{
+#ifndef _WIN32
+	struct stat st;
+	if(os_lstat(path, &st) == 0)
+	{
+		return estimate_data_size(st.st_size, (uint64_t)st.st_blocks*512U);
+	}
+	return 0;
+#else
+	return get_file_size(path);
+#endif
+}
+
+uint64_t
+estimate_data_size(uint64_t size, uint64_t allocated)
+{
+	/* Small difference is more likely to be caused by compression or storing
+	 * data inline than by holes. */
+	return (allocated + SPARSE_SLACK < size) ? allocated : size;
+}
+
 char **
 list_regular_files(const char path[], char *list[], int *len)
 {
@@ -118,6 +118,14 @@ int is_dir_writable(const char path[]);
  * empty files and on error. */
 uint64_t get_file_size(const char path[]);
 
+/* Gets amount of data stored in a file, which can be much less than its size
+ * for sparse files.  Returns zero for both empty files and on error. */
+uint64_t get_file_data_size(const char path[]);
+
+/* Estimates amount of data stored in a file of the size that occupies allocated
+ * bytes of storage.  Returns the estimate. */
+uint64_t estimate_data_size(uint64_t size, uint64_t allocated);
+
 /* Appends all regular files inside the path directory.  Reallocates array of
  * strings if necessary to fit all elements.  Returns pointer to reallocated
  * array or source list (on error). */
@@ -16,52 +16,103 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
  */
 
-/* The implementation is a tree (with links to leftmost child and right
- * sibling), which is traversed according to slash separated path.  Siblings are
- * sorted by name. */
+/* The implementation is a tree traversed according to slash separated path.
+ * Children of each node are kept in an open addressing hash table.  Nodes,
+ * their names, data and hash tables are allocated from big blocks owned by the
+ * tree and are never freed until whole tree is freed.
+ *
+ * Lookups don't take locks.  Modifications are bracketed by incrementing
+ * sequence number (odd value means that modification is in progress) and
+ * readers retry if the number has changed while they were reading.  Since no
+ * memory is ever released, reader that sees partially updated tree can't
+ * access freed memory and just retries. */
 
 #include "fsdata.h"
 #include "private/fsdata.h"
 
+#include <sched.h> /* sched_yield() */
+
+#include <ctype.h> /* tolower() */
 #include <stddef.h> /* NULL size_t */
 #include <stdlib.h> /* free() malloc() */
-#include <string.h> /* memcpy() */
+#include <string.h> /* memcpy() memset() */
 
 #include "../compat/fs_limits.h"
 #include "../compat/os.h"
 #include "str.h"
 
-/* Special value for get_or_create_node()'s data_size argument to prevent it
- * from creating a node. */
-#define NO_CREATE (size_t)-1
+/* Size of data part of regular blocks of memory. */
+#define BLOCK_SIZE (16U*1024U)
+
+/* Alignment of all allocations from blocks. */
+#define ALIGNMENT 16U
+
+/* Initial number of slots in hash tables of children (must be a power of
+ * two). */
+#define INITIAL_CAPACITY 4U
+
+/* Wrappers for atomic accesses to fields shared with readers. */
+#define LOAD(var) __atomic_load_n(&(var), __ATOMIC_ACQUIRE)
+#define STORE(var, val) __atomic_store_n(&(var), (val), __ATOMIC_RELEASE)
+
+/* Hash table of children of a node. */
+typedef struct
+{
+	size_t capacity;        /* Number of slots, always a power of two. */
+	struct node_t *slots[]; /* Slots, NULL means free slot. */
+}
+children_t;
 
 /* Tree node type. */
 typedef struct node_t
 {
-	char *name;           /* Name of this node. */
-	size_t name_len;      /* Length of the name. */
-	int valid;            /* Whether data in this node is meaningful. */
-	struct node_t *next;  /* Next sibling on this level. */
-	struct node_t *child; /* Leftmost child of this node. */
-	char data[];          /* Data associated with the node follows. */
+	const char *name;      /* Name of this node (stored right after the node). */
+	size_t name_len;       /* Length of the name. */
+	size_t hash;           /* Hash of the name. */
+	int valid;             /* Whether data in this node is meaningful. */
+	children_t *children;  /* Children of this node or NULL. */
+	size_t nchildren;      /* Number of children in the table. */
+	void *data;            /* Data associated with the node or NULL. */
+	size_t data_size;      /* Size of memory pointed to by data. */
 }
 node_t;
 
+/* Block of memory from which everything is allocated. */
+typedef struct block_t
+{
+	struct block_t *next; /* Previously allocated block or NULL. */
+	size_t used;          /* Number of used bytes of the data. */
+	size_t size;          /* Size of the data. */
+	char *data;           /* Aligned storage (points inside this allocation). */
+}
+block_t;
+
 /* A node subtype that holds additional data. */
 struct fsdata_t
 {
 	node_t *root;             /* Root node data. */
 	int prefix;               /* Whether we use last seen value on searches. */
 	fsd_cleanup_func cleanup; /* Node data cleanup function. */
+	block_t *blocks;          /* List of blocks of memory. */
+	unsigned int seq;         /* Sequence number of modifications. */
 };
 
 static void do_nothing(void *data);
-static void nodes_free(node_t *node, fsd_cleanup_func cleanup);
-static node_t * get_or_create_node(node_t *root, const char path[],
-		size_t data_size, node_t **last, node_t **link);
-static node_t * make_node(const char name[], size_t name_len, size_t data_size);
-static int invalidate_path(node_t *root, const char path[],
-		fsd_cleanup_func cleanup);
+static void cleanup_nodes(node_t *node, fsd_cleanup_func cleanup);
+static void begin_write(fsdata_t *fsd);
+static void end_write(fsdata_t *fsd);
+static node_t * get_or_create_node(fsdata_t *fsd, const char path[]);
+static node_t * find_node(node_t *root, const char path[], node_t **last);
+static node_t * find_child(const node_t *node, const char name[],
+		size_t name_len, size_t hash);
+static node_t * add_child(fsdata_t *fsd, node_t *node, const char name[],
+		size_t name_len, size_t hash);
+static int insert_child(fsdata_t *fsd, node_t *node, node_t *child);
+static void put_child(children_t *children, node_t *child);
+static node_t * make_node(fsdata_t *fsd, const char name[], size_t name_len,
+		size_t hash);
+static size_t hash_name(const char name[], size_t name_len);
+static void * alloc(fsdata_t *fsd, size_t size);
 
 fsdata_t *
 fsdata_create(int prefix)
@@ -72,9 +123,18 @@ fsdata_create(int prefix)
 		return NULL;
 	}
 
-	fsd->root = NULL;
 	fsd->prefix = prefix;
 	fsd->cleanup = &do_nothing;
+	fsd->blocks = NULL;
+	fsd->seq = 0U;
+
+	fsd->root = make_node(fsd, "/", 1U, 0U);
+	if(fsd->root == NULL)
+	{
+		free(fsd);
+		return NULL;
+	}
+
 	return fsd;
 }
 
@@ -94,32 +154,52 @@ fsdata_set_cleanup(fsdata_t *fsd, fsd_cleanup_func cleanup)
 void
 fsdata_free(fsdata_t *fsd)
 {
-	if(fsd != NULL)
+	block_t *block;
+
+	if(fsd == NULL)
 	{
-		nodes_free(fsd->root, fsd->cleanup);
-		free(fsd);
+		return;
 	}
+
+	if(fsd->cleanup != &do_nothing)
+	{
+		cleanup_nodes(fsd->root, fsd->cleanup);
+	}
+
+	block = fsd->blocks;
+	while(block != NULL)
+	{
+		block_t *const next = block->next;
+		free(block);
+		block = next;
+	}
+
+	free(fsd);
 }
 
-/* Recursively frees all the nodes and everything associated with them. */
+/* Recursively calls cleanup function for data of all valid nodes. */
 static void
-nodes_free(node_t *node, fsd_cleanup_func cleanup)
+cleanup_nodes(node_t *node, fsd_cleanup_func cleanup)
 {
-	if(node == NULL)
-	{
-		return;
-	}
+	size_t i;
 
 	if(node->valid)
 	{
-		cleanup(&node->data);
+		cleanup(node->data);
 	}
 
-	nodes_free(node->child, cleanup);
-	nodes_free(node->next, cleanup);
+	if(node->children == NULL)
+	{
+		return;
+	}
 
-	free(node->name);
-	free(node);
+	for(i = 0U; i < node->children->capacity; ++i)
+	{
+		if(node->children->slots[i] != NULL)
+		{
+			cleanup_nodes(node->children->slots[i], cleanup);
+		}
+	}
 }
 
 int
@@ -127,176 +207,381 @@ fsdata_set(fsdata_t *fsd, const char path[], const void *data, size_t len)
 {
 	node_t *node;
 	char real_path[PATH_MAX];
+	int result = -1;
 
 	if(os_realpath(path, real_path) != real_path)
 	{
 		return -1;
 	}
 
-	/* Create root node lazily, when we know data size. */
-	if(fsd->root == NULL)
+	begin_write(fsd);
+
+	node = get_or_create_node(fsd, real_path);
+	if(node != NULL)
 	{
-		fsd->root = make_node("/", 1U, len);
-		if(fsd->root == NULL)
+		if(node->valid)
 		{
-			return -1;
+			fsd->cleanup(node->data);
 		}
-	}
-
-	node = get_or_create_node(fsd->root, real_path, len, NULL, &fsd->root);
-	if(node == NULL)
-	{
-		return -1;
-	}
 
-	if(node->valid)
-	{
-		fsd->cleanup(&node->data);
+		if(node->data == NULL || node->data_size < len)
+		{
+			void *const new_data = alloc(fsd, len);
+			if(new_data != NULL)
+			{
+				memcpy(new_data, data, len);
+				STORE(node->data, new_data);
+				node->data_size = len;
+				STORE(node->valid, 1);
+				result = 0;
+			}
+			else
+			{
+				STORE(node->valid, 0);
+			}
+		}
+		else
+		{
+			memcpy(node->data, data, len);
+			STORE(node->valid, 1);
+			result = 0;
+		}
 	}
 
-	node->valid = 1;
-	memcpy(node->data, data, len);
-	return 0;
+	end_write(fsd);
+	return result;
 }
 
 int
 fsdata_get(fsdata_t *fsd, const char path[], void *data, size_t len)
 {
-	node_t *last = NULL;
-	node_t *node;
-	const void *src;
 	char real_path[PATH_MAX];
 
-	if(fsd->root == NULL)
-	{
-		return -1;
-	}
-
 	if(os_realpath(path, real_path) != real_path)
 	{
 		return -1;
 	}
 
-	node = get_or_create_node(fsd->root, real_path, NO_CREATE,
-			fsd->prefix ? &last : NULL, NULL);
-	if((node == NULL || !node->valid) && last == NULL)
+	while(1)
 	{
-		return -1;
+		node_t *last = NULL;
+		node_t *node;
+		int result = -1;
+
+		const unsigned int seq = LOAD(fsd->seq);
+		if(seq%2U != 0U)
+		{
+			sched_yield();
+			continue;
+		}
+
+		node = find_node(fsd->root, real_path, fsd->prefix ? &last : NULL);
+		if(node != NULL && LOAD(node->valid))
+		{
+			memcpy(data, LOAD(node->data), len);
+			result = 0;
+		}
+		else if(last != NULL)
+		{
+			memcpy(data, LOAD(last->data), len);
+			result = 0;
+		}
+
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		if(__atomic_load_n(&fsd->seq, __ATOMIC_RELAXED) == seq)
+		{
+			return result;
+		}
 	}
+}
 
-	src = (node != NULL && node->valid) ? node->data : last->data;
-	memcpy(data, src, len);
-	return 0;
+/* Marks beginning of modification of the tree. */
+static void
+begin_write(fsdata_t *fsd)
+{
+	__atomic_store_n(&fsd->seq, fsd->seq + 1U, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
 }
 
-/* Looks up a node by its path.  Inserts a node if it doesn't exist and
- * data_size is not equal to NO_CREATE.  If last is not NULL *last is assigned
- * closest valid parent node.  Optionally reallocates and updates *link.
- * Returns the node at the path or NULL on error. */
-static node_t *
-get_or_create_node(node_t *root, const char path[], size_t data_size,
-		node_t **last, node_t **link)
+/* Marks end of modification of the tree. */
+static void
+end_write(fsdata_t *fsd)
 {
-	const char *end;
-	size_t name_len;
-	node_t *prev = NULL, *curr;
-	node_t *new_node;
+	STORE(fsd->seq, fsd->seq + 1U);
+}
 
-	path = skip_char(path, '/');
-	if(*path == '\0')
+/* Looks up a node by its path inserting missing nodes.  Returns the node at the
+ * path or NULL on error. */
+static node_t *
+get_or_create_node(fsdata_t *fsd, const char path[])
+{
+	node_t *node = fsd->root;
+	while(1)
 	{
-		if(link != NULL)
+		const char *end;
+		size_t name_len, hash;
+		node_t *child;
+
+		path = skip_char(path, '/');
+		if(*path == '\0')
 		{
-			root = realloc(root, sizeof(*root) + data_size);
-			if(root != NULL)
+			return node;
+		}
+
+		end = until_first(path, '/');
+		name_len = end - path;
+		hash = hash_name(path, name_len);
+
+		child = find_child(node, path, name_len, hash);
+		if(child == NULL)
+		{
+			child = add_child(fsd, node, path, name_len, hash);
+			if(child == NULL)
 			{
-				*link = root;
+				return NULL;
 			}
 		}
-		return root;
-	}
 
-	end = until_first(path, '/');
+		node = child;
+		path = end;
+	}
+}
 
-	name_len = end - path;
-	curr = root->child;
-	while(curr != NULL)
+/* Looks up a node by its path.  If last is not NULL *last is assigned closest
+ * valid parent node.  Returns the node at the path or NULL if there is no such
+ * node. */
+static node_t *
+find_node(node_t *root, const char path[], node_t **last)
+{
+	node_t *node = root;
+	while(1)
 	{
-		int comp = strnoscmp(path, curr->name, name_len);
-		if(comp == 0 && curr->name_len == name_len)
+		const char *end;
+		size_t name_len;
+
+		path = skip_char(path, '/');
+		if(*path == '\0')
 		{
-			if(curr->valid && last != NULL)
-			{
-				*last = curr;
-			}
-			return get_or_create_node(curr, end, data_size, last,
-					(data_size == NO_CREATE) ? NULL :
-					(root->child == curr) ? &root->child : &prev->next);
+			return node;
 		}
-		else if(comp < 0)
+
+		end = until_first(path, '/');
+		name_len = end - path;
+
+		node = find_child(node, path, name_len, hash_name(path, name_len));
+		if(node == NULL)
 		{
-			break;
+			return NULL;
 		}
-		prev = curr;
-		curr = curr->next;
+
+		if(last != NULL && LOAD(node->valid))
+		{
+			*last = node;
+		}
+
+		path = end;
 	}
+}
 
-	if(data_size == NO_CREATE)
+/* Looks up child of the node by its name.  Returns the child or NULL. */
+static node_t *
+find_child(const node_t *node, const char name[], size_t name_len, size_t hash)
+{
+	size_t i, n;
+	size_t mask;
+	const children_t *const children = LOAD(node->children);
+	if(children == NULL)
 	{
 		return NULL;
 	}
 
-	new_node = make_node(path, name_len, data_size);
-	if(new_node == NULL)
+	mask = children->capacity - 1U;
+	i = hash & mask;
+	for(n = 0U; n < children->capacity; ++n)
+	{
+		node_t *const child = LOAD(children->slots[i]);
+		if(child == NULL)
+		{
+			break;
+		}
+
+		if(child->hash == hash && child->name_len == name_len &&
+				strnoscmp(child->name, name, name_len) == 0)
+		{
+			return child;
+		}
+
+		i = (i + 1U) & mask;
+	}
+	return NULL;
+}
+
+/* Creates new child of the node.  Returns the child or NULL on error. */
+static node_t *
+add_child(fsdata_t *fsd, node_t *node, const char name[], size_t name_len,
+		size_t hash)
+{
+	node_t *const child = make_node(fsd, name, name_len, hash);
+	if(child == NULL || insert_child(fsd, node, child) != 0)
 	{
 		return NULL;
 	}
+	return child;
+}
 
-	new_node->next = curr;
+/* Inserts fully initialized child into hash table of the node growing the table
+ * if needed.  Old table isn't modified to be usable by concurrent readers.
+ * Returns zero on success, otherwise non-zero is returned. */
+static int
+insert_child(fsdata_t *fsd, node_t *node, node_t *child)
+{
+	children_t *children = node->children;
 
-	if(root->child == curr)
+	if(children == NULL || (node->nchildren + 1U)*2U > children->capacity)
 	{
-		root->child = new_node;
+		const size_t capacity = (children == NULL)
+		                      ? INITIAL_CAPACITY
+		                      : children->capacity*2U;
+		children_t *const new_children = alloc(fsd,
+				sizeof(*new_children) + capacity*sizeof(new_children->slots[0]));
+		if(new_children == NULL)
+		{
+			return 1;
+		}
+
+		new_children->capacity = capacity;
+		memset(new_children->slots, 0, capacity*sizeof(new_children->slots[0]));
+
+		if(children != NULL)
+		{
+			size_t i;
+			for(i = 0U; i < children->capacity; ++i)
+			{
+				if(children->slots[i] != NULL)
+				{
+					put_child(new_children, children->slots[i]);
+				}
+			}
+		}
+
+		STORE(node->children, new_children);
+		children = new_children;
 	}
-	else
+
+	put_child(children, child);
+	++node->nchildren;
+	return 0;
+}
+
+/* Puts child into free slot of the table. */
+static void
+put_child(children_t *children, node_t *child)
+{
+	const size_t mask = children->capacity - 1U;
+	size_t i = child->hash & mask;
+	while(children->slots[i] != NULL)
 	{
-		prev->next = new_node;
+		i = (i + 1U) & mask;
 	}
-	/* No need to update anything here, because size is guaranteed to be the
-	 * same. */
-	return get_or_create_node(new_node, end, data_size, last, NULL);
+	STORE(children->slots[i], child);
 }
 
 /* Creates new node for the tree.  Returns the node or NULL on memory allocation
  * error. */
 static node_t *
-make_node(const char name[], size_t name_len, size_t data_size)
+make_node(fsdata_t *fsd, const char name[], size_t name_len, size_t hash)
 {
-	node_t *new_node = malloc(sizeof(*new_node) + data_size);
+	char *node_name;
+	node_t *const new_node = alloc(fsd, sizeof(*new_node) + name_len + 1U);
 	if(new_node == NULL)
 	{
 		return NULL;
 	}
 
-	new_node->name = malloc(name_len + 1U);
-	if(new_node->name == NULL)
-	{
-		free(new_node);
-		return NULL;
-	}
+	node_name = (char *)(new_node + 1);
+	copy_str(node_name, name_len + 1U, name);
 
-	copy_str(new_node->name, name_len + 1U, name);
+	new_node->name = node_name;
 	new_node->name_len = name_len;
+	new_node->hash = hash;
 	new_node->valid = 0;
-	new_node->child = NULL;
-	new_node->next = NULL;
+	new_node->children = NULL;
+	new_node->nchildren = 0U;
+	new_node->data = NULL;
+	new_node->data_size = 0U;
 
 	return new_node;
 }
 
+/* Computes hash of the name consistent with strnoscmp().  Returns the hash. */
+static size_t
+hash_name(const char name[], size_t name_len)
+{
+	/* FNV-1a hash. */
+	size_t hash = 2166136261U;
+	size_t i;
+	for(i = 0U; i < name_len; ++i)
+	{
+#ifndef _WIN32
+		hash ^= (unsigned char)name[i];
+#else
+		hash ^= (unsigned char)tolower((unsigned char)name[i]);
+#endif
+		hash *= 16777619U;
+	}
+	return hash;
+}
+
+/* Allocates aligned piece of memory from blocks of the tree.  Returns pointer
+ * to the memory or NULL on error. */
+static void *
+alloc(fsdata_t *fsd, size_t size)
+{
+	void *ptr;
+	block_t *block = fsd->blocks;
+
+	size = (size + ALIGNMENT - 1U) & ~(size_t)(ALIGNMENT - 1U);
+
+	if(block == NULL || block->size - block->used < size)
+	{
+		const size_t block_size = (size > BLOCK_SIZE) ? size : BLOCK_SIZE;
+		char *storage;
+
+		block = malloc(sizeof(*block) + ALIGNMENT + block_size);
+		if(block == NULL)
+		{
+			return NULL;
+		}
+
+		storage = (char *)(block + 1);
+		storage += (ALIGNMENT - (size_t)storage%ALIGNMENT)%ALIGNMENT;
+
+		block->data = storage;
+		block->used = 0U;
+		block->size = block_size;
+
+		/* Keep partially used current block if new block is an exclusive one. */
+		if(fsd->blocks != NULL && block_size != BLOCK_SIZE)
+		{
+			block->next = fsd->blocks->next;
+			fsd->blocks->next = block;
+		}
+		else
+		{
+			block->next = fsd->blocks;
+			fsd->blocks = block;
+		}
+	}
+
+	ptr = block->data + block->used;
+	block->used += size;
+	return ptr;
+}
+
 int
 fsdata_invalidate(fsdata_t *fsd, const char path[])
 {
+	node_t *node;
 	char real_path[PATH_MAX];
 
 	if(os_realpath(path, real_path) != real_path)
@@ -304,53 +589,39 @@ fsdata_invalidate(fsdata_t *fsd, const char path[])
 		return 1;
 	}
 
-	return invalidate_path(fsd->root, real_path, fsd->cleanup);
-}
-
-/* Invalidates nodes on the path if end item is found.  Returns zero on
- * successful invalidation otherwise non-zero is returned. */
-static int
-invalidate_path(node_t *root, const char path[], fsd_cleanup_func cleanup)
-{
-	const char *end;
-	size_t name_len;
-	node_t *curr;
-
-	path = skip_char(path, '/');
-	if(*path == '\0')
+	if(find_node(fsd->root, real_path, NULL) == NULL)
 	{
-		goto invalidate;
+		return 1;
 	}
 
-	end = until_first(path, '/');
+	begin_write(fsd);
 
-	name_len = end - path;
-	curr = root->child;
-	while(curr != NULL)
+	node = fsd->root;
+	path = real_path;
+	while(node != NULL)
 	{
-		const int cmp = strnoscmp(path, curr->name, name_len);
-		if(cmp == 0 && curr->name_len == name_len)
+		const char *end;
+		size_t name_len;
+
+		if(node->valid)
 		{
-			if(invalidate_path(curr, end, cleanup) == 0)
-			{
-				goto invalidate;
-			}
+			fsd->cleanup(node->data);
+			STORE(node->valid, 0);
 		}
-		else if(cmp < 0)
+
+		path = skip_char(path, '/');
+		if(*path == '\0')
 		{
 			break;
 		}
-		curr = curr->next;
-	}
-
-	return 1;
 
-invalidate:
-	if(root->valid)
-	{
-		cleanup(&root->data);
+		end = until_first(path, '/');
+		name_len = end - path;
+		node = find_child(node, path, name_len, hash_name(path, name_len));
+		path = end;
 	}
-	root->valid = 0;
+
+	end_write(fsd);
 	return 0;
 }
 
@@ -21,7 +21,11 @@
 
 /* Structure that maps arbitrary data onto file system tree.  Each node can
  * contain arbitrary amount of data, with size changed on every set operation.
- * No additional checks are performed in get/set functions. */
+ * No additional checks are performed in get/set functions.
+ *
+ * fsdata_get() doesn't lock and can be called concurrently with other calls of
+ * itself and with a modifying function (fsdata_set() or fsdata_invalidate()),
+ * calls of modifying functions must be serialized by the caller. */
 
 #include <stddef.h> /* size_t */
 
@@ -86,10 +86,11 @@ fswatch_create(const char path[])
 		return NULL;
 	}
 
-	/* Add directory to watch. */
+	/* Add directory or file to watch.  Moving or removing the entity itself is
+	 * reported too, as the path doesn't refer to it anymore. */
 	wd = inotify_add_watch(w->fd, path, IN_ATTRIB | IN_MODIFY | IN_CREATE |
 			IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_EXCL_UNLINK |
-			IN_CLOSE_WRITE);
+			IN_CLOSE_WRITE | IN_MOVE_SELF | IN_DELETE_SELF);
 	if(wd == -1)
 	{
 		close(w->fd);
@@ -0,0 +1,161 @@
+/* vifm
+ * Copyright (C) 2026 agent.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "str_pool.h"
+
+#include <stddef.h> /* NULL size_t */
+#include <stdlib.h> /* free() malloc() */
+#include <string.h> /* memcpy() strlen() */
+
+/* Size of data part of regular blocks. */
+#define BLOCK_SIZE (64*1024)
+
+/* Strings longer than this are put in blocks of their own. */
+#define MAX_SHARED_LEN (BLOCK_SIZE/16)
+
+/* Block of memory that holds strings.  Each string is preceded by a pointer to
+ * the block it belongs to. */
+typedef struct block_t
+{
+	size_t refs; /* Number of live strings plus one for the current block. */
+	size_t used; /* Number of used bytes of the data field. */
+	size_t size; /* Size of the data field. */
+	char *data;  /* Points right after the structure. */
+}
+block_t;
+
+static char * alloc_str(size_t len);
+static block_t * alloc_block(size_t size);
+static void release_block(block_t *block);
+
+/* Block from which strings are currently allocated. */
+static block_t *curr_block;
+/* Pool statistics. */
+static str_pool_stats_t stats;
+
+char *
+str_pool_dup(const char str[])
+{
+	const size_t len = strlen(str);
+	char *const copy = alloc_str(len);
+	if(copy != NULL)
+	{
+		memcpy(copy, str, len + 1U);
+	}
+	return copy;
+}
+
+/* Allocates space for string of specified length.  Returns pointer to it or
+ * NULL on error. */
+static char *
+alloc_str(size_t len)
+{
+	block_t *block;
+	char *str;
+	/* Keep pointers to blocks aligned. */
+	const size_t size = (sizeof(block_t *) + len + 1U + sizeof(block_t *) - 1U)
+	                  & ~(sizeof(block_t *) - 1U);
+
+	if(len > MAX_SHARED_LEN)
+	{
+		block = alloc_block(size);
+		if(block == NULL)
+		{
+			return NULL;
+		}
+		/* This block is never current, so there is no extra reference. */
+		block->refs = 0U;
+	}
+	else
+	{
+		if(curr_block == NULL || curr_block->size - curr_block->used < size)
+		{
+			block_t *const new_block = alloc_block(BLOCK_SIZE);
+			if(new_block == NULL)
+			{
+				return NULL;
+			}
+
+			if(curr_block != NULL)
+			{
+				release_block(curr_block);
+			}
+			curr_block = new_block;
+		}
+		block = curr_block;
+	}
+
+	str = block->data + block->used;
+	*(block_t **)str = block;
+	block->used += size;
+	++block->refs;
+
+	++stats.nstrings;
+	return str + sizeof(block_t *);
+}
+
+/* Allocates block with data part of the given size.  Returns the block or NULL
+ * on error. */
+static block_t *
+alloc_block(size_t size)
+{
+	block_t *const block = malloc(sizeof(*block) + size);
+	if(block == NULL)
+	{
+		return NULL;
+	}
+
+	block->refs = 1U;
+	block->used = 0U;
+	block->size = size;
+	block->data = (char *)(block + 1);
+
+	++stats.nblocks;
+	++stats.nlive;
+	return block;
+}
+
+void
+str_pool_free(char str[])
+{
+	if(str != NULL)
+	{
+		release_block(*(block_t **)(str - sizeof(block_t *)));
+	}
+}
+
+/* Drops one reference to the block freeing it when there are no more of
+ * them. */
+static void
+release_block(block_t *block)
+{
+	if(--block->refs == 0U)
+	{
+		free(block);
+		--stats.nlive;
+	}
+}
+
+str_pool_stats_t
+str_pool_get_stats(void)
+{
+	return stats;
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
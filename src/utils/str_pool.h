@@ -0,0 +1,53 @@
+/* vifm
+ * Copyright (C) 2026 agent.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef VIFM__UTILS__STR_POOL_H__
+#define VIFM__UTILS__STR_POOL_H__
+
+#include <stddef.h> /* size_t */
+
+/* Pool of strings that are allocated from big blocks of memory instead of
+ * allocating each of them separately.  A block is freed once all strings that
+ * were allocated in it are freed.  There is a single pool, which isn't
+ * thread-safe, so strings must be allocated and freed only from the main
+ * thread (other threads can read them). */
+
+/* Statistics of the pool. */
+typedef struct
+{
+	size_t nstrings; /* Total number of strings allocated from the pool. */
+	size_t nblocks;  /* Total number of blocks allocated by the pool. */
+	size_t nlive;    /* Number of currently allocated blocks. */
+}
+str_pool_stats_t;
+
+/* Duplicates the str in the pool.  Returns pointer to the copy or NULL on
+ * memory allocation error. */
+char * str_pool_dup(const char str[]);
+
+/* Frees string previously allocated by str_pool_dup().  NULL is fine. */
+void str_pool_free(char str[]);
+
+/* Retrieves statistics of the pool.  Difference between number of strings and
+ * number of blocks is the number of saved memory allocations. */
+str_pool_stats_t str_pool_get_stats(void);
+
+#endif /* VIFM__UTILS__STR_POOL_H__ */
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -18,51 +18,113 @@
 
 #include "trie.h"
 
-#include <stdlib.h> /* calloc() free() */
+#include <stddef.h> /* size_t */
+#include <stdlib.h> /* calloc() free() malloc() */
+#include <string.h> /* memcpy() strcmp() strlen() */
 
-/* Trie node. */
-struct trie_t
+/* Despite the name, the "trie" is an open addressing hash table with linear
+ * probing.  Keys are copied into big blocks of memory owned by the table, which
+ * makes it compact and cheap to free compared to a tree of per-character
+ * nodes. */
+
+/* Initial number of slots in the table (must be a power of two). */
+#define INITIAL_SIZE 64U
+
+/* Size of data part of regular blocks of keys. */
+#define KEY_BLOCK_SIZE (16U*1024U)
+
+/* Single slot of the table. */
+typedef struct
 {
-	trie_t left;     /* Nodes with values less than value. */
-	trie_t right;    /* Nodes with values greater than value. */
-	trie_t children; /* Child nodes. */
+	const char *key; /* Key or NULL for free slot. */
 	void *data;      /* Data associated with the key. */
-	char value;      /* Value of the node. */
-	char exists;     /* Whether this node exists or it's an intermediate node. */
+	size_t hash;     /* Hash of the key. */
+}
+slot_t;
+
+/* Block of memory that stores copies of keys. */
+typedef struct key_block_t
+{
+	struct key_block_t *next; /* Previously allocated block or NULL. */
+	size_t used;              /* Number of used bytes of the data. */
+	size_t size;              /* Size of the data. */
+	char data[];              /* Storage of keys. */
+}
+key_block_t;
+
+/* Hash table. */
+struct trie_t
+{
+	slot_t *slots;       /* Array of slots. */
+	size_t size;         /* Number of slots, always a power of two. */
+	size_t count;        /* Number of used slots. */
+	key_block_t *blocks; /* List of blocks of keys, most recent one first. */
 };
 
-static trie_t get_or_create(trie_t trie, const char str[], void *data,
-		int *result);
+static slot_t * find_slot(slot_t slots[], size_t size, const char str[],
+		size_t hash);
+static int grow(trie_t trie);
+static const char * store_key(trie_t trie, const char str[]);
+static size_t hash_str(const char str[]);
 
 trie_t
 trie_create(void)
 {
-	return calloc(1U, sizeof(struct trie_t));
+	trie_t trie = calloc(1U, sizeof(*trie));
+	if(trie == NULL)
+	{
+		return NULL_TRIE;
+	}
+
+	trie->slots = calloc(INITIAL_SIZE, sizeof(*trie->slots));
+	if(trie->slots == NULL)
+	{
+		free(trie);
+		return NULL_TRIE;
+	}
+	trie->size = INITIAL_SIZE;
+
+	return trie;
 }
 
 void
 trie_free(trie_t trie)
 {
-	if(trie != NULL_TRIE)
+	key_block_t *block;
+
+	if(trie == NULL_TRIE)
 	{
-		trie_free(trie->left);
-		trie_free(trie->right);
-		trie_free(trie->children);
-		free(trie);
+		return;
 	}
+
+	block = trie->blocks;
+	while(block != NULL)
+	{
+		key_block_t *const next = block->next;
+		free(block);
+		block = next;
+	}
+
+	free(trie->slots);
+	free(trie);
 }
 
 void
 trie_free_with_data(trie_t trie)
 {
-	if(trie != NULL_TRIE)
+	size_t i;
+
+	if(trie == NULL_TRIE)
 	{
-		trie_free_with_data(trie->left);
-		trie_free_with_data(trie->right);
-		trie_free_with_data(trie->children);
-		free(trie->data);
-		free(trie);
+		return;
 	}
+
+	for(i = 0U; i < trie->size; ++i)
+	{
+		free(trie->slots[i].data);
+	}
+
+	trie_free(trie);
 }
 
 int
@@ -74,86 +136,162 @@ trie_put(trie_t trie, const char str[])
 int
 trie_set(trie_t trie, const char str[], const void *data)
 {
-	int result;
+	const size_t hash = hash_str(str);
+	slot_t *slot;
 
 	if(trie == NULL_TRIE)
 	{
 		return -1;
 	}
 
-	(void)get_or_create(trie, str, (void *)data, &result);
-	return result;
-}
+	slot = find_slot(trie->slots, trie->size, str, hash);
+	if(slot->key != NULL)
+	{
+		slot->data = (void *)data;
+		return 1;
+	}
 
-/* Gets node which might involve its creation.  Sets *return to negative value
- * on error, to zero on successful insertion and to positive number if element
- * was already in the trie. */
-static trie_t
-get_or_create(trie_t trie, const char str[], void *data, int *result)
-{
-	/* Create inexistent node. */
-	if(trie == NULL_TRIE)
+	/* Keep load factor under 1/2 for probe sequences to stay short. */
+	if((trie->count + 1U)*2U > trie->size)
 	{
-		trie = trie_create();
-		if(trie == NULL_TRIE)
+		if(grow(trie) != 0)
 		{
-			*result = -1;
-			return trie;
+			return -1;
 		}
-		trie->value = *str;
+		slot = find_slot(trie->slots, trie->size, str, hash);
 	}
 
-	if(trie->value == *str)
+	slot->key = store_key(trie, str);
+	if(slot->key == NULL)
 	{
-		if(*str == '\0')
-		{
-			/* Found full match. */
-			*result = (trie->exists != 0);
-			trie->exists = 1;
-			trie->data = data;
-		}
-		else
-		{
-			trie->children = get_or_create(trie->children, str + 1, data, result);
-		}
+		return -1;
 	}
-	else if(*str < trie->value)
+	slot->data = (void *)data;
+	slot->hash = hash;
+	++trie->count;
+	return 0;
+}
+
+int
+trie_get(trie_t trie, const char str[], void **data)
+{
+	const slot_t *slot;
+
+	if(trie == NULL_TRIE)
 	{
-		trie->left = get_or_create(trie->left, str, data, result);
+		return 1;
 	}
-	else
+
+	slot = find_slot(trie->slots, trie->size, str, hash_str(str));
+	if(slot->key == NULL)
 	{
-		trie->right = get_or_create(trie->right, str, data, result);
+		return 1;
 	}
 
-	return trie;
+	*data = slot->data;
+	return 0;
 }
 
-int
-trie_get(trie_t trie, const char str[], void **data)
+/* Finds slot that contains the key or free slot where it should be put.
+ * Returns pointer to the slot. */
+static slot_t *
+find_slot(slot_t slots[], size_t size, const char str[], size_t hash)
 {
-	if(trie == NULL_TRIE)
+	const size_t mask = size - 1U;
+	size_t i = hash & mask;
+
+	while(slots[i].key != NULL)
+	{
+		if(slots[i].hash == hash && strcmp(slots[i].key, str) == 0)
+		{
+			break;
+		}
+		i = (i + 1U) & mask;
+	}
+
+	return &slots[i];
+}
+
+/* Doubles number of slots of the table.  Returns zero on success, otherwise
+ * non-zero is returned and the table is left unchanged. */
+static int
+grow(trie_t trie)
+{
+	const size_t new_size = trie->size*2U;
+	slot_t *const new_slots = calloc(new_size, sizeof(*new_slots));
+	size_t i;
+
+	if(new_slots == NULL)
 	{
 		return 1;
 	}
 
-	if(trie->value != *str)
+	for(i = 0U; i < trie->size; ++i)
 	{
-		return trie_get((*str < trie->value) ? trie->left : trie->right, str, data);
+		const slot_t *const slot = &trie->slots[i];
+		if(slot->key != NULL)
+		{
+			*find_slot(new_slots, new_size, slot->key, slot->hash) = *slot;
+		}
 	}
 
-	if(*str == '\0')
+	free(trie->slots);
+	trie->slots = new_slots;
+	trie->size = new_size;
+	return 0;
+}
+
+/* Copies key into storage of the table.  Returns pointer to the copy or NULL
+ * on error. */
+static const char *
+store_key(trie_t trie, const char str[])
+{
+	const size_t len = strlen(str) + 1U;
+	key_block_t *block = trie->blocks;
+	char *copy;
+
+	if(block == NULL || block->size - block->used < len)
 	{
-		/* Found full match. */
-		if(!trie->exists)
+		const size_t size = (len > KEY_BLOCK_SIZE) ? len : KEY_BLOCK_SIZE;
+		block = malloc(sizeof(*block) + size);
+		if(block == NULL)
 		{
-			return 1;
+			return NULL;
+		}
+
+		block->used = 0U;
+		block->size = size;
+
+		/* Putting a big key into a block of its own shouldn't waste free space of
+		 * the current one. */
+		if(len > KEY_BLOCK_SIZE && trie->blocks != NULL)
+		{
+			block->next = trie->blocks->next;
+			trie->blocks->next = block;
+		}
+		else
+		{
+			block->next = trie->blocks;
+			trie->blocks = block;
 		}
-		*data = trie->data;
-		return 0;
 	}
 
-	return trie_get(trie->children, str + 1, data);
+	copy = &block->data[block->used];
+	memcpy(copy, str, len);
+	block->used += len;
+	return copy;
+}
+
+/* Computes FNV-1a hash of the string.  Returns the hash. */
+static size_t
+hash_str(const char str[])
+{
+	size_t hash = 2166136261U;
+	while(*str != '\0')
+	{
+		hash = (hash ^ (unsigned char)*str++)*16777619U;
+	}
+	return hash;
 }
 
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
@@ -102,6 +102,10 @@ const char * make_name_unique(const char filename[]);
 /* Returns process identification in a portable way. */
 unsigned int get_pid(void);
 
+/* Lowers I/O priority of the calling thread and of threads it creates
+ * afterwards to idle one if the system supports this. */
+void lower_io_priority(void);
+
 /* Finds command name in the command line and writes it to the buf.
  * Raw mode will preserve quotes on Windows.
  * Returns a pointer to the argument list. */
@@ -26,16 +26,20 @@
 #include <sys/user.h>
 #endif
 
+#include <sys/resource.h> /* PRIO_PROCESS setpriority() */
 #include <sys/select.h> /* select() FD_SET FD_ZERO */
 #include <sys/stat.h> /* O_* S_* */
+#ifdef __linux__
+#include <sys/syscall.h> /* SYS_ioprio_set */
+#endif
 #include <sys/time.h> /* timeval futimens() utimes() */
 #include <sys/types.h> /* gid_t mode_t pid_t uid_t */
 #include <sys/wait.h> /* waitpid */
 #include <fcntl.h> /* open() close() */
 #include <grp.h> /* getgrnam() getgrgid_r() */
 #include <pwd.h> /* getpwnam() getpwuid_r() */
-#include <unistd.h> /* X_OK dup() dup2() getpid() isatty() pause() sysconf()
-                       ttyname() */
+#include <unistd.h> /* X_OK dup() dup2() getpid() isatty() pause() setpgid()
+                       syscall() sysconf() ttyname() */
 
 #include <assert.h> /* assert() */
 #include <ctype.h> /* isdigit() */
@@ -66,6 +70,9 @@
 #include "str.h"
 #include "utils.h"
 
+/* Niceness of commands run with low priority. */
+#define LOW_PRIO_NICENESS 10
+
 /* Types of mount point information for get_mount_point_traverser_state. */
 typedef enum
 {
@@ -646,6 +653,24 @@ get_pid(void)
 	return getpid();
 }
 
+void
+lower_io_priority(void)
+{
+#if defined(__linux__) && defined(SYS_ioprio_set)
+	/* These aren't exposed by libc headers. */
+	enum
+	{
+		IOPRIO_WHO_PROCESS = 1,
+		IOPRIO_CLASS_IDLE = 3,
+		IOPRIO_CLASS_SHIFT = 13,
+	};
+
+	/* Zero process ID means calling thread. */
+	(void)syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, 0,
+			IOPRIO_CLASS_IDLE << IOPRIO_CLASS_SHIFT);
+#endif
+}
+
 int
 get_uid(const char user[], uid_t *uid)
 {
@@ -987,6 +1012,51 @@ read_cmd_output(const char cmd[])
 	return fp;
 }
 
+FILE *
+read_cmd_output_grouped(const char cmd[], int low_prio, pid_t *pgid)
+{
+	FILE *fp;
+	pid_t pid;
+	int out_pipe[2];
+
+	if(pipe(out_pipe) != 0)
+	{
+		return NULL;
+	}
+
+	pid = fork();
+	if(pid == (pid_t)-1)
+	{
+		close(out_pipe[0]);
+		close(out_pipe[1]);
+		return NULL;
+	}
+
+	if(pid == 0)
+	{
+		(void)setpgid(0, 0);
+		if(low_prio)
+		{
+			(void)setpriority(PRIO_PROCESS, 0, LOW_PRIO_NICENESS);
+		}
+		run_from_fork(out_pipe, 0, (char *)cmd);
+	}
+
+	/* Both processes set the group to do not depend on which one runs first. */
+	(void)setpgid(pid, pid);
+	*pgid = pid;
+
+	/* Close write end of pipe. */
+	close(out_pipe[1]);
+
+	fp = fdopen(out_pipe[0], "r");
+	if(fp == NULL)
+	{
+		close(out_pipe[0]);
+	}
+	return fp;
+}
+
 const char *
 get_installed_data_dir(void)
 {
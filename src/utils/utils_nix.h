@@ -25,6 +25,8 @@
 #include <sys/types.h> /* gid_t mode_t pid_t uid_t */
 #include <sys/wait.h> /* WEXITSTATUS() WIFEXITED() */
 
+#include <stdio.h> /* FILE */
+
 #define PAUSE_CMD "vifm-pause"
 #define PAUSE_STR "; "PAUSE_CMD
 
@@ -40,6 +42,12 @@ int get_proc_exit_status(pid_t pid);
  * and stderr are redirected to the pipe. */
 void _gnuc_noreturn run_from_fork(int pipe[2], int err_only, char cmd[]);
 
+/* Same as read_cmd_output(), but runs the command in a new process group, id
+ * of which is stored in *pgid to make it possible to kill the command along
+ * with its children.  Non-zero low_prio lowers scheduling priority of the
+ * command.  Returns the stream or NULL on error. */
+FILE * read_cmd_output_grouped(const char cmd[], int low_prio, pid_t *pgid);
+
 /* Extracts name of the shell to be used with execv*() function.  Returns
  * pointer to statically allocated buffer. */
 char * get_execv_path(char shell[]);
@@ -139,6 +139,14 @@ get_pid(void)
 	return GetCurrentProcessId();
 }
 
+void
+lower_io_priority(void)
+{
+#ifdef THREAD_MODE_BACKGROUND_BEGIN
+	(void)SetThreadPriority(GetCurrentThread(), THREAD_MODE_BACKGROUND_BEGIN);
+#endif
+}
+
 int
 wcwidth(wchar_t c)
 {
@@ -277,6 +277,10 @@ main(int argc, char *argv[])
 	vle_aucmd_execute("DirEnter", lwin.curr_dir, &lwin);
 	vle_aucmd_execute("DirEnter", rwin.curr_dir, &rwin);
 
+	/* Operations left unfinished by previous run can be continued only after
+	 * everything is loaded. */
+	resume_bg_ops();
+
 	event_loop(&quit);
 
 	return 0;
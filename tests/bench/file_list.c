@@ -0,0 +1,139 @@
+#include <stic.h>
+
+#include <stdio.h> /* snprintf() */
+#include <stdlib.h> /* free() */
+#include <string.h> /* memset() strcpy() strdup() */
+
+#include "../../src/cfg/config.h"
+#include "../../src/ui/ui.h"
+#include "../../src/utils/dynarray.h"
+#include "../../src/utils/filter.h"
+#include "../../src/utils/str.h"
+#include "../../src/filelist.h"
+#include "../../src/filtering.h"
+#include "../../src/sort.h"
+#include "../../src/status.h"
+
+#include "utils.h"
+
+/* Sorting and filtering of a big file list.  Drawing isn't measured, because it
+ * needs a terminal and processes only entries that fit on the screen. */
+
+/* Number of entries in the list. */
+#define NENTRIES 200000
+
+static void fill_list(void);
+static void free_list(void);
+
+SETUP()
+{
+	assert_success(init_status(&cfg));
+	cfg.sort_numbers = 1;
+	update_string(&cfg.slow_fs_list, "");
+
+	assert_success(filter_init(&lwin.local_filter.filter, 1));
+	assert_success(filter_init(&lwin.manual_filter, 1));
+	assert_success(filter_init(&lwin.auto_filter, 1));
+	strcpy(lwin.curr_dir, "/path");
+	curr_view = &lwin;
+	other_view = &rwin;
+
+	fill_list();
+}
+
+TEARDOWN()
+{
+	free_list();
+
+	filter_dispose(&lwin.local_filter.filter);
+	filter_dispose(&lwin.manual_filter);
+	filter_dispose(&lwin.auto_filter);
+
+	update_string(&cfg.slow_fs_list, NULL);
+	cfg.sort_numbers = 0;
+}
+
+TEST(sorting)
+{
+	lwin.sort[0] = SK_BY_NAME;
+	memset(&lwin.sort[1], SK_NONE, sizeof(lwin.sort) - 1);
+	bench_start();
+	sort_view(&lwin);
+	bench_report("sort 200k entries by name");
+
+	lwin.sort[0] = SK_BY_SIZE;
+	lwin.sort[1] = SK_BY_NAME;
+	memset(&lwin.sort[2], SK_NONE, sizeof(lwin.sort) - 2);
+	bench_start();
+	sort_view(&lwin);
+	bench_report("sort 200k entries by size and name");
+
+	lwin.sort[0] = -SK_BY_NAME;
+	memset(&lwin.sort[1], SK_NONE, sizeof(lwin.sort) - 1);
+	bench_start();
+	sort_view(&lwin);
+	bench_report("sort 200k entries by name in reverse");
+}
+
+TEST(local_filtering)
+{
+	/* Simulates typing of the filter one character at a time. */
+	bench_start();
+	local_filter_set(&lwin, "1");
+	local_filter_set(&lwin, "12");
+	local_filter_set(&lwin, "123");
+	local_filter_accept(&lwin);
+	bench_report("filter 200k entries interactively");
+
+	assert_true(lwin.list_rows < NENTRIES);
+}
+
+/* Fills left view with entries in pseudo-random order. */
+static void
+fill_list(void)
+{
+	int i;
+
+	lwin.list_rows = NENTRIES;
+	lwin.list_pos = 0;
+	lwin.dir_entry = dynarray_cextend(NULL,
+			lwin.list_rows*sizeof(*lwin.dir_entry));
+	for(i = 0; i < NENTRIES; ++i)
+	{
+		/* Pseudo-random permutation of indexes. */
+		const int n = (int)((i*7919LL)%NENTRIES);
+		char name[32];
+		snprintf(name, sizeof(name), "file%d", n);
+
+		lwin.dir_entry[i].name = strdup(name);
+		lwin.dir_entry[i].origin = &lwin.curr_dir[0];
+		lwin.dir_entry[i].type = (n%10 == 0) ? FT_DIR : FT_REG;
+		lwin.dir_entry[i].size = n%16;
+	}
+}
+
+/* Frees entries of the left view. */
+static void
+free_list(void)
+{
+	int i;
+
+	for(i = 0; i < lwin.list_rows; ++i)
+	{
+		free_dir_entry(&lwin, &lwin.dir_entry[i]);
+	}
+	dynarray_free(lwin.dir_entry);
+	lwin.dir_entry = NULL;
+	lwin.list_rows = 0;
+
+	for(i = 0; i < lwin.custom.entry_count; ++i)
+	{
+		free_dir_entry(&lwin, &lwin.custom.entries[i]);
+	}
+	dynarray_free(lwin.custom.entries);
+	lwin.custom.entries = NULL;
+	lwin.custom.entry_count = 0;
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,101 @@
+#include <stic.h>
+
+#include <sys/stat.h> /* mkdir() */
+
+#include <stdio.h> /* FILE fclose() fopen() fputs() puts() snprintf() */
+
+#include "../../src/compat/fs_limits.h"
+#include "../../src/io/private/uring.h"
+#include "../../src/io/ior.h"
+
+#include "utils.h"
+
+/* Removal of a tree of many small files with and without batching of requests
+ * via io_uring.  Each way is measured several times to see the spread. */
+
+/* Number of subdirectories of the tree. */
+#define NDIRS 10
+
+/* Number of files in each of the subdirectories. */
+#define NFILES 500
+
+/* Number of measurements of each way. */
+#define NROUNDS 5
+
+static void measure(const char label[]);
+static void create_tree(const char root[]);
+
+TEARDOWN()
+{
+	uring_disable(0);
+}
+
+TEST(removal_in_batches)
+{
+	uring_t *const ring = uring_create(8);
+	if(ring == NULL)
+	{
+		puts("io_uring isn't supported, batches aren't measured");
+		return;
+	}
+	uring_free(ring);
+
+	measure("rm 5000 files via io_uring");
+}
+
+TEST(removal_one_by_one)
+{
+	uring_disable(1);
+	measure("rm 5000 files via system calls");
+}
+
+/* Creates and removes the tree several times printing time of each removal. */
+static void
+measure(const char label[])
+{
+	int i;
+	for(i = 0; i < NROUNDS; ++i)
+	{
+		io_args_t args = {
+			.arg1.path = SANDBOX_PATH "/tree",
+			.nworkers = 2,
+		};
+		ioe_errlst_init(&args.result.errors);
+
+		create_tree(SANDBOX_PATH "/tree");
+
+		bench_start();
+		assert_success(ior_rm(&args));
+		bench_report(label);
+
+		assert_int_equal(0, args.result.errors.error_count);
+	}
+}
+
+/* Creates directory with several subdirectories filled with small files. */
+static void
+create_tree(const char root[])
+{
+	int i, j;
+
+	assert_success(mkdir(root, 0700));
+	for(i = 0; i < NDIRS; ++i)
+	{
+		char path[PATH_MAX];
+		snprintf(path, sizeof(path), "%s/dir%d", root, i);
+		assert_success(mkdir(path, 0700));
+
+		for(j = 0; j < NFILES; ++j)
+		{
+			FILE *f;
+			snprintf(path, sizeof(path), "%s/dir%d/file%d", root, i, j);
+			f = fopen(path, "w");
+			assert_non_null(f);
+			fputs("x", f);
+			fclose(f);
+		}
+	}
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,73 @@
+#include <stic.h>
+
+#include <stdio.h> /* snprintf() */
+
+#include "../../src/utils/trie.h"
+
+#include "utils.h"
+
+/* Insertion, lookup and freeing of many keys that look like paths. */
+
+/* Common prefix of keys, which makes them about 60 bytes long. */
+#define PREFIX "/home/user/projects/some-project/build/output/objects/"
+
+static void benchmark(int count, const char label[]);
+
+TEST(keys_10k)
+{
+	benchmark(10*1000, "10k");
+}
+
+TEST(keys_100k)
+{
+	benchmark(100*1000, "100k");
+}
+
+TEST(keys_1m)
+{
+	benchmark(1000*1000, "1m");
+}
+
+/* Measures insertion of count unique keys into a trie, lookup of each of them
+ * and freeing of the trie. */
+static void
+benchmark(int count, const char label[])
+{
+	int i;
+	int found = 0;
+	char msg[64];
+	trie_t trie;
+
+	bench_start();
+	trie = trie_create();
+	for(i = 0; i < count; ++i)
+	{
+		char key[128];
+		snprintf(key, sizeof(key), PREFIX "%07d.o", i);
+		(void)trie_set(trie, key, &trie);
+	}
+	snprintf(msg, sizeof(msg), "trie: insert %s keys", label);
+	bench_report(msg);
+
+	bench_start();
+	for(i = 0; i < count; ++i)
+	{
+		char key[128];
+		void *data;
+		snprintf(key, sizeof(key), PREFIX "%07d.o", i);
+		found += (trie_get(trie, key, &data) == 0);
+	}
+	snprintf(msg, sizeof(msg), "trie: look up %s keys", label);
+	bench_report(msg);
+
+	bench_start();
+	trie_free(trie);
+	snprintf(msg, sizeof(msg), "trie: free %s keys", label);
+	bench_report(msg);
+
+	/* Checked once outside of measurements. */
+	assert_int_equal(count, found);
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,28 @@
+#include "utils.h"
+
+#include <stdio.h> /* printf() */
+#include <time.h> /* CLOCK_MONOTONIC clock_gettime() timespec */
+
+/* Moment of the last bench_start() call. */
+static struct timespec started;
+
+void
+bench_start(void)
+{
+	clock_gettime(CLOCK_MONOTONIC, &started);
+}
+
+void
+bench_report(const char label[])
+{
+	struct timespec now;
+	long long ms;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	ms = (now.tv_sec - started.tv_sec)*1000LL
+	   + (now.tv_nsec - started.tv_nsec)/1000000;
+	printf("%-40s %6lld ms\n", label, ms);
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,13 @@
+#ifndef VIFM_TESTS__BENCH__UTILS_H__
+#define VIFM_TESTS__BENCH__UTILS_H__
+
+/* Remembers current time as the beginning of a measurement. */
+void bench_start(void);
+
+/* Prints time passed since the last bench_start() call along with the label. */
+void bench_report(const char label[]);
+
+#endif /* VIFM_TESTS__BENCH__UTILS_H__ */
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,123 @@
+#include <stic.h>
+
+#include <unistd.h> /* rmdir() unlink() */
+
+#include <stddef.h> /* NULL */
+#include <stdio.h> /* FILE fclose() fopen() fputs() fread() */
+#include <string.h> /* strlen() */
+
+#include "../../src/io/iojournal.h"
+#include "../../src/utils/fs.h"
+#include "../../src/utils/string_array.h"
+#include "../../src/fileops.h"
+#include "../../src/ops.h"
+
+static iojournal_t * reload_journal(iojournal_t *journal);
+static void write_file(const char path[], const char text[]);
+static void check_file(const char path[], const char expected[]);
+
+static char *srcs[] = { SANDBOX_PATH "/src" };
+static char *dsts[] = { SANDBOX_PATH "/dst" };
+
+static iojournal_t *journal;
+static ops_t *ops;
+
+SETUP()
+{
+	journal = iojournal_create(SANDBOX_PATH "/journal", IOJ_COPY, 0,
+			SANDBOX_PATH, srcs, dsts, 1U);
+	assert_non_null(journal);
+
+	write_file(srcs[0], "contents of source");
+	ops = ops_alloc(OP_COPY, 1, "copying", SANDBOX_PATH, SANDBOX_PATH);
+}
+
+TEARDOWN()
+{
+	ops_free(ops);
+	iojournal_close(journal, 1);
+
+	assert_success(unlink(srcs[0]));
+	assert_success(unlink(dsts[0]));
+	assert_success(rmdir(SANDBOX_PATH "/journal"));
+}
+
+TEST(existing_destination_of_not_started_item_is_left_alone)
+{
+	write_file(dsts[0], "user");
+
+	journal = reload_journal(journal);
+	ops->journal = journal;
+	assert_success(resume_item(ops, journal, 0U));
+
+	check_file(dsts[0], "user");
+}
+
+TEST(missing_destination_of_not_started_item_is_created)
+{
+	journal = reload_journal(journal);
+	ops->journal = journal;
+	assert_success(resume_item(ops, journal, 0U));
+
+	check_file(dsts[0], "contents of source");
+	assert_true(journal->items[0].started);
+}
+
+TEST(destination_of_started_item_is_continued)
+{
+	iojournal_item_started(journal, 0U);
+	write_file(dsts[0], "contents");
+
+	journal = reload_journal(journal);
+	ops->journal = journal;
+	assert_success(resume_item(ops, journal, 0U));
+
+	check_file(dsts[0], "contents of source");
+}
+
+/* Closes journal keeping its file and loads it back.  Returns loaded
+ * journal. */
+static iojournal_t *
+reload_journal(iojournal_t *journal)
+{
+	int count;
+	char **list;
+
+	iojournal_close(journal, 0);
+
+	list = iojournal_list(SANDBOX_PATH "/journal", &count);
+	assert_int_equal(1, count);
+	journal = iojournal_load(list[0]);
+	free_string_array(list, count);
+
+	assert_non_null(journal);
+	return journal;
+}
+
+/* Replaces contents of the file. */
+static void
+write_file(const char path[], const char text[])
+{
+	FILE *const f = fopen(path, "wb");
+	assert_non_null(f);
+	fputs(text, f);
+	fclose(f);
+}
+
+/* Checks that file has expected contents. */
+static void
+check_file(const char path[], const char expected[])
+{
+	char data[64];
+	size_t len;
+	FILE *const f = fopen(path, "rb");
+	assert_non_null(f);
+
+	len = fread(data, 1U, sizeof(data) - 1U, f);
+	data[len] = '\0';
+	assert_string_equal(expected, data);
+	fclose(f);
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
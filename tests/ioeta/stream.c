@@ -0,0 +1,202 @@
+#include <stic.h>
+
+#include <unistd.h> /* usleep() */
+
+#include <stddef.h> /* NULL */
+#include <stdio.h> /* FILE fclose() fopen() */
+
+#include "../../src/compat/os.h"
+#include "../../src/io/private/ioeta.h"
+#include "../../src/io/private/walker.h"
+#include "../../src/io/ioeta.h"
+#include "../../src/io/iop.h"
+#include "../../src/io/ior.h"
+#include "../../src/utils/fs.h"
+
+static void create_file(const char path[]);
+static void wait_for_estimation(ioeta_estim_t *estim);
+static void copy_dir(ioeta_estim_t *estim, int nworkers);
+static void remove_dir(const char path[]);
+
+TEST(calculation_returns_immediately_and_totals_are_synced_on_update)
+{
+	ioeta_estim_t *const estim = ioeta_alloc(NULL);
+	ioeta_stream(estim, 0);
+	assert_non_null(estim->walker);
+
+	ioeta_calculate(estim, TEST_DATA_PATH "/various-sizes", 0);
+	ioeta_calculate(estim, TEST_DATA_PATH "/existing-files", 1);
+	wait_for_estimation(estim);
+
+	assert_int_equal(0, estim->total_items);
+	assert_int_equal(0, estim->total_bytes);
+
+	ioeta_update(estim, NULL, NULL, 0, 0);
+
+	assert_int_equal(8, estim->total_items);
+	assert_int_equal(73728, estim->total_bytes);
+
+	ioeta_free(estim);
+}
+
+TEST(totals_are_not_decreased_by_syncing)
+{
+	ioeta_estim_t *const estim = ioeta_alloc(NULL);
+	ioeta_stream(estim, 0);
+
+	ioeta_calculate(estim, TEST_DATA_PATH "/various-sizes", 0);
+	wait_for_estimation(estim);
+
+	ioeta_update(estim, NULL, NULL, 0, 100000);
+
+	assert_int_equal(7, estim->total_items);
+	assert_int_equal(100000, estim->total_bytes);
+
+	ioeta_free(estim);
+}
+
+TEST(copying_reuses_listing_of_estimation)
+{
+	ioeta_estim_t *const estim = ioeta_alloc(NULL);
+	ioeta_stream(estim, 1);
+
+	assert_success(os_mkdir(SANDBOX_PATH "/src", 0700));
+	create_file(SANDBOX_PATH "/src/listed");
+
+	ioeta_calculate(estim, SANDBOX_PATH "/src", 0);
+	wait_for_estimation(estim);
+
+	/* The file is missing from the listing. */
+	create_file(SANDBOX_PATH "/src/unlisted");
+
+	copy_dir(estim, 0);
+	ioeta_free(estim);
+
+	assert_true(path_exists(SANDBOX_PATH "/dst/listed", NODEREF));
+	assert_false(path_exists(SANDBOX_PATH "/dst/unlisted", NODEREF));
+
+	remove_dir(SANDBOX_PATH "/src");
+	remove_dir(SANDBOX_PATH "/dst");
+}
+
+TEST(parallel_copying_reuses_listing_of_estimation)
+{
+	ioeta_estim_t *const estim = ioeta_alloc(NULL);
+	ioeta_stream(estim, 1);
+
+	assert_success(os_mkdir(SANDBOX_PATH "/src", 0700));
+	assert_success(os_mkdir(SANDBOX_PATH "/src/sub", 0700));
+	create_file(SANDBOX_PATH "/src/sub/listed");
+
+	ioeta_calculate(estim, SANDBOX_PATH "/src", 0);
+	wait_for_estimation(estim);
+
+	create_file(SANDBOX_PATH "/src/sub/unlisted");
+
+	copy_dir(estim, 4);
+
+	assert_int_equal(1, estim->total_items);
+	assert_int_equal(1, estim->current_item);
+	ioeta_free(estim);
+
+	assert_true(path_exists(SANDBOX_PATH "/dst/sub/listed", NODEREF));
+	assert_false(path_exists(SANDBOX_PATH "/dst/sub/unlisted", NODEREF));
+
+	remove_dir(SANDBOX_PATH "/src");
+	remove_dir(SANDBOX_PATH "/dst");
+}
+
+TEST(copying_without_listing_traverses_the_tree)
+{
+	ioeta_estim_t *const estim = ioeta_alloc(NULL);
+	ioeta_stream(estim, 0);
+
+	assert_success(os_mkdir(SANDBOX_PATH "/src", 0700));
+	create_file(SANDBOX_PATH "/src/listed");
+
+	ioeta_calculate(estim, SANDBOX_PATH "/src", 0);
+	wait_for_estimation(estim);
+
+	create_file(SANDBOX_PATH "/src/unlisted");
+
+	copy_dir(estim, 0);
+	ioeta_free(estim);
+
+	assert_true(path_exists(SANDBOX_PATH "/dst/listed", NODEREF));
+	assert_true(path_exists(SANDBOX_PATH "/dst/unlisted", NODEREF));
+
+	remove_dir(SANDBOX_PATH "/src");
+	remove_dir(SANDBOX_PATH "/dst");
+}
+
+TEST(listing_is_consumed_while_it_is_being_made)
+{
+	ioeta_estim_t *const estim = ioeta_alloc(NULL);
+	ioeta_stream(estim, 1);
+
+	assert_success(os_mkdir(SANDBOX_PATH "/src", 0700));
+	create_file(SANDBOX_PATH "/src/a");
+	create_file(SANDBOX_PATH "/src/b");
+
+	/* Copying starts right away and waits for the listing if needed. */
+	ioeta_calculate(estim, SANDBOX_PATH "/src", 0);
+	copy_dir(estim, 2);
+	ioeta_free(estim);
+
+	assert_true(path_exists(SANDBOX_PATH "/dst/a", NODEREF));
+	assert_true(path_exists(SANDBOX_PATH "/dst/b", NODEREF));
+
+	remove_dir(SANDBOX_PATH "/src");
+	remove_dir(SANDBOX_PATH "/dst");
+}
+
+/* Creates empty file. */
+static void
+create_file(const char path[])
+{
+	FILE *const f = fopen(path, "w");
+	assert_non_null(f);
+	fclose(f);
+}
+
+/* Waits until background estimation is done. */
+static void
+wait_for_estimation(ioeta_estim_t *estim)
+{
+	while(!walker_finished(estim->walker))
+	{
+		usleep(1000);
+	}
+}
+
+/* Copies src directory of the sandbox to dst one. */
+static void
+copy_dir(ioeta_estim_t *estim, int nworkers)
+{
+	io_args_t args = {
+		.arg1.src = SANDBOX_PATH "/src",
+		.arg2.dst = SANDBOX_PATH "/dst",
+		.nworkers = nworkers,
+		.estim = estim,
+	};
+	ioe_errlst_init(&args.result.errors);
+
+	assert_success(ior_cp(&args));
+	assert_int_equal(0, args.result.errors.error_count);
+}
+
+/* Removes directory along with its content. */
+static void
+remove_dir(const char path[])
+{
+	io_args_t args = {
+		.arg1.path = path,
+	};
+	ioe_errlst_init(&args.result.errors);
+
+	assert_success(ior_rm(&args));
+	assert_int_equal(0, args.result.errors.error_count);
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,112 @@
+#include <stic.h>
+
+#include <stdio.h> /* FILE fclose() fopen() fwrite() */
+#include <stdlib.h> /* free() malloc() */
+
+#include "../../src/io/iop.h"
+#include "../../src/utils/fs.h"
+
+#include "utils.h"
+
+/* Size of file to check correctness of copying, crosses boundaries of chunks
+ * used by all methods. */
+#define SMALL_SIZE (9*1024*1024 + 1)
+
+/* Size of file for benchmarking, run tests one by one to compare throughput of
+ * different methods. */
+#define BIG_SIZE (64*1024*1024)
+
+static void check_method(CopyMethod method, size_t size);
+static void make_file(const char path[], size_t size);
+
+TEARDOWN()
+{
+	iop_force_copy_method(CM_AUTO);
+}
+
+TEST(copy_file_range_copies_file)
+{
+	check_method(CM_COPY_FILE_RANGE, SMALL_SIZE);
+}
+
+TEST(sendfile_copies_file)
+{
+	check_method(CM_SENDFILE, SMALL_SIZE);
+}
+
+TEST(buffered_copying_copies_file)
+{
+	check_method(CM_BUFFERED, SMALL_SIZE);
+}
+
+TEST(automatic_method_copies_file)
+{
+	check_method(CM_AUTO, SMALL_SIZE);
+}
+
+TEST(benchmark_copy_file_range)
+{
+	check_method(CM_COPY_FILE_RANGE, BIG_SIZE);
+}
+
+TEST(benchmark_sendfile)
+{
+	check_method(CM_SENDFILE, BIG_SIZE);
+}
+
+TEST(benchmark_buffered_copying)
+{
+	check_method(CM_BUFFERED, BIG_SIZE);
+}
+
+/* Copies file of specified size using the method and checks the result. */
+static void
+check_method(CopyMethod method, size_t size)
+{
+	make_file(SANDBOX_PATH "/src", size);
+
+	iop_force_copy_method(method);
+
+	{
+		io_args_t args = {
+			.arg1.src = SANDBOX_PATH "/src",
+			.arg2.dst = SANDBOX_PATH "/dst",
+		};
+		ioe_errlst_init(&args.result.errors);
+
+		assert_success(iop_cp(&args));
+
+		assert_int_equal(0, args.result.errors.error_count);
+	}
+
+	assert_true(get_file_size(SANDBOX_PATH "/dst") == size);
+	assert_true(files_have_same_content(SANDBOX_PATH "/src", SANDBOX_PATH "/dst"));
+
+	delete_test_file(SANDBOX_PATH "/src");
+	delete_test_file(SANDBOX_PATH "/dst");
+}
+
+/* Creates file of specified size filled with pseudo-random data. */
+static void
+make_file(const char path[], size_t size)
+{
+	unsigned int seed = 1U;
+	size_t i;
+	unsigned char *const data = malloc(size);
+	FILE *const f = fopen(path, "wb");
+	assert_non_null(data);
+	assert_non_null(f);
+
+	for(i = 0U; i < size; ++i)
+	{
+		seed = seed*1103515245U + 12345U;
+		data[i] = seed >> 16;
+	}
+
+	assert_int_equal(size, fwrite(data, 1, size, f));
+	fclose(f);
+	free(data);
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
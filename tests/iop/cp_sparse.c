@@ -0,0 +1,144 @@
+#include <stic.h>
+
+#include <sys/stat.h> /* stat */
+#include <fcntl.h> /* O_CREAT O_WRONLY open() */
+#include <unistd.h> /* close() ftruncate() pwrite() */
+
+#include <string.h> /* memset() */
+
+#include "../../src/io/ioeta.h"
+#include "../../src/io/iop.h"
+#include "../../src/utils/fs.h"
+
+#include "utils.h"
+
+/* Apparent size of sparse files. */
+#define SPARSE_SIZE (32*1024*1024)
+
+/* Size of each of data regions. */
+#define DATA_SIZE (64*1024)
+
+static void make_sparse_file(const char path[], int trailing_hole);
+static void copy_file(ioeta_estim_t *estim);
+static int allocated_size(const char path[]);
+static int sparse_files_supported(void);
+
+TEST(holes_are_not_written, IF(sparse_files_supported))
+{
+	make_sparse_file(SANDBOX_PATH "/src", 0);
+	copy_file(NULL);
+
+	assert_true(get_file_size(SANDBOX_PATH "/dst") == SPARSE_SIZE);
+	assert_true(allocated_size(SANDBOX_PATH "/dst") < SPARSE_SIZE/4);
+	assert_true(files_have_same_content(SANDBOX_PATH "/src",
+				SANDBOX_PATH "/dst"));
+
+	delete_test_file(SANDBOX_PATH "/src");
+	delete_test_file(SANDBOX_PATH "/dst");
+}
+
+TEST(trailing_hole_is_recreated, IF(sparse_files_supported))
+{
+	make_sparse_file(SANDBOX_PATH "/src", 1);
+	copy_file(NULL);
+
+	assert_true(get_file_size(SANDBOX_PATH "/dst") == SPARSE_SIZE);
+	assert_true(allocated_size(SANDBOX_PATH "/dst") < SPARSE_SIZE/4);
+	assert_true(files_have_same_content(SANDBOX_PATH "/src",
+				SANDBOX_PATH "/dst"));
+
+	delete_test_file(SANDBOX_PATH "/src");
+	delete_test_file(SANDBOX_PATH "/dst");
+}
+
+TEST(progress_counts_only_data, IF(sparse_files_supported))
+{
+	ioeta_estim_t *const estim = ioeta_alloc(NULL);
+
+	make_sparse_file(SANDBOX_PATH "/src", 0);
+
+	ioeta_calculate(estim, SANDBOX_PATH "/src", 0);
+	assert_true(estim->total_bytes < SPARSE_SIZE/4);
+
+	copy_file(estim);
+	assert_true(estim->current_byte == 3*DATA_SIZE);
+	assert_true(estim->total_bytes < SPARSE_SIZE/4);
+
+	ioeta_free(estim);
+
+	delete_test_file(SANDBOX_PATH "/src");
+	delete_test_file(SANDBOX_PATH "/dst");
+}
+
+/* Creates sparse file with data regions at the beginning and in the middle
+ * and optionally at the end. */
+static void
+make_sparse_file(const char path[], int trailing_hole)
+{
+	char data[DATA_SIZE];
+	const int fd = open(path, O_CREAT | O_WRONLY, 0600);
+	assert_true(fd >= 0);
+
+	memset(data, 'x', sizeof(data));
+	assert_int_equal(DATA_SIZE, pwrite(fd, data, sizeof(data), 0));
+	assert_int_equal(DATA_SIZE, pwrite(fd, data, sizeof(data), SPARSE_SIZE/2));
+
+	if(trailing_hole)
+	{
+		assert_success(ftruncate(fd, SPARSE_SIZE));
+	}
+	else
+	{
+		assert_int_equal(DATA_SIZE, pwrite(fd, data, sizeof(data),
+					SPARSE_SIZE - DATA_SIZE));
+	}
+
+	close(fd);
+}
+
+/* Copies source file to destination. */
+static void
+copy_file(ioeta_estim_t *estim)
+{
+	io_args_t args = {
+		.arg1.src = SANDBOX_PATH "/src",
+		.arg2.dst = SANDBOX_PATH "/dst",
+
+		.estim = estim,
+	};
+	ioe_errlst_init(&args.result.errors);
+
+	assert_success(iop_cp(&args));
+
+	assert_int_equal(0, args.result.errors.error_count);
+}
+
+/* Queries number of bytes allocated for the file.  Returns the number. */
+static int
+allocated_size(const char path[])
+{
+	struct stat st;
+	assert_success(stat(path, &st));
+	return st.st_blocks*512;
+}
+
+/* Checks whether sandbox is on a file system that supports sparse files.
+ * Returns non-zero if so. */
+static int
+sparse_files_supported(void)
+{
+#ifdef __linux__
+	int supported;
+
+	make_sparse_file(SANDBOX_PATH "/probe", 1);
+	supported = (allocated_size(SANDBOX_PATH "/probe") < SPARSE_SIZE/4);
+	delete_test_file(SANDBOX_PATH "/probe");
+
+	return supported;
+#else
+	return 0;
+#endif
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,174 @@
+#include <stic.h>
+
+#include <unistd.h> /* truncate() */
+
+#include <stdio.h> /* FILE fclose() fgetc() fopen() fputc() fseek() fwrite() */
+#include <stdlib.h> /* free() malloc() */
+
+#include "../../src/io/iop.h"
+#include "../../src/utils/fs.h"
+
+#include "utils.h"
+
+/* Size of file to check correctness of copying, crosses boundaries of blocks
+ * and isn't a multiple of alignment of direct I/O. */
+#define SMALL_SIZE (3*1024*1024 + 1)
+
+/* Size of file for benchmarking, compare with benchmarks in cp_methods.c to
+ * see cost of verification. */
+#define BIG_SIZE (64*1024*1024)
+
+static void check_verified_copy(IoVerify verify, size_t size);
+static int copy_file(IoVerify verify, IoCrs crs);
+static void make_file(const char path[], size_t size);
+static void corrupt_file(const char path[]);
+static int not_windows(void);
+
+TEARDOWN()
+{
+	iop_set_verify_hook(NULL);
+}
+
+TEST(copy_verified_with_fast_hash, IF(not_windows))
+{
+	check_verified_copy(IO_VERIFY_FAST, SMALL_SIZE);
+}
+
+TEST(copy_verified_with_sha256, IF(not_windows))
+{
+	check_verified_copy(IO_VERIFY_SHA256, SMALL_SIZE);
+}
+
+TEST(empty_file_is_verified, IF(not_windows))
+{
+	check_verified_copy(IO_VERIFY_SHA256, 0U);
+}
+
+TEST(appended_part_is_verified, IF(not_windows))
+{
+	make_file(SANDBOX_PATH "/src", SMALL_SIZE);
+	assert_success(copy_file(IO_VERIFY_NONE, IO_CRS_FAIL));
+
+	/* Leave part of the file that doesn't end at aligned offset. */
+	assert_success(truncate(SANDBOX_PATH "/dst", 12345));
+
+	assert_success(copy_file(IO_VERIFY_FAST, IO_CRS_APPEND_TO_FILES));
+	assert_true(files_have_same_content(SANDBOX_PATH "/src", SANDBOX_PATH "/dst"));
+
+	delete_test_file(SANDBOX_PATH "/src");
+	delete_test_file(SANDBOX_PATH "/dst");
+}
+
+TEST(mismatch_is_reported, IF(not_windows))
+{
+	make_file(SANDBOX_PATH "/src", SMALL_SIZE);
+	iop_set_verify_hook(&corrupt_file);
+
+	{
+		io_args_t args = {
+			.arg1.src = SANDBOX_PATH "/src",
+			.arg2.dst = SANDBOX_PATH "/dst",
+			.verify = IO_VERIFY_FAST,
+		};
+		ioe_errlst_init(&args.result.errors);
+
+		assert_failure(iop_cp(&args));
+
+		assert_int_equal(1, args.result.errors.error_count);
+		assert_string_equal(SANDBOX_PATH "/dst",
+				args.result.errors.errors[0].path);
+		ioe_errlst_free(&args.result.errors);
+	}
+
+	delete_test_file(SANDBOX_PATH "/src");
+	delete_test_file(SANDBOX_PATH "/dst");
+}
+
+TEST(benchmark_verified_copying, IF(not_windows))
+{
+	check_verified_copy(IO_VERIFY_FAST, BIG_SIZE);
+}
+
+/* Copies file of specified size with verification and checks the result. */
+static void
+check_verified_copy(IoVerify verify, size_t size)
+{
+	make_file(SANDBOX_PATH "/src", size);
+
+	assert_success(copy_file(verify, IO_CRS_FAIL));
+
+	assert_true(get_file_size(SANDBOX_PATH "/dst") == size);
+	assert_true(files_have_same_content(SANDBOX_PATH "/src", SANDBOX_PATH "/dst"));
+
+	delete_test_file(SANDBOX_PATH "/src");
+	delete_test_file(SANDBOX_PATH "/dst");
+}
+
+/* Copies src file of the sandbox to dst one.  Returns result of iop_cp(). */
+static int
+copy_file(IoVerify verify, IoCrs crs)
+{
+	int result;
+	io_args_t args = {
+		.arg1.src = SANDBOX_PATH "/src",
+		.arg2.dst = SANDBOX_PATH "/dst",
+		.arg3.crs = crs,
+		.verify = verify,
+	};
+	ioe_errlst_init(&args.result.errors);
+
+	result = iop_cp(&args);
+
+	assert_int_equal(0, args.result.errors.error_count);
+	return result;
+}
+
+/* Creates file of specified size filled with pseudo-random data. */
+static void
+make_file(const char path[], size_t size)
+{
+	unsigned int seed = 1U;
+	size_t i;
+	unsigned char *const data = malloc(size + 1U);
+	FILE *const f = fopen(path, "wb");
+	assert_non_null(data);
+	assert_non_null(f);
+
+	for(i = 0U; i < size; ++i)
+	{
+		seed = seed*1103515245U + 12345U;
+		data[i] = seed >> 16;
+	}
+
+	assert_int_equal(size, fwrite(data, 1, size, f));
+	fclose(f);
+	free(data);
+}
+
+/* Flips bits of a byte in the middle of the file. */
+static void
+corrupt_file(const char path[])
+{
+	int c;
+	FILE *const f = fopen(path, "r+b");
+	assert_non_null(f);
+
+	assert_success(fseek(f, SMALL_SIZE/2, SEEK_SET));
+	c = fgetc(f);
+	assert_success(fseek(f, SMALL_SIZE/2, SEEK_SET));
+	fputc(~c & 0xff, f);
+	fclose(f);
+}
+
+static int
+not_windows(void)
+{
+#ifdef _WIN32
+	return 0;
+#else
+	return 1;
+#endif
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
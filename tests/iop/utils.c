@@ -2,7 +2,8 @@
 
 #include <stic.h>
 
-#include <stdio.h> /* EOF FILE fclose() fopen() */
+#include <stdio.h> /* EOF FILE fclose() fopen() fread() */
+#include <string.h> /* memcmp() */
 
 #include "../../src/io/iop.h"
 
@@ -76,5 +77,30 @@ files_are_identical(const char a[], const char b[])
 	return a_data == b_data && a_data == EOF;
 }
 
+int
+files_have_same_content(const char a[], const char b[])
+{
+	char a_buf[64*1024], b_buf[64*1024];
+	size_t a_len, b_len;
+	int same;
+
+	FILE *const a_file = fopen(a, "rb");
+	FILE *const b_file = fopen(b, "rb");
+	assert_non_null(a_file);
+	assert_non_null(b_file);
+
+	do
+	{
+		a_len = fread(a_buf, 1, sizeof(a_buf), a_file);
+		b_len = fread(b_buf, 1, sizeof(b_buf), b_file);
+		same = (a_len == b_len && memcmp(a_buf, b_buf, a_len) == 0);
+	}
+	while(same && a_len != 0U);
+
+	fclose(a_file);
+	fclose(b_file);
+	return same;
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 filetype=c : */
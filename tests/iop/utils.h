@@ -9,6 +9,8 @@ void delete_test_file(const char name[]);
 
 int files_are_identical(const char a[], const char b[]);
 
+int files_have_same_content(const char a[], const char b[]);
+
 #endif /* VIFM_TESTS__UTILS_H__ */
 
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
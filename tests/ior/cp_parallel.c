@@ -0,0 +1,199 @@
+#include <stic.h>
+
+#include <sys/stat.h> /* stat chmod() */
+
+#include <stdio.h> /* FILE fclose() fgets() fopen() fputs() snprintf() */
+#include <string.h> /* strlen() */
+
+#include "../../src/compat/fs_limits.h"
+#include "../../src/compat/os.h"
+#include "../../src/io/ioeta.h"
+#include "../../src/io/iop.h"
+#include "../../src/io/ior.h"
+#include "../../src/utils/fs.h"
+
+#include "utils.h"
+
+/* Number of subdirectories of the source tree. */
+#define NDIRS 4
+
+/* Number of files in each of directories of the source tree. */
+#define NFILES 50
+
+static void create_tree(const char root[]);
+static void check_tree(const char root[]);
+static void remove_tree(const char root[]);
+static int not_windows(void);
+
+TEST(tree_is_copied_concurrently)
+{
+	ioeta_estim_t *const estim = ioeta_alloc(NULL);
+
+	create_tree(SANDBOX_PATH "/src");
+	ioeta_calculate(estim, SANDBOX_PATH "/src", 0);
+
+	{
+		io_args_t args = {
+			.arg1.src = SANDBOX_PATH "/src",
+			.arg2.dst = SANDBOX_PATH "/dst",
+			.nworkers = 4,
+			.estim = estim,
+		};
+		ioe_errlst_init(&args.result.errors);
+
+		assert_success(ior_cp(&args));
+		assert_int_equal(0, args.result.errors.error_count);
+	}
+
+	check_tree(SANDBOX_PATH "/dst");
+	assert_int_equal(estim->total_items, estim->current_item);
+	assert_true(estim->total_bytes == estim->current_byte);
+
+	ioeta_free(estim);
+	remove_tree(SANDBOX_PATH "/src");
+	remove_tree(SANDBOX_PATH "/dst");
+}
+
+TEST(permissions_are_set_after_files_are_copied, IF(not_windows))
+{
+	struct stat src;
+	struct stat dst;
+
+	create_tree(SANDBOX_PATH "/src");
+	assert_success(chmod(SANDBOX_PATH "/src/dir0", 0500));
+	assert_success(chmod(SANDBOX_PATH "/src", 0500));
+
+	{
+		io_args_t args = {
+			.arg1.src = SANDBOX_PATH "/src",
+			.arg2.dst = SANDBOX_PATH "/dst",
+			.nworkers = 3,
+		};
+		ioe_errlst_init(&args.result.errors);
+
+		assert_success(ior_cp(&args));
+		assert_int_equal(0, args.result.errors.error_count);
+	}
+
+	assert_success(os_stat(SANDBOX_PATH "/src/dir0", &src));
+	assert_success(os_stat(SANDBOX_PATH "/dst/dir0", &dst));
+	assert_int_equal(src.st_mode & 0777, dst.st_mode & 0777);
+	assert_success(os_stat(SANDBOX_PATH "/src", &src));
+	assert_success(os_stat(SANDBOX_PATH "/dst", &dst));
+	assert_int_equal(src.st_mode & 0777, dst.st_mode & 0777);
+
+	assert_success(chmod(SANDBOX_PATH "/src", 0700));
+	assert_success(chmod(SANDBOX_PATH "/src/dir0", 0700));
+	assert_success(chmod(SANDBOX_PATH "/dst", 0700));
+	assert_success(chmod(SANDBOX_PATH "/dst/dir0", 0700));
+
+	check_tree(SANDBOX_PATH "/dst");
+
+	remove_tree(SANDBOX_PATH "/src");
+	remove_tree(SANDBOX_PATH "/dst");
+}
+
+TEST(errors_of_workers_are_collected)
+{
+	create_tree(SANDBOX_PATH "/src");
+
+	/* Directory in place of a file can't be overwritten by a file. */
+	create_empty_dir(SANDBOX_PATH "/dst");
+	create_empty_dir(SANDBOX_PATH "/dst/dir1");
+	create_empty_dir(SANDBOX_PATH "/dst/dir1/file7");
+
+	{
+		io_args_t args = {
+			.arg1.src = SANDBOX_PATH "/src",
+			.arg2.dst = SANDBOX_PATH "/dst",
+			.arg3.crs = IO_CRS_REPLACE_FILES,
+			.nworkers = 4,
+		};
+		ioe_errlst_init(&args.result.errors);
+
+		assert_failure(ior_cp(&args));
+		assert_true(args.result.errors.error_count != 0);
+		ioe_errlst_free(&args.result.errors);
+	}
+
+	remove_tree(SANDBOX_PATH "/src");
+	remove_tree(SANDBOX_PATH "/dst");
+}
+
+/* Creates directory with several subdirectories filled with files, whose
+ * content is their name. */
+static void
+create_tree(const char root[])
+{
+	int i, j;
+
+	create_empty_dir(root);
+	for(i = 0; i < NDIRS; ++i)
+	{
+		char path[PATH_MAX];
+		snprintf(path, sizeof(path), "%s/dir%d", root, i);
+		create_empty_dir(path);
+
+		for(j = 0; j < NFILES; ++j)
+		{
+			FILE *f;
+			snprintf(path, sizeof(path), "%s/dir%d/file%d", root, i, j);
+			f = fopen(path, "w");
+			assert_non_null(f);
+			fputs(path + strlen(root), f);
+			fclose(f);
+		}
+	}
+}
+
+/* Checks that all files created by create_tree() are present and have expected
+ * content. */
+static void
+check_tree(const char root[])
+{
+	int i, j;
+
+	for(i = 0; i < NDIRS; ++i)
+	{
+		for(j = 0; j < NFILES; ++j)
+		{
+			char path[PATH_MAX];
+			char line[PATH_MAX];
+			FILE *f;
+
+			snprintf(path, sizeof(path), "%s/dir%d/file%d", root, i, j);
+			f = fopen(path, "r");
+			assert_non_null(f);
+			assert_non_null(fgets(line, sizeof(line), f));
+			fclose(f);
+
+			assert_string_equal(path + strlen(root), line);
+		}
+	}
+}
+
+/* Removes directory tree. */
+static void
+remove_tree(const char root[])
+{
+	io_args_t args = {
+		.arg1.path = root,
+	};
+	ioe_errlst_init(&args.result.errors);
+
+	assert_success(ior_rm(&args));
+	assert_int_equal(0, args.result.errors.error_count);
+}
+
+static int
+not_windows(void)
+{
+#ifdef _WIN32
+	return 0;
+#else
+	return 1;
+#endif
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
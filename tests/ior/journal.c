@@ -0,0 +1,313 @@
+#include <stic.h>
+
+#include <sys/stat.h> /* stat */
+#include <utime.h> /* utimbuf utime() */
+
+#include <stddef.h> /* NULL */
+#include <stdio.h> /* FILE fclose() fopen() fputs() fread() fwrite() */
+#include <string.h> /* memcmp() memset() */
+
+#include "../../src/compat/os.h"
+#include "../../src/io/iojournal.h"
+#include "../../src/io/iop.h"
+#include "../../src/io/ior.h"
+#include "../../src/utils/fs.h"
+#include "../../src/utils/string_array.h"
+
+#include "utils.h"
+
+/* Size of files used in tests. */
+#define FILE_SIZE (3*4096)
+
+static iojournal_t * create_journal(void);
+static iojournal_t * reload_journal(iojournal_t *journal);
+static void write_file(const char path[], char fill, size_t size);
+static void copy_with_journal(iojournal_t *journal);
+static void check_file(const char path[], const char expected[], size_t size);
+static int not_windows(void);
+static int linux_only(void);
+
+static char *srcs[] = { SANDBOX_PATH "/src", SANDBOX_PATH "/src2" };
+static char *dsts[] = { SANDBOX_PATH "/dst", SANDBOX_PATH "/dst2" };
+
+SETUP()
+{
+	create_empty_dir(SANDBOX_PATH "/journal");
+}
+
+TEARDOWN()
+{
+	delete_tree(SANDBOX_PATH "/journal");
+	iop_set_checkpoint_size(64*1024*1024);
+}
+
+TEST(journal_is_reloaded)
+{
+	iojournal_t *journal = create_journal();
+	assert_false(journal->resumed);
+
+	iojournal_item_cleared(journal, 0);
+	iojournal_item_started(journal, 0);
+	iojournal_item_done(journal, 1);
+	journal = reload_journal(journal);
+	assert_non_null(journal);
+
+	assert_true(journal->resumed);
+	assert_int_equal(IOJ_MOVE, journal->op);
+	assert_true(journal->force);
+	assert_string_equal(SANDBOX_PATH, journal->target_dir);
+	assert_int_equal(2, journal->nitems);
+	assert_string_equal(srcs[0], journal->items[0].src);
+	assert_string_equal(dsts[0], journal->items[0].dst);
+	assert_true(journal->items[0].cleared);
+	assert_true(journal->items[0].started);
+	assert_false(journal->items[0].done);
+	assert_string_equal(srcs[1], journal->items[1].src);
+	assert_string_equal(dsts[1], journal->items[1].dst);
+	assert_false(journal->items[1].cleared);
+	assert_false(journal->items[1].started);
+	assert_true(journal->items[1].done);
+
+	iojournal_close(journal, 1);
+}
+
+TEST(discarded_journal_is_removed)
+{
+	int count;
+	char **list;
+
+	iojournal_close(create_journal(), 1);
+
+	list = iojournal_list(SANDBOX_PATH "/journal", &count);
+	assert_int_equal(0, count);
+	free_string_array(list, count);
+}
+
+TEST(incomplete_record_is_dropped_on_loading)
+{
+	int count;
+	char **list;
+	FILE *f;
+	iojournal_t *journal = create_journal();
+	iojournal_close(journal, 0);
+
+	list = iojournal_list(SANDBOX_PATH "/journal", &count);
+	assert_int_equal(1, count);
+
+	f = fopen(list[0], "ab");
+	assert_non_null(f);
+	fputs("D1", f);
+	fclose(f);
+
+	journal = iojournal_load(list[0]);
+	assert_non_null(journal);
+	assert_false(journal->items[1].done);
+
+	/* New records are readable after the tail is dropped. */
+	iojournal_item_done(journal, 0);
+	journal = reload_journal(journal);
+	assert_non_null(journal);
+	assert_true(journal->items[0].done);
+	assert_false(journal->items[1].done);
+
+	iojournal_close(journal, 1);
+	free_string_array(list, count);
+}
+
+TEST(journal_in_use_is_not_loaded, IF(not_windows))
+{
+	int count;
+	char **list;
+	iojournal_t *const journal = create_journal();
+
+	list = iojournal_list(SANDBOX_PATH "/journal", &count);
+	assert_int_equal(1, count);
+	assert_null(iojournal_load(list[0]));
+
+	iojournal_close(journal, 1);
+	free_string_array(list, count);
+}
+
+TEST(partial_file_is_continued_from_checkpoint)
+{
+	char expected[FILE_SIZE];
+	iojournal_t *journal;
+	FILE *f;
+
+	memset(expected, 'x', sizeof(expected));
+	write_file(srcs[0], 'x', FILE_SIZE);
+
+	/* Data past the checkpoint might not have reached the disk. */
+	write_file(dsts[0], 'x', 4096);
+	f = fopen(dsts[0], "ab");
+	assert_non_null(f);
+	fputs("garbage", f);
+	fclose(f);
+
+	journal = create_journal();
+	iojournal_checkpoint(journal, dsts[0], 4096);
+	journal = reload_journal(journal);
+	assert_non_null(journal);
+
+	copy_with_journal(journal);
+	check_file(dsts[0], expected, FILE_SIZE);
+
+	iojournal_close(journal, 1);
+	delete_file(srcs[0]);
+	delete_file(dsts[0]);
+}
+
+TEST(complete_file_is_not_copied_again)
+{
+	char expected[FILE_SIZE];
+	struct stat st;
+	struct utimbuf times;
+	iojournal_t *journal;
+
+	memset(expected, 'y', sizeof(expected));
+	write_file(srcs[0], 'x', FILE_SIZE);
+	write_file(dsts[0], 'y', FILE_SIZE);
+
+	assert_success(os_stat(srcs[0], &st));
+	times.actime = st.st_atime;
+	times.modtime = st.st_mtime;
+	assert_success(utime(dsts[0], &times));
+
+	journal = reload_journal(create_journal());
+	assert_non_null(journal);
+
+	copy_with_journal(journal);
+	check_file(dsts[0], expected, FILE_SIZE);
+
+	iojournal_close(journal, 1);
+	delete_file(srcs[0]);
+	delete_file(dsts[0]);
+}
+
+TEST(copying_records_checkpoints, IF(linux_only))
+{
+	char expected[FILE_SIZE];
+	struct stat st;
+	iojournal_t *journal;
+	FILE *f;
+
+	memset(expected, 'x', sizeof(expected));
+	write_file(srcs[0], 'x', FILE_SIZE);
+
+	iop_set_checkpoint_size(4096);
+	journal = create_journal();
+	copy_with_journal(journal);
+	journal = reload_journal(journal);
+	assert_non_null(journal);
+
+	/* Make destination look like an interrupted copy. */
+	f = fopen(dsts[0], "ab");
+	assert_non_null(f);
+	fputs("garbage", f);
+	fclose(f);
+
+	assert_false(iojournal_resume_file(journal, srcs[0], dsts[0]));
+	assert_success(os_stat(dsts[0], &st));
+	assert_true(st.st_size >= 4096);
+	assert_true(st.st_size <= FILE_SIZE);
+
+	copy_with_journal(journal);
+	check_file(dsts[0], expected, FILE_SIZE);
+
+	iojournal_close(journal, 1);
+	delete_file(srcs[0]);
+	delete_file(dsts[0]);
+}
+
+/* Creates journal of moving with overwriting in the sandbox. */
+static iojournal_t *
+create_journal(void)
+{
+	iojournal_t *const journal = iojournal_create(SANDBOX_PATH "/journal",
+			IOJ_MOVE, 1, SANDBOX_PATH, srcs, dsts, 2U);
+	assert_non_null(journal);
+	return journal;
+}
+
+/* Closes journal keeping its file and loads it back.  Returns loaded
+ * journal. */
+static iojournal_t *
+reload_journal(iojournal_t *journal)
+{
+	int count;
+	char **list;
+
+	iojournal_close(journal, 0);
+
+	list = iojournal_list(SANDBOX_PATH "/journal", &count);
+	assert_int_equal(1, count);
+	journal = iojournal_load(list[0]);
+	free_string_array(list, count);
+
+	return journal;
+}
+
+/* Creates file of specified size filled with the same character. */
+static void
+write_file(const char path[], char fill, size_t size)
+{
+	char data[FILE_SIZE];
+	FILE *const f = fopen(path, "wb");
+	assert_non_null(f);
+
+	memset(data, fill, size);
+	assert_int_equal(size, fwrite(data, 1U, size, f));
+	fclose(f);
+}
+
+/* Copies first source file of the journal appending to destination. */
+static void
+copy_with_journal(iojournal_t *journal)
+{
+	io_args_t args = {
+		.arg1.src = srcs[0],
+		.arg2.dst = dsts[0],
+		.arg3.crs = IO_CRS_APPEND_TO_FILES,
+		.journal = journal,
+	};
+	ioe_errlst_init(&args.result.errors);
+
+	assert_success(iop_cp(&args));
+	assert_int_equal(0, args.result.errors.error_count);
+}
+
+/* Checks that file has expected contents. */
+static void
+check_file(const char path[], const char expected[], size_t size)
+{
+	char data[FILE_SIZE + 1];
+	FILE *const f = fopen(path, "rb");
+	assert_non_null(f);
+
+	assert_int_equal(size, fread(data, 1U, sizeof(data), f));
+	assert_success(memcmp(data, expected, size));
+	fclose(f);
+}
+
+static int
+not_windows(void)
+{
+#ifdef _WIN32
+	return 0;
+#else
+	return 1;
+#endif
+}
+
+static int
+linux_only(void)
+{
+#ifdef __linux__
+	return 1;
+#else
+	return 0;
+#endif
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
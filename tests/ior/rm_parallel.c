@@ -0,0 +1,204 @@
+#include <stic.h>
+
+#include <sys/stat.h> /* chmod() */
+#include <unistd.h> /* geteuid() symlink() */
+
+#include <stdio.h> /* FILE fclose() fopen() fputs() snprintf() */
+#include <string.h> /* strlen() */
+
+#include "../../src/compat/fs_limits.h"
+#include "../../src/io/private/ioeta.h"
+#include "../../src/io/ioeta.h"
+#include "../../src/io/ior.h"
+#include "../../src/utils/fs.h"
+
+#include "utils.h"
+
+/* Number of subdirectories of the tree at each level. */
+#define NDIRS 4
+
+/* Number of levels of subdirectories. */
+#define NLEVELS 3
+
+/* Number of files in each of directories of the tree. */
+#define NFILES 20
+
+static int create_tree(const char root[], int level);
+static int not_windows(void);
+static int non_root_on_unix_like_os(void);
+
+TEST(tree_is_removed_concurrently, IF(not_windows))
+{
+	const int nentries = create_tree(SANDBOX_PATH "/tree", 0);
+	ioeta_estim_t *const estim = ioeta_alloc(NULL);
+
+	/* Shallow estimation counts only the root, the rest is found on removal. */
+	ioeta_calculate(estim, SANDBOX_PATH "/tree", 1);
+	assert_int_equal(1, estim->total_items);
+
+	{
+		io_args_t args = {
+			.arg1.path = SANDBOX_PATH "/tree",
+			.nworkers = 4,
+			.estim = estim,
+		};
+		ioe_errlst_init(&args.result.errors);
+
+		assert_success(ior_rm(&args));
+		assert_int_equal(0, args.result.errors.error_count);
+	}
+
+	assert_false(path_exists(SANDBOX_PATH "/tree", NODEREF));
+	assert_int_equal(nentries + 1, estim->current_item);
+	assert_int_equal(nentries + 1, estim->total_items);
+	assert_true(estim->current_byte != 0U);
+	assert_true(estim->current_byte == estim->total_bytes);
+
+	ioeta_free(estim);
+}
+
+TEST(symbolic_links_are_not_followed, IF(not_windows))
+{
+	create_empty_dir(SANDBOX_PATH "/dir");
+	create_empty_file(SANDBOX_PATH "/dir/file");
+	create_empty_dir(SANDBOX_PATH "/tree");
+	assert_success(symlink(SANDBOX_PATH "/dir", SANDBOX_PATH "/tree/link"));
+
+	{
+		io_args_t args = {
+			.arg1.path = SANDBOX_PATH "/tree",
+			.nworkers = 2,
+		};
+		ioe_errlst_init(&args.result.errors);
+
+		assert_success(ior_rm(&args));
+		assert_int_equal(0, args.result.errors.error_count);
+	}
+
+	assert_false(path_exists(SANDBOX_PATH "/tree", NODEREF));
+	assert_true(path_exists(SANDBOX_PATH "/dir/file", NODEREF));
+
+	delete_file(SANDBOX_PATH "/dir/file");
+	delete_dir(SANDBOX_PATH "/dir");
+}
+
+TEST(deep_tree_is_removed, IF(not_windows))
+{
+	char path[PATH_MAX];
+	int i;
+
+	/* Deeper than number of levels whose descriptors are kept open. */
+	snprintf(path, sizeof(path), "%s", SANDBOX_PATH "/tree");
+	for(i = 0; i < 100; ++i)
+	{
+		create_empty_dir(path);
+		snprintf(path + strlen(path), sizeof(path) - strlen(path), "/f");
+		create_empty_file(path);
+		path[strlen(path) - 1] = 'd';
+	}
+
+	{
+		io_args_t args = {
+			.arg1.path = SANDBOX_PATH "/tree",
+			.nworkers = 4,
+		};
+		ioe_errlst_init(&args.result.errors);
+
+		assert_success(ior_rm(&args));
+		assert_int_equal(0, args.result.errors.error_count);
+	}
+
+	assert_false(path_exists(SANDBOX_PATH "/tree", NODEREF));
+}
+
+TEST(errors_stop_removal, IF(non_root_on_unix_like_os))
+{
+	create_tree(SANDBOX_PATH "/tree", 0);
+	assert_success(chmod(SANDBOX_PATH "/tree/dir1", 0500));
+
+	{
+		io_args_t args = {
+			.arg1.path = SANDBOX_PATH "/tree",
+			.nworkers = 4,
+		};
+		ioe_errlst_init(&args.result.errors);
+
+		assert_failure(ior_rm(&args));
+		assert_true(args.result.errors.error_count != 0);
+		ioe_errlst_free(&args.result.errors);
+	}
+
+	assert_true(path_exists(SANDBOX_PATH "/tree/dir1", NODEREF));
+	assert_success(chmod(SANDBOX_PATH "/tree/dir1", 0700));
+
+	{
+		io_args_t args = {
+			.arg1.path = SANDBOX_PATH "/tree",
+		};
+		ioe_errlst_init(&args.result.errors);
+
+		assert_success(ior_rm(&args));
+		assert_int_equal(0, args.result.errors.error_count);
+	}
+}
+
+/* Creates directory with several levels of subdirectories filled with files.
+ * Returns number of created entries excluding the root. */
+static int
+create_tree(const char root[], int level)
+{
+	int i;
+	int count = NFILES;
+
+	create_empty_dir(root);
+
+	for(i = 0; i < NFILES; ++i)
+	{
+		char path[PATH_MAX];
+		FILE *f;
+
+		snprintf(path, sizeof(path), "%s/file%d", root, i);
+		f = fopen(path, "w");
+		assert_non_null(f);
+		fputs(path, f);
+		fclose(f);
+	}
+
+	if(level == NLEVELS)
+	{
+		return count;
+	}
+
+	for(i = 0; i < NDIRS; ++i)
+	{
+		char path[PATH_MAX];
+		snprintf(path, sizeof(path), "%s/dir%d", root, i);
+		count += 1 + create_tree(path, level + 1);
+	}
+
+	return count;
+}
+
+static int
+not_windows(void)
+{
+#ifdef _WIN32
+	return 0;
+#else
+	return 1;
+#endif
+}
+
+/* Permissions don't restrict root user. */
+static int
+non_root_on_unix_like_os(void)
+{
+#if defined(_WIN32) || defined(__CYGWIN__)
+	return 0;
+#else
+	return (geteuid() != 0);
+#endif
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,161 @@
+#include <stic.h>
+
+#include <fcntl.h> /* AT_FDCWD */
+
+#include <stdio.h> /* FILE fclose() fopen() fputs() snprintf() */
+
+#include "../../src/compat/fs_limits.h"
+#include "../../src/io/private/uring.h"
+#include "../../src/io/ioeta.h"
+#include "../../src/io/ior.h"
+#include "../../src/utils/fs.h"
+
+#include "utils.h"
+
+/* Removal of many small files with and without batching of requests.  Timings
+ * of the two ways are compared by tests/bench/rm_uring.c. */
+
+/* Number of subdirectories of the tree. */
+#define NDIRS 10
+
+/* Number of files in each of the subdirectories. */
+#define NFILES 500
+
+static void create_tree(const char root[]);
+static void remove_tree(const char root[], int estimate);
+static int not_windows(void);
+
+TEARDOWN()
+{
+	uring_disable(0);
+}
+
+TEST(ring_is_either_created_or_not_supported)
+{
+	uring_t *const ring = uring_create(8);
+	if(ring != NULL)
+	{
+		assert_int_equal(8, uring_size(ring));
+	}
+	uring_free(ring);
+
+	uring_disable(1);
+	assert_null(uring_create(8));
+}
+
+TEST(ring_removes_files, IF(not_windows))
+{
+	int results[2];
+	uring_t *const ring = uring_create(2);
+	if(ring == NULL)
+	{
+		return;
+	}
+
+	create_empty_file(SANDBOX_PATH "/a");
+	assert_success(uring_unlink(ring, AT_FDCWD, SANDBOX_PATH "/a"));
+	assert_success(uring_unlink(ring, AT_FDCWD, SANDBOX_PATH "/b"));
+	assert_failure(uring_unlink(ring, AT_FDCWD, SANDBOX_PATH "/c"));
+	assert_success(uring_run(ring, results));
+
+	assert_int_equal(0, results[0]);
+	assert_true(results[1] != 0);
+	assert_false(path_exists(SANDBOX_PATH "/a", NODEREF));
+
+	uring_free(ring);
+}
+
+TEST(many_small_files_are_removed_in_batches, IF(not_windows))
+{
+	create_tree(SANDBOX_PATH "/tree");
+	remove_tree(SANDBOX_PATH "/tree", 0);
+}
+
+TEST(many_small_files_are_removed_one_by_one, IF(not_windows))
+{
+	uring_disable(1);
+	create_tree(SANDBOX_PATH "/tree");
+	remove_tree(SANDBOX_PATH "/tree", 0);
+}
+
+TEST(many_small_files_are_counted_in_batches, IF(not_windows))
+{
+	create_tree(SANDBOX_PATH "/tree");
+	remove_tree(SANDBOX_PATH "/tree", 1);
+}
+
+TEST(many_small_files_are_counted_one_by_one, IF(not_windows))
+{
+	uring_disable(1);
+	create_tree(SANDBOX_PATH "/tree");
+	remove_tree(SANDBOX_PATH "/tree", 1);
+}
+
+/* Creates directory with several subdirectories filled with small files. */
+static void
+create_tree(const char root[])
+{
+	int i, j;
+
+	create_empty_dir(root);
+	for(i = 0; i < NDIRS; ++i)
+	{
+		char path[PATH_MAX];
+		snprintf(path, sizeof(path), "%s/dir%d", root, i);
+		create_empty_dir(path);
+
+		for(j = 0; j < NFILES; ++j)
+		{
+			FILE *f;
+			snprintf(path, sizeof(path), "%s/dir%d/file%d", root, i, j);
+			f = fopen(path, "w");
+			assert_non_null(f);
+			fputs("x", f);
+			fclose(f);
+		}
+	}
+}
+
+/* Removes the tree by two threads checking that everything is accounted for
+ * when estimation is requested. */
+static void
+remove_tree(const char root[], int estimate)
+{
+	ioeta_estim_t *const estim = estimate ? ioeta_alloc(NULL) : NULL;
+	io_args_t args = {
+		.arg1.path = root,
+		.nworkers = 2,
+		.estim = estim,
+	};
+	ioe_errlst_init(&args.result.errors);
+
+	if(estim != NULL)
+	{
+		ioeta_calculate(estim, root, 1);
+	}
+
+	assert_success(ior_rm(&args));
+	assert_int_equal(0, args.result.errors.error_count);
+	assert_false(path_exists(root, NODEREF));
+
+	if(estim != NULL)
+	{
+		assert_int_equal(1 + NDIRS*(1 + NFILES), estim->current_item);
+		assert_int_equal(1 + NDIRS*(1 + NFILES), estim->total_items);
+		assert_true(estim->current_byte == estim->total_bytes);
+		ioeta_free(estim);
+	}
+}
+
+static int
+not_windows(void)
+{
+#ifdef _WIN32
+	return 0;
+#else
+	return 1;
+#endif
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
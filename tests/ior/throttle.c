@@ -0,0 +1,155 @@
+#include <stic.h>
+
+#include <sys/time.h> /* gettimeofday() timeval */
+
+#include <stddef.h> /* NULL */
+#include <stdint.h> /* uint64_t */
+#include <stdio.h> /* FILE fclose() fopen() fwrite() */
+#include <string.h> /* memset() */
+
+#include "../../src/io/ior.h"
+#include "../../src/io/iothrottle.h"
+#include "../../src/ui/cancellation.h"
+#include "../../src/utils/fs.h"
+
+#include "utils.h"
+
+static uint64_t get_time_ms(void);
+
+TEST(null_throttle_does_not_block)
+{
+	const uint64_t start = get_time_ms();
+	(void)iothrottle_charge(NULL, 1024U*1024U*1024U, 1000U, 0);
+	assert_true(get_time_ms() - start < 100U);
+}
+
+TEST(zero_rates_do_not_block)
+{
+	iothrottle_t *const throttle = iothrottle_create(0U, 0U, NULL);
+	const uint64_t start = get_time_ms();
+
+	assert_non_null(throttle);
+	(void)iothrottle_charge(throttle, 1024U*1024U*1024U, 1000U, 0);
+	assert_true(get_time_ms() - start < 100U);
+
+	iothrottle_free(throttle);
+}
+
+TEST(rate_of_bytes_is_limited)
+{
+	iothrottle_t *const throttle = iothrottle_create(100000U, 0U, NULL);
+	const uint64_t start = get_time_ms();
+
+	assert_non_null(throttle);
+	(void)iothrottle_charge(throttle, 10000U, 0U, 0);
+	(void)iothrottle_charge(throttle, 10000U, 0U, 0);
+	assert_true(get_time_ms() - start >= 150U);
+
+	iothrottle_free(throttle);
+}
+
+TEST(parent_limits_its_children)
+{
+	iothrottle_t *const parent = iothrottle_create(0U, 100U, NULL);
+	iothrottle_t *const child1 = iothrottle_create(0U, 0U, parent);
+	iothrottle_t *const child2 = iothrottle_create(0U, 0U, parent);
+	const uint64_t start = get_time_ms();
+
+	(void)iothrottle_charge(child1, 0U, 10U, 0);
+	(void)iothrottle_charge(child2, 0U, 10U, 0);
+	assert_true(get_time_ms() - start >= 150U);
+
+	iothrottle_free(child1);
+	iothrottle_free(child2);
+	iothrottle_free(parent);
+}
+
+TEST(limits_can_be_lifted)
+{
+	iothrottle_t *const throttle = iothrottle_create(10U, 10U, NULL);
+	const uint64_t start = get_time_ms();
+
+	assert_non_null(throttle);
+	iothrottle_set_limits(throttle, 0U, 0U);
+	(void)iothrottle_charge(throttle, 1024U*1024U, 1000U, 0);
+	assert_true(get_time_ms() - start < 100U);
+
+	iothrottle_free(throttle);
+}
+
+TEST(waiting_is_interrupted_by_cancellation)
+{
+	iothrottle_t *const throttle = iothrottle_create(1000U, 0U, NULL);
+	const uint64_t start = get_time_ms();
+	assert_non_null(throttle);
+
+	ui_cancellation_enable();
+	ui_cancellation_request();
+	assert_true(iothrottle_charge(throttle, 10000U, 0U, 1));
+	ui_cancellation_disable();
+	ui_cancellation_reset();
+	assert_true(get_time_ms() - start < 100U);
+
+	iothrottle_free(throttle);
+}
+
+TEST(chunks_are_limited_by_bursts)
+{
+	iothrottle_t *const parent = iothrottle_create(100000U, 0U, NULL);
+	iothrottle_t *const child = iothrottle_create(0U, 10U, parent);
+	iothrottle_t *const slow = iothrottle_create(1U, 0U, NULL);
+
+	assert_int_equal(1000U, iothrottle_chunk(NULL, 1000U));
+	assert_int_equal(1000U, iothrottle_chunk(child, 1000U));
+	assert_int_equal(25000U, iothrottle_chunk(child, 8U*1024U*1024U));
+	assert_int_equal(1U, iothrottle_chunk(slow, 8U*1024U*1024U));
+
+	iothrottle_free(slow);
+	iothrottle_free(child);
+	iothrottle_free(parent);
+}
+
+TEST(copying_is_throttled)
+{
+	char data[32*1024];
+	FILE *f;
+	uint64_t start;
+	iothrottle_t *const throttle = iothrottle_create(128U*1024U, 0U, NULL);
+	assert_non_null(throttle);
+
+	memset(data, 'x', sizeof(data));
+	f = fopen(SANDBOX_PATH "/src", "wb");
+	assert_non_null(f);
+	assert_int_equal(sizeof(data), fwrite(data, 1U, sizeof(data), f));
+	fclose(f);
+
+	start = get_time_ms();
+	{
+		io_args_t args = {
+			.arg1.src = SANDBOX_PATH "/src",
+			.arg2.dst = SANDBOX_PATH "/dst",
+			.throttle = throttle,
+		};
+		ioe_errlst_init(&args.result.errors);
+
+		assert_success(ior_cp(&args));
+		assert_int_equal(0, args.result.errors.error_count);
+	}
+	assert_true(get_time_ms() - start >= 200U);
+
+	iothrottle_free(throttle);
+	delete_file(SANDBOX_PATH "/src");
+	delete_file(SANDBOX_PATH "/dst");
+}
+
+/* Retrieves current time.  Returns the time in milliseconds. */
+static uint64_t
+get_time_ms(void)
+{
+	struct timeval tv;
+	(void)gettimeofday(&tv, NULL);
+	return (uint64_t)tv.tv_sec*1000U + tv.tv_usec/1000;
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
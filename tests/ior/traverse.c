@@ -0,0 +1,183 @@
+#include <stic.h>
+
+#include <unistd.h> /* symlink() */
+
+#include <stdio.h> /* snprintf() */
+#include <string.h> /* strlen() */
+
+#include "../../src/compat/fs_limits.h"
+#include "../../src/io/private/traverser.h"
+#include "../../src/io/ior.h"
+#include "../../src/utils/fs.h"
+
+#include "utils.h"
+
+/* Traversal of a deep tree, which also works as a benchmark that shows number
+ * of system calls and allocations per traversal.  Run with a bigger DEPTH to
+ * compare timings. */
+
+/* Number of nested directories, which is more than traverser keeps open. */
+#define DEPTH 100
+
+/* Number of files in each of the directories. */
+#define NFILES 10
+
+/* Counters of visitor calls. */
+typedef struct
+{
+	int enters;           /* Number of VA_DIR_ENTER calls. */
+	int files;            /* Number of VA_FILE calls. */
+	int leaves;           /* Number of VA_DIR_LEAVE calls. */
+	int depth;            /* Current depth. */
+	int max_depth;        /* Maximum depth reached. */
+	char last[PATH_MAX];  /* Last path passed to the visitor. */
+}
+counts_t;
+
+static VisitResult count_visitor(const char full_path[], VisitAction action,
+		void *param);
+static void create_tree(const char root[]);
+static void remove_tree(const char root[]);
+static int not_windows(void);
+
+TEST(deep_tree_is_traversed_in_correct_order)
+{
+	counts_t counts = { .enters = 0 };
+
+	create_tree(SANDBOX_PATH "/root");
+
+	assert_success(traverse(SANDBOX_PATH "/root", &count_visitor, &counts));
+	assert_int_equal(DEPTH + 1, counts.enters);
+	assert_int_equal(DEPTH + 1, counts.leaves);
+	assert_int_equal((DEPTH + 1)*NFILES, counts.files);
+	assert_int_equal(DEPTH + 1, counts.max_depth);
+	assert_int_equal(0, counts.depth);
+	assert_string_equal(SANDBOX_PATH "/root", counts.last);
+
+	remove_tree(SANDBOX_PATH "/root");
+	assert_false(path_exists(SANDBOX_PATH "/root", NODEREF));
+}
+
+TEST(no_allocations_per_entry, IF(not_windows))
+{
+	traverser_stats_t stats;
+	counts_t counts = { .enters = 0 };
+
+	create_tree(SANDBOX_PATH "/root");
+
+	traverser_reset_stats();
+	assert_success(traverse(SANDBOX_PATH "/root", &count_visitor, &counts));
+	stats = traverser_get_stats();
+
+	/* Each directory is opened once and read in one go (plus a read that
+	 * detects end of entries). */
+	assert_int_equal(DEPTH + 1, stats.opens);
+	assert_true(stats.reads <= 2*(DEPTH + 1));
+	/* Types of entries are queried only if file system doesn't report them. */
+	assert_true(stats.stats <= (DEPTH + 1)*(NFILES + 1));
+	/* Buffers are allocated per level of depth, not per entry. */
+	assert_true(stats.allocs <= 2*(DEPTH + 1) + 16);
+	assert_true(stats.allocs < (DEPTH + 1)*(NFILES + 1)/4);
+
+	remove_tree(SANDBOX_PATH "/root");
+}
+
+TEST(symbolic_link_to_directory_is_a_file, IF(not_windows))
+{
+	counts_t counts = { .enters = 0 };
+
+	create_empty_dir(SANDBOX_PATH "/root");
+	create_empty_dir(SANDBOX_PATH "/root/dir");
+	create_empty_file(SANDBOX_PATH "/root/dir/file");
+	assert_success(symlink("dir", SANDBOX_PATH "/root/link"));
+
+	assert_success(traverse(SANDBOX_PATH "/root", &count_visitor, &counts));
+	assert_int_equal(2, counts.enters);
+	assert_int_equal(2, counts.files);
+	assert_int_equal(2, counts.leaves);
+
+	remove_tree(SANDBOX_PATH "/root");
+}
+
+/* Counts calls and checks their nesting. */
+static VisitResult
+count_visitor(const char full_path[], VisitAction action, void *param)
+{
+	counts_t *const counts = param;
+
+	switch(action)
+	{
+		case VA_DIR_ENTER:
+			++counts->enters;
+			++counts->depth;
+			if(counts->depth > counts->max_depth)
+			{
+				counts->max_depth = counts->depth;
+			}
+			break;
+		case VA_FILE:
+			++counts->files;
+			break;
+		case VA_DIR_LEAVE:
+			++counts->leaves;
+			--counts->depth;
+			break;
+	}
+
+	snprintf(counts->last, sizeof(counts->last), "%s", full_path);
+	return VR_OK;
+}
+
+/* Creates chain of nested directories each of which contains several files. */
+static void
+create_tree(const char root[])
+{
+	char path[PATH_MAX];
+	int i, j;
+
+	snprintf(path, sizeof(path), "%s", root);
+	create_empty_dir(path);
+
+	for(i = 0; i <= DEPTH; ++i)
+	{
+		const size_t len = strlen(path);
+
+		for(j = 0; j < NFILES; ++j)
+		{
+			snprintf(path + len, sizeof(path) - len, "/file%d", j);
+			create_empty_file(path);
+		}
+
+		if(i != DEPTH)
+		{
+			snprintf(path + len, sizeof(path) - len, "/d");
+			create_empty_dir(path);
+		}
+	}
+}
+
+/* Removes directory tree. */
+static void
+remove_tree(const char root[])
+{
+	io_args_t args = {
+		.arg1.path = root,
+	};
+	ioe_errlst_init(&args.result.errors);
+
+	assert_success(ior_rm(&args));
+	assert_int_equal(0, args.result.errors.error_count);
+}
+
+static int
+not_windows(void)
+{
+#ifdef _WIN32
+	return 0;
+#else
+	return 1;
+#endif
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,226 @@
+#include <stic.h>
+
+#include <sys/stat.h> /* stat */
+#include <unistd.h> /* chdir() rmdir() symlink() unlink() */
+
+#include <stdio.h> /* FILE fclose() fopen() fputs() snprintf() */
+#include <stdlib.h> /* free() malloc() */
+#include <string.h> /* strdup() */
+
+#include "../../src/cfg/config.h"
+#include "../../src/compat/os.h"
+#include "../../src/ui/ui.h"
+#include "../../src/utils/fs.h"
+#include "../../src/utils/str.h"
+#include "../../src/filelist.h"
+#include "../../src/status.h"
+#include "../../src/types.h"
+
+#include "utils.h"
+
+/* Number of files in the directory, should be large enough for stat() calls to
+ * be performed by several threads. */
+#define NFILES 2048
+
+static void create_files(int count);
+static void remove_files(int count);
+static void check_entries(const FileView *view);
+static int not_windows(void);
+
+SETUP()
+{
+	update_string(&cfg.fuse_home, "no");
+	update_string(&cfg.slow_fs_list, "");
+	assert_success(init_status(&cfg));
+
+	view_setup(&lwin);
+	curr_view = &lwin;
+	other_view = &lwin;
+
+	/* So that nothing is written into directory history. */
+	rwin.list_rows = 0;
+
+	assert_success(chdir(SANDBOX_PATH));
+	assert_non_null(get_cwd(lwin.curr_dir, sizeof(lwin.curr_dir)));
+}
+
+TEARDOWN()
+{
+	view_teardown(&lwin);
+	curr_view = NULL;
+	other_view = NULL;
+
+	update_string(&cfg.slow_fs_list, NULL);
+	update_string(&cfg.fuse_home, NULL);
+}
+
+TEST(small_directory_is_loaded_correctly)
+{
+	create_files(10);
+
+	populate_dir_list(&lwin, 0);
+	assert_int_equal(10, lwin.list_rows);
+	check_entries(&lwin);
+
+	remove_files(10);
+}
+
+TEST(large_directory_is_loaded_correctly)
+{
+	create_files(NFILES);
+
+	populate_dir_list(&lwin, 0);
+	assert_int_equal(NFILES, lwin.list_rows);
+	check_entries(&lwin);
+
+	remove_files(NFILES);
+}
+
+TEST(large_directory_is_reloaded_correctly)
+{
+	create_files(NFILES);
+
+	populate_dir_list(&lwin, 0);
+	lwin.dir_entry[NFILES/2].selected = 1;
+	lwin.selected_files = 1;
+
+	populate_dir_list(&lwin, 1);
+	assert_int_equal(NFILES, lwin.list_rows);
+	assert_true(lwin.dir_entry[NFILES/2].selected);
+	assert_int_equal(1, lwin.selected_files);
+	check_entries(&lwin);
+
+	remove_files(NFILES);
+}
+
+TEST(partially_drawn_list_does_not_affect_final_order)
+{
+	int i;
+	char **names;
+
+	create_files(NFILES);
+
+	/* Sorting by type produces a lot of ties, which are resolved according to
+	 * order of entries before sorting. */
+	lwin.sort[0] = SK_BY_TYPE;
+
+	/* Initial loading of a big directory draws list while it's being loaded. */
+	populate_dir_list(&lwin, 0);
+	assert_int_equal(NFILES, lwin.list_rows);
+
+	names = malloc(sizeof(*names)*lwin.list_rows);
+	for(i = 0; i < lwin.list_rows; ++i)
+	{
+		names[i] = strdup(lwin.dir_entry[i].name);
+	}
+
+	/* Reloading doesn't do that. */
+	populate_dir_list(&lwin, 1);
+	assert_int_equal(NFILES, lwin.list_rows);
+
+	for(i = 0; i < lwin.list_rows; ++i)
+	{
+		assert_string_equal(names[i], lwin.dir_entry[i].name);
+		free(names[i]);
+	}
+	free(names);
+
+	remove_files(NFILES);
+}
+
+TEST(links_are_resolved_in_large_directory, IF(not_windows))
+{
+	create_files(NFILES);
+
+#ifndef _WIN32
+	assert_success(symlink("00000", "link-to-dir"));
+	assert_success(symlink("00001", "link-to-file"));
+#endif
+
+	populate_dir_list(&lwin, 0);
+	assert_int_equal(NFILES + 2, lwin.list_rows);
+	check_entries(&lwin);
+
+	assert_success(unlink("link-to-dir"));
+	assert_success(unlink("link-to-file"));
+	remove_files(NFILES);
+}
+
+/* Creates count files with names being zero-padded numbers.  Every third one is
+ * a directory, others are files of different size. */
+static void
+create_files(int count)
+{
+	int i;
+	for(i = 0; i < count; ++i)
+	{
+		char name[16];
+		snprintf(name, sizeof(name), "%05d", i);
+
+		if(i%3 == 0)
+		{
+			assert_success(os_mkdir(name, 0700));
+		}
+		else
+		{
+			FILE *const f = fopen(name, "w");
+			assert_non_null(f);
+			fputs(name + i%5, f);
+			fclose(f);
+		}
+	}
+}
+
+/* Removes files created by create_files(). */
+static void
+remove_files(int count)
+{
+	int i;
+	for(i = 0; i < count; ++i)
+	{
+		char name[16];
+		snprintf(name, sizeof(name), "%05d", i);
+		assert_success((i%3 == 0) ? rmdir(name) : unlink(name));
+	}
+}
+
+/* Verifies that information of every entry in the view matches the one
+ * obtained directly from the file system. */
+static void
+check_entries(const FileView *view)
+{
+	int i;
+	for(i = 0; i < view->list_rows; ++i)
+	{
+		struct stat s;
+		const dir_entry_t *const entry = &view->dir_entry[i];
+
+		assert_success(os_lstat(entry->name, &s));
+		assert_int_equal(get_type_from_mode(s.st_mode), entry->type);
+		assert_true(entry->mtime == s.st_mtime);
+		if(entry->type != FT_LINK)
+		{
+			assert_true(entry->size == (uint64_t)s.st_size);
+		}
+#ifndef _WIN32
+		else
+		{
+			assert_success(os_stat(entry->name, &s));
+			assert_true(entry->mode == s.st_mode);
+		}
+#endif
+	}
+}
+
+static int
+not_windows(void)
+{
+#ifdef _WIN32
+	return 0;
+#else
+	return 1;
+#endif
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -1,6 +1,9 @@
 #include <stic.h>
 
+#include <unistd.h> /* rmdir() */
+
 #include <stddef.h> /* NULL */
+#include <stdio.h> /* rename() */
 #include <string.h> /* memset() */
 
 #include "../../src/compat/os.h"
@@ -42,7 +45,7 @@ TEARDOWN()
 	int i;
 
 	for(i = 0; i < view->list_rows; i++)
-		free(view->dir_entry[i].name);
+		free_dir_entry(view, &view->dir_entry[i]);
 	dynarray_free(view->dir_entry);
 
 	filter_dispose(&view->auto_filter);
@@ -102,5 +105,45 @@ TEST(selection_is_preserved)
 	assert_int_equal(2, view->selected_files);
 }
 
+TEST(added_entries_are_inserted_in_sorted_order)
+{
+	view->dir_entry[2].selected = 1;
+	view->selected_files = 1;
+	view->list_pos = 3;
+	assert_success(os_mkdir("10", 0000));
+	assert_success(os_mkdir("25", 0000));
+
+	populate_dir_list(view, 1);
+	assert_int_equal(6, view->list_rows);
+	assert_string_equal("0", view->dir_entry[0].name);
+	assert_string_equal("1", view->dir_entry[1].name);
+	assert_string_equal("10", view->dir_entry[2].name);
+	assert_string_equal("2", view->dir_entry[3].name);
+	assert_string_equal("25", view->dir_entry[4].name);
+	assert_string_equal("3", view->dir_entry[5].name);
+
+	assert_true(view->dir_entry[3].selected);
+	assert_int_equal(1, view->selected_files);
+	assert_string_equal("3", view->dir_entry[view->list_pos].name);
+
+	assert_success(rmdir("10"));
+	assert_success(rmdir("25"));
+}
+
+TEST(renamed_entry_is_moved_to_correct_position)
+{
+	assert_success(rename("0", "4"));
+	fentry_rename(&view->dir_entry[0], "4");
+
+	populate_dir_list(view, 1);
+	assert_int_equal(4, view->list_rows);
+	assert_string_equal("1", view->dir_entry[0].name);
+	assert_string_equal("2", view->dir_entry[1].name);
+	assert_string_equal("3", view->dir_entry[2].name);
+	assert_string_equal("4", view->dir_entry[3].name);
+
+	assert_success(rename("4", "0"));
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 filetype=c : */
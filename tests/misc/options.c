@@ -17,6 +17,7 @@
 static void print_func(const void *data, int column_id, const char buf[],
 		size_t offset, AlignType align, const char full_column[]);
 static void format_none(int id, const void *data, size_t buf_len, char buf[]);
+static int not_windows(void);
 
 static int ncols;
 
@@ -144,5 +145,81 @@ TEST(fails_to_set_sort_group_with_wrong_regexp)
 	assert_failure(exec_commands("set sortgroups=.*,*", &lwin, CIT_COMMAND));
 }
 
+TEST(iolimits_are_parsed)
+{
+	assert_success(exec_commands("set iolimits=rate:2K,ops:10,jobrate:3M,jobops:1",
+				&lwin, CIT_COMMAND));
+	assert_int_equal(2048, cfg.io_rate);
+	assert_int_equal(10, cfg.io_ops_rate);
+	assert_int_equal(3*1024*1024, cfg.io_job_rate);
+	assert_int_equal(1, cfg.io_job_ops_rate);
+
+	assert_success(exec_commands("set iolimits=", &lwin, CIT_COMMAND));
+	assert_int_equal(0, cfg.io_rate);
+	assert_int_equal(0, cfg.io_job_rate);
+}
+
+TEST(wrong_iolimits_are_rejected)
+{
+	assert_success(exec_commands("set iolimits=rate:1G", &lwin, CIT_COMMAND));
+
+	assert_failure(exec_commands("set iolimits=speed:1", &lwin, CIT_COMMAND));
+	assert_failure(exec_commands("set iolimits=rate:1X", &lwin, CIT_COMMAND));
+	assert_failure(exec_commands("set iolimits=rate:", &lwin, CIT_COMMAND));
+
+	assert_int_equal(1024*1024*1024, cfg.io_rate);
+	assert_string_equal("rate:1073741824",
+			get_option_value("iolimits", OPT_GLOBAL));
+
+	assert_success(exec_commands("set iolimits=", &lwin, CIT_COMMAND));
+}
+
+TEST(previewprefetch_is_parsed_and_normalized, IF(not_windows))
+{
+	assert_success(exec_commands("set previewprefetch=memory:1024K,entries:3",
+				&lwin, CIT_COMMAND));
+	assert_int_equal(3, cfg.prefetch_entries);
+	assert_int_equal(1, cfg.prefetch_jobs);
+	assert_int_equal(1024*1024, cfg.preview_cache_size);
+	assert_string_equal("entries:3,jobs:1,memory:1M",
+			get_option_value("previewprefetch", OPT_GLOBAL));
+
+	assert_success(exec_commands("set previewprefetch=", &lwin, CIT_COMMAND));
+	assert_int_equal(0, cfg.prefetch_entries);
+	assert_string_equal("entries:0,jobs:1,memory:8M",
+			get_option_value("previewprefetch", OPT_GLOBAL));
+}
+
+TEST(wrong_previewprefetch_is_rejected, IF(not_windows))
+{
+	assert_success(exec_commands("set previewprefetch=jobs:2", &lwin,
+				CIT_COMMAND));
+
+	assert_failure(exec_commands("set previewprefetch=jobs:0", &lwin,
+				CIT_COMMAND));
+	assert_failure(exec_commands("set previewprefetch=jobs:100", &lwin,
+				CIT_COMMAND));
+	assert_failure(exec_commands("set previewprefetch=entries:1K", &lwin,
+				CIT_COMMAND));
+	assert_failure(exec_commands("set previewprefetch=count:1", &lwin,
+				CIT_COMMAND));
+
+	assert_int_equal(2, cfg.prefetch_jobs);
+	assert_string_equal("entries:0,jobs:2,memory:8M",
+			get_option_value("previewprefetch", OPT_GLOBAL));
+
+	assert_success(exec_commands("set previewprefetch=", &lwin, CIT_COMMAND));
+}
+
+static int
+not_windows(void)
+{
+#ifdef _WIN32
+	return 0;
+#else
+	return 1;
+#endif
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,225 @@
+#include <stic.h>
+
+#include <unistd.h> /* usleep() */
+
+#include <stddef.h> /* NULL size_t */
+#include <stdlib.h> /* free() */
+#include <string.h> /* memcmp() */
+
+#include "../../src/cfg/config.h"
+#include "../../src/ui/qv_cache.h"
+#include "../../src/utils/str.h"
+#include "../../src/status.h"
+
+static void wait_for_preview(void);
+static void wait_for_entry(const qvc_key_t *key);
+static int not_windows(void);
+
+static const qvc_key_t key_a = {
+	.path = TEST_DATA_PATH "/read/two-lines",
+	.viewer = "a",
+	.width = 80,
+	.height = 10,
+};
+
+static const qvc_key_t key_b = {
+	.path = TEST_DATA_PATH "/read/two-lines",
+	.viewer = "b",
+	.width = 80,
+	.height = 10,
+};
+
+SETUP()
+{
+	update_string(&cfg.shell, "/bin/sh");
+	stats_update_shell_type(cfg.shell);
+}
+
+TEARDOWN()
+{
+	qvc_cancel();
+	qvc_clear();
+	qvc_pause_prefetch(0);
+	qvc_set_limits(1, 8*1024*1024);
+
+	update_string(&cfg.shell, NULL);
+	stats_update_shell_type("/bin/sh");
+}
+
+TEST(preview_is_cached_after_it_is_produced, IF(not_windows))
+{
+	char *data;
+	size_t len;
+
+	assert_int_equal(QVC_MISSING, qvc_lookup(&key_a, &data, &len));
+
+	qvc_request(&key_a, "echo text");
+	wait_for_preview();
+
+	assert_int_equal(QVC_READY, qvc_lookup(&key_a, &data, &len));
+	assert_int_equal(5, len);
+	assert_success(memcmp(data, "text\n", len));
+	free(data);
+}
+
+TEST(geometry_is_part_of_the_key, IF(not_windows))
+{
+	char *data;
+	size_t len;
+	qvc_key_t key = key_a;
+
+	qvc_request(&key_a, "echo text");
+	wait_for_preview();
+
+	key.height = 20;
+	assert_int_equal(QVC_MISSING, qvc_lookup(&key, &data, &len));
+	key.height = key_a.height;
+	key.width = 40;
+	assert_int_equal(QVC_MISSING, qvc_lookup(&key, &data, &len));
+}
+
+TEST(output_is_limited_by_height, IF(not_windows))
+{
+	char *data;
+	size_t len;
+	qvc_key_t key = key_a;
+	key.height = 2;
+
+	qvc_request(&key, "printf 'a\\nb\\nc\\n'");
+	wait_for_preview();
+
+	assert_int_equal(QVC_READY, qvc_lookup(&key, &data, &len));
+	assert_int_equal(4, len);
+	assert_success(memcmp(data, "a\nb\n", len));
+	free(data);
+}
+
+TEST(new_request_cancels_previous_one, IF(not_windows))
+{
+	char *data;
+	size_t len;
+
+	qvc_request(&key_a, "sleep 10");
+	qvc_request(&key_b, "echo b");
+	wait_for_preview();
+
+	assert_int_equal(QVC_MISSING, qvc_lookup(&key_a, &data, &len));
+	assert_int_equal(QVC_READY, qvc_lookup(&key_b, &data, &len));
+	free(data);
+}
+
+TEST(cancelled_request_is_not_stored, IF(not_windows))
+{
+	char *data;
+	size_t len;
+
+	qvc_request(&key_a, "sleep 10");
+	qvc_cancel();
+	qvc_request(&key_b, "echo b");
+	wait_for_preview();
+
+	assert_int_equal(QVC_MISSING, qvc_lookup(&key_a, &data, &len));
+	assert_int_equal(QVC_READY, qvc_lookup(&key_b, &data, &len));
+	free(data);
+}
+
+TEST(previews_are_prefetched, IF(not_windows))
+{
+	char *data;
+	size_t len;
+	const qvc_key_t keys[] = { key_a, key_b };
+	char *cmds[] = { "echo a", "echo b" };
+
+	qvc_set_limits(2, 8*1024*1024);
+	qvc_prefetch(keys, cmds, 2);
+	wait_for_entry(&key_a);
+	wait_for_entry(&key_b);
+
+	assert_int_equal(QVC_READY, qvc_lookup(&key_b, &data, &len));
+	assert_int_equal(2, len);
+	assert_success(memcmp(data, "b\n", len));
+	free(data);
+}
+
+TEST(paused_prefetching_does_not_run_viewers, IF(not_windows))
+{
+	char *data;
+	size_t len;
+	char *cmds[] = { "echo a" };
+
+	qvc_pause_prefetch(1);
+	qvc_prefetch(&key_a, cmds, 1);
+	usleep(50000);
+	assert_int_equal(QVC_MISSING, qvc_lookup(&key_a, &data, &len));
+
+	qvc_pause_prefetch(0);
+	wait_for_entry(&key_a);
+}
+
+TEST(request_of_prefetched_preview_is_completed, IF(not_windows))
+{
+	char *data;
+	size_t len;
+	char *cmds[] = { "sleep 0.05; echo a" };
+
+	qvc_prefetch(&key_a, cmds, 1);
+	qvc_request(&key_a, cmds[0]);
+	wait_for_preview();
+
+	assert_int_equal(QVC_READY, qvc_lookup(&key_a, &data, &len));
+	free(data);
+}
+
+TEST(cache_respects_memory_limit, IF(not_windows))
+{
+	char *data;
+	size_t len;
+
+	qvc_set_limits(1, 4);
+
+	qvc_request(&key_a, "echo aaa");
+	wait_for_preview();
+	qvc_request(&key_b, "echo bbb");
+	wait_for_preview();
+
+	assert_int_equal(QVC_MISSING, qvc_lookup(&key_a, &data, &len));
+	assert_int_equal(QVC_READY, qvc_lookup(&key_b, &data, &len));
+	free(data);
+}
+
+/* Waits until requested preview is produced. */
+static void
+wait_for_preview(void)
+{
+	while(!qvc_fetch_ready())
+	{
+		usleep(1000);
+	}
+}
+
+/* Waits until preview appears in the cache. */
+static void
+wait_for_entry(const qvc_key_t *key)
+{
+	char *data;
+	size_t len;
+
+	while(qvc_lookup(key, &data, &len) != QVC_READY)
+	{
+		usleep(1000);
+	}
+	free(data);
+}
+
+static int
+not_windows(void)
+{
+#ifdef _WIN32
+	return 0;
+#else
+	return 1;
+#endif
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,211 @@
+#include <stic.h>
+
+#include <stdio.h> /* snprintf() */
+#include <stdlib.h> /* atoi() free() malloc() */
+#include <string.h> /* memset() strdup() */
+
+#include "../../src/cfg/config.h"
+#include "../../src/ui/ui.h"
+#include "../../src/utils/dynarray.h"
+#include "../../src/sort.h"
+#include "../../src/status.h"
+
+#include "utils.h"
+
+/* Number of entries in the list, also makes this fixture a benchmark of
+ * sorting. */
+#define NENTRIES 200000
+
+static void fill_list(void);
+
+SETUP()
+{
+	cfg.sort_numbers = 1;
+	assert_success(init_status(&cfg));
+
+	view_setup(&lwin);
+	fill_list();
+}
+
+TEARDOWN()
+{
+	sort_force_workers(0);
+	sort_force_in_place(0);
+	cfg.sort_numbers = 0;
+
+	view_teardown(&lwin);
+}
+
+TEST(big_list_is_sorted_by_name)
+{
+	int i;
+
+	lwin.sort[0] = SK_BY_NAME;
+	memset(&lwin.sort[1], SK_NONE, sizeof(lwin.sort) - 1);
+
+	sort_view(&lwin);
+
+	for(i = 1; i < NENTRIES; ++i)
+	{
+		const dir_entry_t *const prev = &lwin.dir_entry[i - 1];
+		const dir_entry_t *const curr = &lwin.dir_entry[i];
+		if(prev->type == curr->type)
+		{
+			assert_true(atoi(prev->name) < atoi(curr->name));
+		}
+		else
+		{
+			assert_true(prev->type == FT_DIR);
+		}
+	}
+}
+
+TEST(sorting_big_list_is_stable)
+{
+	int i;
+
+	lwin.sort[0] = SK_BY_SIZE;
+	lwin.sort[1] = SK_BY_NAME;
+	memset(&lwin.sort[2], SK_NONE, sizeof(lwin.sort) - 2);
+
+	sort_view(&lwin);
+
+	for(i = 1; i < NENTRIES; ++i)
+	{
+		const dir_entry_t *const prev = &lwin.dir_entry[i - 1];
+		const dir_entry_t *const curr = &lwin.dir_entry[i];
+		if(prev->type != curr->type)
+		{
+			assert_true(prev->type == FT_DIR);
+		}
+		else if(prev->size == curr->size)
+		{
+			assert_true(atoi(prev->name) < atoi(curr->name));
+		}
+		else
+		{
+			assert_true(prev->size < curr->size);
+		}
+	}
+}
+
+TEST(sorting_big_list_in_parallel_is_stable)
+{
+	int i;
+
+	/* Odd number of threads gets rounded down to a power of two. */
+	sort_force_workers(7);
+
+	lwin.sort[0] = -SK_BY_SIZE;
+	lwin.sort[1] = SK_BY_NAME;
+	memset(&lwin.sort[2], SK_NONE, sizeof(lwin.sort) - 2);
+
+	sort_view(&lwin);
+
+	for(i = 1; i < NENTRIES; ++i)
+	{
+		const dir_entry_t *const prev = &lwin.dir_entry[i - 1];
+		const dir_entry_t *const curr = &lwin.dir_entry[i];
+		if(prev->type != curr->type)
+		{
+			assert_true(prev->type == FT_DIR);
+		}
+		else if(prev->size == curr->size)
+		{
+			assert_true(atoi(prev->name) < atoi(curr->name));
+		}
+		else
+		{
+			assert_true(prev->size > curr->size);
+		}
+	}
+}
+
+TEST(parallel_sorting_matches_sequential_one)
+{
+	int i;
+	int *order = malloc(sizeof(*order)*NENTRIES);
+
+	lwin.sort[0] = SK_BY_TYPE;
+	memset(&lwin.sort[1], SK_NONE, sizeof(lwin.sort) - 1);
+
+	/* Sorting by type leaves a lot of ties, which must be resolved the same
+	 * way. */
+	sort_force_workers(1);
+	sort_view(&lwin);
+	for(i = 0; i < NENTRIES; ++i)
+	{
+		order[i] = atoi(lwin.dir_entry[i].name);
+	}
+
+	view_teardown(&lwin);
+	view_setup(&lwin);
+	fill_list();
+
+	lwin.sort[0] = SK_BY_TYPE;
+	sort_force_workers(8);
+	sort_view(&lwin);
+	for(i = 0; i < NENTRIES; ++i)
+	{
+		assert_int_equal(order[i], atoi(lwin.dir_entry[i].name));
+	}
+
+	free(order);
+}
+
+TEST(sorting_in_place_matches_sorting_of_pointers)
+{
+	int i;
+	int *order = malloc(sizeof(*order)*NENTRIES);
+
+	lwin.sort[0] = SK_BY_TYPE;
+	lwin.sort[1] = -SK_BY_SIZE;
+	memset(&lwin.sort[2], SK_NONE, sizeof(lwin.sort) - 2);
+
+	sort_view(&lwin);
+	for(i = 0; i < NENTRIES; ++i)
+	{
+		order[i] = atoi(lwin.dir_entry[i].name);
+	}
+
+	view_teardown(&lwin);
+	view_setup(&lwin);
+	fill_list();
+
+	lwin.sort[0] = SK_BY_TYPE;
+	lwin.sort[1] = -SK_BY_SIZE;
+	sort_force_in_place(1);
+	sort_view(&lwin);
+	for(i = 0; i < NENTRIES; ++i)
+	{
+		assert_int_equal(order[i], atoi(lwin.dir_entry[i].name));
+	}
+
+	free(order);
+}
+
+/* Fills left view with entries in pseudo-random order. */
+static void
+fill_list(void)
+{
+	int i;
+
+	lwin.list_rows = NENTRIES;
+	lwin.dir_entry = dynarray_cextend(NULL,
+			lwin.list_rows*sizeof(*lwin.dir_entry));
+	for(i = 0; i < NENTRIES; ++i)
+	{
+		/* Pseudo-random permutation of indexes. */
+		const int n = (int)((i*7919LL)%NENTRIES);
+		char name[32];
+		snprintf(name, sizeof(name), "%d", n);
+
+		lwin.dir_entry[i].name = strdup(name);
+		lwin.dir_entry[i].origin = &lwin.curr_dir[0];
+		lwin.dir_entry[i].type = (n%10 == 0) ? FT_DIR : FT_REG;
+		lwin.dir_entry[i].size = n%16;
+	}
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,187 @@
+#include <stic.h>
+
+#include <locale.h> /* LC_ALL setlocale() */
+#include <stdio.h> /* snprintf() */
+#include <stdlib.h> /* free() */
+#include <string.h> /* memset() strdup() */
+
+#include "../../src/cfg/config.h"
+#include "../../src/ui/ui.h"
+#include "../../src/utils/dynarray.h"
+#include "../../src/sort.h"
+#include "../../src/status.h"
+
+#include "utils.h"
+
+/* Number of entries for benchmarking, run tests one by one to compare sorting
+ * with and without collation keys. */
+#define NBENCH 100000
+
+static void fill_view(int count, int mixed);
+static void free_entries(void);
+static void check_keys_match_names(SortingKey key, int mixed);
+
+static unsigned int seed;
+
+SETUP_ONCE()
+{
+	(void)setlocale(LC_ALL, "");
+}
+
+SETUP()
+{
+	seed = 1U;
+	cfg.sort_numbers = 1;
+	assert_success(init_status(&cfg));
+
+	view_setup(&lwin);
+	memset(&lwin.sort[1], SK_NONE, sizeof(lwin.sort) - 1);
+}
+
+TEARDOWN()
+{
+	sort_use_coll_keys(1);
+	cfg.sort_numbers = 0;
+
+	view_teardown(&lwin);
+}
+
+TEST(keys_sort_like_names_with_numbers)
+{
+	check_keys_match_names(SK_BY_NAME, 0);
+}
+
+TEST(keys_sort_like_names_with_numbers_ignoring_case)
+{
+	check_keys_match_names(SK_BY_INAME, 0);
+}
+
+TEST(keys_sort_like_names_without_numbers)
+{
+	cfg.sort_numbers = 0;
+	check_keys_match_names(SK_BY_NAME, 0);
+}
+
+TEST(keys_sort_like_names_in_reverse)
+{
+	check_keys_match_names(-SK_BY_INAME, 0);
+}
+
+TEST(keys_sort_like_names_for_mixed_names)
+{
+	check_keys_match_names(SK_BY_INAME, 1);
+}
+
+TEST(benchmark_sorting_with_keys)
+{
+	fill_view(NBENCH, 1);
+	lwin.sort[0] = SK_BY_INAME;
+	sort_view(&lwin);
+}
+
+TEST(benchmark_sorting_without_keys)
+{
+	fill_view(NBENCH, 1);
+	lwin.sort[0] = SK_BY_INAME;
+	sort_use_coll_keys(0);
+	sort_view(&lwin);
+}
+
+/* Fills left view with pseudo-random names.  Non-mixed names are short and are
+ * made of characters which trigger corner cases of comparison, mixed ones look
+ * more like real file names. */
+static void
+fill_view(int count, int mixed)
+{
+	static const char alphabet[] = "0001239aAbB._-\xd1\x8f";
+	static const char *const stems[] = {
+		"IMG_", "photo", "Report-v", "track", "file", "Data.", "build-"
+	};
+	static const char *const exts[] = {
+		".jpg", ".txt", ".tar.gz", "", ".c", ".v2"
+	};
+
+	int i;
+
+	lwin.list_rows = count;
+	lwin.dir_entry = dynarray_cextend(NULL,
+			lwin.list_rows*sizeof(*lwin.dir_entry));
+	for(i = 0; i < count; ++i)
+	{
+		char name[64];
+		seed = seed*1103515245U + 12345U;
+
+		if(mixed)
+		{
+			const unsigned int r = seed >> 8;
+			snprintf(name, sizeof(name), (r%3 == 0) ? "%s%04u%s" : "%s%u%s",
+					stems[r%7], (r/7)%5000, exts[(r/11)%6]);
+		}
+		else
+		{
+			unsigned int r = seed >> 4;
+			int len = 1 + r%8;
+			int j;
+			for(j = 0; j < len; ++j)
+			{
+				r = r*69069U + 1U;
+				name[j] = alphabet[(r >> 16)%(sizeof(alphabet) - 1U)];
+			}
+			name[len] = '\0';
+		}
+
+		lwin.dir_entry[i].name = strdup(name);
+		lwin.dir_entry[i].origin = &lwin.curr_dir[0];
+		lwin.dir_entry[i].type = (i%10 == 0) ? FT_DIR : FT_REG;
+	}
+}
+
+/* Frees entries of the left view. */
+static void
+free_entries(void)
+{
+	int i;
+	for(i = 0; i < lwin.list_rows; ++i)
+	{
+		free(lwin.dir_entry[i].name);
+	}
+	dynarray_free(lwin.dir_entry);
+	lwin.dir_entry = NULL;
+	lwin.list_rows = 0;
+}
+
+/* Verifies that sorting by name with and without collation keys produces the
+ * same result. */
+static void
+check_keys_match_names(SortingKey key, int mixed)
+{
+	enum { NENTRIES = 20000 };
+
+	int i;
+	char *names[NENTRIES];
+
+	lwin.sort[0] = key;
+
+	fill_view(NENTRIES, mixed);
+	sort_use_coll_keys(0);
+	sort_view(&lwin);
+	for(i = 0; i < NENTRIES; ++i)
+	{
+		names[i] = strdup(lwin.dir_entry[i].name);
+	}
+	free_entries();
+
+	/* Order of equal elements depends on original order, so start over. */
+	seed = 1U;
+	fill_view(NENTRIES, mixed);
+	sort_use_coll_keys(1);
+	sort_view(&lwin);
+	for(i = 0; i < NENTRIES; ++i)
+	{
+		assert_string_equal(names[i], lwin.dir_entry[i].name);
+		free(names[i]);
+	}
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
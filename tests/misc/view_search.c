@@ -0,0 +1,175 @@
+#include <stic.h>
+
+#include <regex.h> /* REG_EXTENDED REG_ICASE */
+#include <unistd.h> /* unlink() usleep() */
+
+#include <stddef.h> /* NULL */
+#include <stdio.h> /* FILE fclose() fopen() fputs() */
+#include <string.h> /* memset() */
+
+#include "../../src/ui/view_search.h"
+#include "../../src/utils/file_lines.h"
+
+static void write_file(const char text[]);
+static vs_counter_t * count_in_file(const char pattern[]);
+static int not_windows(void);
+
+static const vs_layout_t layout = { .width = 2, .tab_stop = 8, .wrap = 1 };
+
+TEARDOWN()
+{
+	(void)unlink(SANDBOX_PATH "/file");
+}
+
+TEST(only_patterns_without_special_characters_are_literal)
+{
+	assert_true(vs_is_literal("abc", REG_EXTENDED));
+	assert_false(vs_is_literal("abc", REG_EXTENDED | REG_ICASE));
+	assert_false(vs_is_literal("", REG_EXTENDED));
+	assert_false(vs_is_literal("a.c", REG_EXTENDED));
+	assert_false(vs_is_literal("a c", REG_EXTENDED));
+	assert_false(vs_is_literal("a\\c", 0));
+}
+
+TEST(finder_skips_lines_without_literal, IF(not_windows))
+{
+	vs_finder_t finder;
+	file_lines_t *fl;
+
+	write_file("abc\nxyz\n\033[1mab\033[0mc\nfooabc\nab\n");
+	fl = fl_open(SANDBOX_PATH "/file");
+	assert_non_null(fl);
+
+	vs_finder_init(&finder, fl, "abc");
+	assert_int_equal(0, vs_finder_next(&finder, 0));
+	/* Lines with escape sequences are matched after removing them. */
+	assert_int_equal(2, vs_finder_next(&finder, 1));
+	assert_int_equal(3, vs_finder_next(&finder, 3));
+	assert_int_equal(-1, vs_finder_next(&finder, 4));
+
+	fl_close(fl);
+}
+
+TEST(counter_counts_matches_in_screen_lines, IF(not_windows))
+{
+	vs_counter_t *counter;
+	vs_pos_t match;
+	int index, total, done;
+	const vs_pos_t pos = { .line = 0, .row = 0 };
+
+	write_file("aaaa\nb\naa\n");
+	counter = count_in_file("a");
+
+	vs_counter_stats(counter, pos, &index, &total, &done);
+	assert_int_equal(0, index);
+	assert_int_equal(3, total);
+
+	assert_int_equal(1, vs_counter_find(counter, pos, 0, &match));
+	assert_int_equal(0, match.line);
+	assert_int_equal(1, match.row);
+
+	assert_int_equal(1, vs_counter_find(counter, match, 0, &match));
+	assert_int_equal(2, match.line);
+	assert_int_equal(0, match.row);
+	assert_int_equal(0, vs_counter_find(counter, match, 0, &match));
+
+	assert_int_equal(1, vs_counter_find(counter, match, 1, &match));
+	assert_int_equal(0, match.line);
+	assert_int_equal(1, match.row);
+
+	vs_counter_free(counter);
+}
+
+TEST(anchors_are_matched_against_screen_lines, IF(not_windows))
+{
+	vs_counter_t *counter;
+	int index, total, done;
+	const vs_pos_t pos = { .line = 0, .row = 0 };
+
+	write_file("aaaa\nxaab\n");
+
+	/* Second line doesn't start with "a", but its second screen line does. */
+	counter = count_in_file("^a");
+	vs_counter_stats(counter, pos, &index, &total, &done);
+	assert_int_equal(3, total);
+	vs_counter_free(counter);
+
+	counter = count_in_file("ab$");
+	vs_counter_stats(counter, pos, &index, &total, &done);
+	assert_int_equal(1, total);
+	vs_counter_free(counter);
+
+	counter = count_in_file("aa");
+	vs_counter_stats(counter, pos, &index, &total, &done);
+	assert_int_equal(2, total);
+	vs_counter_free(counter);
+}
+
+TEST(all_matched_screen_lines_of_a_long_line_are_counted, IF(not_windows))
+{
+	vs_counter_t *counter;
+	vs_pos_t match;
+	int index, total, done;
+	char text[202];
+	const vs_pos_t pos = { .line = 0, .row = 0 };
+	const vs_pos_t last = { .line = 0, .row = 99 };
+
+	/* 100 screen lines, each of which matches. */
+	memset(text, 'a', 200);
+	text[200] = '\n';
+	text[201] = '\0';
+	write_file(text);
+	counter = count_in_file("a");
+
+	vs_counter_stats(counter, pos, &index, &total, &done);
+	assert_int_equal(100, total);
+
+	assert_int_equal(1, vs_counter_find(counter, last, 1, &match));
+	assert_int_equal(0, match.line);
+	assert_int_equal(98, match.row);
+
+	vs_counter_free(counter);
+}
+
+/* Replaces contents of the file in the sandbox. */
+static void
+write_file(const char text[])
+{
+	FILE *const f = fopen(SANDBOX_PATH "/file", "wb");
+	assert_non_null(f);
+	fputs(text, f);
+	fclose(f);
+}
+
+/* Counts matches of the pattern in the file in the sandbox and waits for
+ * counting to finish.  Returns the counter. */
+static vs_counter_t *
+count_in_file(const char pattern[])
+{
+	vs_counter_t *counter;
+	int index, total, done = 0;
+	const vs_pos_t pos = { .line = 0, .row = 0 };
+
+	counter = vs_counter_start(SANDBOX_PATH "/file", pattern, REG_EXTENDED,
+			&layout);
+	assert_non_null(counter);
+
+	while(vs_counter_stats(counter, pos, &index, &total, &done), !done)
+	{
+		usleep(1000);
+	}
+	return counter;
+}
+
+static int
+not_windows(void)
+{
+#ifdef _WIN32
+	return 0;
+#else
+	return 1;
+#endif
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,92 @@
+#include <stic.h>
+
+#include <stddef.h> /* size_t */
+#include <stdio.h> /* snprintf() */
+#include <string.h> /* strlen() */
+
+#include "../../src/utils/checksum.h"
+
+static const char * hash(ChecksumKind kind, const char data[], size_t len,
+		size_t step);
+
+TEST(xxh64_of_short_inputs)
+{
+	assert_string_equal("ef46db3751d8e999", hash(CK_XXH64, "", 0U, 1U));
+	assert_string_equal("44bc2cf5ad770999", hash(CK_XXH64, "abc", 3U, 1U));
+}
+
+TEST(xxh64_of_input_longer_than_a_block)
+{
+	const char *const data = "Nobody inspects the spammish repetition";
+	assert_string_equal("fbcea83c8a378bf1",
+			hash(CK_XXH64, data, strlen(data), strlen(data)));
+}
+
+TEST(sha256_of_short_inputs)
+{
+	assert_string_equal(
+			"e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855",
+			hash(CK_SHA256, "", 0U, 1U));
+	assert_string_equal(
+			"ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad",
+			hash(CK_SHA256, "abc", 3U, 1U));
+}
+
+TEST(sha256_of_input_that_needs_extra_padding_block)
+{
+	const char *const data =
+		"abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+	assert_string_equal(
+			"248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1",
+			hash(CK_SHA256, data, strlen(data), strlen(data)));
+}
+
+TEST(result_does_not_depend_on_how_data_is_split)
+{
+	char data[1000];
+	char whole[2*CHECKSUM_MAX_LEN + 1];
+	size_t i;
+
+	for(i = 0U; i < sizeof(data); ++i)
+	{
+		data[i] = i*7 + i/13;
+	}
+
+	snprintf(whole, sizeof(whole), "%s",
+			hash(CK_XXH64, data, sizeof(data), sizeof(data)));
+	assert_string_equal(whole, hash(CK_XXH64, data, sizeof(data), 1U));
+	assert_string_equal(whole, hash(CK_XXH64, data, sizeof(data), 31U));
+
+	snprintf(whole, sizeof(whole), "%s",
+			hash(CK_SHA256, data, sizeof(data), sizeof(data)));
+	assert_string_equal(whole, hash(CK_SHA256, data, sizeof(data), 1U));
+	assert_string_equal(whole, hash(CK_SHA256, data, sizeof(data), 63U));
+}
+
+/* Computes checksum of the data feeding it by pieces of step bytes.  Returns
+ * pointer to statically allocated hex form of the digest. */
+static const char *
+hash(ChecksumKind kind, const char data[], size_t len, size_t step)
+{
+	static char hex[2*CHECKSUM_MAX_LEN + 1];
+	unsigned char digest[CHECKSUM_MAX_LEN];
+	checksum_t cs;
+	size_t i;
+	size_t digest_len;
+
+	checksum_init(&cs, kind);
+	for(i = 0U; i < len; i += step)
+	{
+		checksum_update(&cs, data + i, (len - i < step) ? len - i : step);
+	}
+	digest_len = checksum_final(&cs, digest);
+
+	for(i = 0U; i < digest_len; ++i)
+	{
+		snprintf(hex + 2*i, sizeof(hex) - 2*i, "%02x", digest[i]);
+	}
+	return hex;
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,192 @@
+#include <stic.h>
+
+#include <pthread.h> /* PTHREAD_MUTEX_INITIALIZER pthread_mutex_* */
+#include <unistd.h> /* rmdir() symlink() unlink() */
+
+#include <stdint.h> /* uint64_t */
+#include <stdio.h> /* FILE fclose() fopen() fputs() snprintf() */
+#include <string.h> /* strcmp() */
+
+#include "../../src/compat/os.h"
+#include "../../src/utils/dirsize.h"
+
+/* Number of subdirectories of the root and of each of them. */
+#define FANOUT 5
+
+static void make_tree(void);
+static void remove_tree(void);
+static void make_file(const char path[], const char content[]);
+static void check_tree(int nworkers);
+static int get_cached(const char path[], uint64_t *size, void *arg);
+static void count_dirs(const char path[], const dirsize_stats_t *stats,
+		void *arg);
+
+/* Number of times dir_done callback was called. */
+static int ndone;
+/* Statistics reported for the root. */
+static dirsize_stats_t root_stats;
+/* Protects variables above. */
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+
+SETUP()
+{
+	ndone = 0;
+	make_tree();
+}
+
+TEARDOWN()
+{
+	dirsize_force_workers(0);
+	remove_tree();
+}
+
+TEST(unreadable_root_is_an_error)
+{
+	dirsize_stats_t stats;
+	const dirsize_params_t params = { .count_links = 0 };
+	assert_failure(dirsize_calc(SANDBOX_PATH "/no-such-dir", &params, &stats));
+	assert_true(stats.bytes == 0U);
+}
+
+TEST(tree_is_calculated_by_single_worker)
+{
+	check_tree(1);
+}
+
+TEST(tree_is_calculated_by_several_workers)
+{
+	check_tree(4);
+}
+
+TEST(cached_sizes_are_used)
+{
+	dirsize_stats_t stats;
+	const dirsize_params_t params = { .get_cached = &get_cached };
+	assert_success(dirsize_calc(SANDBOX_PATH, &params, &stats));
+
+	/* Each subdirectory of the root is said to be 1000 bytes big. */
+	assert_true(stats.bytes == FANOUT*1000U + 1U);
+	assert_true(stats.nfiles == 1U);
+	assert_true(stats.ndirs == FANOUT);
+}
+
+TEST(links_are_not_followed)
+{
+	dirsize_stats_t stats;
+	const dirsize_params_t params = { .count_links = 0 };
+
+#ifndef _WIN32
+	assert_success(symlink(SANDBOX_PATH "/dir0", SANDBOX_PATH "/link"));
+#endif
+
+	assert_success(dirsize_calc(SANDBOX_PATH, &params, &stats));
+
+#ifndef _WIN32
+	assert_success(unlink(SANDBOX_PATH "/link"));
+	assert_true(stats.nfiles == FANOUT*FANOUT + 2U);
+#endif
+
+	assert_true(stats.bytes == FANOUT*FANOUT*2U + 1U);
+}
+
+/* Calculates size of the tree and checks the result. */
+static void
+check_tree(int nworkers)
+{
+	dirsize_stats_t stats;
+	const dirsize_params_t params = { .dir_done = &count_dirs };
+
+	dirsize_force_workers(nworkers);
+	assert_success(dirsize_calc(SANDBOX_PATH, &params, &stats));
+
+	assert_true(stats.bytes == FANOUT*FANOUT*2U + 1U);
+	assert_true(stats.nfiles == FANOUT*FANOUT + 1U);
+	assert_true(stats.ndirs == FANOUT + FANOUT*FANOUT);
+
+	assert_int_equal(1 + FANOUT + FANOUT*FANOUT, ndone);
+	assert_true(root_stats.bytes == stats.bytes);
+	assert_true(root_stats.ndirs == stats.ndirs);
+}
+
+/* Creates two levels of directories with a two byte file in each directory of
+ * the last level and a one byte file at the root. */
+static void
+make_tree(void)
+{
+	int i, j;
+
+	make_file(SANDBOX_PATH "/file", "x");
+
+	for(i = 0; i < FANOUT; ++i)
+	{
+		char path[128];
+		snprintf(path, sizeof(path), SANDBOX_PATH "/dir%d", i);
+		assert_success(os_mkdir(path, 0700));
+
+		for(j = 0; j < FANOUT; ++j)
+		{
+			snprintf(path, sizeof(path), SANDBOX_PATH "/dir%d/sub%d", i, j);
+			assert_success(os_mkdir(path, 0700));
+			snprintf(path, sizeof(path), SANDBOX_PATH "/dir%d/sub%d/file", i, j);
+			make_file(path, "xx");
+		}
+	}
+}
+
+/* Removes tree created by make_tree(). */
+static void
+remove_tree(void)
+{
+	int i, j;
+
+	assert_success(unlink(SANDBOX_PATH "/file"));
+
+	for(i = 0; i < FANOUT; ++i)
+	{
+		char path[128];
+		for(j = 0; j < FANOUT; ++j)
+		{
+			snprintf(path, sizeof(path), SANDBOX_PATH "/dir%d/sub%d/file", i, j);
+			assert_success(unlink(path));
+			snprintf(path, sizeof(path), SANDBOX_PATH "/dir%d/sub%d", i, j);
+			assert_success(rmdir(path));
+		}
+
+		snprintf(path, sizeof(path), SANDBOX_PATH "/dir%d", i);
+		assert_success(rmdir(path));
+	}
+}
+
+/* Creates file with specified content. */
+static void
+make_file(const char path[], const char content[])
+{
+	FILE *const f = fopen(path, "w");
+	assert_non_null(f);
+	fputs(content, f);
+	fclose(f);
+}
+
+/* Reports subdirectories of the root as having size of 1000 bytes. */
+static int
+get_cached(const char path[], uint64_t *size, void *arg)
+{
+	*size = 1000U;
+	return 1;
+}
+
+/* Counts calls and remembers statistics of the root. */
+static void
+count_dirs(const char path[], const dirsize_stats_t *stats, void *arg)
+{
+	pthread_mutex_lock(&lock);
+	++ndone;
+	if(strcmp(path, SANDBOX_PATH) == 0)
+	{
+		root_stats = *stats;
+	}
+	pthread_mutex_unlock(&lock);
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
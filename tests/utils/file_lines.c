@@ -0,0 +1,303 @@
+#include <stic.h>
+
+#include <unistd.h> /* unlink() */
+
+#include <stddef.h> /* size_t */
+#include <stdio.h> /* FILE fclose() fopen() fprintf() fputs() rename()
+                      snprintf() */
+#include <string.h> /* memcmp() strlen() */
+
+#include "../../src/utils/file_lines.h"
+#include "../../src/utils/string_array.h"
+
+static void check_against_reading(const char path[]);
+static void write_lines(const char path[], int count);
+static void append(const char path[], const char text[]);
+static int not_windows(void);
+
+TEST(lines_are_split_as_when_reading_file, IF(not_windows))
+{
+	check_against_reading(TEST_DATA_PATH "/read/binary-data");
+	check_against_reading(TEST_DATA_PATH "/read/dos-eof");
+	check_against_reading(TEST_DATA_PATH "/read/dos-line-endings");
+	check_against_reading(TEST_DATA_PATH "/read/two-lines");
+	check_against_reading(TEST_DATA_PATH "/read/very-long-line");
+}
+
+TEST(data_appended_to_empty_file_is_indexed, IF(not_windows))
+{
+	file_lines_t *fl;
+	const char *line;
+	size_t len;
+	size_t count;
+
+	write_lines(SANDBOX_PATH "/empty", 0);
+	fl = fl_open(SANDBOX_PATH "/empty");
+	assert_non_null(fl);
+
+	assert_success(fl_known_count(fl, &count));
+	assert_int_equal(0, count);
+	assert_false(fl_has_line(fl, 0));
+	assert_false(fl_grow(fl));
+
+	append(SANDBOX_PATH "/empty", "first\nsecond\n");
+	assert_true(fl_grow(fl));
+
+	assert_int_equal(2, fl_count(fl));
+	line = fl_get(fl, 1, &len);
+	assert_non_null(line);
+	assert_int_equal(6, len);
+	assert_success(memcmp(line, "second", len));
+
+	fl_close(fl);
+	assert_success(unlink(SANDBOX_PATH "/empty"));
+}
+
+TEST(file_is_indexed_on_demand, IF(not_windows))
+{
+	file_lines_t *fl;
+	const char *line;
+	size_t len;
+	size_t count;
+
+	write_lines(SANDBOX_PATH "/file", 1000);
+	fl = fl_open(SANDBOX_PATH "/file");
+	assert_non_null(fl);
+
+	assert_true(fl_has_line(fl, 10));
+	assert_failure(fl_known_count(fl, &count));
+
+	line = fl_get(fl, 999, &len);
+	assert_non_null(line);
+	assert_int_equal(7, len);
+	assert_success(memcmp(line, "line999", len));
+	assert_null(fl_get(fl, 1000, &len));
+	assert_false(fl_has_line(fl, 1000));
+
+	/* Going backward is handled as well. */
+	line = fl_get(fl, 257, &len);
+	assert_non_null(line);
+	assert_success(memcmp(line, "line257", len));
+
+	assert_int_equal(1000, fl_count(fl));
+	assert_success(fl_known_count(fl, &count));
+	assert_int_equal(1000, count);
+
+	fl_close(fl);
+	assert_success(unlink(SANDBOX_PATH "/file"));
+}
+
+TEST(truncation_of_file_is_detected, IF(not_windows))
+{
+	file_lines_t *fl;
+	size_t len;
+
+	write_lines(SANDBOX_PATH "/file", 1000);
+	fl = fl_open(SANDBOX_PATH "/file");
+	assert_non_null(fl);
+	assert_int_equal(1000, fl_count(fl));
+	assert_false(fl_sync(fl));
+
+	write_lines(SANDBOX_PATH "/file", 10);
+	assert_true(fl_sync(fl));
+	assert_int_equal(10, fl_count(fl));
+	assert_null(fl_get(fl, 10, &len));
+
+	fl_close(fl);
+	assert_success(unlink(SANDBOX_PATH "/file"));
+}
+
+TEST(truncation_before_sync_looks_like_end_of_file, IF(not_windows))
+{
+	file_lines_t *fl;
+	size_t len;
+
+	/* The file is bigger than a block that is read at once. */
+	write_lines(SANDBOX_PATH "/file", 100000);
+	fl = fl_open(SANDBOX_PATH "/file");
+	assert_non_null(fl);
+	assert_true(fl_has_line(fl, 10));
+
+	write_lines(SANDBOX_PATH "/file", 10);
+	assert_true(fl_count(fl) < 100000);
+	assert_null(fl_get(fl, 99999, &len));
+	assert_null(fl_read(fl, fl_size(fl) - 1U, 1U, &len));
+
+	assert_true(fl_sync(fl));
+	assert_int_equal(10, fl_count(fl));
+
+	fl_close(fl);
+	assert_success(unlink(SANDBOX_PATH "/file"));
+}
+
+TEST(appended_data_is_indexed, IF(not_windows))
+{
+	file_lines_t *fl;
+	const char *line;
+	size_t len;
+	size_t count;
+
+	/* Last line starts a new checkpoint. */
+	write_lines(SANDBOX_PATH "/file", 256);
+	append(SANDBOX_PATH "/file", "tail");
+	fl = fl_open(SANDBOX_PATH "/file");
+	assert_non_null(fl);
+	assert_int_equal(257, fl_count(fl));
+	assert_false(fl_grow(fl));
+
+	append(SANDBOX_PATH "/file", "ed\r");
+	assert_true(fl_grow(fl));
+	assert_failure(fl_known_count(fl, &count));
+	assert_int_equal(257, fl_count(fl));
+
+	/* Line ending is split between appends. */
+	append(SANDBOX_PATH "/file", "\nnext\n");
+	assert_true(fl_grow(fl));
+	assert_int_equal(258, fl_count(fl));
+
+	line = fl_get(fl, 256, &len);
+	assert_non_null(line);
+	assert_int_equal(6, len);
+	assert_success(memcmp(line, "tailed", len));
+	line = fl_get(fl, 257, &len);
+	assert_non_null(line);
+	assert_int_equal(4, len);
+	assert_success(memcmp(line, "next", len));
+	line = fl_get(fl, 255, &len);
+	assert_non_null(line);
+	assert_success(memcmp(line, "line255", len));
+
+	fl_close(fl);
+	assert_success(unlink(SANDBOX_PATH "/file"));
+}
+
+TEST(rewriting_of_truncated_file_resets_index, IF(not_windows))
+{
+	file_lines_t *fl;
+	const char *line;
+	size_t len;
+
+	write_lines(SANDBOX_PATH "/file", 10);
+	fl = fl_open(SANDBOX_PATH "/file");
+	assert_non_null(fl);
+	assert_int_equal(10, fl_count(fl));
+
+	/* Truncation followed by writing more data than there was. */
+	write_lines(SANDBOX_PATH "/file", 0);
+	append(SANDBOX_PATH "/file", "first\nsecond\nthird\nfourth\nfifth\n"
+	                             "sixth\nseventh\neighth\nninth\ntenth\n"
+	                             "eleventh\n");
+	assert_true(fl_grow(fl));
+	assert_int_equal(11, fl_count(fl));
+	line = fl_get(fl, 0, &len);
+	assert_non_null(line);
+	assert_int_equal(5, len);
+	assert_success(memcmp(line, "first", len));
+	line = fl_get(fl, 10, &len);
+	assert_non_null(line);
+	assert_int_equal(8, len);
+	assert_success(memcmp(line, "eleventh", len));
+
+	/* Writing the same amount of data doesn't change size of the file. */
+	write_lines(SANDBOX_PATH "/file", 0);
+	append(SANDBOX_PATH "/file", "FIRST\nSECOND\nTHIRD\nFOURTH\nFIFTH\n"
+	                             "SIXTH\nSEVENTH\nEIGHTH\nNINTH\nTENTH\n"
+	                             "ELEVENTH\n");
+	assert_true(fl_sync(fl));
+	assert_false(fl_grow(fl));
+	assert_int_equal(11, fl_count(fl));
+	line = fl_get(fl, 10, &len);
+	assert_non_null(line);
+	assert_int_equal(8, len);
+	assert_success(memcmp(line, "ELEVENTH", len));
+
+	assert_false(fl_sync(fl));
+	assert_false(fl_grow(fl));
+
+	fl_close(fl);
+	assert_success(unlink(SANDBOX_PATH "/file"));
+}
+
+TEST(replacement_of_file_is_detected, IF(not_windows))
+{
+	file_lines_t *fl;
+
+	write_lines(SANDBOX_PATH "/file", 10);
+	fl = fl_open(SANDBOX_PATH "/file");
+	assert_non_null(fl);
+	assert_true(fl_is_same_file(fl, SANDBOX_PATH "/file"));
+
+	assert_success(rename(SANDBOX_PATH "/file", SANDBOX_PATH "/file.1"));
+	assert_false(fl_is_same_file(fl, SANDBOX_PATH "/file"));
+	write_lines(SANDBOX_PATH "/file", 10);
+	assert_false(fl_is_same_file(fl, SANDBOX_PATH "/file"));
+	assert_true(fl_is_same_file(fl, SANDBOX_PATH "/file.1"));
+
+	fl_close(fl);
+	assert_success(unlink(SANDBOX_PATH "/file"));
+	assert_success(unlink(SANDBOX_PATH "/file.1"));
+}
+
+/* Checks that splitting of the file yields the same lines as reading it. */
+static void
+check_against_reading(const char path[])
+{
+	int i;
+	int nlines;
+	char **lines = read_file_of_lines(path, &nlines);
+	file_lines_t *const fl = fl_open(path);
+
+	assert_non_null(lines);
+	assert_non_null(fl);
+
+	assert_int_equal(nlines, fl_count(fl));
+	for(i = 0; i < nlines; ++i)
+	{
+		size_t len;
+		const char *const line = fl_get(fl, i, &len);
+		assert_non_null(line);
+		assert_int_equal(strlen(lines[i]), len);
+		assert_success(memcmp(lines[i], line, len));
+	}
+
+	fl_close(fl);
+	free_string_array(lines, nlines);
+}
+
+/* Overwrites file with specified number of numbered lines. */
+static void
+write_lines(const char path[], int count)
+{
+	int i;
+	FILE *const f = fopen(path, "w");
+	assert_non_null(f);
+
+	for(i = 0; i < count; ++i)
+	{
+		fprintf(f, "line%d\n", i);
+	}
+	fclose(f);
+}
+
+/* Appends text to the file. */
+static void
+append(const char path[], const char text[])
+{
+	FILE *const f = fopen(path, "ab");
+	assert_non_null(f);
+	fputs(text, f);
+	fclose(f);
+}
+
+static int
+not_windows(void)
+{
+#ifdef _WIN32
+	return 0;
+#else
+	return 1;
+#endif
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
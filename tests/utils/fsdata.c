@@ -1,8 +1,10 @@
 #include <stic.h>
 
+#include <pthread.h> /* pthread_create() pthread_join() */
 #include <unistd.h> /* rmdir() */
 
 #include <stddef.h> /* NULL */
+#include <stdio.h> /* snprintf() */
 
 #include "../../src/compat/os.h"
 #include "../../src/utils/fsdata.h"
@@ -13,6 +15,21 @@
 #define ROOT "C:/"
 #endif
 
+/* Number of directories created by tests of many siblings. */
+#define NDIRS 200
+
+static void * read_pairs(void *arg);
+static void make_dirs(void);
+static void remove_dirs(void);
+
+/* Pair of values that are always updated together. */
+typedef struct
+{
+	int first;  /* First value. */
+	int second; /* Second value. */
+}
+pair_t;
+
 TEST(freeing_null_fsdata_is_ok)
 {
 	fsdata_free(NULL);
@@ -195,5 +212,108 @@ TEST(data_size_can_change)
 	fsdata_free(fsd);
 }
 
+TEST(many_siblings_are_independent)
+{
+	int i;
+	fsdata_t *const fsd = fsdata_create(0);
+
+	make_dirs();
+
+	for(i = 0; i < NDIRS; ++i)
+	{
+		char path[64];
+		snprintf(path, sizeof(path), SANDBOX_PATH "/dir%d", i);
+		assert_success(fsdata_set(fsd, path, &i, sizeof(i)));
+	}
+
+	for(i = 0; i < NDIRS; ++i)
+	{
+		int data = -1;
+		char path[64];
+		snprintf(path, sizeof(path), SANDBOX_PATH "/dir%d", i);
+		assert_success(fsdata_get(fsd, path, &data, sizeof(data)));
+		assert_int_equal(i, data);
+	}
+
+	remove_dirs();
+	fsdata_free(fsd);
+}
+
+TEST(reading_while_writing_gets_consistent_data)
+{
+	int i;
+	pthread_t reader;
+	pair_t pair = { 0, 0 };
+	fsdata_t *const fsd = fsdata_create(0);
+
+	make_dirs();
+	assert_success(fsdata_set(fsd, SANDBOX_PATH, &pair, sizeof(pair)));
+
+	assert_success(pthread_create(&reader, NULL, &read_pairs, fsd));
+
+	/* Adding siblings makes hash tables grow while being read. */
+	for(i = 1; i <= NDIRS; ++i)
+	{
+		char path[64];
+		snprintf(path, sizeof(path), SANDBOX_PATH "/dir%d", i - 1);
+
+		pair.first = i;
+		pair.second = i;
+		assert_success(fsdata_set(fsd, SANDBOX_PATH, &pair, sizeof(pair)));
+		assert_success(fsdata_set(fsd, path, &pair, sizeof(pair)));
+	}
+
+	pair.first = -1;
+	pair.second = -1;
+	assert_success(fsdata_set(fsd, SANDBOX_PATH, &pair, sizeof(pair)));
+
+	assert_success(pthread_join(reader, NULL));
+
+	remove_dirs();
+	fsdata_free(fsd);
+}
+
+/* Reads pairs until negative one is encountered, checks that parts of each
+ * pair are equal.  Returns NULL. */
+static void *
+read_pairs(void *arg)
+{
+	fsdata_t *const fsd = arg;
+	pair_t pair;
+	do
+	{
+		assert_success(fsdata_get(fsd, SANDBOX_PATH, &pair, sizeof(pair)));
+		assert_int_equal(pair.first, pair.second);
+	}
+	while(pair.first >= 0);
+	return NULL;
+}
+
+/* Creates NDIRS directories in the sandbox. */
+static void
+make_dirs(void)
+{
+	int i;
+	for(i = 0; i < NDIRS; ++i)
+	{
+		char path[64];
+		snprintf(path, sizeof(path), SANDBOX_PATH "/dir%d", i);
+		assert_success(os_mkdir(path, 0700));
+	}
+}
+
+/* Removes directories created by make_dirs(). */
+static void
+remove_dirs(void)
+{
+	int i;
+	for(i = 0; i < NDIRS; ++i)
+	{
+		char path[64];
+		snprintf(path, sizeof(path), SANDBOX_PATH "/dir%d", i);
+		assert_success(rmdir(path));
+	}
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,75 @@
+#include <stic.h>
+
+#include <stddef.h> /* NULL */
+#include <stdio.h> /* snprintf() */
+#include <string.h> /* memset() strcmp() */
+
+#include "../../src/utils/str_pool.h"
+
+TEST(freeing_null_is_ok)
+{
+	str_pool_free(NULL);
+}
+
+TEST(strings_are_copied)
+{
+	char *const a = str_pool_dup("a");
+	char *const b = str_pool_dup("bb");
+	char *const empty = str_pool_dup("");
+
+	assert_string_equal("a", a);
+	assert_string_equal("bb", b);
+	assert_string_equal("", empty);
+
+	str_pool_free(a);
+	str_pool_free(b);
+	str_pool_free(empty);
+}
+
+TEST(many_strings_take_few_blocks)
+{
+	char *strs[10000];
+	int i;
+	const str_pool_stats_t before = str_pool_get_stats();
+	str_pool_stats_t after;
+
+	for(i = 0; i < (int)(sizeof(strs)/sizeof(strs[0])); ++i)
+	{
+		char buf[32];
+		snprintf(buf, sizeof(buf), "file%d.txt", i);
+		strs[i] = str_pool_dup(buf);
+		assert_non_null(strs[i]);
+	}
+
+	after = str_pool_get_stats();
+	assert_int_equal(10000, after.nstrings - before.nstrings);
+	assert_true(after.nblocks - before.nblocks < 10);
+
+	for(i = 0; i < (int)(sizeof(strs)/sizeof(strs[0])); ++i)
+	{
+		char buf[32];
+		snprintf(buf, sizeof(buf), "file%d.txt", i);
+		assert_string_equal(buf, strs[i]);
+		str_pool_free(strs[i]);
+	}
+
+	/* Only current block might be left. */
+	assert_true(str_pool_get_stats().nlive <= 1);
+}
+
+TEST(long_strings_are_handled)
+{
+	static char long_str[256*1024];
+	char *copy;
+
+	memset(long_str, 'x', sizeof(long_str) - 1);
+	long_str[sizeof(long_str) - 1] = '\0';
+
+	copy = str_pool_dup(long_str);
+	assert_non_null(copy);
+	assert_true(strcmp(long_str, copy) == 0);
+	str_pool_free(copy);
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,143 @@
+#include <stic.h>
+
+#include <stdio.h> /* snprintf() */
+#include <stdlib.h> /* free() malloc() */
+#include <string.h> /* memset() */
+
+#include "../../src/utils/trie.h"
+
+/* Checks of the trie that involve many keys, which makes it grow several
+ * times, and keys that don't fit into a regular block of keys. */
+
+/* Number of keys, enough for several resizes of the table. */
+#define NKEYS (10*1000)
+
+/* Length of a key bigger than a block of keys (16 KiB). */
+#define LONG_KEY_LEN (20*1024)
+
+/* Common prefix of keys, which makes them about 60 bytes long. */
+#define PREFIX "/home/user/projects/some-project/build/output/objects/"
+
+static void make_key(char buf[], size_t size, int i, const char ext[]);
+
+static int values[NKEYS];
+
+TEST(keys_survive_growth_of_the_table)
+{
+	int i;
+	trie_t trie = trie_create();
+	assert_non_null(trie);
+
+	for(i = 0; i < NKEYS; ++i)
+	{
+		char key[128];
+		make_key(key, sizeof(key), i, "o");
+		assert_int_equal(0, trie_set(trie, key, &values[i]));
+	}
+
+	for(i = 0; i < NKEYS; ++i)
+	{
+		char key[128];
+		void *data = NULL;
+		make_key(key, sizeof(key), i, "o");
+		assert_success(trie_get(trie, key, &data));
+		assert_true(data == &values[i]);
+	}
+
+	for(i = 0; i < NKEYS; i += 100)
+	{
+		char key[128];
+		void *data;
+		make_key(key, sizeof(key), i, "c");
+		assert_failure(trie_get(trie, key, &data));
+	}
+
+	trie_free(trie);
+}
+
+TEST(set_overwrites_data_after_growth)
+{
+	int i;
+	trie_t trie = trie_create();
+	assert_non_null(trie);
+
+	for(i = 0; i < NKEYS; ++i)
+	{
+		char key[128];
+		make_key(key, sizeof(key), i, "o");
+		assert_int_equal(0, trie_put(trie, key));
+	}
+
+	for(i = 0; i < NKEYS; i += 7)
+	{
+		char key[128];
+		make_key(key, sizeof(key), i, "o");
+		assert_true(trie_set(trie, key, &values[i]) > 0);
+	}
+
+	for(i = 0; i < NKEYS; ++i)
+	{
+		char key[128];
+		void *data = &trie;
+		make_key(key, sizeof(key), i, "o");
+		assert_success(trie_get(trie, key, &data));
+		assert_true(data == ((i%7 == 0) ? &values[i] : NULL));
+	}
+
+	trie_free(trie);
+}
+
+TEST(key_longer_than_block_of_keys)
+{
+	int i;
+	void *data = NULL;
+	char *const key = malloc(LONG_KEY_LEN + 1);
+	trie_t trie = trie_create();
+	assert_non_null(trie);
+	assert_non_null(key);
+
+	memset(key, 'k', LONG_KEY_LEN);
+	key[LONG_KEY_LEN] = '\0';
+
+	/* Surround the long key with short ones to use partially filled block. */
+	for(i = 0; i < 10; ++i)
+	{
+		char short_key[128];
+		make_key(short_key, sizeof(short_key), i, "o");
+		assert_int_equal(0, trie_set(trie, short_key, &values[i]));
+	}
+	assert_int_equal(0, trie_set(trie, key, &trie));
+	for(i = 10; i < 20; ++i)
+	{
+		char short_key[128];
+		make_key(short_key, sizeof(short_key), i, "o");
+		assert_int_equal(0, trie_set(trie, short_key, &values[i]));
+	}
+
+	assert_success(trie_get(trie, key, &data));
+	assert_true(data == &trie);
+
+	key[LONG_KEY_LEN - 1] = 'x';
+	assert_failure(trie_get(trie, key, &data));
+
+	for(i = 0; i < 20; ++i)
+	{
+		char short_key[128];
+		make_key(short_key, sizeof(short_key), i, "o");
+		assert_success(trie_get(trie, short_key, &data));
+		assert_true(data == &values[i]);
+	}
+
+	trie_free(trie);
+	free(key);
+}
+
+/* Formats i-th key with the specified extension into the buffer. */
+static void
+make_key(char buf[], size_t size, int i, const char ext[])
+{
+	snprintf(buf, size, PREFIX "%07d.%s", i, ext);
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */